@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "../../../socket-forwarder/buffer/DatagramRing.h"
+
+namespace forwarder
+{
+    /**
+     * Pushes and takes a datagram of the provided size on a single thread, the cost of passing a message through the ring without contention.
+     */
+    static void BM_DatagramRing_PushAcquire(benchmark::State& state)
+    {
+        const std::string message(static_cast<size_t>(state.range(0)), 'm');
+        DatagramRing ring(1024, 10240, OverflowPolicy::DropNewest);
+        const kt::SocketAddress address{};
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (auto _ : state)
+        {
+            ring.push(message.data(), message.size(), address, now, 0);
+            DatagramSlot* slot = ring.acquire();
+            benchmark::DoNotOptimize(slot->data);
+            ring.release(slot);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_DatagramRing_PushAcquire)->Arg(64)->Arg(1024);
+
+    /**
+     * Pushes from the benchmark thread while another thread takes the datagrams, waiting on the ring whenever it is empty like the UDP forwarding thread.
+     * Datagrams pushed while the ring is full are dropped and counted.
+     */
+    static void BM_DatagramRing_ProducerConsumer(benchmark::State& state)
+    {
+        const std::string message(64, 'm');
+        DatagramRing ring(static_cast<size_t>(state.range(0)), 1024, OverflowPolicy::DropNewest);
+        std::atomic<bool> consuming{ true };
+        std::thread consumer([&ring, &consuming]()
+        {
+            while (consuming.load(std::memory_order_relaxed))
+            {
+                if (ring.wait(std::chrono::milliseconds(10)))
+                {
+                    DatagramSlot* slot = nullptr;
+                    while ((slot = ring.acquire()) != nullptr)
+                    {
+                        ring.release(slot);
+                    }
+                }
+            }
+        });
+
+        const kt::SocketAddress address{};
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (auto _ : state)
+        {
+            ring.push(message.data(), message.size(), address, now, 0);
+        }
+        consuming = false;
+        consumer.join();
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["dropped"] = static_cast<double>(ring.getDroppedMessages());
+    }
+    BENCHMARK(BM_DatagramRing_ProducerConsumer)->Arg(256)->Arg(4096)->UseRealTime();
+}
@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../../socket-forwarder/buffer/SplicePipe.h"
+
+namespace forwarder
+{
+    const size_t SPLICE_BENCHMARK_PEERS = 4;
+
+    /**
+     * A source connection and a connection per peer over loopback TCP, the forwarder side of each connection is what the benchmark reads from and writes to.
+     */
+    class LoopbackGroup
+    {
+    public:
+        std::pair<int, int> source;
+        std::vector<std::pair<int, int>> peers;
+        std::vector<char> scratch;
+
+        LoopbackGroup(const size_t peerCount, const size_t messageSize): scratch(messageSize)
+        {
+            int listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            listen(listener, static_cast<int>(peerCount + 1));
+            socklen_t length = sizeof(address);
+            getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+
+            source = connectPair(listener, address);
+            for (size_t i = 0; i < peerCount; i++)
+            {
+                peers.push_back(connectPair(listener, address));
+            }
+            close(listener);
+        }
+
+        ~LoopbackGroup()
+        {
+            close(source.first);
+            close(source.second);
+            for (std::pair<int, int>& peer : peers)
+            {
+                close(peer.first);
+                close(peer.second);
+            }
+        }
+
+        /**
+         * Returns the client and forwarder ends of a new connection.
+         */
+        static std::pair<int, int> connectPair(const int listener, const sockaddr_in& address)
+        {
+            int client = socket(AF_INET, SOCK_STREAM, 0);
+            connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            int accepted = accept(listener, nullptr, nullptr);
+            int enabled = 1;
+            setsockopt(accepted, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+            return std::make_pair(client, accepted);
+        }
+
+        void sendMessage()
+        {
+            size_t sent = 0;
+            while (sent < scratch.size())
+            {
+                sent += static_cast<size_t>(send(source.first, scratch.data() + sent, scratch.size() - sent, 0));
+            }
+        }
+
+        void receiveOnEveryPeer()
+        {
+            for (std::pair<int, int>& peer : peers)
+            {
+                size_t received = 0;
+                while (received < scratch.size())
+                {
+                    received += static_cast<size_t>(recv(peer.first, scratch.data() + received, scratch.size() - received, 0));
+                }
+            }
+        }
+    };
+
+    /**
+     * The copy based path, the message is read into user space and written to every peer.
+     */
+    static void BM_Forward_Copy(benchmark::State& state)
+    {
+        const size_t messageSize = static_cast<size_t>(state.range(0));
+        LoopbackGroup group(SPLICE_BENCHMARK_PEERS, messageSize);
+        std::vector<char> buffer(messageSize);
+
+        for (auto _ : state)
+        {
+            group.sendMessage();
+            size_t received = 0;
+            while (received < messageSize)
+            {
+                received += static_cast<size_t>(recv(group.source.second, buffer.data() + received, messageSize - received, 0));
+            }
+            for (std::pair<int, int>& peer : group.peers)
+            {
+                send(peer.second, buffer.data(), messageSize, 0);
+            }
+            group.receiveOnEveryPeer();
+        }
+        state.SetBytesProcessed(state.iterations() * messageSize * SPLICE_BENCHMARK_PEERS);
+    }
+    BENCHMARK(BM_Forward_Copy)->Arg(4096)->Arg(16384)->Arg(65536);
+
+    /**
+     * The splice path, the message is moved into a pipe, duplicated into a pipe per peer and moved into every peer's socket without entering user space.
+     */
+    static void BM_Forward_Splice(benchmark::State& state)
+    {
+        const size_t messageSize = static_cast<size_t>(state.range(0));
+        LoopbackGroup group(SPLICE_BENCHMARK_PEERS, messageSize);
+        int nullDescriptor = open("/dev/null", O_WRONLY);
+
+        SplicePipe receivePipe;
+        receivePipe.open(1048576);
+        std::vector<SplicePipe> peerPipes(SPLICE_BENCHMARK_PEERS);
+        for (SplicePipe& pipe : peerPipes)
+        {
+            pipe.open(1048576);
+        }
+
+        for (auto _ : state)
+        {
+            group.sendMessage();
+            while (receivePipe.getQueuedBytes() < messageSize)
+            {
+                receivePipe.spliceFrom(group.source.second, messageSize - receivePipe.getQueuedBytes());
+            }
+            for (size_t i = 0; i < SPLICE_BENCHMARK_PEERS; i++)
+            {
+                receivePipe.teeTo(peerPipes[i], messageSize);
+                peerPipes[i].flush(group.peers[i].second);
+            }
+            receivePipe.discard(nullDescriptor);
+            group.receiveOnEveryPeer();
+        }
+        state.SetBytesProcessed(state.iterations() * messageSize * SPLICE_BENCHMARK_PEERS);
+
+        receivePipe.close();
+        for (SplicePipe& pipe : peerPipes)
+        {
+            pipe.close();
+        }
+        close(nullDescriptor);
+    }
+    BENCHMARK(BM_Forward_Splice)->Arg(4096)->Arg(16384)->Arg(65536);
+}
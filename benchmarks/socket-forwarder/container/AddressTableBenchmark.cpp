@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <netinet/in.h>
+
+#include "../../../socket-forwarder/container/AddressTable.h"
+
+namespace forwarder
+{
+    static std::vector<kt::SocketAddress> benchmarkAddresses(const size_t amount)
+    {
+        std::vector<kt::SocketAddress> addresses(amount);
+        for (size_t i = 0; i < amount; i++)
+        {
+            addresses[i].ipv4.sin_family = AF_INET;
+            addresses[i].ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK + static_cast<uint32_t>(i / 50000));
+            addresses[i].ipv4.sin_port = htons(static_cast<unsigned short>(1024 + i % 50000));
+        }
+        return addresses;
+    }
+
+    /**
+     * Looks up a peer that is in the table, as every datagram received by the UDP listener is checked against its group.
+     */
+    static void BM_AddressTable_FindHit(benchmark::State& state)
+    {
+        const std::vector<kt::SocketAddress> addresses = benchmarkAddresses(static_cast<size_t>(state.range(0)));
+        AddressTable table;
+        for (const kt::SocketAddress& address : addresses)
+        {
+            table.insert(address);
+        }
+
+        size_t next = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(table.find(addresses[next]));
+            next = next + 1 == addresses.size() ? 0 : next + 1;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_AddressTable_FindHit)->Arg(8)->Arg(1000)->Arg(100000);
+
+    static void BM_AddressTable_FindMiss(benchmark::State& state)
+    {
+        const std::vector<kt::SocketAddress> addresses = benchmarkAddresses(static_cast<size_t>(state.range(0)) * 2);
+        AddressTable table;
+        for (size_t i = 0; i < addresses.size(); i += 2)
+        {
+            table.insert(addresses[i]);
+        }
+
+        size_t next = 1;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(table.find(addresses[next]));
+            next = next + 2 >= addresses.size() ? 1 : next + 2;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_AddressTable_FindMiss)->Arg(8)->Arg(1000)->Arg(100000);
+
+    static void BM_AddressTable_Insert(benchmark::State& state)
+    {
+        const std::vector<kt::SocketAddress> addresses = benchmarkAddresses(static_cast<size_t>(state.range(0)));
+        for (auto _ : state)
+        {
+            AddressTable table;
+            for (const kt::SocketAddress& address : addresses)
+            {
+                benchmark::DoNotOptimize(table.insert(address));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * addresses.size());
+    }
+    BENCHMARK(BM_AddressTable_Insert)->Arg(8)->Arg(1000)->Arg(100000);
+}
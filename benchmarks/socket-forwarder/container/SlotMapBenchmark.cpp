@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "../../../socket-forwarder/container/SlotMap.h"
+
+namespace forwarder
+{
+    /**
+     * Stands in for a group member, roughly the size of a socket plus its bookkeeping.
+     */
+    struct BenchmarkMember
+    {
+        int descriptor;
+        char padding[60];
+    };
+
+    static void BM_SlotMap_Join(benchmark::State& state)
+    {
+        const size_t members = static_cast<size_t>(state.range(0));
+        for (auto _ : state)
+        {
+            SlotMap<BenchmarkMember> group;
+            for (size_t i = 0; i < members; i++)
+            {
+                benchmark::DoNotOptimize(group.insert({ static_cast<int>(i) }));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * members);
+    }
+    BENCHMARK(BM_SlotMap_Join)->Arg(100)->Arg(1000)->Arg(10000);
+
+    /**
+     * One member leaves and another joins per iteration, from a group of the provided size.
+     */
+    static void BM_SlotMap_Churn(benchmark::State& state)
+    {
+        const size_t members = static_cast<size_t>(state.range(0));
+        SlotMap<BenchmarkMember> group;
+        std::vector<SlotHandle> handles;
+        for (size_t i = 0; i < members; i++)
+        {
+            handles.push_back(group.insert({ static_cast<int>(i) }));
+        }
+
+        std::mt19937 random(12345);
+        for (auto _ : state)
+        {
+            size_t position = random() % handles.size();
+            group.erase(handles[position]);
+            handles[position] = group.insert({ static_cast<int>(position) });
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_SlotMap_Churn)->Arg(100)->Arg(1000)->Arg(10000);
+
+    /**
+     * The previous membership storage, a vector where leaving members are found and erased by position.
+     */
+    static void BM_Vector_Churn(benchmark::State& state)
+    {
+        const size_t members = static_cast<size_t>(state.range(0));
+        std::vector<BenchmarkMember> group;
+        for (size_t i = 0; i < members; i++)
+        {
+            group.push_back({ static_cast<int>(i) });
+        }
+
+        std::mt19937 random(12345);
+        int nextDescriptor = static_cast<int>(members);
+        for (auto _ : state)
+        {
+            int leaving = group[random() % group.size()].descriptor;
+            auto position = std::find_if(group.begin(), group.end(), [leaving](const BenchmarkMember& member) { return member.descriptor == leaving; });
+            group.erase(position);
+            group.push_back({ nextDescriptor++ });
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_Vector_Churn)->Arg(100)->Arg(1000)->Arg(10000);
+
+    /**
+     * Visits every member once, the way a message is fanned out to a group.
+     */
+    static void BM_SlotMap_FanOut(benchmark::State& state)
+    {
+        const size_t members = static_cast<size_t>(state.range(0));
+        SlotMap<BenchmarkMember> group;
+        std::vector<SlotHandle> handles;
+        for (size_t i = 0; i < members; i++)
+        {
+            handles.push_back(group.insert({ static_cast<int>(i) }));
+        }
+        // Churn the group first so the dense array is not simply in insertion order
+        std::mt19937 random(12345);
+        for (size_t i = 0; i < members; i++)
+        {
+            size_t position = random() % handles.size();
+            group.erase(handles[position]);
+            handles[position] = group.insert({ static_cast<int>(position) });
+        }
+
+        for (auto _ : state)
+        {
+            long long sum = 0;
+            for (const BenchmarkMember& member : group)
+            {
+                sum += member.descriptor;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * members);
+    }
+    BENCHMARK(BM_SlotMap_FanOut)->Arg(100)->Arg(1000)->Arg(10000);
+}
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../../../socket-forwarder/container/TimingWheel.h"
+
+namespace forwarder
+{
+    /**
+     * Advances the wheel by a tick per iteration with the provided amount of values spread over a 30 second TTL, each scheduled again as it
+     * expires, as the UDP peer expiry does for peers that are still being heard from. Items are the values expired and scheduled again.
+     */
+    static void BM_TimingWheel_ExpireAndReschedule(benchmark::State& state)
+    {
+        const size_t waiting = static_cast<size_t>(state.range(0));
+        const std::chrono::milliseconds tick(10);
+        const std::chrono::milliseconds ttl(30000);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TimingWheel<size_t> wheel(tick, start);
+        for (size_t i = 0; i < waiting; i++)
+        {
+            wheel.schedule(i, start + ttl * i / waiting);
+        }
+
+        std::chrono::steady_clock::time_point now = start;
+        size_t expired = 0;
+        for (auto _ : state)
+        {
+            now += tick;
+            wheel.advance(now, [&wheel, &now, &expired, ttl](size_t value)
+            {
+                wheel.schedule(value, now + ttl);
+                expired++;
+            });
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(expired));
+    }
+    BENCHMARK(BM_TimingWheel_ExpireAndReschedule)->Arg(1000)->Arg(100000)->Arg(1000000);
+}
@@ -0,0 +1,202 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "../../../socket-forwarder/environment/Environment.h"
+#include "../../../socket-forwarder/forwarder/Forwarder.h"
+#include "../../../socket-forwarder/metrics/Histogram.h"
+
+namespace forwarder
+{
+    // How long a UDP client waits for a forwarded message before counting it as lost
+    const long FORWARDER_BENCHMARK_UDP_RECEIVE_TIMEOUT_MICROSECONDS = 200000;
+
+    static bool receiveExactly(const int descriptor, char* buffer, const size_t amount)
+    {
+        size_t received = 0;
+        while (received < amount)
+        {
+            ssize_t result = recv(descriptor, buffer + received, amount - received, 0);
+            if (result <= 0)
+            {
+                return false;
+            }
+            received += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    /**
+     * Adds the throughput and the latency percentiles of the recorded messages to the benchmark's counters, so they are included in
+     * the JSON and CSV output (--benchmark_format=json or --benchmark_out=<file> --benchmark_out_format=csv).
+     */
+    static void reportForwarding(benchmark::State& state, const LatencyHistogram& latencies, const size_t messagesPerIteration, const size_t bytesPerIteration)
+    {
+        const HistogramSnapshot snapshot = latencies.snapshot();
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * messagesPerIteration));
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytesPerIteration));
+        state.counters["p50_us"] = snapshot.valueAtPercentile(50.0) / 1000.0;
+        state.counters["p99_us"] = snapshot.valueAtPercentile(99.0) / 1000.0;
+        state.counters["p999_us"] = snapshot.valueAtPercentile(99.9) / 1000.0;
+        state.counters["max_us"] = snapshot.max / 1000.0;
+    }
+
+    /**
+     * Runs a forwarder over loopback with the provided amount of TCP groups, each with the provided amount of members. Each iteration sends a
+     * message of the provided size from one member of every group, then waits until every other member of every group has received all of it.
+     * A message is counted once for each member it is delivered to, its latency is from its send until the last member of its group received it.
+     * Groups are drained in order, so with several groups the later groups' latencies include the time spent draining the earlier groups.
+     */
+    static void BM_Forwarder_TCPFanOut(benchmark::State& state)
+    {
+        const size_t groupSize = static_cast<size_t>(state.range(0));
+        const size_t messageSize = static_cast<size_t>(state.range(1));
+        const size_t groupCount = static_cast<size_t>(state.range(2));
+
+        kt::ServerSocket serverSocket(kt::SocketType::Wifi);
+        Forwarder forwarder(serverSocket, std::nullopt, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, false);
+        forwarder.start();
+
+        std::vector<std::vector<kt::TCPSocket>> groups(groupCount);
+        for (size_t group = 0; group < groupCount; group++)
+        {
+            std::string groupId = "BM_Forwarder_TCPFanOut-" + std::to_string(group);
+            for (size_t i = 0; i < groupSize; i++)
+            {
+                groups[group].emplace_back("localhost", serverSocket.getPort());
+                groups[group].back().send(NEW_CLIENT_PREFIX_DEFAULT + groupId);
+            }
+            int enabled = 1;
+            setsockopt(groups[group].front().getSocket(), IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+            while (forwarder.tcpGroupMemberCount(groupId) < groupSize)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        const std::string message(messageSize, 'm');
+        std::vector<char> scratch(messageSize);
+        std::vector<std::chrono::steady_clock::time_point> sentAt(groupCount);
+        LatencyHistogram latencies;
+        for (auto _ : state)
+        {
+            for (size_t group = 0; group < groupCount; group++)
+            {
+                sentAt[group] = std::chrono::steady_clock::now();
+                send(groups[group].front().getSocket(), message.data(), message.size(), MSG_NOSIGNAL);
+            }
+            for (size_t group = 0; group < groupCount; group++)
+            {
+                for (size_t i = 1; i < groupSize; i++)
+                {
+                    if (!receiveExactly(groups[group][i].getSocket(), scratch.data(), scratch.size()))
+                    {
+                        state.SkipWithError("A group member was disconnected.");
+                        break;
+                    }
+                }
+                latencies.record(std::chrono::steady_clock::now() - sentAt[group]);
+            }
+        }
+
+        const size_t deliveries = groupCount * (groupSize - 1);
+        reportForwarding(state, latencies, deliveries, deliveries * messageSize);
+
+        for (std::vector<kt::TCPSocket>& group : groups)
+        {
+            for (kt::TCPSocket& client : group)
+            {
+                client.close();
+            }
+        }
+        forwarder.stop();
+        forwarder.join();
+        serverSocket.close();
+    }
+    // Group sizes against message sizes in a single group, then the amount of groups sharing the workers
+    BENCHMARK(BM_Forwarder_TCPFanOut)->ArgNames({ "group_size", "message_size", "groups" })
+        ->ArgsProduct({ { 2, 10, 100, 1000 }, { 16, 256, 4096, 65536 }, { 1 } })
+        ->ArgsProduct({ { 10 }, { 256 }, { 4, 16, 64 } })
+        ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+    /**
+     * Runs a UDP forwarder over loopback with the provided amount of joined peers. Each iteration sends a message of the provided size from a
+     * client that has not joined, then waits until every peer has received it. Messages that do not arrive within the receive timeout are
+     * counted as lost rather than failing the run, as UDP may drop them when a peer's receive buffer is full.
+     */
+    static void BM_Forwarder_UDPFanOut(benchmark::State& state)
+    {
+        const size_t peerCount = static_cast<size_t>(state.range(0));
+        const size_t messageSize = static_cast<size_t>(state.range(1));
+
+        kt::UDPSocket udpSocket;
+        udpSocket.bind();
+        Forwarder forwarder(std::nullopt, udpSocket, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, false);
+        forwarder.start();
+
+        std::vector<kt::UDPSocket> peers(peerCount);
+        const timeval timeout{ 0, FORWARDER_BENCHMARK_UDP_RECEIVE_TIMEOUT_MICROSECONDS };
+        for (kt::UDPSocket& peer : peers)
+        {
+            peer.bind();
+            setsockopt(peer.getListeningSocket(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            peer.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(peer.getListeningPort().value()));
+        }
+        while (forwarder.udpGroupMemberCount() < peerCount)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const int sender = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        sockaddr_in forwarderAddress{};
+        forwarderAddress.sin_family = AF_INET;
+        forwarderAddress.sin_port = htons(udpSocket.getListeningPort().value());
+        forwarderAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        const std::string message(messageSize, 'm');
+        std::vector<char> scratch(messageSize);
+        LatencyHistogram latencies;
+        size_t lost = 0;
+        for (auto _ : state)
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            sendto(sender, message.data(), message.size(), 0, reinterpret_cast<const sockaddr*>(&forwarderAddress), sizeof(forwarderAddress));
+            bool delivered = true;
+            for (kt::UDPSocket& peer : peers)
+            {
+                if (recv(peer.getListeningSocket(), scratch.data(), scratch.size(), 0) < 0)
+                {
+                    lost++;
+                    delivered = false;
+                }
+            }
+            if (delivered)
+            {
+                latencies.record(std::chrono::steady_clock::now() - start);
+            }
+        }
+
+        reportForwarding(state, latencies, peerCount, peerCount * messageSize);
+        state.counters["lost"] = static_cast<double>(lost);
+
+        close(sender);
+        for (kt::UDPSocket& peer : peers)
+        {
+            peer.close();
+        }
+        forwarder.stop();
+        forwarder.join();
+        udpSocket.close();
+    }
+    BENCHMARK(BM_Forwarder_UDPFanOut)->ArgNames({ "peers", "message_size" })
+        ->ArgsProduct({ { 1, 8, 64, 256 }, { 16, 1024, 8192 } })
+        ->UseRealTime()->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "../../../socket-forwarder/environment/Environment.h"
+#include "../../../socket-forwarder/forwarder/Forwarder.h"
+
+namespace forwarder
+{
+    const size_t IO_ENGINE_BENCHMARK_MESSAGE_SIZE = 256;
+
+    static void receiveExactly(const int descriptor, char* buffer, const size_t amount)
+    {
+        size_t received = 0;
+        while (received < amount)
+        {
+            ssize_t result = recv(descriptor, buffer + received, amount - received, 0);
+            if (result <= 0)
+            {
+                return;
+            }
+            received += static_cast<size_t>(result);
+        }
+    }
+
+    /**
+     * Runs a forwarder with the selected I/O engine and a single group over loopback, each iteration sends a message from one client
+     * and waits until every other client in the group has received it. Reports the messages forwarded per second and the 99th percentile latency.
+     */
+    static void BM_IOEngine_Forward(benchmark::State& state)
+    {
+        const IOEngine engine = state.range(0) == 0 ? IOEngine::Epoll : IOEngine::IoUring;
+        const size_t peerCount = static_cast<size_t>(state.range(1));
+        if (engine == IOEngine::IoUring && !isIoUringSupported())
+        {
+            state.SkipWithError("io_uring is not available on this system.");
+            return;
+        }
+
+        kt::ServerSocket serverSocket(kt::SocketType::Wifi);
+        Forwarder forwarder(serverSocket, std::nullopt, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, false);
+        forwarder.setIOEngine(engine);
+        forwarder.start();
+
+        std::string groupId = "BM_IOEngine_Forward";
+        std::vector<kt::TCPSocket> clients;
+        for (size_t i = 0; i < peerCount + 1; i++)
+        {
+            clients.emplace_back("localhost", serverSocket.getPort());
+            clients.back().send(NEW_CLIENT_PREFIX_DEFAULT + groupId);
+            int enabled = 1;
+            setsockopt(clients.back().getSocket(), IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+        }
+        while (forwarder.tcpGroupMemberCount(groupId) < clients.size())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::string message(IO_ENGINE_BENCHMARK_MESSAGE_SIZE, 'm');
+        std::vector<char> scratch(IO_ENGINE_BENCHMARK_MESSAGE_SIZE);
+        std::vector<double> latencies;
+        for (auto _ : state)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            send(clients[0].getSocket(), message.data(), message.size(), MSG_NOSIGNAL);
+            for (size_t i = 1; i < clients.size(); i++)
+            {
+                receiveExactly(clients[i].getSocket(), scratch.data(), scratch.size());
+            }
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p99_us"] = latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        state.counters["messages_per_second"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+        state.SetLabel(ioEngineToString(engine));
+
+        for (kt::TCPSocket& client : clients)
+        {
+            client.close();
+        }
+        forwarder.stop();
+        forwarder.join();
+        serverSocket.close();
+    }
+    BENCHMARK(BM_IOEngine_Forward)->ArgsProduct({ { 0, 1 }, { 4, 32 } })->UseRealTime();
+}
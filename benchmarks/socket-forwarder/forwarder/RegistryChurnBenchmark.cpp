@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "../../../socket-forwarder/environment/Environment.h"
+#include "../../../socket-forwarder/forwarder/Forwarder.h"
+
+namespace forwarder
+{
+    const size_t REGISTRY_CHURN_BENCHMARK_MESSAGE_SIZE = 256;
+    const size_t REGISTRY_CHURN_BENCHMARK_GROUP_COUNT = 64;
+
+    /**
+     * Forwards messages through a single group on a single worker while, optionally, other clients continuously join and leave
+     * other groups owned by the same worker and another thread continuously reads the group registry.
+     * Comparing the two runs shows how much membership churn costs the forwarding path.
+     */
+    static void BM_Registry_ForwardWhileChurning(benchmark::State& state)
+    {
+        const bool churn = state.range(0) != 0;
+
+        kt::ServerSocket serverSocket(kt::SocketType::Wifi);
+        Forwarder forwarder(serverSocket, std::nullopt, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, false);
+        forwarder.start();
+
+        std::string groupId = "BM_Registry_ForwardWhileChurning";
+        kt::TCPSocket sender("localhost", serverSocket.getPort());
+        kt::TCPSocket receiver("localhost", serverSocket.getPort());
+        sender.send(NEW_CLIENT_PREFIX_DEFAULT + groupId);
+        receiver.send(NEW_CLIENT_PREFIX_DEFAULT + groupId);
+        int enabled = 1;
+        setsockopt(sender.getSocket(), IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+        while (forwarder.tcpGroupMemberCount(groupId) < 2)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::atomic<bool> running{ true };
+        std::atomic<uint64_t> joins{ 0 };
+        std::vector<std::thread> threads;
+        if (churn)
+        {
+            threads.emplace_back([&]()
+            {
+                for (size_t i = 0; running; i++)
+                {
+                    kt::TCPSocket client("localhost", serverSocket.getPort());
+                    client.send(NEW_CLIENT_PREFIX_DEFAULT + "churn-" + std::to_string(i % REGISTRY_CHURN_BENCHMARK_GROUP_COUNT));
+                    client.close();
+                    joins++;
+                }
+            });
+            threads.emplace_back([&]()
+            {
+                while (running)
+                {
+                    for (size_t i = 0; i < REGISTRY_CHURN_BENCHMARK_GROUP_COUNT; i++)
+                    {
+                        std::string churnGroupId = "churn-" + std::to_string(i);
+                        benchmark::DoNotOptimize(forwarder.tcpGroupMemberCount(churnGroupId));
+                    }
+                }
+            });
+        }
+
+        std::string message(REGISTRY_CHURN_BENCHMARK_MESSAGE_SIZE, 'm');
+        std::vector<char> scratch(REGISTRY_CHURN_BENCHMARK_MESSAGE_SIZE);
+        for (auto _ : state)
+        {
+            send(sender.getSocket(), message.data(), message.size(), MSG_NOSIGNAL);
+            size_t received = 0;
+            while (received < scratch.size())
+            {
+                ssize_t result = recv(receiver.getSocket(), scratch.data() + received, scratch.size() - received, 0);
+                if (result <= 0)
+                {
+                    break;
+                }
+                received += static_cast<size_t>(result);
+            }
+        }
+
+        running = false;
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        state.counters["messages_per_second"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+        state.counters["joins_per_second"] = benchmark::Counter(static_cast<double>(joins.load()), benchmark::Counter::kIsRate);
+        state.SetLabel(churn ? "churning" : "idle");
+
+        sender.close();
+        receiver.close();
+        forwarder.stop();
+        forwarder.join();
+        serverSocket.close();
+    }
+    BENCHMARK(BM_Registry_ForwardWhileChurning)->Arg(0)->Arg(1)->UseRealTime();
+}
@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <fstream>
+
+#include "../../../socket-forwarder/logging/Logger.h"
+
+namespace forwarder
+{
+    // Flushed this often, outside of the timed region, so the ring never fills and every timed call writes a record
+    const size_t LOGGER_BENCHMARK_FLUSH_INTERVAL = LOG_RING_CAPACITY / 2;
+
+    /**
+     * The cost paid by the forwarding thread for a typical message, the budget for this is 100ns per call.
+     */
+    static void BM_Logger_Log(benchmark::State& state)
+    {
+        std::ofstream output("/dev/null");
+        Logger logger(output);
+        std::string groupId = "BM_Logger_Log-group";
+
+        size_t logged = 0;
+        for (auto _ : state)
+        {
+            logger.log(LogLevel::Info, "[TCP] - Group [", groupId, "] - Peer [", 42, "] exceeded its outbound queue limits with [", logged, "] bytes queued, disconnecting.");
+            if (++logged % LOGGER_BENCHMARK_FLUSH_INTERVAL == 0)
+            {
+                state.PauseTiming();
+                logger.flush();
+                state.ResumeTiming();
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_Logger_Log);
+
+    /**
+     * The cost of a message below the logger's level, e.g. a debug message in production.
+     */
+    static void BM_Logger_LogBelowLevel(benchmark::State& state)
+    {
+        std::ofstream output("/dev/null");
+        Logger logger(output);
+        std::string groupId = "BM_Logger_LogBelowLevel-group";
+
+        size_t logged = 0;
+        for (auto _ : state)
+        {
+            logger.log(LogLevel::Debug, "[TCP] - Group [", groupId, "] - Peer [", 42, "] queued [", logged++, "] bytes.");
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_Logger_LogBelowLevel);
+
+    /**
+     * The same message formatted and written on the calling thread, as the forwarder did before logging moved to a background thread.
+     */
+    static void BM_Logger_OstreamBaseline(benchmark::State& state)
+    {
+        std::ofstream output("/dev/null");
+        std::string groupId = "BM_Logger_OstreamBaseline-group";
+
+        size_t logged = 0;
+        for (auto _ : state)
+        {
+            output << "[TCP] - Group [" << groupId << "] - Peer [" << 42 << "] exceeded its outbound queue limits with [" << logged++ << "] bytes queued, disconnecting.\n" << std::flush;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_Logger_OstreamBaseline);
+}
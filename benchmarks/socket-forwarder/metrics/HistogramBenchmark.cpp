@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../../../socket-forwarder/metrics/Histogram.h"
+
+namespace forwarder
+{
+    /**
+     * Records a value into the histogram, which is paid for every interval of every forwarded message.
+     */
+    static void BM_LatencyHistogram_Record(benchmark::State& state)
+    {
+        LatencyHistogram histogram;
+        uint64_t value = 1;
+        for (auto _ : state)
+        {
+            histogram.record(value);
+            // Spread the values over the buckets that forwarding latencies usually land in
+            value = value * 7 % 1000003;
+        }
+        benchmark::DoNotOptimize(histogram.snapshot().count);
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_LatencyHistogram_Record);
+
+    /**
+     * Records an interval the way the forwarder does, including the clock read that ends it.
+     */
+    static void BM_LatencyHistogram_RecordElapsed(benchmark::State& state)
+    {
+        LatencyHistogram histogram;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (auto _ : state)
+        {
+            histogram.record(std::chrono::steady_clock::now() - start);
+        }
+        benchmark::DoNotOptimize(histogram.snapshot().count);
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_LatencyHistogram_RecordElapsed);
+}
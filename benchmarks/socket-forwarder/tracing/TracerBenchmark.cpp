@@ -0,0 +1,27 @@
+#include <benchmark/benchmark.h>
+
+#include "../../../socket-forwarder/tracing/Tracer.h"
+
+namespace forwarder
+{
+    /**
+     * Traces a message the way the forwarder does, a receive and a send to each of 4 peers, with the provided sample rate.
+     * A rate of 0 is the cost paid by every message when tracing is disabled.
+     */
+    static void BM_Tracer_TraceMessage(benchmark::State& state)
+    {
+        Tracer tracer(static_cast<uint64_t>(state.range(0)));
+        for (auto _ : state)
+        {
+            const uint64_t traceId = tracer.sample();
+            tracer.record(traceId, TraceEventType::Receive, 1, 256);
+            for (int peer = 2; peer < 6; peer++)
+            {
+                tracer.record(traceId, TraceEventType::Send, peer, 256);
+            }
+            benchmark::DoNotOptimize(traceId);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_Tracer_TraceMessage)->Arg(0)->Arg(1024)->Arg(1);
+}
@@ -0,0 +1,226 @@
+#include "DatagramBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+namespace forwarder
+{
+    // Room for a single control message carrying an int, the size the kernel uses for UDP_GRO
+    const size_t DATAGRAM_CONTROL_SIZE = CMSG_SPACE(sizeof(int));
+
+    /**
+     * Allocates room for the provided amount of datagrams, each up to the provided size in bytes.
+     */
+    DatagramReceiveBatch::DatagramReceiveBatch(const size_t batchSize, const size_t maxDatagramSize)
+        : datagramCapacity(maxDatagramSize), storage(batchSize * maxDatagramSize), vectors(batchSize), messages(batchSize), addresses(batchSize),
+        controls(batchSize * DATAGRAM_CONTROL_SIZE)
+    {
+        for (size_t i = 0; i < batchSize; i++)
+        {
+            vectors[i].iov_base = storage.data() + i * maxDatagramSize;
+            vectors[i].iov_len = maxDatagramSize;
+            std::memset(&messages[i], 0, sizeof(mmsghdr));
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_control = controls.data() + i * DATAGRAM_CONTROL_SIZE;
+        }
+    }
+
+    /**
+     * Receives as many datagrams as are already queued on the socket, up to the batch's capacity, without blocking.
+     * Returns the amount received, or -1 with errno set, EAGAIN when nothing was queued.
+     */
+    int DatagramReceiveBatch::receive(const int descriptor)
+    {
+        for (size_t i = 0; i < messages.size(); i++)
+        {
+            // The kernel overwrites the address length, control length and flags of every header it fills
+            messages[i].msg_hdr.msg_namelen = sizeof(kt::SocketAddress);
+            messages[i].msg_hdr.msg_controllen = DATAGRAM_CONTROL_SIZE;
+            messages[i].msg_hdr.msg_flags = 0;
+        }
+        return recvmmsg(descriptor, messages.data(), static_cast<unsigned int>(messages.size()), MSG_DONTWAIT, nullptr);
+    }
+
+    size_t DatagramReceiveBatch::capacity() const
+    {
+        return messages.size();
+    }
+
+    const char* DatagramReceiveBatch::data(const size_t index) const
+    {
+        return static_cast<const char*>(vectors[index].iov_base);
+    }
+
+    /**
+     * Returns the amount of bytes of the datagram held by the batch, a datagram larger than the batch's datagram size is cut off at that size.
+     */
+    size_t DatagramReceiveBatch::size(const size_t index) const
+    {
+        return std::min<size_t>(messages[index].msg_len, datagramCapacity);
+    }
+
+    bool DatagramReceiveBatch::truncated(const size_t index) const
+    {
+        return (messages[index].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    }
+
+    /**
+     * Returns the size of each datagram coalesced into the provided one when UDP_GRO is enabled on the socket, the last may be smaller.
+     * Returns 0 for a datagram that was received as it was sent.
+     */
+    size_t DatagramReceiveBatch::segmentSize(const size_t index) const
+    {
+        const msghdr& header = messages[index].msg_hdr;
+        for (const cmsghdr* control = CMSG_FIRSTHDR(&header); control != nullptr; control = CMSG_NXTHDR(const_cast<msghdr*>(&header), const_cast<cmsghdr*>(control)))
+        {
+            if (control->cmsg_level == SOL_UDP && control->cmsg_type == UDP_GRO)
+            {
+                int size = 0;
+                std::memcpy(&size, CMSG_DATA(control), sizeof(size));
+                return static_cast<size_t>(size);
+            }
+        }
+        return 0;
+    }
+
+    const kt::SocketAddress& DatagramReceiveBatch::address(const size_t index) const
+    {
+        return addresses[index];
+    }
+
+    DatagramSendBatch::DatagramSendBatch(const size_t batchSize) : messages(batchSize), tags(batchSize), results(batchSize), controls(batchSize * DATAGRAM_CONTROL_SIZE)
+    {
+        std::memset(messages.data(), 0, batchSize * sizeof(mmsghdr));
+    }
+
+    /**
+     * Queues the payload to be sent to the provided address, returns false if the batch is full.
+     */
+    bool DatagramSendBatch::add(iovec* payload, const kt::SocketAddress& address, const size_t entryTag)
+    {
+        return add(payload, 1, 0, address, entryTag);
+    }
+
+    /**
+     * Queues the provided amount of consecutive payloads to be sent to the provided address as separate datagrams with a single UDP_SEGMENT
+     * send, every payload but the last must be exactly the segment size. Returns false if the batch is full.
+     */
+    bool DatagramSendBatch::add(iovec* payloads, const size_t payloadCount, const uint16_t segmentSize, const kt::SocketAddress& address, const size_t entryTag)
+    {
+        if (full())
+        {
+            return false;
+        }
+        msghdr& header = messages[entries].msg_hdr;
+        header.msg_iov = payloads;
+        header.msg_iovlen = payloadCount;
+        header.msg_control = nullptr;
+        header.msg_controllen = 0;
+        if (payloadCount > 1)
+        {
+            header.msg_control = controls.data() + entries * DATAGRAM_CONTROL_SIZE;
+            header.msg_controllen = CMSG_SPACE(sizeof(segmentSize));
+            cmsghdr* control = CMSG_FIRSTHDR(&header);
+            control->cmsg_level = SOL_UDP;
+            control->cmsg_type = UDP_SEGMENT;
+            control->cmsg_len = CMSG_LEN(sizeof(segmentSize));
+            std::memcpy(CMSG_DATA(control), &segmentSize, sizeof(segmentSize));
+        }
+        // The kernel only reads the address when sending
+        header.msg_name = const_cast<kt::SocketAddress*>(&address);
+        header.msg_namelen = kt::getAddressLength(address);
+        tags[entries] = entryTag;
+        results[entries] = false;
+        entries++;
+        return true;
+    }
+
+    /**
+     * Sends the entries that have not been sent yet with a single sendmmsg() call. The kernel stops at the first entry it fails to send,
+     * that entry is marked as failed so the next call carries on from the entry after it.
+     * Returns the amount of entries sent, or -1 with errno set if the first remaining entry failed.
+     */
+    int DatagramSendBatch::send(const int descriptor)
+    {
+        if (remaining() == 0)
+        {
+            return 0;
+        }
+
+        const int result = sendmmsg(descriptor, messages.data() + completedEntries, static_cast<unsigned int>(remaining()), MSG_NOSIGNAL);
+        if (result < 0)
+        {
+            results[completedEntries] = false;
+            completedEntries++;
+            return result;
+        }
+        for (int i = 0; i < result; i++)
+        {
+            results[completedEntries + i] = true;
+        }
+        completedEntries += static_cast<size_t>(result);
+        return result;
+    }
+
+    void DatagramSendBatch::clear()
+    {
+        entries = 0;
+        completedEntries = 0;
+    }
+
+    size_t DatagramSendBatch::capacity() const
+    {
+        return messages.size();
+    }
+
+    size_t DatagramSendBatch::size() const
+    {
+        return entries;
+    }
+
+    bool DatagramSendBatch::full() const
+    {
+        return entries == messages.size();
+    }
+
+    /**
+     * Returns the amount of entries that have been sent or failed, these are always the first entries of the batch.
+     */
+    size_t DatagramSendBatch::completed() const
+    {
+        return completedEntries;
+    }
+
+    size_t DatagramSendBatch::remaining() const
+    {
+        return entries - completedEntries;
+    }
+
+    size_t DatagramSendBatch::tag(const size_t index) const
+    {
+        return tags[index];
+    }
+
+    /**
+     * Returns the amount of payloads, and so datagrams, the provided entry sends.
+     */
+    size_t DatagramSendBatch::segments(const size_t index) const
+    {
+        return messages[index].msg_hdr.msg_iovlen;
+    }
+
+    bool DatagramSendBatch::sent(const size_t index) const
+    {
+        return results[index];
+    }
+
+    const kt::SocketAddress& DatagramSendBatch::address(const size_t index) const
+    {
+        return *static_cast<const kt::SocketAddress*>(messages[index].msg_hdr.msg_name);
+    }
+}
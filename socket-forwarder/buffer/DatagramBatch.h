@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <socket/UDPSocket.h>
+
+namespace forwarder
+{
+    /**
+     * A fixed set of datagram buffers filled by a single recvmmsg() call.
+     * The buffers, vectors, message headers and source addresses are allocated once up front and reused by every receive, the message headers
+     * point into the other arrays so the batch can be neither copied nor moved.
+     */
+    class DatagramReceiveBatch
+    {
+    protected:
+        size_t datagramCapacity;
+        std::vector<char> storage;
+        std::vector<iovec> vectors;
+        std::vector<mmsghdr> messages;
+        std::vector<kt::SocketAddress> addresses;
+        // Room for each datagram's UDP_GRO control message
+        std::vector<char> controls;
+
+    public:
+        DatagramReceiveBatch(const size_t, const size_t);
+        DatagramReceiveBatch(const DatagramReceiveBatch&) = delete;
+        DatagramReceiveBatch& operator=(const DatagramReceiveBatch&) = delete;
+
+        int receive(const int);
+
+        size_t capacity() const;
+        const char* data(const size_t) const;
+        size_t size(const size_t) const;
+        bool truncated(const size_t) const;
+        size_t segmentSize(const size_t) const;
+        const kt::SocketAddress& address(const size_t) const;
+    };
+
+    /**
+     * A set of datagrams sent with as few sendmmsg() calls as possible, each addressed to its own peer.
+     * Entries only point at their payload and address, so a payload sent to many peers is shared by all of its entries without being copied,
+     * the payload and the address must stay valid until the batch is sent. Each entry carries a tag identifying what it was sent for.
+     * An entry can hold several payloads, which the kernel splits into one datagram per payload (UDP_SEGMENT).
+     */
+    class DatagramSendBatch
+    {
+    protected:
+        std::vector<mmsghdr> messages;
+        std::vector<size_t> tags;
+        std::vector<bool> results;
+        // Room for each entry's UDP_SEGMENT control message
+        std::vector<char> controls;
+        size_t entries = 0;
+        size_t completedEntries = 0;
+
+    public:
+        DatagramSendBatch(const size_t);
+        DatagramSendBatch(const DatagramSendBatch&) = delete;
+        DatagramSendBatch& operator=(const DatagramSendBatch&) = delete;
+
+        bool add(iovec*, const kt::SocketAddress&, const size_t);
+        bool add(iovec*, const size_t, const uint16_t, const kt::SocketAddress&, const size_t);
+        int send(const int);
+        void clear();
+
+        size_t capacity() const;
+        size_t size() const;
+        bool full() const;
+        size_t completed() const;
+        size_t remaining() const;
+        size_t tag(const size_t) const;
+        size_t segments(const size_t) const;
+        bool sent(const size_t) const;
+        const kt::SocketAddress& address(const size_t) const;
+    };
+}
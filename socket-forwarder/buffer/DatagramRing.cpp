@@ -0,0 +1,224 @@
+#include "DatagramRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace forwarder
+{
+    std::optional<OverflowPolicy> parseOverflowPolicy(const std::string& policy)
+    {
+        if (policy == "drop_oldest")
+        {
+            return std::make_optional(OverflowPolicy::DropOldest);
+        }
+        else if (policy == "drop_newest")
+        {
+            return std::make_optional(OverflowPolicy::DropNewest);
+        }
+        return std::nullopt;
+    }
+
+    std::string overflowPolicyToString(const OverflowPolicy policy)
+    {
+        switch (policy)
+        {
+            case OverflowPolicy::DropOldest:
+                return "drop_oldest";
+            default:
+                return "drop_newest";
+        }
+    }
+
+    /**
+     * Allocates the slots up front, the requested amount of slots is rounded up to a power of 2. Datagrams larger than the slot size are cut off.
+     */
+    DatagramRing::DatagramRing(const size_t requestedCapacity, const size_t datagramSize, const OverflowPolicy overflowPolicy)
+        : slotSize(datagramSize), policy(overflowPolicy)
+    {
+        size_t slotCount = 2;
+        while (slotCount < requestedCapacity)
+        {
+            slotCount <<= 1;
+        }
+        mask = slotCount - 1;
+        slots = std::make_unique<DatagramSlot[]>(slotCount);
+        storage.resize(slotCount * slotSize);
+        for (size_t i = 0; i < slotCount; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+            slots[i].data = storage.data() + i * slotSize;
+        }
+    }
+
+    /**
+     * Copies the datagram into the next free slot. If the ring is full the overflow policy decides whether the new datagram or the oldest queued
+     * one is dropped. The oldest datagram can only be dropped while it is still queued, if the consumer already holds it the new one is dropped instead.
+     */
+    DatagramPushResult DatagramRing::push(const char* data, const size_t size, const kt::SocketAddress& address, const std::chrono::steady_clock::time_point receivedAt, const uint32_t channel)
+    {
+        DatagramPushResult result;
+        const size_t amount = std::min(size, slotSize);
+        bool droppedOldest = false;
+        size_t position = tail.load(std::memory_order_relaxed);
+        DatagramSlot* slot = nullptr;
+        while (true)
+        {
+            slot = &slots[position & mask];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Only a single datagram is dropped to make room, if another producer takes the freed slot first the new datagram is dropped
+                if (policy == OverflowPolicy::DropOldest && !droppedOldest && tryDropOldest(position, result))
+                {
+                    droppedOldest = true;
+                    position = tail.load(std::memory_order_relaxed);
+                    continue;
+                }
+                result.droppedMessages++;
+                result.droppedBytes += size;
+                droppedMessages.fetch_add(1, std::memory_order_relaxed);
+                droppedBytes.fetch_add(size, std::memory_order_relaxed);
+                return result;
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        std::memcpy(slot->data, data, amount);
+        slot->size = amount;
+        slot->address = address;
+        slot->receivedAt = receivedAt;
+        slot->channel = channel;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        result.queued = true;
+
+        // Pairs with the fence in wait(), either the consumer sees this datagram before sleeping or this sees the consumer waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumerWaiting.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            waitCondition.notify_one();
+        }
+        return result;
+    }
+
+    /**
+     * Takes the oldest datagram out of the ring and frees its slot, provided it is the datagram in the slot the producer at the provided position needs.
+     */
+    bool DatagramRing::tryDropOldest(const size_t position, DatagramPushResult& result)
+    {
+        const size_t oldest = position - capacity();
+        DatagramSlot& slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != oldest + 1)
+        {
+            return false;
+        }
+        size_t expected = oldest;
+        if (!head.compare_exchange_strong(expected, oldest + 1, std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        result.droppedMessages++;
+        result.droppedBytes += slot.size;
+        result.evicted = true;
+        result.evictedChannel = slot.channel;
+        result.evictedBytes = slot.size;
+        droppedMessages.fetch_add(1, std::memory_order_relaxed);
+        droppedBytes.fetch_add(slot.size, std::memory_order_relaxed);
+        slot.sequence.store(position, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Takes the oldest queued datagram, returns nullptr if there is none. The slot must be released once its datagram is no longer needed.
+     */
+    DatagramSlot* DatagramRing::acquire()
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            DatagramSlot& slot = slots[position & mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.position = position;
+                    return &slot;
+                }
+            }
+            else if (difference < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void DatagramRing::release(DatagramSlot* slot)
+    {
+        slot->sequence.store(slot->position + capacity(), std::memory_order_release);
+    }
+
+    /**
+     * Blocks until a datagram is queued or the timeout passes, returns whether a datagram is queued.
+     */
+    bool DatagramRing::wait(const std::chrono::milliseconds timeout)
+    {
+        if (!empty())
+        {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(waitMutex);
+        consumerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool ready = waitCondition.wait_for(lock, timeout, [this]() { return !empty(); });
+        consumerWaiting.store(false, std::memory_order_relaxed);
+        return ready;
+    }
+
+    size_t DatagramRing::capacity() const
+    {
+        return mask + 1;
+    }
+
+    size_t DatagramRing::getSlotSize() const
+    {
+        return slotSize;
+    }
+
+    /**
+     * Returns true if the next datagram is not ready to be acquired, including while a producer is still copying it in.
+     */
+    bool DatagramRing::empty() const
+    {
+        const size_t position = head.load(std::memory_order_acquire);
+        return slots[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    uint64_t DatagramRing::getDroppedMessages() const
+    {
+        return droppedMessages.load(std::memory_order_relaxed);
+    }
+
+    uint64_t DatagramRing::getDroppedBytes() const
+    {
+        return droppedBytes.load(std::memory_order_relaxed);
+    }
+}
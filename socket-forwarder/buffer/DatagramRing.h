@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <socket/UDPSocket.h>
+
+namespace forwarder
+{
+    /**
+     * What to do with a datagram received while the UDP forwarding queue is full.
+     */
+    enum class OverflowPolicy
+    {
+        // Drop the oldest queued datagram to make room for the new one
+        DropOldest,
+        // Drop the new datagram
+        DropNewest
+    };
+
+    std::optional<OverflowPolicy> parseOverflowPolicy(const std::string&);
+    std::string overflowPolicyToString(const OverflowPolicy);
+
+    /**
+     * A datagram held in the ring, along with the address it was received from, when it was received and its channel.
+     */
+    struct alignas(64) DatagramSlot
+    {
+        std::atomic<size_t> sequence{ 0 };
+        // The position the slot was taken from, so it can be handed back to the producers
+        size_t position = 0;
+        size_t size = 0;
+        kt::SocketAddress address{};
+        std::chrono::steady_clock::time_point receivedAt;
+        // Identifies who the datagram is for, e.g. the group it was sent to
+        uint32_t channel = 0;
+        char* data = nullptr;
+    };
+
+    struct DatagramPushResult
+    {
+        bool queued = false;
+        // The datagrams dropped by the push, the new datagram, the oldest queued one or both
+        uint64_t droppedMessages = 0;
+        uint64_t droppedBytes = 0;
+        // Whether the oldest queued datagram was dropped to make room, it may belong to another channel than the new datagram
+        bool evicted = false;
+        uint32_t evictedChannel = 0;
+        size_t evictedBytes = 0;
+    };
+
+    /**
+     * A bounded queue of datagrams in preallocated fixed-size slots, so neither queueing nor memory use grows with the amount of traffic.
+     * Each slot has a sequence number telling whether it is free, holds a datagram, or has been taken, so producers and the consumer never lock
+     * (Vyukov's bounded queue). Any number of threads may push, dropping the oldest datagram takes it the same way the consumer does.
+     * Only a single thread may acquire and release slots, a slot stays with the consumer until released so its datagram is never copied out.
+     */
+    class DatagramRing
+    {
+    protected:
+        size_t mask;
+        size_t slotSize;
+        OverflowPolicy policy;
+        std::unique_ptr<DatagramSlot[]> slots;
+        std::vector<char> storage;
+
+        alignas(64) std::atomic<size_t> head{ 0 };
+        alignas(64) std::atomic<size_t> tail{ 0 };
+        alignas(64) std::atomic<uint64_t> droppedMessages{ 0 };
+        std::atomic<uint64_t> droppedBytes{ 0 };
+
+        // The consumer only sleeps once the ring is empty, producers only take the lock to wake it while it is sleeping
+        std::atomic<bool> consumerWaiting{ false };
+        std::mutex waitMutex;
+        std::condition_variable waitCondition;
+
+        bool tryDropOldest(const size_t, DatagramPushResult&);
+
+    public:
+        DatagramRing(const size_t, const size_t, const OverflowPolicy);
+        DatagramRing(const DatagramRing&) = delete;
+        DatagramRing& operator=(const DatagramRing&) = delete;
+
+        DatagramPushResult push(const char*, const size_t, const kt::SocketAddress&, const std::chrono::steady_clock::time_point, const uint32_t);
+        DatagramSlot* acquire();
+        void release(DatagramSlot*);
+        bool wait(const std::chrono::milliseconds);
+
+        size_t capacity() const;
+        size_t getSlotSize() const;
+        bool empty() const;
+        uint64_t getDroppedMessages() const;
+        uint64_t getDroppedBytes() const;
+    };
+}
@@ -0,0 +1,157 @@
+#include "MessageBuffer.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+
+namespace forwarder
+{
+    BufferPool::BufferPool(const size_t capacity): bufferCapacity(capacity) { }
+
+    MessageBuffer* BufferPool::acquire()
+    {
+        MessageBuffer* buffer;
+        if (available.empty())
+        {
+            allocated.push_back(std::make_unique<MessageBuffer>());
+            buffer = allocated.back().get();
+            buffer->data.resize(bufferCapacity);
+        }
+        else
+        {
+            buffer = available.back();
+            available.pop_back();
+        }
+
+        buffer->size = 0;
+        buffer->references = 1;
+        return buffer;
+    }
+
+    void BufferPool::retain(MessageBuffer* buffer)
+    {
+        buffer->references++;
+    }
+
+    void BufferPool::release(MessageBuffer* buffer)
+    {
+        if (--buffer->references == 0)
+        {
+            // Buffers grown to hold a large frame are shrunk back, so the pool does not keep the memory of every large frame it has seen
+            if (buffer->data.size() > bufferCapacity)
+            {
+                buffer->data.resize(bufferCapacity);
+                buffer->data.shrink_to_fit();
+            }
+            available.push_back(buffer);
+        }
+    }
+
+    size_t BufferPool::getAllocatedCount() const
+    {
+        return allocated.size();
+    }
+
+    size_t BufferPool::getAvailableCount() const
+    {
+        return available.size();
+    }
+
+    /**
+     * Records a successful MSG_ZEROCOPY send of the provided buffer, the buffer is retained until its completion is reported.
+     */
+    void ZeroCopyTracker::sent(MessageBuffer* buffer, BufferPool& pool)
+    {
+        sent(&buffer, 1, pool);
+    }
+
+    /**
+     * Records a single successful MSG_ZEROCOPY send that covered all of the provided buffers, so they share one sequence number.
+     */
+    void ZeroCopyTracker::sent(MessageBuffer* const* buffers, const size_t count, BufferPool& pool)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            pool.retain(buffers[i]);
+            pending.emplace_back(nextSequence, buffers[i]);
+        }
+        nextSequence++;
+    }
+
+    /**
+     * Releases every buffer with a sequence number in the completed inclusive range [lower, upper].
+     * The range usually starts at the oldest pending send, but the kernel does not guarantee completions are reported in order,
+     * so sends before the lower bound are kept until their own completion arrives.
+     */
+    size_t ZeroCopyTracker::complete(const uint32_t lower, const uint32_t upper, BufferPool& pool)
+    {
+        size_t released = 0;
+        // Pending sends are in sequence order. Compare using the signed distance so this still works when the 32 bit sequence wraps around
+        std::deque<std::pair<uint32_t, MessageBuffer*>>::iterator entry = pending.begin();
+        while (entry != pending.end() && static_cast<int32_t>(upper - entry->first) >= 0)
+        {
+            if (static_cast<int32_t>(entry->first - lower) < 0)
+            {
+                ++entry;
+                continue;
+            }
+            pool.release(entry->second);
+            entry = pending.erase(entry);
+            released++;
+        }
+        return released;
+    }
+
+    void ZeroCopyTracker::releaseAll(BufferPool& pool)
+    {
+        for (std::pair<uint32_t, MessageBuffer*>& entry : pending)
+        {
+            pool.release(entry.second);
+        }
+        pending.clear();
+    }
+
+    size_t ZeroCopyTracker::getPendingCount() const
+    {
+        return pending.size();
+    }
+
+    bool enableZeroCopy(const int descriptor)
+    {
+        const int enabled = 1;
+        return setsockopt(descriptor, SOL_SOCKET, SO_ZEROCOPY, &enabled, sizeof(enabled)) == 0;
+    }
+
+    /**
+     * Drains the error queue of the provided socket and releases the buffers of every completed zero copy send.
+     * Returns the amount of buffers released.
+     */
+    size_t readZeroCopyCompletions(const int descriptor, ZeroCopyTracker& tracker, BufferPool& pool)
+    {
+        size_t released = 0;
+        char control[128];
+        while (true)
+        {
+            msghdr message{};
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            if (recvmsg(descriptor, &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+            {
+                break;
+            }
+
+            for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+            {
+                if ((header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR) || (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR))
+                {
+                    const sock_extended_err* error = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+                    if (error->ee_errno == 0 && error->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+                    {
+                        released += tracker.complete(error->ee_info, error->ee_data, pool);
+                    }
+                }
+            }
+        }
+        return released;
+    }
+}
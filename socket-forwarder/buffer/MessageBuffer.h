@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace forwarder
+{
+    /**
+     * A single received message which is shared by every send that forwards it.
+     * The reference count is not atomic, a buffer must only be used by the thread that owns its BufferPool.
+     */
+    struct MessageBuffer
+    {
+        std::vector<char> data;
+        size_t size = 0;
+        size_t references = 0;
+    };
+
+    /**
+     * Recycles MessageBuffers so that forwarding a message does not need to allocate.
+     * A buffer acquired from the pool starts with a single reference and is returned to the pool once all references are released.
+     */
+    class BufferPool
+    {
+    protected:
+        size_t bufferCapacity;
+        std::vector<std::unique_ptr<MessageBuffer>> allocated;
+        std::vector<MessageBuffer*> available;
+
+    public:
+        BufferPool(const size_t = 0);
+
+        MessageBuffer* acquire();
+        void retain(MessageBuffer*);
+        void release(MessageBuffer*);
+
+        size_t getAllocatedCount() const;
+        size_t getAvailableCount() const;
+    };
+
+    /**
+     * Keeps buffers alive while the kernel still references them after a MSG_ZEROCOPY send on a single socket.
+     * The kernel numbers each successful zero copy send on a socket sequentially from 0, and reports completed ranges of these numbers on the socket's error queue.
+     */
+    class ZeroCopyTracker
+    {
+    protected:
+        uint32_t nextSequence = 0;
+        std::deque<std::pair<uint32_t, MessageBuffer*>> pending;
+
+    public:
+        void sent(MessageBuffer*, BufferPool&);
+        void sent(MessageBuffer* const*, const size_t, BufferPool&);
+        size_t complete(const uint32_t, const uint32_t, BufferPool&);
+        void releaseAll(BufferPool&);
+
+        size_t getPendingCount() const;
+    };
+
+    bool enableZeroCopy(const int);
+    size_t readZeroCopyCompletions(const int, ZeroCopyTracker&, BufferPool&);
+}
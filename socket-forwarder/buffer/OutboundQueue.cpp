@@ -0,0 +1,382 @@
+#include "OutboundQueue.h"
+
+#include <cerrno>
+#include <algorithm>
+#include <climits>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace forwarder
+{
+    std::optional<SlowConsumerPolicy> parseSlowConsumerPolicy(const std::string& policy)
+    {
+        if (policy == "drop_oldest")
+        {
+            return std::make_optional(SlowConsumerPolicy::DropOldest);
+        }
+        else if (policy == "drop_newest")
+        {
+            return std::make_optional(SlowConsumerPolicy::DropNewest);
+        }
+        else if (policy == "disconnect")
+        {
+            return std::make_optional(SlowConsumerPolicy::Disconnect);
+        }
+        return std::nullopt;
+    }
+
+    std::string slowConsumerPolicyToString(const SlowConsumerPolicy policy)
+    {
+        switch (policy)
+        {
+            case SlowConsumerPolicy::DropOldest:
+                return "drop_oldest";
+            case SlowConsumerPolicy::DropNewest:
+                return "drop_newest";
+            default:
+                return "disconnect";
+        }
+    }
+
+    MessageDelivery* DeliveryPool::acquire(const std::chrono::steady_clock::time_point receivedAt)
+    {
+        MessageDelivery* delivery;
+        if (available.empty())
+        {
+            allocated.push_back(std::make_unique<MessageDelivery>());
+            delivery = allocated.back().get();
+        }
+        else
+        {
+            delivery = available.back();
+            available.pop_back();
+        }
+
+        delivery->receivedAt = receivedAt;
+        delivery->pendingSends = 1;
+        delivery->firstSendRecorded = false;
+        delivery->incomplete = false;
+        return delivery;
+    }
+
+    void DeliveryPool::release(MessageDelivery* delivery)
+    {
+        if (--delivery->pendingSends == 0)
+        {
+            available.push_back(delivery);
+        }
+    }
+
+    size_t DeliveryPool::getAllocatedCount() const
+    {
+        return allocated.size();
+    }
+
+    size_t DeliveryPool::getAvailableCount() const
+    {
+        return available.size();
+    }
+
+    void OutboundQueue::setLatencies(const DeliveryLatencies& deliveryLatencies)
+    {
+        latencies = deliveryLatencies;
+    }
+
+    /**
+     * Marks a queued message as never going to be written by this queue, so its delivery is not recorded as having reached every peer.
+     */
+    void OutboundQueue::abandon(const QueuedMessage& message)
+    {
+        if (message.delivery != nullptr)
+        {
+            message.delivery->incomplete = true;
+            latencies.deliveries->release(message.delivery);
+        }
+    }
+
+    void OutboundQueue::markIncomplete(MessageDelivery* delivery)
+    {
+        if (delivery != nullptr)
+        {
+            delivery->incomplete = true;
+        }
+    }
+
+    /**
+     * Records the latencies of a message that has been fully written, then releases this queue's pending send of the message's delivery.
+     */
+    void OutboundQueue::recordDelivered(const QueuedMessage& message, const std::chrono::steady_clock::time_point now)
+    {
+        if (latencies.peerSend != nullptr)
+        {
+            latencies.peerSend->record(now - message.queuedAt);
+        }
+        MessageDelivery* delivery = message.delivery;
+        if (delivery == nullptr)
+        {
+            return;
+        }
+        if (!delivery->firstSendRecorded && latencies.receiveToFirstSend != nullptr)
+        {
+            delivery->firstSendRecorded = true;
+            latencies.receiveToFirstSend->record(now - delivery->receivedAt);
+        }
+        if (delivery->pendingSends == 1 && !delivery->incomplete && latencies.receiveToLastSend != nullptr)
+        {
+            latencies.receiveToLastSend->record(now - delivery->receivedAt);
+        }
+        latencies.deliveries->release(delivery);
+    }
+
+    void OutboundQueue::drop(const size_t index, BufferPool& pool)
+    {
+        MessageBuffer* buffer = messages[index].buffer;
+        queuedBytes -= buffer->size;
+        droppedMessages++;
+        droppedBytes += buffer->size;
+        abandon(messages[index]);
+        pool.release(buffer);
+        messages.erase(messages.begin() + index);
+    }
+
+    /**
+     * Queues the provided message, applying the slow consumer policy when the queue is over its byte limit or its oldest message
+     * has been queued for longer than the lag limit (a limit of 0 is unlimited).
+     * Returns whether the message was queued, and whether older messages were dropped for it, or why it was not.
+     */
+    PushResult OutboundQueue::push(MessageBuffer* buffer, BufferPool& pool, const SlowConsumerPolicy policy, const size_t maxQueuedBytes, const std::chrono::milliseconds maxLag, const std::chrono::steady_clock::time_point now, MessageDelivery* delivery)
+    {
+        const bool overLag = maxLag.count() > 0 && !messages.empty() && getLag(now) > maxLag;
+        const bool overSize = maxQueuedBytes > 0 && queuedBytes + buffer->size > maxQueuedBytes;
+        const uint64_t droppedBefore = droppedMessages;
+
+        if (overLag || overSize)
+        {
+            if (policy == SlowConsumerPolicy::Disconnect)
+            {
+                markIncomplete(delivery);
+                return PushResult::Disconnect;
+            }
+            else if (policy == SlowConsumerPolicy::DropNewest)
+            {
+                droppedMessages++;
+                droppedBytes += buffer->size;
+                markIncomplete(delivery);
+                return PushResult::Rejected;
+            }
+            else
+            {
+                dropOldest(pool, buffer->size, maxQueuedBytes, maxLag, now);
+            }
+        }
+
+        pool.retain(buffer);
+        if (delivery != nullptr)
+        {
+            delivery->pendingSends++;
+        }
+        messages.push_back({ buffer, 0, now, delivery });
+        queuedBytes += buffer->size;
+        return droppedMessages != droppedBefore ? PushResult::QueuedWithEvictions : PushResult::Queued;
+    }
+
+    /**
+     * Applies the slow consumer policy when the oldest queued message has been queued for longer than the lag limit, so a peer that has stopped
+     * reading is dealt with even while nothing new is pushed to it. With the newest policy there is nothing to drop until a new message is pushed.
+     * Returns false if the peer should be disconnected.
+     */
+    bool OutboundQueue::expire(BufferPool& pool, const SlowConsumerPolicy policy, const std::chrono::milliseconds maxLag, const std::chrono::steady_clock::time_point now)
+    {
+        if (maxLag.count() <= 0 || messages.empty() || getLag(now) <= maxLag)
+        {
+            return true;
+        }
+
+        if (policy == SlowConsumerPolicy::Disconnect)
+        {
+            return false;
+        }
+        else if (policy == SlowConsumerPolicy::DropOldest)
+        {
+            dropOldest(pool, 0, 0, maxLag, now);
+        }
+        return true;
+    }
+
+    /**
+     * Drops messages from the front of the queue until a message of the provided size fits within the byte limit and the oldest message is within the lag limit.
+     */
+    void OutboundQueue::dropOldest(BufferPool& pool, const size_t incomingSize, const size_t maxQueuedBytes, const std::chrono::milliseconds maxLag, const std::chrono::steady_clock::time_point now)
+    {
+        // A partially written message cannot be dropped without corrupting the stream, so the front message is only dropped if nothing has been written from it
+        size_t keep = std::max<size_t>(inFlight, !messages.empty() && messages.front().offset > 0 ? 1 : 0);
+        while (messages.size() > keep
+            && ((maxQueuedBytes > 0 && queuedBytes + incomingSize > maxQueuedBytes)
+                || (maxLag.count() > 0 && now - messages[keep].queuedAt > maxLag)))
+        {
+            drop(keep, pool);
+        }
+    }
+
+    /**
+     * Writes as much of the queue as the socket will accept without blocking, batching the queued messages into a single sendmsg() call.
+     * When a zero copy tracker is provided and the batch contains a message of at least the zero copy threshold the batch is sent with MSG_ZEROCOPY.
+     */
+    FlushResult OutboundQueue::flush(const int descriptor, BufferPool& pool, ZeroCopyTracker* zeroCopyTracker, const size_t zeroCopyThreshold)
+    {
+        iovec vectors[TCP_MAX_SEND_BATCH];
+        MessageBuffer* batchBuffers[TCP_MAX_SEND_BATCH];
+
+        while (!messages.empty())
+        {
+            size_t batchSize = prepare(vectors, batchBuffers, TCP_MAX_SEND_BATCH);
+            bool zeroCopy = false;
+            for (size_t i = 0; i < batchSize && zeroCopyTracker != nullptr && zeroCopyThreshold > 0; i++)
+            {
+                zeroCopy = zeroCopy || batchBuffers[i]->size >= zeroCopyThreshold;
+            }
+
+            msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = batchSize;
+            ssize_t written = sendmsg(descriptor, &message, MSG_NOSIGNAL | MSG_DONTWAIT | (zeroCopy ? MSG_ZEROCOPY : 0));
+            if (written < 0 && zeroCopy && errno == ENOBUFS)
+            {
+                // The kernel cannot pin any more pages for this socket, copy the batch instead
+                zeroCopy = false;
+                written = sendmsg(descriptor, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+            }
+
+            if (written < 0)
+            {
+                consume(0, pool);
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                {
+                    return FlushResult::WouldBlock;
+                }
+                return FlushResult::Failed;
+            }
+
+            if (zeroCopy)
+            {
+                zeroCopyTracker->sent(batchBuffers, batchSize, pool);
+            }
+            consume(static_cast<size_t>(written), pool);
+
+            if (!messages.empty() && messages.front().offset > 0)
+            {
+                // Short write, the socket buffer is full
+                return FlushResult::WouldBlock;
+            }
+        }
+        return FlushResult::Drained;
+    }
+
+    /**
+     * Fills the provided vectors with the unwritten part of up to the provided amount of messages from the front of the queue, returning the amount filled.
+     * The filled messages are in flight and are never dropped by the slow consumer policy until consume() is called with the amount of bytes that were written.
+     */
+    size_t OutboundQueue::prepare(iovec* vectors, MessageBuffer** buffers, const size_t maxBatch)
+    {
+        size_t batchSize = 0;
+        for (auto it = messages.begin(); it != messages.end() && batchSize < maxBatch; ++it, batchSize++)
+        {
+            vectors[batchSize].iov_base = it->buffer->data.data() + it->offset;
+            vectors[batchSize].iov_len = it->buffer->size - it->offset;
+            buffers[batchSize] = it->buffer;
+        }
+        inFlight = batchSize;
+        return batchSize;
+    }
+
+    /**
+     * Removes the provided amount of written bytes from the front of the queue, releasing every message that has been fully written.
+     * Each call that consumes any bytes is counted as a single send, and every message it completes is recorded as delivered at the same time.
+     */
+    void OutboundQueue::consume(const size_t written, BufferPool& pool)
+    {
+        inFlight = 0;
+        if (written > 0)
+        {
+            sendCount++;
+        }
+        std::optional<std::chrono::steady_clock::time_point> now = std::nullopt;
+        size_t remaining = written;
+        while (remaining > 0 && !messages.empty())
+        {
+            QueuedMessage& front = messages.front();
+            size_t frontRemaining = front.buffer->size - front.offset;
+            if (remaining >= frontRemaining)
+            {
+                remaining -= frontRemaining;
+                queuedBytes -= front.buffer->size;
+                if (!now.has_value())
+                {
+                    now = std::chrono::steady_clock::now();
+                }
+                recordDelivered(front, *now);
+                pool.release(front.buffer);
+                messages.pop_front();
+                sentMessages++;
+            }
+            else
+            {
+                front.offset += remaining;
+                remaining = 0;
+            }
+        }
+    }
+
+    void OutboundQueue::clear(BufferPool& pool)
+    {
+        for (QueuedMessage& message : messages)
+        {
+            abandon(message);
+            pool.release(message.buffer);
+        }
+        messages.clear();
+        queuedBytes = 0;
+        inFlight = 0;
+    }
+
+    bool OutboundQueue::empty() const
+    {
+        return messages.empty();
+    }
+
+    size_t OutboundQueue::size() const
+    {
+        return messages.size();
+    }
+
+    size_t OutboundQueue::getQueuedBytes() const
+    {
+        return queuedBytes;
+    }
+
+    uint64_t OutboundQueue::getDroppedMessages() const
+    {
+        return droppedMessages;
+    }
+
+    uint64_t OutboundQueue::getDroppedBytes() const
+    {
+        return droppedBytes;
+    }
+
+    uint64_t OutboundQueue::getSendCount() const
+    {
+        return sendCount;
+    }
+
+    uint64_t OutboundQueue::getSentMessages() const
+    {
+        return sentMessages;
+    }
+
+    std::chrono::steady_clock::duration OutboundQueue::getLag(const std::chrono::steady_clock::time_point now) const
+    {
+        return messages.empty() ? std::chrono::steady_clock::duration::zero() : now - messages.front().queuedAt;
+    }
+}
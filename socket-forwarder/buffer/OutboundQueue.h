@@ -0,0 +1,154 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <optional>
+#include <cstdint>
+
+#include <sys/uio.h>
+
+#include "MessageBuffer.h"
+#include "../metrics/Histogram.h"
+
+namespace forwarder
+{
+    // The most messages written to a TCP socket by a single send
+    const size_t TCP_MAX_SEND_BATCH = 64;
+
+    /**
+     * What to do with a peer that is not reading its messages fast enough to keep its outbound queue within its limits.
+     */
+    enum class SlowConsumerPolicy
+    {
+        // Drop the oldest queued messages to make room for new messages
+        DropOldest,
+        // Drop new messages until the queue has room for them
+        DropNewest,
+        // Disconnect the peer and remove it from its group
+        Disconnect
+    };
+
+    std::optional<SlowConsumerPolicy> parseSlowConsumerPolicy(const std::string&);
+    std::string slowConsumerPolicyToString(const SlowConsumerPolicy);
+
+    /**
+     * The progress of a received message being written to every peer it was queued for, shared by each queue it is pushed to so the first
+     * queue to finish writing it records the first send and the queue that finishes last records the last send.
+     */
+    struct MessageDelivery
+    {
+        std::chrono::steady_clock::time_point receivedAt;
+        // The queues that have not yet written or dropped the message, plus one for whoever acquired it while they are still pushing it
+        size_t pendingSends = 0;
+        bool firstSendRecorded = false;
+        bool incomplete = false;
+    };
+
+    /**
+     * Recycles MessageDeliveries so that recording a message's delivery does not need to allocate.
+     * A delivery acquired from the pool starts with a single pending send and is returned to the pool once every pending send is released.
+     */
+    class DeliveryPool
+    {
+    protected:
+        std::vector<std::unique_ptr<MessageDelivery>> allocated;
+        std::vector<MessageDelivery*> available;
+
+    public:
+        MessageDelivery* acquire(const std::chrono::steady_clock::time_point);
+        void release(MessageDelivery*);
+
+        size_t getAllocatedCount() const;
+        size_t getAvailableCount() const;
+    };
+
+    struct QueuedMessage
+    {
+        MessageBuffer* buffer;
+        // The amount of bytes of this message that have already been written to the socket
+        size_t offset;
+        std::chrono::steady_clock::time_point queuedAt;
+        // Null if the message's receive latencies are not recorded
+        MessageDelivery* delivery;
+    };
+
+    /**
+     * Where an OutboundQueue records how long its messages took to be written. Any of these may be null to skip recording that interval.
+     * The receive intervals are only recorded for messages pushed with a delivery, which are released to the provided pool.
+     */
+    struct DeliveryLatencies
+    {
+        LatencyHistogram* peerSend = nullptr;
+        LatencyHistogram* receiveToFirstSend = nullptr;
+        LatencyHistogram* receiveToLastSend = nullptr;
+        DeliveryPool* deliveries = nullptr;
+    };
+
+    enum class PushResult
+    {
+        // The message was queued
+        Queued,
+        // The message was queued after the oldest queued messages were dropped to make room for it
+        QueuedWithEvictions,
+        // The message was dropped and nothing was queued
+        Rejected,
+        // The peer should be disconnected, the message was not queued
+        Disconnect
+    };
+
+    enum class FlushResult
+    {
+        // Everything queued was written to the socket
+        Drained,
+        // The socket cannot accept any more data right now, wait for it to become writable
+        WouldBlock,
+        // The socket has failed and should be closed
+        Failed
+    };
+
+    /**
+     * A bounded queue of messages waiting to be written to a single non-blocking socket.
+     * The queued messages hold a reference to their buffers, so the same buffer can be queued for every peer in a group.
+     */
+    class OutboundQueue
+    {
+    protected:
+        std::deque<QueuedMessage> messages;
+        size_t queuedBytes = 0;
+        uint64_t droppedMessages = 0;
+        uint64_t droppedBytes = 0;
+        // The amount of sends that wrote at least one byte and the amount of messages they completed, their ratio is the average batch size
+        uint64_t sendCount = 0;
+        uint64_t sentMessages = 0;
+        // The amount of messages at the front of the queue that are being written, these must not be dropped until the write completes
+        size_t inFlight = 0;
+        DeliveryLatencies latencies;
+
+        void drop(const size_t, BufferPool&);
+        void abandon(const QueuedMessage&);
+        void markIncomplete(MessageDelivery*);
+        void dropOldest(BufferPool&, const size_t, const size_t, const std::chrono::milliseconds, const std::chrono::steady_clock::time_point);
+        void recordDelivered(const QueuedMessage&, const std::chrono::steady_clock::time_point);
+
+    public:
+        void setLatencies(const DeliveryLatencies&);
+        PushResult push(MessageBuffer*, BufferPool&, const SlowConsumerPolicy, const size_t, const std::chrono::milliseconds, const std::chrono::steady_clock::time_point, MessageDelivery* = nullptr);
+        bool expire(BufferPool&, const SlowConsumerPolicy, const std::chrono::milliseconds, const std::chrono::steady_clock::time_point);
+        FlushResult flush(const int, BufferPool&, ZeroCopyTracker*, const size_t);
+        size_t prepare(iovec*, MessageBuffer**, const size_t);
+        void consume(const size_t, BufferPool&);
+        void clear(BufferPool&);
+
+        bool empty() const;
+        size_t size() const;
+        size_t getQueuedBytes() const;
+        uint64_t getDroppedMessages() const;
+        uint64_t getDroppedBytes() const;
+        uint64_t getSendCount() const;
+        uint64_t getSentMessages() const;
+        std::chrono::steady_clock::duration getLag(const std::chrono::steady_clock::time_point) const;
+    };
+}
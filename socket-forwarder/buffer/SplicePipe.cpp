@@ -0,0 +1,135 @@
+#include "SplicePipe.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace forwarder
+{
+    /**
+     * Creates the pipe, attempting to resize it to the provided capacity in bytes. If the resize is not permitted the kernel's default capacity is kept.
+     */
+    bool SplicePipe::open(const size_t requestedCapacity)
+    {
+        int descriptors[2];
+        if (pipe2(descriptors, O_NONBLOCK | O_CLOEXEC) != 0)
+        {
+            return false;
+        }
+        readDescriptor = descriptors[0];
+        writeDescriptor = descriptors[1];
+        queuedBytes = 0;
+
+        if (requestedCapacity > 0)
+        {
+            fcntl(writeDescriptor, F_SETPIPE_SZ, static_cast<int>(requestedCapacity));
+        }
+        int actualCapacity = fcntl(writeDescriptor, F_GETPIPE_SZ);
+        capacity = actualCapacity > 0 ? static_cast<size_t>(actualCapacity) : 0;
+        return true;
+    }
+
+    bool SplicePipe::isOpen() const
+    {
+        return readDescriptor != -1;
+    }
+
+    /**
+     * Moves up to the provided amount of bytes from the socket into the pipe without blocking.
+     * Returns the amount moved, 0 if the socket has been closed by its peer or -1 with errno set.
+     */
+    ssize_t SplicePipe::spliceFrom(const int socket, const size_t maxBytes)
+    {
+        ssize_t result = splice(socket, nullptr, writeDescriptor, nullptr, maxBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (result > 0)
+        {
+            queuedBytes += static_cast<size_t>(result);
+        }
+        return result;
+    }
+
+    /**
+     * Duplicates up to the provided amount of bytes from the start of this pipe into the other pipe, without consuming them from this pipe.
+     * The pages are shared between both pipes rather than copied. Returns the amount duplicated, which is less than requested if the other pipe is full.
+     */
+    ssize_t SplicePipe::teeTo(SplicePipe& destination, const size_t amount)
+    {
+        ssize_t result = tee(readDescriptor, destination.writeDescriptor, amount, SPLICE_F_NONBLOCK);
+        if (result > 0)
+        {
+            destination.queuedBytes += static_cast<size_t>(result);
+        }
+        else if (result < 0 && errno == EAGAIN)
+        {
+            return 0;
+        }
+        return result;
+    }
+
+    /**
+     * Moves as much of the pipe into the socket as it will accept without blocking.
+     */
+    FlushResult SplicePipe::flush(const int socket)
+    {
+        while (queuedBytes > 0)
+        {
+            ssize_t result = splice(readDescriptor, nullptr, socket, nullptr, queuedBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (result > 0)
+            {
+                queuedBytes -= static_cast<size_t>(result);
+            }
+            else if (result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return FlushResult::WouldBlock;
+            }
+            else
+            {
+                return FlushResult::Failed;
+            }
+        }
+        return FlushResult::Drained;
+    }
+
+    /**
+     * Empties the pipe into the provided descriptor, which is expected to be opened to /dev/null.
+     */
+    void SplicePipe::discard(const int nullDescriptor)
+    {
+        while (queuedBytes > 0)
+        {
+            ssize_t result = splice(readDescriptor, nullptr, nullDescriptor, nullptr, queuedBytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (result <= 0)
+            {
+                break;
+            }
+            queuedBytes -= static_cast<size_t>(result);
+        }
+    }
+
+    size_t SplicePipe::getCapacity() const
+    {
+        return capacity;
+    }
+
+    size_t SplicePipe::getQueuedBytes() const
+    {
+        return queuedBytes;
+    }
+
+    void SplicePipe::close()
+    {
+        if (readDescriptor != -1)
+        {
+            ::close(readDescriptor);
+            ::close(writeDescriptor);
+        }
+        readDescriptor = -1;
+        writeDescriptor = -1;
+        queuedBytes = 0;
+    }
+}
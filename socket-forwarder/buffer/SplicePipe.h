@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <sys/types.h>
+
+#include "OutboundQueue.h"
+
+namespace forwarder
+{
+    /**
+     * A pipe used to move socket data through the kernel with splice() and tee() without copying it into user space.
+     * The receiving side of a group reads into one pipe, which is duplicated into a pipe per peer with tee(), and each peer's pipe is then
+     * spliced into the peer's socket. A peer's pipe also acts as its outbound queue, holding whatever the socket cannot accept yet.
+     *
+     * Like the kt socket types, this is a handle to the underlying descriptors, close() must be called explicitly to release them.
+     */
+    class SplicePipe
+    {
+    protected:
+        int readDescriptor = -1;
+        int writeDescriptor = -1;
+        size_t capacity = 0;
+        size_t queuedBytes = 0;
+
+    public:
+        bool open(const size_t = 0);
+        bool isOpen() const;
+
+        ssize_t spliceFrom(const int, const size_t);
+        ssize_t teeTo(SplicePipe&, const size_t);
+        FlushResult flush(const int);
+        void discard(const int);
+
+        size_t getCapacity() const;
+        size_t getQueuedBytes() const;
+
+        void close();
+    };
+}
@@ -0,0 +1,206 @@
+#include "AddressTable.h"
+
+#include <cstring>
+
+#include <netinet/in.h>
+
+namespace forwarder
+{
+    AddressKey toAddressKey(const kt::SocketAddress& address)
+    {
+        AddressKey key;
+        key.family = address.address.sa_family;
+        if (key.family == AF_INET6)
+        {
+            std::memcpy(&key.high, address.ipv6.sin6_addr.s6_addr, sizeof(key.high));
+            std::memcpy(&key.low, address.ipv6.sin6_addr.s6_addr + sizeof(key.high), sizeof(key.low));
+            key.scope = address.ipv6.sin6_scope_id;
+            key.port = address.ipv6.sin6_port;
+        }
+        else
+        {
+            key.low = address.ipv4.sin_addr.s_addr;
+            key.port = address.ipv4.sin_port;
+        }
+        return key;
+    }
+
+    /**
+     * Folds the key into 64 bits and mixes it with the finaliser of MurmurHash3, so addresses that only differ in their low bits spread
+     * across the whole table.
+     */
+    uint64_t hashAddressKey(const AddressKey& key)
+    {
+        uint64_t hash = key.high * 0x9e3779b97f4a7c15ULL;
+        hash ^= key.low + (static_cast<uint64_t>(key.port) << 48) + (static_cast<uint64_t>(key.family) << 32) + key.scope;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    /**
+     * Returns the bucket holding the provided key, or the empty bucket where it would be inserted. The table must not be empty.
+     */
+    size_t AddressTable::findBucket(const AddressKey& key, const uint64_t hash) const
+    {
+        const size_t mask = buckets.size() - 1;
+        size_t bucket = static_cast<size_t>(hash) & mask;
+        while (buckets[bucket] != EMPTY_BUCKET && !(keys[buckets[bucket] - 1] == key))
+        {
+            bucket = (bucket + 1) & mask;
+        }
+        return bucket;
+    }
+
+    /**
+     * Doubles the index and re-inserts every address, the addresses themselves do not move within the dense array.
+     */
+    void AddressTable::grow()
+    {
+        buckets.assign(buckets.empty() ? 16 : buckets.size() * 2, EMPTY_BUCKET);
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            buckets[findBucket(keys[i], hashAddressKey(keys[i]))] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    /**
+     * Adds the address if it is not in the table yet. Returns its position in the dense array and whether it was added.
+     * Positions of existing addresses are unaffected, although the array may be reallocated.
+     */
+    std::pair<size_t, bool> AddressTable::insert(const kt::SocketAddress& address)
+    {
+        // Kept at most half full, so probe sequences stay short
+        if ((addresses.size() + 1) * 2 > buckets.size())
+        {
+            grow();
+        }
+
+        const AddressKey key = toAddressKey(address);
+        const size_t bucket = findBucket(key, hashAddressKey(key));
+        if (buckets[bucket] != EMPTY_BUCKET)
+        {
+            return { buckets[bucket] - 1, false };
+        }
+
+        addresses.push_back(address);
+        keys.push_back(key);
+        buckets[bucket] = static_cast<uint32_t>(addresses.size());
+        return { addresses.size() - 1, true };
+    }
+
+    /**
+     * Empties the provided bucket, shifting back any address further along its probe sequence that could be stored in it,
+     * so lookups never stop at the emptied bucket before reaching an address that probed past it.
+     */
+    void AddressTable::eraseBucket(size_t bucket)
+    {
+        const size_t mask = buckets.size() - 1;
+        for (size_t next = (bucket + 1) & mask; buckets[next] != EMPTY_BUCKET; next = (next + 1) & mask)
+        {
+            const size_t home = static_cast<size_t>(hashAddressKey(keys[buckets[next] - 1])) & mask;
+            // Only moved if its home bucket is not between the emptied bucket and where it is stored
+            if (((next - home) & mask) >= ((next - bucket) & mask))
+            {
+                buckets[bucket] = buckets[next];
+                bucket = next;
+            }
+        }
+        buckets[bucket] = EMPTY_BUCKET;
+    }
+
+    /**
+     * Removes the address if it is in the table and returns the position it was at, which the last address is moved into.
+     */
+    std::optional<size_t> AddressTable::erase(const kt::SocketAddress& address)
+    {
+        if (addresses.empty())
+        {
+            return std::nullopt;
+        }
+
+        const AddressKey key = toAddressKey(address);
+        const size_t bucket = findBucket(key, hashAddressKey(key));
+        if (buckets[bucket] == EMPTY_BUCKET)
+        {
+            return std::nullopt;
+        }
+
+        const size_t position = buckets[bucket] - 1;
+        eraseBucket(bucket);
+        const size_t last = addresses.size() - 1;
+        if (position != last)
+        {
+            addresses[position] = addresses[last];
+            keys[position] = keys[last];
+            buckets[findBucket(keys[position], hashAddressKey(keys[position]))] = static_cast<uint32_t>(position + 1);
+        }
+        addresses.pop_back();
+        keys.pop_back();
+        return position;
+    }
+
+    std::optional<size_t> AddressTable::find(const kt::SocketAddress& address) const
+    {
+        if (addresses.empty())
+        {
+            return std::nullopt;
+        }
+
+        const AddressKey key = toAddressKey(address);
+        const size_t bucket = findBucket(key, hashAddressKey(key));
+        if (buckets[bucket] == EMPTY_BUCKET)
+        {
+            return std::nullopt;
+        }
+        return buckets[bucket] - 1;
+    }
+
+    bool AddressTable::contains(const kt::SocketAddress& address) const
+    {
+        return find(address).has_value();
+    }
+
+    void AddressTable::reserve(const size_t capacity)
+    {
+        addresses.reserve(capacity);
+        keys.reserve(capacity);
+        while (capacity * 2 > buckets.size())
+        {
+            grow();
+        }
+    }
+
+    size_t AddressTable::size() const
+    {
+        return addresses.size();
+    }
+
+    bool AddressTable::empty() const
+    {
+        return addresses.empty();
+    }
+
+    const kt::SocketAddress& AddressTable::operator[](const size_t index) const
+    {
+        return addresses[index];
+    }
+
+    const kt::SocketAddress* AddressTable::data() const
+    {
+        return addresses.data();
+    }
+
+    std::vector<kt::SocketAddress>::const_iterator AddressTable::begin() const
+    {
+        return addresses.begin();
+    }
+
+    std::vector<kt::SocketAddress>::const_iterator AddressTable::end() const
+    {
+        return addresses.end();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include <socket/UDPSocket.h>
+
+namespace forwarder
+{
+    /**
+     * The parts of a socket address that identify a peer, the family, port, IP address and IPv6 scope.
+     * Padding and unused bytes of the address are left out, so two addresses for the same peer always have the same key.
+     */
+    struct AddressKey
+    {
+        uint64_t high = 0;
+        uint64_t low = 0;
+        uint32_t scope = 0;
+        uint16_t port = 0;
+        uint16_t family = 0;
+
+        bool operator==(const AddressKey& other) const
+        {
+            return high == other.high && low == other.low && scope == other.scope && port == other.port && family == other.family;
+        }
+    };
+
+    AddressKey toAddressKey(const kt::SocketAddress&);
+    uint64_t hashAddressKey(const AddressKey&);
+
+    /**
+     * A set of socket addresses stored densely packed in insertion order, so iterating it walks a contiguous array of addresses that can be
+     * handed straight to batched sends. Lookups go through an open addressing index with linear probing, hashed from the binary address.
+     * An address keeps its position until an address is erased, erasing moves the last address into the erased position (swap and pop).
+     */
+    class AddressTable
+    {
+    protected:
+        static constexpr uint32_t EMPTY_BUCKET = 0;
+
+        std::vector<kt::SocketAddress> addresses;
+        std::vector<AddressKey> keys;
+        // Each bucket holds the position of its address plus 1, so a zeroed bucket is empty
+        std::vector<uint32_t> buckets;
+
+        size_t findBucket(const AddressKey&, const uint64_t) const;
+        void grow();
+        void eraseBucket(size_t);
+
+    public:
+        std::pair<size_t, bool> insert(const kt::SocketAddress&);
+        std::optional<size_t> find(const kt::SocketAddress&) const;
+        bool contains(const kt::SocketAddress&) const;
+        std::optional<size_t> erase(const kt::SocketAddress&);
+        void reserve(const size_t);
+
+        size_t size() const;
+        bool empty() const;
+        const kt::SocketAddress& operator[](const size_t) const;
+        const kt::SocketAddress* data() const;
+        std::vector<kt::SocketAddress>::const_iterator begin() const;
+        std::vector<kt::SocketAddress>::const_iterator end() const;
+    };
+}
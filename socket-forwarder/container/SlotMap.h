@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace forwarder
+{
+    /**
+     * A stable reference to a value in a SlotMap. The generation is bumped every time a slot is freed,
+     * so a handle to a removed value never resolves to a value inserted into the same slot afterwards.
+     */
+    struct SlotHandle
+    {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        bool operator==(const SlotHandle& other) const
+        {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(const SlotHandle& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     * Stores values densely packed in a vector while handing out stable generational handles to them.
+     * Insert, lookup and erase are O(1), erase moves the last value into the erased position (swap and pop)
+     * so iteration is always over a contiguous array of live values. Iteration order is not stable across erases.
+     */
+    template <typename T>
+    class SlotMap
+    {
+    protected:
+        static constexpr uint32_t FREE_SLOT = std::numeric_limits<uint32_t>::max();
+
+        struct Slot
+        {
+            uint32_t denseIndex;
+            uint32_t generation;
+        };
+
+        std::vector<T> values;
+        // The slot index of each value in the dense array, used to fix up the moved value's slot on erase
+        std::vector<uint32_t> denseToSlot;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+
+    public:
+        SlotHandle insert(T value)
+        {
+            uint32_t slotIndex;
+            if (freeSlots.empty())
+            {
+                slotIndex = static_cast<uint32_t>(slots.size());
+                slots.push_back({ FREE_SLOT, 0 });
+            }
+            else
+            {
+                slotIndex = freeSlots.back();
+                freeSlots.pop_back();
+            }
+
+            slots[slotIndex].denseIndex = static_cast<uint32_t>(values.size());
+            values.push_back(std::move(value));
+            denseToSlot.push_back(slotIndex);
+            return { slotIndex, slots[slotIndex].generation };
+        }
+
+        bool contains(const SlotHandle handle) const
+        {
+            return handle.index < slots.size() && slots[handle.index].generation == handle.generation && slots[handle.index].denseIndex != FREE_SLOT;
+        }
+
+        T* get(const SlotHandle handle)
+        {
+            return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+        }
+
+        const T* get(const SlotHandle handle) const
+        {
+            return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+        }
+
+        bool erase(const SlotHandle handle)
+        {
+            if (!contains(handle))
+            {
+                return false;
+            }
+
+            Slot& slot = slots[handle.index];
+            const uint32_t lastIndex = static_cast<uint32_t>(values.size() - 1);
+            if (slot.denseIndex != lastIndex)
+            {
+                values[slot.denseIndex] = std::move(values[lastIndex]);
+                denseToSlot[slot.denseIndex] = denseToSlot[lastIndex];
+                slots[denseToSlot[slot.denseIndex]].denseIndex = slot.denseIndex;
+            }
+            values.pop_back();
+            denseToSlot.pop_back();
+
+            slot.denseIndex = FREE_SLOT;
+            slot.generation++;
+            freeSlots.push_back(handle.index);
+            return true;
+        }
+
+        /**
+         * Returns the handle of the value at the provided position in the dense array.
+         */
+        SlotHandle handleAt(const size_t denseIndex) const
+        {
+            uint32_t slotIndex = denseToSlot[denseIndex];
+            return { slotIndex, slots[slotIndex].generation };
+        }
+
+        void clear()
+        {
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                Slot& slot = slots[denseToSlot[i]];
+                slot.denseIndex = FREE_SLOT;
+                slot.generation++;
+                freeSlots.push_back(denseToSlot[i]);
+            }
+            values.clear();
+            denseToSlot.clear();
+        }
+
+        void reserve(const size_t capacity)
+        {
+            values.reserve(capacity);
+            denseToSlot.reserve(capacity);
+            slots.reserve(capacity);
+        }
+
+        size_t size() const
+        {
+            return values.size();
+        }
+
+        bool empty() const
+        {
+            return values.empty();
+        }
+
+        T& operator[](const size_t denseIndex)
+        {
+            return values[denseIndex];
+        }
+
+        const T& operator[](const size_t denseIndex) const
+        {
+            return values[denseIndex];
+        }
+
+        typename std::vector<T>::iterator begin()
+        {
+            return values.begin();
+        }
+
+        typename std::vector<T>::iterator end()
+        {
+            return values.end();
+        }
+
+        typename std::vector<T>::const_iterator begin() const
+        {
+            return values.begin();
+        }
+
+        typename std::vector<T>::const_iterator end() const
+        {
+            return values.end();
+        }
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <utility>
+
+namespace forwarder
+{
+    /**
+     * A read-mostly value that is published as a series of immutable versions (copy-on-write).
+     * Readers load the current version without waiting on the writer and can keep using it for as long as they hold it, even after a newer
+     * version has been published. The writer copies the current version, changes the copy and publishes it, so readers never see a partial change.
+     * Old versions are reclaimed once the last reader holding them lets go.
+     *
+     * Only one thread may publish at a time, any number of threads may load concurrently with it.
+     */
+    template <typename T>
+    class Snapshot
+    {
+    protected:
+        std::shared_ptr<const T> current;
+
+    public:
+        Snapshot() : current(std::make_shared<const T>()) {}
+
+        std::shared_ptr<const T> load() const
+        {
+            return std::atomic_load_explicit(&current, std::memory_order_acquire);
+        }
+
+        void publish(std::shared_ptr<const T> next)
+        {
+            std::atomic_store_explicit(&current, std::move(next), std::memory_order_release);
+        }
+
+        /**
+         * Publishes a copy of the current version with the provided change applied to it.
+         */
+        template <typename Modifier>
+        void update(Modifier&& modify)
+        {
+            std::shared_ptr<T> next = std::make_shared<T>(*load());
+            modify(*next);
+            publish(std::move(next));
+        }
+    };
+}
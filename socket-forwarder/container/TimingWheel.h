@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace forwarder
+{
+    /**
+     * A hierarchical timing wheel holding values until their deadline passes. Each of the 4 levels has 64 slots, a slot of the first level
+     * covers a single tick and a slot of every level above covers a whole turn of the level below it. Values are scheduled into the lowest
+     * level that reaches their deadline and cascade down a level whenever the level below completes a turn, so scheduling is O(1) and each
+     * value is moved at most once per level. Deadlines further out than the top level reaches are parked in its furthest slot until they come
+     * within reach. Scheduled values cannot be cancelled, callers that need to push a deadline back check whether a value is still due when it
+     * expires and schedule it again.
+     */
+    template <typename T>
+    class TimingWheel
+    {
+    protected:
+        static constexpr size_t SLOT_BITS = 6;
+        static constexpr size_t SLOTS = size_t{ 1 } << SLOT_BITS;
+        static constexpr size_t LEVELS = 4;
+
+        struct Entry
+        {
+            uint64_t deadline;
+            T value;
+        };
+
+        std::chrono::steady_clock::duration tick;
+        std::chrono::steady_clock::time_point start;
+        // Every tick up to and including this one has been expired
+        uint64_t currentTick = 0;
+        size_t count = 0;
+        std::array<std::vector<Entry>, LEVELS * SLOTS> slots;
+
+        uint64_t toTick(const std::chrono::steady_clock::time_point time) const
+        {
+            if (time <= start)
+            {
+                return 0;
+            }
+            // Rounded up, so a value never expires before its deadline
+            return static_cast<uint64_t>((time - start + tick - std::chrono::steady_clock::duration(1)) / tick);
+        }
+
+        void place(Entry entry)
+        {
+            const uint64_t delta = entry.deadline - currentTick;
+            size_t level = 0;
+            while (level < LEVELS - 1 && delta >= (uint64_t{ 1 } << (SLOT_BITS * (level + 1))))
+            {
+                level++;
+            }
+            // Parked in the top level's furthest slot, it is placed again by its real deadline once that slot cascades
+            const uint64_t reachable = currentTick + (uint64_t{ 1 } << (SLOT_BITS * LEVELS)) - 1;
+            const uint64_t slotTick = entry.deadline > reachable ? reachable : entry.deadline;
+            slots[level * SLOTS + ((slotTick >> (SLOT_BITS * level)) & (SLOTS - 1))].push_back(std::move(entry));
+        }
+
+        /**
+         * Moves the values in the slot of the provided level that the current tick starts into the levels below it.
+         */
+        void cascade(const size_t level)
+        {
+            std::vector<Entry> entries;
+            entries.swap(slots[level * SLOTS + ((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1))]);
+            for (Entry& entry : entries)
+            {
+                if (entry.deadline <= currentTick)
+                {
+                    // Expired along with the rest of the current tick's slot
+                    slots[currentTick & (SLOTS - 1)].push_back(std::move(entry));
+                }
+                else
+                {
+                    place(std::move(entry));
+                }
+            }
+        }
+
+    public:
+        TimingWheel(const std::chrono::steady_clock::duration resolution, const std::chrono::steady_clock::time_point now) : tick(resolution), start(now) {}
+
+        /**
+         * Adds a value that expires once the provided deadline has passed, deadlines that have already passed expire on the next advance.
+         */
+        void schedule(T value, const std::chrono::steady_clock::time_point deadline)
+        {
+            const uint64_t deadlineTick = toTick(deadline);
+            place({ deadlineTick > currentTick ? deadlineTick : currentTick + 1, std::move(value) });
+            count++;
+        }
+
+        /**
+         * Hands every value whose deadline is at or before the provided time to the callback, which may schedule values again.
+         */
+        template <typename Callback>
+        void advance(const std::chrono::steady_clock::time_point now, Callback&& expired)
+        {
+            // Only ticks that have fully elapsed are expired
+            const uint64_t target = now <= start ? 0 : static_cast<uint64_t>((now - start) / tick);
+            if (count == 0)
+            {
+                // Nothing to cascade or expire, so the ticks in between can be skipped
+                currentTick = std::max(currentTick, target);
+                return;
+            }
+
+            std::vector<Entry> due;
+            while (currentTick < target)
+            {
+                currentTick++;
+                for (size_t level = LEVELS - 1; level > 0; level--)
+                {
+                    if ((currentTick & ((uint64_t{ 1 } << (SLOT_BITS * level)) - 1)) == 0)
+                    {
+                        cascade(level);
+                    }
+                }
+
+                due.clear();
+                due.swap(slots[currentTick & (SLOTS - 1)]);
+                count -= due.size();
+                for (Entry& entry : due)
+                {
+                    expired(std::move(entry.value));
+                }
+            }
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+    };
+}
@@ -1,5 +1,9 @@
 #include "Environment.h"
 
+#include <cerrno>
+#include <cstdlib>
+#include <cctype>
+
 namespace forwarder
 {
     std::optional<std::string> getEnvironmentVariableValue(std::string environmentVariableKey)
@@ -13,4 +17,25 @@ namespace forwarder
         char *val = std::getenv(environmentVariableKey.c_str());
         return val == nullptr ? defaultValue : std::string(val);
     }
+
+    /**
+     * Parses a whole decimal number between minimum and maximum inclusive, returns nullopt for anything else, including negative numbers
+     * that strtoull() would otherwise wrap around.
+     */
+    std::optional<size_t> parseSize(const std::string& value, const size_t minimum, const size_t maximum)
+    {
+        if (value.empty() || !std::isdigit(static_cast<unsigned char>(value.front())))
+        {
+            return std::nullopt;
+        }
+
+        errno = 0;
+        char* end = nullptr;
+        const unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+        if (errno == ERANGE || *end != '\0' || parsed < minimum || parsed > maximum)
+        {
+            return std::nullopt;
+        }
+        return static_cast<size_t>(parsed);
+    }
 }
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <optional>
+#include <cstddef>
 
 namespace forwarder
 {
@@ -10,23 +11,103 @@ namespace forwarder
     const std::string NEW_CLIENT_PREFIX = SOCKET_FORWARDER_PREFIX + "new_client_prefix";
     const std::string MAX_READ_IN_SIZE = SOCKET_FORWARDER_PREFIX + "max_read_in_size";
     const std::string DEBUG = SOCKET_FORWARDER_PREFIX + "debug";
+    const std::string IO_ENGINE = SOCKET_FORWARDER_PREFIX + "io_engine";
+    const std::string TRACE_SAMPLE_RATE = SOCKET_FORWARDER_PREFIX + "trace_sample_rate";
+    const std::string TRACE_BUFFER_SIZE = SOCKET_FORWARDER_PREFIX + "trace_buffer_size";
+    const std::string LOG_LEVEL = SOCKET_FORWARDER_PREFIX + "log_level";
 
     const std::string PRECONFIG_ADDRESSES_SUFFIX = "preconfig_addresses";
     const std::string PORT_SUFFIX = "port";
+    const std::string REUSE_PORT_SUFFIX = "reuse_port";
 
     const std::string TCP = "tcp.";
     const std::string TCP_PORT = SOCKET_FORWARDER_PREFIX + TCP + PORT_SUFFIX;
     const std::string PRECONFIG_TCP_ADDRESSES = SOCKET_FORWARDER_PREFIX + TCP + PRECONFIG_ADDRESSES_SUFFIX;
+    const std::string TCP_WORKER_COUNT = SOCKET_FORWARDER_PREFIX + TCP + "worker_count";
+    const std::string TCP_REUSE_PORT = SOCKET_FORWARDER_PREFIX + TCP + REUSE_PORT_SUFFIX;
+    const std::string TCP_ZERO_COPY_THRESHOLD = SOCKET_FORWARDER_PREFIX + TCP + "zerocopy_threshold";
+    const std::string TCP_SLOW_CONSUMER_POLICY = SOCKET_FORWARDER_PREFIX + TCP + "slow_consumer_policy";
+    const std::string TCP_MAX_QUEUED_BYTES = SOCKET_FORWARDER_PREFIX + TCP + "max_queued_bytes";
+    const std::string TCP_MAX_LAG_MS = SOCKET_FORWARDER_PREFIX + TCP + "max_lag_ms";
+    const std::string TCP_FRAMING = SOCKET_FORWARDER_PREFIX + TCP + "framing";
+    const std::string TCP_MAX_FRAME_SIZE = SOCKET_FORWARDER_PREFIX + TCP + "max_frame_size";
+    const std::string TCP_SPLICE_GROUPS = SOCKET_FORWARDER_PREFIX + TCP + "splice_groups";
+    const std::string TCP_FLUSH_WINDOW_US = SOCKET_FORWARDER_PREFIX + TCP + "flush_window_us";
+    const std::string TCP_GROUP_FLUSH_WINDOW_US = SOCKET_FORWARDER_PREFIX + TCP + "group_flush_window_us";
+    const std::string TCP_HANDSHAKE_TIMEOUT_MS = SOCKET_FORWARDER_PREFIX + TCP + "handshake_timeout_ms";
+    const std::string TCP_USE_CORK = SOCKET_FORWARDER_PREFIX + TCP + "cork";
     
     const std::string UDP = "udp.";
     const std::string UDP_PORT = SOCKET_FORWARDER_PREFIX + UDP + PORT_SUFFIX;
     const std::string PRECONFIG_UDP_ADDRESSES = SOCKET_FORWARDER_PREFIX + UDP + PRECONFIG_ADDRESSES_SUFFIX;
+    const std::string UDP_QUEUE_SIZE = SOCKET_FORWARDER_PREFIX + UDP + "queue_size";
+    const std::string UDP_OVERFLOW_POLICY = SOCKET_FORWARDER_PREFIX + UDP + "overflow_policy";
+    const std::string UDP_DISABLE_OFFLOAD = SOCKET_FORWARDER_PREFIX + UDP + "disable_offload";
+    const std::string UDP_RECEIVER_COUNT = SOCKET_FORWARDER_PREFIX + UDP + "receiver_count";
+    const std::string UDP_CPU_STEERING = SOCKET_FORWARDER_PREFIX + UDP + "cpu_steering";
+    const std::string UDP_PEER_TTL_MS = SOCKET_FORWARDER_PREFIX + UDP + "peer_ttl_ms";
+    const std::string UDP_EXPIRE_PRECONFIGURED = SOCKET_FORWARDER_PREFIX + UDP + "expire_preconfigured";
+
+    const std::string METRICS = "metrics.";
+    const std::string METRICS_PORT = SOCKET_FORWARDER_PREFIX + METRICS + PORT_SUFFIX;
+    const std::string METRICS_HOST_ADDRESS = SOCKET_FORWARDER_PREFIX + METRICS + "host_address";
+
+    // Read by the load generator, which uses NEW_CLIENT_PREFIX to join the same way the forwarder expects
+    const std::string LOAD_GENERATOR_PREFIX = "loadgenerator.";
+    const std::string LOAD_GENERATOR_HOST_ADDRESS = LOAD_GENERATOR_PREFIX + "host_address";
+    const std::string LOAD_GENERATOR_RATE = LOAD_GENERATOR_PREFIX + "rate";
+    const std::string LOAD_GENERATOR_MESSAGE_SIZE = LOAD_GENERATOR_PREFIX + "message_size";
+    const std::string LOAD_GENERATOR_DURATION_MS = LOAD_GENERATOR_PREFIX + "duration_ms";
+    const std::string LOAD_GENERATOR_JOIN_WAIT_MS = LOAD_GENERATOR_PREFIX + "join_wait_ms";
+    const std::string LOAD_GENERATOR_DRAIN_MS = LOAD_GENERATOR_PREFIX + "drain_ms";
+    const std::string LOAD_GENERATOR_TCP_PORT = LOAD_GENERATOR_PREFIX + TCP + PORT_SUFFIX;
+    const std::string LOAD_GENERATOR_TCP_GROUPS = LOAD_GENERATOR_PREFIX + TCP + "groups";
+    const std::string LOAD_GENERATOR_TCP_CLIENTS_PER_GROUP = LOAD_GENERATOR_PREFIX + TCP + "clients_per_group";
+    const std::string LOAD_GENERATOR_UDP_PORT = LOAD_GENERATOR_PREFIX + UDP + PORT_SUFFIX;
+    const std::string LOAD_GENERATOR_UDP_PEERS = LOAD_GENERATOR_PREFIX + UDP + "peers";
 
     const std::string NEW_CLIENT_PREFIX_DEFAULT = "SOCKETFORWARDER-NEW:";
     const unsigned short MAX_READ_IN_DEFAULT = 10240;
     const std::string HOST_ADDRESS_DEFAULT = "0.0.0.0";
+    const std::string IO_ENGINE_DEFAULT = "epoll";
+    const unsigned long TRACE_SAMPLE_RATE_DEFAULT = 0;
+    const std::string LOG_LEVEL_DEFAULT = "info";
+    const std::string METRICS_HOST_ADDRESS_DEFAULT = "127.0.0.1";
+    const size_t TCP_WORKER_COUNT_DEFAULT = 1;
+    const size_t TCP_WORKER_COUNT_MAX = 1024;
+    const size_t TCP_ZERO_COPY_THRESHOLD_DEFAULT = 0;
+    const size_t TCP_ZERO_COPY_THRESHOLD_MAX = 1073741824;
+    const std::string TCP_SLOW_CONSUMER_POLICY_DEFAULT = "disconnect";
+    const size_t TCP_MAX_QUEUED_BYTES_DEFAULT = 4194304;
+    const size_t TCP_MAX_QUEUED_BYTES_MAX = 17179869184;
+    const long TCP_MAX_LAG_MS_DEFAULT = 0;
+    const size_t TCP_MAX_LAG_MS_MAX = 3600000;
+    const size_t TCP_MAX_FRAME_SIZE_DEFAULT = 1048576;
+    const size_t TCP_MAX_FRAME_SIZE_MAX = 1073741824;
+    const long TCP_FLUSH_WINDOW_US_DEFAULT = 0;
+    const size_t TCP_FLUSH_WINDOW_US_MAX = 1000000;
+    const long TCP_HANDSHAKE_TIMEOUT_MS_DEFAULT = 5000;
+    const size_t TCP_HANDSHAKE_TIMEOUT_MS_MAX = 3600000;
+    const size_t UDP_QUEUE_SIZE_DEFAULT = 1024;
+    const size_t UDP_QUEUE_SIZE_MAX = 65536;
+    const std::string UDP_OVERFLOW_POLICY_DEFAULT = "drop_newest";
+    const size_t UDP_RECEIVER_COUNT_DEFAULT = 1;
+    const size_t UDP_RECEIVER_COUNT_MAX = 1024;
+    const long UDP_PEER_TTL_MS_DEFAULT = 0;
+    const size_t UDP_PEER_TTL_MS_MAX = 86400000;
+    const std::string LOAD_GENERATOR_HOST_ADDRESS_DEFAULT = "127.0.0.1";
+    const double LOAD_GENERATOR_RATE_DEFAULT = 1000;
+    const size_t LOAD_GENERATOR_MESSAGE_SIZE_DEFAULT = 64;
+    const long LOAD_GENERATOR_DURATION_MS_DEFAULT = 10000;
+    const long LOAD_GENERATOR_JOIN_WAIT_MS_DEFAULT = 500;
+    const long LOAD_GENERATOR_DRAIN_MS_DEFAULT = 1000;
+    const size_t LOAD_GENERATOR_TCP_GROUPS_DEFAULT = 1;
+    const size_t LOAD_GENERATOR_TCP_CLIENTS_PER_GROUP_DEFAULT = 2;
+    const size_t LOAD_GENERATOR_UDP_PEERS_DEFAULT = 1;
 
     std::optional<std::string> getEnvironmentVariableValue(std::string);
 
     std::string getEnvironmentVariableValueOrDefault(std::string, std::string);
+
+    std::optional<size_t> parseSize(const std::string&, const size_t, const size_t);
 }
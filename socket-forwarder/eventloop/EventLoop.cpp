@@ -0,0 +1,133 @@
+#include "EventLoop.h"
+
+#include <cerrno>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace forwarder
+{
+    std::optional<IOEngine> parseIOEngine(const std::string& engine)
+    {
+        if (engine == "epoll")
+        {
+            return std::make_optional(IOEngine::Epoll);
+        }
+        else if (engine == "io_uring")
+        {
+            return std::make_optional(IOEngine::IoUring);
+        }
+        return std::nullopt;
+    }
+
+    std::string ioEngineToString(const IOEngine engine)
+    {
+        switch (engine)
+        {
+            case IOEngine::IoUring:
+                return "io_uring";
+            default:
+                return "epoll";
+        }
+    }
+
+    EventLoop::EventLoop(const size_t maxEventsPerWait):
+        epollDescriptor(epoll_create1(EPOLL_CLOEXEC)), wakeDescriptor(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), events(maxEventsPerWait)
+    {
+        add(wakeDescriptor, EPOLLIN);
+    }
+
+    bool EventLoop::add(const int descriptor, const uint32_t eventFlags) const
+    {
+        epoll_event event{};
+        event.events = eventFlags;
+        event.data.fd = descriptor;
+        return epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, descriptor, &event) == 0;
+    }
+
+    bool EventLoop::modify(const int descriptor, const uint32_t eventFlags) const
+    {
+        epoll_event event{};
+        event.events = eventFlags;
+        event.data.fd = descriptor;
+        return epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, descriptor, &event) == 0;
+    }
+
+    bool EventLoop::remove(const int descriptor) const
+    {
+        return epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, descriptor, nullptr) == 0;
+    }
+
+    /**
+     * Blocks until at least one registered descriptor is ready or the timeout (negative for no timeout) expires.
+     * The timeout is honoured to the microsecond with epoll_pwait2(), kernels without it round the timeout up to the next millisecond.
+     * Returns the amount of ready events that can be read with getEvent(), this will be 0 on timeout or interruption.
+     */
+    int EventLoop::wait(const std::chrono::microseconds timeout)
+    {
+        int result;
+        if (timeout.count() < 0)
+        {
+            result = epoll_wait(epollDescriptor, events.data(), static_cast<int>(events.size()), -1);
+        }
+        else
+        {
+            timespec waitFor{};
+            waitFor.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+            waitFor.tv_nsec = static_cast<long>(timeout.count() % 1000000) * 1000;
+            result = epoll_pwait2(epollDescriptor, events.data(), static_cast<int>(events.size()), &waitFor, nullptr);
+            if (result < 0 && errno == ENOSYS)
+            {
+                const int timeoutMillis = static_cast<int>((timeout.count() + 999) / 1000);
+                result = epoll_wait(epollDescriptor, events.data(), static_cast<int>(events.size()), timeoutMillis);
+            }
+        }
+        return result < 0 ? 0 : result;
+    }
+
+    const epoll_event& EventLoop::getEvent(const int index) const
+    {
+        return events[index];
+    }
+
+    bool EventLoop::isWakeEvent(const epoll_event& event) const
+    {
+        return event.data.fd == wakeDescriptor;
+    }
+
+    /**
+     * The eventfd that wake() signals, so another loop (such as an io_uring worker) can wait on the same wake ups.
+     */
+    int EventLoop::getWakeDescriptor() const
+    {
+        return wakeDescriptor;
+    }
+
+    void EventLoop::wake() const
+    {
+        if (wakeDescriptor != -1)
+        {
+            eventfd_write(wakeDescriptor, 1);
+        }
+    }
+
+    void EventLoop::clearWake() const
+    {
+        eventfd_t value;
+        eventfd_read(wakeDescriptor, &value);
+    }
+
+    void EventLoop::close()
+    {
+        if (epollDescriptor != -1)
+        {
+            ::close(epollDescriptor);
+            epollDescriptor = -1;
+        }
+        if (wakeDescriptor != -1)
+        {
+            ::close(wakeDescriptor);
+            wakeDescriptor = -1;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <cstdint>
+#include <chrono>
+
+#include <sys/epoll.h>
+
+namespace forwarder
+{
+    /**
+     * The I/O engine that drives the forwarder's sockets.
+     */
+    enum class IOEngine
+    {
+        // Readiness is reported by epoll and every read and write is its own system call
+        Epoll,
+        // Accepts, reads and writes are queued to io_uring and completed by the kernel, many per system call
+        IoUring
+    };
+
+    std::optional<IOEngine> parseIOEngine(const std::string&);
+    std::string ioEngineToString(const IOEngine);
+
+    /**
+     * A small wrapper around an epoll instance and an eventfd.
+     * The eventfd is always registered in the epoll set so that another thread can call wake() to interrupt a blocking wait().
+     *
+     * Like the kt socket types, this is a handle to the underlying descriptors, close() must be called explicitly to release them.
+     */
+    class EventLoop
+    {
+    protected:
+        int epollDescriptor = -1;
+        int wakeDescriptor = -1;
+        std::vector<epoll_event> events;
+
+    public:
+        EventLoop(const size_t = 1024);
+
+        bool add(const int, const uint32_t = EPOLLIN) const;
+        bool modify(const int, const uint32_t) const;
+        bool remove(const int) const;
+
+        int wait(const std::chrono::microseconds = std::chrono::microseconds(-1));
+        const epoll_event& getEvent(const int) const;
+
+        bool isWakeEvent(const epoll_event&) const;
+        int getWakeDescriptor() const;
+        void wake() const;
+        void clearWake() const;
+
+        void close();
+    };
+}
@@ -1,87 +1,451 @@
 #include "Forwarder.h"
 #include "../environment/Environment.h"
+#include "../sockets/Sockets.h"
+#include "../logging/Logger.h"
 
 #include <socketexceptions/SocketException.hpp>
-#include <socketexceptions/TimeoutException.hpp>
 
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <cerrno>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
-#include <uuid/uuid.h>
 
 namespace forwarder
 {
+    // Every TCP receive on a worker's ring picks its buffer from this group of provided buffers
+    const uint16_t TCP_BUFFER_GROUP = 0;
+    const unsigned TCP_PROVIDED_BUFFER_COUNT = 256;
+    const unsigned TCP_RING_ENTRIES = 256;
+
+    const uint16_t UDP_BUFFER_GROUP = 0;
+    const unsigned UDP_PROVIDED_BUFFER_COUNT = 256;
+    const unsigned UDP_RING_ENTRIES = 1024;
+    const uint64_t UDP_RECEIVE_USER_DATA = 1;
+    // The most datagrams the UDP listener reads with a single recvmmsg()
+    const size_t UDP_RECEIVE_BATCH_SIZE = 64;
+    // The most messages the UDP data forwarder takes from its queue at a time, and the most sends it makes with a single sendmmsg()
+    const size_t UDP_MAX_SEND_MESSAGES = 16;
+    const size_t UDP_SEND_BATCH_SIZE = 1024;
+    // A UDP_GRO read can hold a whole coalesced run of datagrams, up to the largest UDP payload
+    const size_t UDP_GRO_BUFFER_SIZE = 65535;
+    // Limits of a single UDP_SEGMENT send, the kernel rejects sends with more segments or more bytes than a single IPv4 UDP payload
+    const size_t UDP_GSO_MAX_SEGMENTS = 64;
+    const size_t UDP_GSO_MAX_BYTES = 65507;
+    // Peers are checked for expiry at a tick of 1/32 of their TTL, so they are removed at most about 3% late, within these bounds
+    const std::chrono::milliseconds UDP_PEER_EXPIRY_MIN_TICK = std::chrono::milliseconds(1);
+    const std::chrono::milliseconds UDP_PEER_EXPIRY_MAX_TICK = std::chrono::milliseconds(100);
+
+    /**
+     * The operation a TCP io_uring completion belongs to, kept in the upper 32 bits of its user data with the socket descriptor in the lower 32 bits.
+     */
+    enum class UringOperation : uint32_t
+    {
+        Accept,
+        Wake,
+        Handshake,
+        Receive,
+        Send
+    };
+
+    static uint64_t encodeUringOperation(const UringOperation operation, const int descriptor)
+    {
+        return (static_cast<uint64_t>(operation) << 32) | static_cast<uint32_t>(descriptor);
+    }
+
+    /**
+     * Returns the shorter of two wait timeouts, where a negative timeout is no timeout.
+     */
+    static std::chrono::microseconds earliestTimeout(const std::chrono::microseconds first, const std::chrono::microseconds second)
+    {
+        if (first.count() < 0)
+        {
+            return second;
+        }
+        return second.count() < 0 ? first : std::min(first, second);
+    }
+
+    static bool isDisconnected(const ssize_t receivedAmount)
+    {
+        return receivedAmount == 0 || (receivedAmount < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+    }
+
     Forwarder::Forwarder(std::optional<kt::ServerSocket> tcpSocket, std::optional<kt::UDPSocket> udpSocket, const std::string prefix, const unsigned short maxRead, const bool debugFlag):
         tcpServerSocket(tcpSocket), udpRecieveSocket(udpSocket), newClientPrefix(prefix), maxReadInSize(maxRead), debug(debugFlag)
     { }
 
-    void Forwarder::addSocketToTCPGroup(const std::string& groupId, kt::TCPSocket socket)
+    TCPShard& Forwarder::getTCPShardForGroup(const std::string& groupId)
     {
-        std::string addressString = kt::getAddress(socket.getSocketAddress()).value_or("") + ":" + std::to_string(kt::getPortNumber(socket.getSocketAddress()));
+        return *tcpShards[std::hash<std::string>()(groupId) % tcpShards.size()];
+    }
 
-        if (tcpSessions.find(groupId) == tcpSessions.end())
+    /**
+     * Places the socket into the provided group, if the group is owned by another shard the socket is queued for that shard
+     * and its event loop is woken so that only the owning thread ever touches the group.
+     */
+    void Forwarder::dispatchSocketToTCPGroup(TCPShard& currentShard, const std::string& groupId, kt::TCPSocket socket)
+    {
+        TCPShard& owningShard = getTCPShardForGroup(groupId);
+        if (&owningShard == &currentShard)
         {
-            std::cout << "[TCP] - Creating new group with ID [" << groupId << "], adding address [" << addressString << "] to group.\n";
-            // No existing groups with this ID, creating new
-            std::vector<kt::TCPSocket> sockets = { socket };
-            tcpSessions.insert(std::make_pair(groupId, sockets));
+            addSocketToTCPGroup(currentShard, groupId, socket);
         }
         else
         {
             if (debug)
             {
-                std::cout << "[TCP] - Adding new connection [" << addressString << "] to group [" << groupId << "].\n";
+                logDebug("[TCP] - Handing off connection for group [", groupId, "] from worker [", currentShard.index, "] to worker [", owningShard.index, "].");
+            }
+            std::lock_guard<std::mutex> lock(owningShard.handoffMutex);
+            owningShard.handoffQueue.emplace_back(groupId, socket);
+            owningShard.eventLoop.wake();
+        }
+    }
+
+    void Forwarder::addSocketToTCPGroup(TCPShard& shard, const std::string& groupId, kt::TCPSocket socket)
+    {
+        std::string addressString = kt::getAddress(socket.getSocketAddress()).value_or("") + ":" + std::to_string(kt::getPortNumber(socket.getSocketAddress()));
+
+        auto group = shard.sessions.find(groupId);
+        if (group == shard.sessions.end())
+        {
+            logInfo("[TCP] - Creating new group with ID [", groupId, "] on worker [", shard.index, "], adding address [", addressString, "] to group.");
+            // No existing groups with this ID, creating new
+            group = shard.sessions.insert(std::make_pair(groupId, TCPGroup{ groupId })).first;
+            group->second.counters = metrics.createCounters({ METRICS_PROTOCOL_TCP, groupId });
+
+            auto framing = tcpGroupFraming.find(groupId);
+            if (framing != tcpGroupFraming.end())
+            {
+                group->second.framing = framing->second;
+            }
+
+            auto flushWindow = tcpGroupFlushWindows.find(groupId);
+            group->second.flushWindow = flushWindow != tcpGroupFlushWindows.end() ? flushWindow->second : tcpFlushWindow;
+
+            if (tcpSpliceGroups.find(groupId) != tcpSpliceGroups.end())
+            {
+                if (group->second.framing != FramingMode::None)
+                {
+                    logInfo("[TCP] - Group [", groupId, "] is framed, frames must be parsed in user space so splice forwarding is disabled for this group.");
+                }
+                else if (shard.ring.isOpen())
+                {
+                    logInfo("[TCP] - Worker [", shard.index, "] is using io_uring, splice forwarding is disabled for group [", groupId, "].");
+                }
+                else
+                {
+                    if (shard.nullDescriptor == -1)
+                    {
+                        shard.nullDescriptor = open("/dev/null", O_WRONLY | O_CLOEXEC);
+                    }
+                    if (!shard.receivePipe.isOpen())
+                    {
+                        shard.receivePipe.open(maxReadInSize);
+                    }
+
+                    group->second.splice = shard.nullDescriptor != -1 && shard.receivePipe.isOpen();
+                    if (!group->second.splice)
+                    {
+                        logWarning("[TCP] - Unable to create splice pipe on worker [", shard.index, "], group [", groupId, "] will copy its messages.");
+                    }
+                }
+            }
+        }
+        else if (debug)
+        {
+            logDebug("[TCP] - Adding new connection [", addressString, "] to group [", groupId, "].");
+        }
+
+        TCPPeer peer{ socket, groupId };
+        peer.counters = std::make_shared<TCPPeerCounters>(addressString);
+        ForwardingCounters& groupCounters = *group->second.counters;
+        peer.outboundQueue.setLatencies({ &groupCounters.peerSend, &groupCounters.receiveToFirstSend, &groupCounters.receiveToLastSend, &shard.deliveryPool });
+        if (group->second.splice)
+        {
+            peer.splicePipe = SplicePipe();
+            // Each pipe buffer is spliced into the socket separately, without TCP_NODELAY the tail of a message can wait on a delayed ACK
+            setNoDelay(socket.getSocket());
+            if (!peer.splicePipe->open(tcpMaxQueuedBytes))
+            {
+                logWarning("[TCP] - Unable to create splice pipe for connection [", addressString, "], closing connection.");
+                socket.close();
+                return;
+            }
+        }
+        else if (tcpZeroCopyThreshold > 0 && !shard.ring.isOpen())
+        {
+            if (enableZeroCopy(socket.getSocket()))
+            {
+                peer.zeroCopyTracker = ZeroCopyTracker();
+            }
+            else if (debug)
+            {
+                logDebug("[TCP] - Unable to enable SO_ZEROCOPY for connection [", addressString, "], messages will be copied.");
             }
-            tcpSessions[groupId].push_back(socket);
         }
+        setNonBlocking(socket.getSocket());
+        SlotHandle handle = group->second.members.insert(std::move(peer));
+        shard.peers[socket.getSocket()] = { &group->second, handle };
+        shard.changedGroups.insert(groupId);
+        if (shard.ring.isOpen())
+        {
+            armTCPReceive(shard, *group->second.members.get(handle));
+        }
+        else
+        {
+            shard.eventLoop.add(socket.getSocket(), EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    void Forwarder::setTCPWorkerCount(const size_t workerCount)
+    {
+        tcpWorkerCount = workerCount == 0 ? 1 : workerCount;
+    }
+
+    void Forwarder::setTCPReusePort(const bool reusePort)
+    {
+        tcpReusePort = reusePort;
+    }
+
+    void Forwarder::setTCPZeroCopyThreshold(const size_t threshold)
+    {
+        tcpZeroCopyThreshold = threshold;
+    }
+
+    /**
+     * Sets how peers whose outbound queue exceeds the provided byte limit, or whose oldest queued message is older than the provided lag, are handled.
+     * A limit of 0 is unlimited.
+     */
+    void Forwarder::setTCPSlowConsumerPolicy(const SlowConsumerPolicy policy, const size_t maxQueuedBytes, const std::chrono::milliseconds maxLag)
+    {
+        tcpSlowConsumerPolicy = policy;
+        tcpMaxQueuedBytes = maxQueuedBytes;
+        tcpMaxLag = maxLag;
+    }
+
+    /**
+     * Sets the framing used by the members of the provided group, the group forwards whole frames instead of whatever each read returns.
+     */
+    void Forwarder::setTCPGroupFraming(const std::string& groupId, const FramingMode mode)
+    {
+        tcpGroupFraming[groupId] = mode;
+    }
+
+    /**
+     * Sets the largest frame payload accepted in framed groups, peers that announce a larger frame are disconnected. 0 is unlimited, a frame's
+     * buffer only grows as its bytes arrive so the limit bounds the memory a peer can hold with an incomplete frame.
+     */
+    void Forwarder::setTCPMaxFrameSize(const size_t maxFrameSize)
+    {
+        tcpMaxFrameSize = maxFrameSize;
+    }
+
+    /**
+     * Sets whether the provided group forwards using splice() and tee(), so its messages never enter user space.
+     */
+    void Forwarder::setTCPGroupSplice(const std::string& groupId, const bool enabled)
+    {
+        if (enabled)
+        {
+            tcpSpliceGroups.insert(groupId);
+        }
+        else
+        {
+            tcpSpliceGroups.erase(groupId);
+        }
+    }
+
+    /**
+     * Sets how long messages forwarded to a peer can wait for more messages so they are written to its socket together.
+     * A window of 0 still writes every message forwarded to the peer during one loop iteration together, at the end of that iteration.
+     */
+    void Forwarder::setTCPFlushWindow(const std::chrono::microseconds flushWindow)
+    {
+        tcpFlushWindow = flushWindow;
+    }
+
+    /**
+     * Sets the flush window of the provided group, overriding the window set by setTCPFlushWindow().
+     */
+    void Forwarder::setTCPGroupFlushWindow(const std::string& groupId, const std::chrono::microseconds flushWindow)
+    {
+        tcpGroupFlushWindows[groupId] = flushWindow;
+    }
+
+    /**
+     * Sets whether sockets are corked while a queue that needs more than one write is flushed, so the writes are sent as full segments.
+     */
+    void Forwarder::setTCPCork(const bool cork)
+    {
+        tcpCork = cork;
+    }
+
+    /**
+     * Sets how long an accepted connection has to send its join message before it is closed. 0 never times out.
+     */
+    void Forwarder::setTCPHandshakeTimeout(const std::chrono::milliseconds timeout)
+    {
+        tcpHandshakeTimeout = timeout;
+    }
+
+    /**
+     * Sets the amount of received UDP messages that can wait for the forwarding thread, and what happens to messages received while it is full.
+     * Only used by the epoll engine, which receives and forwards on separate threads.
+     */
+    void Forwarder::setUDPQueue(const size_t queueSize, const OverflowPolicy policy)
+    {
+        udpQueueSize = queueSize;
+        udpOverflowPolicy = policy;
+    }
+
+    /**
+     * Sets whether runs of equal sized messages are sent to each peer with a single UDP_SEGMENT send. Only used by the epoll engine, and only
+     * while the kernel accepts it. Coalesced reads (UDP_GRO) are split whenever the receiving socket has them enabled.
+     */
+    void Forwarder::setUDPOffload(const bool enabled)
+    {
+        udpOffload = enabled;
+    }
+
+    /**
+     * Sets how many threads receive UDP datagrams, each from its own socket bound to the UDP port with SO_REUSEPORT. The kernel picks the
+     * socket by a hash of each datagram's addresses, or by the CPU it was received on when CPU steering is enabled. Only used by the epoll engine.
+     */
+    void Forwarder::setUDPReceivers(const size_t receiverCount, const bool cpuSteering)
+    {
+        udpReceiverCount = receiverCount == 0 ? 1 : receiverCount;
+        udpCPUSteering = cpuSteering;
+    }
+
+    /**
+     * Sets how long a UDP peer can go without sending a datagram or joining again before it is removed from its group, 0 never removes peers.
+     * Preconfigured addresses are only removed when expirePreconfigured is set.
+     */
+    void Forwarder::setUDPPeerExpiry(const std::chrono::milliseconds ttl, const bool expirePreconfigured)
+    {
+        udpPeerTTL = ttl.count() < 0 ? std::chrono::milliseconds(0) : ttl;
+        udpExpirePreconfigured = expirePreconfigured;
     }
 
     void Forwarder::preConfigureTCPAddress(const std::string& groupId, kt::SocketAddress address)
     {
-        if (tcpPreconfigured.find(address) != tcpPreconfigured.end())
+        if (!tcpPreconfigured.insert(address).second)
         {
-            std::cout << "[TCP] - Address [" << kt::getAddress(address).value_or("") + ":" + std::to_string(kt::getPortNumber(address)) << "] is already preconfigured, skipping..." << std::endl;
+            logInfo("[TCP] - Address [", kt::getAddress(address).value_or(""), ":", kt::getPortNumber(address), "] is already preconfigured, skipping...");
         }
         else
         {
-            std::cout << "[TCP] - Adding address [" << kt::getAddress(address).value_or("") + ":" + std::to_string(kt::getPortNumber(address)) << "] to TCP preconfiguration list for group [" << groupId << "]." << std::endl;
-            tcpPreconfigured.insert(std::make_pair(address, groupId));
+            logInfo("[TCP] - Adding address [", kt::getAddress(address).value_or(""), ":", kt::getPortNumber(address), "] to TCP preconfiguration list for group [", groupId, "].");
+            tcpPreconfiguredGroups.push_back(groupId);
         }
     }
 
-    void Forwarder::addAddressToUDPGroup(kt::SocketAddress address)
+    void Forwarder::setIOEngine(const IOEngine engine)
+    {
+        ioEngine = engine;
+    }
+
+    /**
+     * Samples one in every sampleRate forwarded messages into a trace ring holding the provided number of events. A sample rate of 0 disables
+     * sampling, although every message is still traced while the debug flag is set.
+     */
+    void Forwarder::setTracing(const uint64_t sampleRate, const size_t capacity)
+    {
+        tracer = std::make_unique<Tracer>(sampleRate, capacity);
+    }
+
+    void Forwarder::preConfigureUDPAddress(const std::string& groupId, kt::SocketAddress address)
     {
-        udpKnownPeers.emplace(address);
+        logInfo("[UDP] - Adding address [", kt::getAddress(address).value_or(""), ":", kt::getPortNumber(address), "] to UDP group [", groupId, "].");
+        addAddressToUDPGroup(groupId, address, true);
+    }
+
+    /**
+     * Adds the address to the provided UDP group, creating the group if it does not exist yet. The default group's ID is the empty string.
+     * Adding an address that is already in the group counts as hearing from it, so joining again keeps a peer from expiring.
+     */
+    void Forwarder::addAddressToUDPGroup(const std::string& groupId, kt::SocketAddress address, const bool preconfigured)
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::shared_ptr<UDPPeerLiveness> joined;
+        std::lock_guard<std::mutex> lock(udpGroupsMutex);
+        udpGroups.update([&](UDPGroups& groups)
+        {
+            std::unordered_map<std::string, uint32_t>::iterator group = groups.indexes.find(groupId);
+            if (group == groups.indexes.end())
+            {
+                group = groups.indexes.emplace(groupId, static_cast<uint32_t>(groups.ids.size())).first;
+                groups.ids.push_back(groupId);
+                groups.peers.push_back(std::make_shared<const UDPGroupPeers>());
+            }
+            std::optional<size_t> position = groups.peers[group->second]->addresses.find(address);
+            if (position.has_value())
+            {
+                groups.peers[group->second]->liveness[*position]->lastSeen.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+                return;
+            }
+            std::shared_ptr<UDPGroupPeers> peers = std::make_shared<UDPGroupPeers>(*groups.peers[group->second]);
+            peers->addresses.insert(address);
+            joined = std::make_shared<UDPPeerLiveness>(address, group->second, preconfigured, now);
+            peers->liveness.push_back(joined);
+            groups.peers[group->second] = std::move(peers);
+        });
+
+        // Peers added before the forwarder starts are scheduled when the wheel is created
+        if (joined != nullptr && udpPeerExpiry.has_value())
+        {
+            scheduleUDPPeerExpiry(std::move(joined));
+        }
     }
 
     void Forwarder::start()
     {
+        if (ioEngine == IOEngine::IoUring)
+        {
+            if (!isIoUringSupported())
+            {
+                logInfo("io_uring is not available on this system, falling back to the [", ioEngineToString(IOEngine::Epoll), "] I/O engine.");
+                ioEngine = IOEngine::Epoll;
+            }
+            else if (tcpZeroCopyThreshold > 0 || !tcpSpliceGroups.empty())
+            {
+                logInfo("[TCP] - Zero copy sends and splice forwarding are not used with the io_uring I/O engine.");
+            }
+        }
+
         if (tcpServerSocket.has_value())
         {
-            std::cout << "[TCP] - Running TCP forwarder on port [" << tcpServerSocket->getPort() << "]" << std::endl;
+            logInfo("[TCP] - Running TCP forwarder on port [", tcpServerSocket->getPort(), "]");
             startTCPForwarder();
         }
         else
         {
-            std::cout << "[TCP] - No TCP socket was provided, TCP forwarding is disabled." << std::endl;
+            logInfo("[TCP] - No TCP socket was provided, TCP forwarding is disabled.");
         }
 
         if (udpRecieveSocket.has_value())
         {
             if (udpRecieveSocket->isUdpBound())
             {
-                std::cout << "[UDP] - Running UDP forwarder on port [" << udpRecieveSocket->getListeningPort().value() << "]" << std::endl;
+                logInfo("[UDP] - Running UDP forwarder on port [", udpRecieveSocket->getListeningPort().value(), "]");
                 startUDPForwarder();
             }
             else
             {
-                std::cout << "[UDP] - Provided UDP socket needs to be bound before it is passed into the forwarder. UDP forwarding will be disabled." << std::endl; 
+                logWarning("[UDP] - Provided UDP socket needs to be bound before it is passed into the forwarder. UDP forwarding will be disabled."); 
             }
         }
         else
         {
-            std::cout << "[UDP] - No UDP socket was provided, UDP forwarding is disabled." << std::endl;
+            logInfo("[UDP] - No UDP socket was provided, UDP forwarding is disabled.");
         }
     }
 
@@ -89,303 +453,2201 @@ namespace forwarder
     {
         forwarderIsRunning = true;
 
-        // Start one thread constantly receiving new connections and adding them to their correct group
-        std::thread listeningThread(&Forwarder::startTCPConnectionListener, this);
-        
-        // Start a second thread that is constantly polling all TCPSockets in the session map and forwarding 
-        // those messages to the other sockets in its group.
-        std::thread dataForwarderThread(&Forwarder::startTCPDataForwarder, this);
-
-        tcpRunningThreads = std::make_pair(std::move(listeningThread), std::move(dataForwarderThread));
-    }
-
-    void Forwarder::startTCPConnectionListener()
-    {
-        kt::ServerSocket& serverSocket = tcpServerSocket.value();
+        for (size_t i = 0; i < tcpWorkerCount; i++)
+        {
+            tcpShards.push_back(std::make_unique<TCPShard>());
+            tcpShards.back()->index = i;
+            tcpShards.back()->bufferPool = BufferPool(maxReadInSize);
+        }
 
-        std::cout << "[TCP] - Starting TCP connection listener..." << std::endl;
-        while(forwarderIsRunning)
+        // The first worker always accepts from the provided server socket. When SO_REUSEPORT is enabled every other worker
+        // binds its own listener to the same port so the kernel spreads incoming connections across all workers.
+        tcpShards[0]->listeningSocket = tcpServerSocket->getSocket();
+        if (tcpReusePort && tcpWorkerCount > 1)
         {
-            try
+            for (size_t i = 1; i < tcpWorkerCount; i++)
             {
-                kt::TCPSocket socket = serverSocket.acceptTCPConnection(10000); // microseconds
-                std::string addressString = kt::getAddress(socket.getSocketAddress()).value_or("") + ":" + std::to_string(kt::getPortNumber(socket.getSocketAddress()));
-
-                auto preConfiguredAddress = tcpPreconfigured.find(socket.getSocketAddress());
-                if (preConfiguredAddress != tcpPreconfigured.end())
+                std::optional<int> listener = setUpReusePortTCPListener(tcpServerSocket->getSocket());
+                if (listener.has_value())
                 {
-                    std::cout << "[TCP] - Accepted connection to pre-configured address [" << addressString << "] adding to group [" << preConfiguredAddress->second << "]." << std::endl;
-                    addSocketToTCPGroup(preConfiguredAddress->second, socket);
+                    tcpShards[i]->listeningSocket = *listener;
                 }
                 else
                 {
-                    std::string firstMessage = socket.receiveAmount(maxReadInSize);
-                    std::cout << "[TCP] - Accepted new connection from [" << addressString << "] and read message of size [" << firstMessage.size() << "].\n";
-
-                    if (debug)
-                    {   
-                        std::cout << "[TCP] - Accepted connection message: [" << firstMessage << "]\n";
-                    }
-
-                    if (firstMessage.rfind(newClientPrefix, 0) == 0)
-                    {
-                        std::string groupId = firstMessage.substr(newClientPrefix.size());
-                        addSocketToTCPGroup(groupId, socket);
-                    }
-                    else
-                    {
-                        // First message does not start with prefix, just close connection
-                        std::cout << "[TCP] - First message from address [" << addressString << "] did not start with prefix: [" << newClientPrefix << "]. Closing connection.\n";
-                        socket.close();
-                    }
+                    logWarning("[TCP] - Failed to create SO_REUSEPORT listener for worker [", i, "], connections will be accepted by other workers.");
                 }
             }
-            catch(kt::TimeoutException e)
-            {
-                // Timeout occurred its fine
-            }
-            catch(kt::SocketException e)
-            {
-                std::cout << "[TCP] - Failed to accept incoming client: " << e.what() << std::endl;
-            }
-
-            std::cout << std::flush;
         }
 
-        // If we exit the loop, close the server socket
-        serverSocket.close();
-    }
-
-    void Forwarder::startTCPDataForwarder()
-    {
-        std::cout << "[TCP] - Starting TCP forwarder listener..." << std::endl;
-        while (forwarderIsRunning)
+        // Connections are accepted in batches until the listener would block. Unless preconfigured clients (which may never send anything)
+        // are expected, the kernel only reports a connection once its join message has arrived, so silent clients never reach the workers
+        const int deferAcceptSeconds = static_cast<int>(std::max<long long>(1, (tcpHandshakeTimeout.count() + 999) / 1000));
+        for (std::unique_ptr<TCPShard>& shard : tcpShards)
         {
-            std::vector<size_t> toRemove;
-            for (auto it = tcpSessions.begin(); it != tcpSessions.end(); ++it)
+            if (shard->listeningSocket != -1)
             {
-                std::string groupID = it->first;
-                for (size_t i = 0; i < it->second.size(); i++)
+                setNonBlocking(shard->listeningSocket);
+                if (tcpPreconfigured.empty() && !setDeferAccept(shard->listeningSocket, deferAcceptSeconds))
                 {
-                    const kt::TCPSocket& receiveSocket = it->second[i];
-                    if (receiveSocket.ready(1))
-                    {
-                        std::string received = receiveSocket.receiveAmount(maxReadInSize);
-                        if (received.empty())
-                        {
-                            continue;
-                        }
-                        
-                        std::string uuidString = getNewUUID();
-                        if (debug)
-                        {
-                            std::cout << "[TCP - " + uuidString + "] - Group [" << groupID << "] with [" << it->second.size() << "] nodes. Received content [" << received << "] from peer [" << i << "] forwarding to other peers...\n";
-                        }
-                        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-                        for (size_t j = 0; j < it->second.size(); j++)
-                        {
-                            if (j != i)
-                            {
-                                const kt::TCPSocket& forwardToSocket = it->second[j];
-                                if (!forwardToSocket.connected())
-                                {
-                                    if (debug)
-                                    {
-                                        std::cout << "[TCP - " + uuidString + "] - Group [" << groupID << "], peer [" << j << "] is no longer connected, marking for removal from group.\n";
-                                    }
-                                    toRemove.push_back(j);
-                                }
-                                else
-                                {
-                                    if (forwardToSocket.send(received, MSG_NOSIGNAL).first)
-                                    {
-                                        if (debug)
-                                        {
-                                            std::cout << "[TCP - " + uuidString + "] - Group [" << groupID << "], successfully forwarded to peer [" << j << "]\n";
-                                        }
-                                    }
-                                    else
-                                    {
-                                        if (debug)
-                                        {
-                                            std::cout << "[TCP - " + uuidString + "] - Group [" << groupID << "], failed to send to peer [" << j << "], marking for removal from group.\n";
-                                        }
-                                        toRemove.push_back(j);
-                                    }
-                                }
-                            }
-                        }
-                        if (debug)
-                        {
-                            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-                            std::cout << "[TCP - " + uuidString + "] - Group [" << groupID << "] took [" << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms] to forward message to [" << it->second.size() - 1 << "] peers.\n";
-                        }
-                        
-                        for (size_t index : toRemove)
-                        {
-                            std::vector<kt::TCPSocket>::iterator socketPosition = std::next(it->second.begin(), index);
-                            std::cout << "[TCP - " + uuidString + "] - Group [" << groupID << "] - Closing and removing socket with address [" << kt::getAddress(socketPosition->getSocketAddress()).value_or("") + ":" + std::to_string(kt::getPortNumber(socketPosition->getSocketAddress())) << "].\n";
-                            socketPosition->close();
-                            it->second.erase(socketPosition);
-                        }
-                        toRemove.clear();
-                    }
+                    logWarning("[TCP] - Unable to enable TCP_DEFER_ACCEPT for worker [", shard->index, "].");
                 }
             }
         }
 
-        // Once we are out of the loop just run through and close everything
-        for (auto it = tcpSessions.begin(); it != tcpSessions.end(); ++it)
+        // Each worker waits on its own epoll instance which holds its listening socket, every socket in the groups it owns
+        // and the wake descriptor used by stop() and connection handoffs. Only sockets that are ready are returned from each wait,
+        // so the cost of each iteration scales with the amount of active sockets rather than the total amount of sockets.
+        for (std::unique_ptr<TCPShard>& shard : tcpShards)
         {
-            for (const kt::TCPSocket& socket : it->second)
+            if (ioEngine == IOEngine::IoUring)
             {
-                socket.close();
+                shard->thread = std::thread(&Forwarder::startTCPUringWorker, this, std::ref(*shard));
+                continue;
             }
-        }
-        tcpSessions.clear();
-    }
-
-    bool Forwarder::tcpGroupWithIdExists(std::string& groupId)
-    {
-        return tcpSessions.find(groupId) != tcpSessions.end();
-    }
 
-    size_t Forwarder::tcpGroupMemberCount(std::string& groupId)
-    {
-        auto group = tcpSessions.find(groupId);
-        if (group != tcpSessions.end())
-        {
-            return group->second.size();
+            if (shard->listeningSocket != -1)
+            {
+                shard->eventLoop.add(shard->listeningSocket, EPOLLIN);
+            }
+            shard->thread = std::thread(&Forwarder::startTCPWorker, this, std::ref(*shard));
         }
-        return 0;
-    }
-
-    void Forwarder::startUDPForwarder()
-    {
-        forwarderIsRunning = true;
-
-        std::thread listeningThread(&Forwarder::startUDPListener, this);
-        std::thread responderThread(&Forwarder::startUDPDataForwarder, this);
-        udpRunningThreads = std::make_pair(std::move(listeningThread), std::move(responderThread));
     }
 
-    void Forwarder::startUDPListener()
+    void Forwarder::startTCPWorker(TCPShard& shard)
     {
-        kt::UDPSocket& udpSocket = udpRecieveSocket.value();
-
-        std::cout << "[UDP] - Starting UDP forwarder connection listener..." << std::endl;
+        logInfo("[TCP] - Starting TCP worker [", shard.index, "]...");
+        std::chrono::microseconds waitTimeout = std::chrono::microseconds(-1);
         while (forwarderIsRunning)
         {
-            if (udpSocket.ready())
+            int eventCount = shard.eventLoop.wait(waitTimeout);
+            for (int i = 0; i < eventCount; i++)
             {
-                std::pair<std::optional<std::string>, std::pair<int, kt::SocketAddress>> result = udpSocket.receiveFrom(maxReadInSize);
-            
-                if (result.second.first > 0 && result.first.has_value())
+                const epoll_event& event = shard.eventLoop.getEvent(i);
+                if (shard.eventLoop.isWakeEvent(event))
                 {
-                    std::string addressString = kt::getAddress(result.second.second).value_or("") + ":" + std::to_string(kt::getPortNumber(result.second.second));
-                    std::string& message = result.first.value();
-
-                    if (debug)
+                    shard.eventLoop.clearWake();
+                    addHandedOffTCPSockets(shard);
+                }
+                else if (event.data.fd == shard.listeningSocket)
+                {
+                    acceptTCPConnections(shard);
+                }
+                else if (shard.pendingHandshakes.find(event.data.fd) != shard.pendingHandshakes.end())
+                {
+                    completeTCPHandshake(shard, event.data.fd);
+                }
+                else
+                {
+                    TCPPeer* peer = shard.findPeer(event.data.fd);
+                    if (peer == nullptr)
                     {
-                        std::cout << "[UDP] - Received message [" << message << "] from address: [" << addressString << "]\n";
+                        continue;
                     }
 
-                    // This is a new client, check their first message content
-                    if (message.rfind(newClientPrefix, 0) == 0)
+                    if ((event.events & EPOLLERR) && peer->zeroCopyTracker.has_value())
                     {
-                        std::string recievingPort = message.substr(newClientPrefix.size());
-                        std::cout << "[UDP] - New client joined UDP group from address [" << addressString << "] with request reply port [" << recievingPort << "]\n";
-
-                        kt::SocketAddress address = result.second.second;
-                        address.ipv4.sin_port = htons(std::atoi(recievingPort.c_str()));
-                        addAddressToUDPGroup(address);
+                        // Zero copy completions are reported through the socket's error queue
+                        readZeroCopyCompletions(event.data.fd, *peer->zeroCopyTracker, shard.bufferPool);
+                    }
+                    if ((event.events & EPOLLOUT) && !flushTCPPeer(shard, *peer))
+                    {
+                        removeSocketFromTCPGroup(shard, event.data.fd);
+                        continue;
                     }
-                    else
+                    if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
                     {
-                        udpMessageQueue.push(message);
+                        forwardTCPData(shard, event.data.fd);
                     }
                 }
             }
-            std::cout << std::flush;
+
+            // Wait no longer than the next flush, handshake or lag check deadline
+            waitTimeout = earliestTimeout(earliestTimeout(flushScheduledTCPPeers(shard), expireTCPHandshakes(shard)), expireLaggingTCPPeers(shard));
+            publishTCPRegistry(shard);
         }
-        udpSocket.close();
+
+        closeTCPShard(shard);
     }
 
-    void Forwarder::startUDPDataForwarder()
+    /**
+     * Closes every socket owned by the shard and returns all of their buffers to the shard's pool, once the shard's worker has stopped.
+     */
+    void Forwarder::closeTCPShard(TCPShard& shard)
     {
-        std::cout << "[UDP] - Starting UDP data forwarder listener..." << std::endl;
-        kt::UDPSocket sendSocket;
-        while (forwarderIsRunning)
+        // Once we are out of the loop just run through and close everything
+        for (auto it = shard.pendingHandshakes.begin(); it != shard.pendingHandshakes.end(); ++it)
         {
-            if (!udpMessageQueue.empty())
+            it->second.socket.close();
+        }
+        shard.pendingHandshakes.clear();
+        shard.handshakeDeadlines.clear();
+
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end(); ++it)
+        {
+            for (TCPPeer& peer : it->second.members)
             {
-                std::string uuidString = getNewUUID();
-                std::string message = udpMessageQueue.front();
-                udpMessageQueue.pop();
+                releaseTCPPeer(shard, peer);
+            }
+        }
+        shard.peers.clear();
+        shard.sessions.clear();
+        shard.changedGroups.clear();
+        shard.registry.publish(std::make_shared<const TCPGroupRegistry>());
 
-                if (debug)
-                {
-                    std::cout << "[UDP - " + uuidString + "] - Received message [" << message << "] forwarding to peers.\n";
-                }
+        for (auto it = shard.closingPeers.begin(); it != shard.closingPeers.end(); ++it)
+        {
+            releaseTCPPeer(shard, it->second);
+        }
+        shard.closingPeers.clear();
+        for (MessageBuffer* buffer : shard.providedBuffers)
+        {
+            shard.bufferPool.release(buffer);
+        }
+        shard.providedBuffers.clear();
 
-                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-                for (const kt::SocketAddress& addr : udpKnownPeers)
-                {
-                    std::pair<bool, int> result = sendSocket.sendTo(message, addr);
-                    if (debug)
-                    {
-                        std::cout << "[UDP - " + uuidString + "] - Forwarded to peer with address: [" << kt::getAddress(addr).value_or("") + ":" + std::to_string(kt::getPortNumber(addr)) << "]. With result [" << result.second << "]\n";
-                    }
-                }
+        shard.receivePipe.close();
+        if (shard.nullDescriptor != -1)
+        {
+            close(shard.nullDescriptor);
+            shard.nullDescriptor = -1;
+        }
 
-                if (debug)
-                {
-                    std::cout << "[UDP - " + uuidString + "] - Forwarded to [" << udpKnownPeers.size() << "] peer(s).\n";
-                    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-                    std::cout << "[UDP - " + uuidString + "] - Took [" << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms] to forward message to [" << udpKnownPeers.size() << "] peers.\n";
-                }
-            }
-            else
+        {
+            std::lock_guard<std::mutex> lock(shard.handoffMutex);
+            for (std::pair<std::string, kt::TCPSocket>& entry : shard.handoffQueue)
             {
-                using namespace std::chrono_literals;
-                std::this_thread::sleep_for(10us);
+                entry.second.close();
             }
+            shard.handoffQueue.clear();
         }
 
-        udpKnownPeers.clear();
-    }
-
-    size_t Forwarder::udpGroupMemberCount()
-    {
-        return udpKnownPeers.size();
-    }
-
-    void Forwarder::stop()
-    {
-        forwarderIsRunning = false;
+        if (shard.listeningSocket == tcpServerSocket->getSocket())
+        {
+            tcpServerSocket->close();
+        }
+        else if (shard.listeningSocket != -1)
+        {
+            close(shard.listeningSocket);
+        }
     }
 
-    void Forwarder::join()
+    void Forwarder::addHandedOffTCPSockets(TCPShard& shard)
     {
-        if (tcpRunningThreads.has_value())
+        std::vector<std::pair<std::string, kt::TCPSocket>> handedOff;
         {
-            tcpRunningThreads->first.join();
-            tcpRunningThreads->second.join();
+            std::lock_guard<std::mutex> lock(shard.handoffMutex);
+            handedOff.swap(shard.handoffQueue);
         }
-
-        if (udpRunningThreads.has_value())
+        for (std::pair<std::string, kt::TCPSocket>& entry : handedOff)
         {
-            udpRunningThreads->first.join();
-            udpRunningThreads->second.join();
+            addSocketToTCPGroup(shard, entry.first, entry.second);
         }
     }
 
-    std::string getNewUUID()
+
+    /**
+     * Accepts every connection waiting on the shard's listening socket, so a burst of reconnecting clients is drained in one go
+     * instead of one connection per wake up.
+     */
+    void Forwarder::acceptTCPConnections(TCPShard& shard)
     {
-        uuid_t uuid{};
-        char temp[100];
-        uuid_generate(uuid);
-        uuid_unparse(uuid, temp);
-        return std::string(temp);
+        while (forwarderIsRunning)
+        {
+            std::optional<kt::TCPSocket> accepted = forwarder::acceptTCPConnection(shard.listeningSocket);
+            if (accepted.has_value())
+            {
+                handleAcceptedTCPConnection(shard, accepted.value());
+            }
+            else if (errno == EINTR || errno == ECONNABORTED)
+            {
+                // The connection was reset before it could be accepted, carry on with the next one
+            }
+            else
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    getLogger().log(shard.acceptErrorLog, LogLevel::Warning, "[TCP] - Failed to accept incoming client on worker [", shard.index, "] with error [", errno, "].");
+                }
+                return;
+            }
+        }
+    }
+
+    void Forwarder::handleAcceptedTCPConnection(TCPShard& shard, kt::TCPSocket socket)
+    {
+        std::string addressString = kt::getAddress(socket.getSocketAddress()).value_or("") + ":" + std::to_string(kt::getPortNumber(socket.getSocketAddress()));
+
+        std::optional<size_t> preConfiguredAddress = tcpPreconfigured.find(socket.getSocketAddress());
+        if (preConfiguredAddress.has_value())
+        {
+            const std::string& groupId = tcpPreconfiguredGroups[*preConfiguredAddress];
+            logInfo("[TCP] - Accepted connection to pre-configured address [", addressString, "] adding to group [", groupId, "].");
+            dispatchSocketToTCPGroup(shard, groupId, socket);
+            return;
+        }
+
+        // Wait for the join message to arrive through the event loop rather than blocking on it here
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        if (tcpHandshakeTimeout.count() > 0)
+        {
+            deadline = std::chrono::steady_clock::now() + tcpHandshakeTimeout;
+            shard.handshakeDeadlines.emplace_back(socket.getSocket(), deadline);
+        }
+        shard.pendingHandshakes[socket.getSocket()] = TCPPendingHandshake{ socket, "", deadline };
+        if (shard.ring.isOpen())
+        {
+            // A single shot receive, so nothing is left in flight on this ring when the socket is handed to another worker
+            shard.ring.prepareReceive(socket.getSocket(), TCP_BUFFER_GROUP, false, encodeUringOperation(UringOperation::Handshake, socket.getSocket()));
+        }
+        else
+        {
+            shard.eventLoop.add(socket.getSocket(), EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    void Forwarder::completeTCPHandshake(TCPShard& shard, int descriptor)
+    {
+        shard.handshakeBuffer.resize(maxReadInSize);
+        ssize_t receivedAmount = recv(descriptor, shard.handshakeBuffer.data(), shard.handshakeBuffer.size(), MSG_DONTWAIT);
+        continueTCPHandshake(shard, descriptor, shard.handshakeBuffer.data(), receivedAmount);
+    }
+
+    /**
+     * Adds the received bytes to the pending connection's join message. The join message has no terminator, so it is complete once a read
+     * returns anything other than the start of the prefix. A connection that sent part of the prefix waits for the rest of it,
+     * so a join message split across segments is still accepted.
+     */
+    void Forwarder::continueTCPHandshake(TCPShard& shard, int descriptor, const char* data, const ssize_t receivedAmount)
+    {
+        auto pending = shard.pendingHandshakes.find(descriptor);
+        if (pending == shard.pendingHandshakes.end())
+        {
+            return;
+        }
+
+        TCPPendingHandshake& handshake = pending->second;
+        if (receivedAmount > 0)
+        {
+            handshake.received.append(data, static_cast<size_t>(receivedAmount));
+        }
+        const bool waitForMore = receivedAmount < 0 ? !isDisconnected(receivedAmount)
+            : receivedAmount > 0 && handshake.received.size() < newClientPrefix.size() && newClientPrefix.compare(0, handshake.received.size(), handshake.received) == 0;
+        if (waitForMore)
+        {
+            if (shard.ring.isOpen())
+            {
+                shard.ring.prepareReceive(descriptor, TCP_BUFFER_GROUP, false, encodeUringOperation(UringOperation::Handshake, descriptor));
+            }
+            return;
+        }
+
+        kt::TCPSocket socket = handshake.socket;
+        std::string firstMessage = std::move(handshake.received);
+        shard.pendingHandshakes.erase(pending);
+        if (!shard.ring.isOpen())
+        {
+            shard.eventLoop.remove(descriptor);
+        }
+
+        if (receivedAmount > 0)
+        {
+            joinTCPGroup(shard, socket, firstMessage);
+        }
+        else
+        {
+            if (debug)
+            {
+                logDebug("[TCP] - Connection [", descriptor, "] disconnected before sending its join message, closing connection.");
+            }
+            socket.close();
+        }
+    }
+
+    /**
+     * Closes every pending connection that has not sent its join message before its deadline.
+     * Returns how long until the next deadline, or a negative duration if no handshakes are pending.
+     */
+    std::chrono::microseconds Forwarder::expireTCPHandshakes(TCPShard& shard)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        while (!shard.handshakeDeadlines.empty())
+        {
+            const std::pair<int, std::chrono::steady_clock::time_point> next = shard.handshakeDeadlines.front();
+            auto pending = shard.pendingHandshakes.find(next.first);
+            // Skip connections that have joined, and descriptor numbers that have since been re-used by another connection
+            if (pending == shard.pendingHandshakes.end() || pending->second.deadline != next.second)
+            {
+                shard.handshakeDeadlines.pop_front();
+                continue;
+            }
+            if (next.second > now)
+            {
+                return std::chrono::ceil<std::chrono::microseconds>(next.second - now);
+            }
+
+            shard.handshakeDeadlines.pop_front();
+            logInfo("[TCP] - Connection [", next.first, "] did not send its join message within [", tcpHandshakeTimeout.count(), "ms], closing connection.");
+            if (shard.ring.isOpen())
+            {
+                // The handshake receive is still in flight, shutting the socket down completes it and the socket is closed with its completion
+                pending->second.deadline = std::chrono::steady_clock::time_point::max();
+                shutdown(next.first, SHUT_RDWR);
+            }
+            else
+            {
+                shard.eventLoop.remove(next.first);
+                pending->second.socket.close();
+                shard.pendingHandshakes.erase(pending);
+            }
+        }
+        return std::chrono::microseconds(-1);
+    }
+
+    /**
+     * Places the socket into the group named by its first message, or closes it if the first message is not a join message.
+     */
+    void Forwarder::joinTCPGroup(TCPShard& shard, kt::TCPSocket socket, const std::string& firstMessage)
+    {
+        std::string addressString = kt::getAddress(socket.getSocketAddress()).value_or("") + ":" + std::to_string(kt::getPortNumber(socket.getSocketAddress()));
+        logInfo("[TCP] - Accepted new connection from [", addressString, "] and read message of size [", firstMessage.size(), "].");
+
+        if (debug)
+        {
+            logDebug("[TCP] - Accepted connection message: [", firstMessage, "]");
+        }
+
+        if (firstMessage.rfind(newClientPrefix, 0) == 0)
+        {
+            std::string groupId = firstMessage.substr(newClientPrefix.size());
+            dispatchSocketToTCPGroup(shard, groupId, socket);
+        }
+        else
+        {
+            // First message does not start with prefix, just close connection
+            logInfo("[TCP] - First message from address [", addressString, "] did not start with prefix: [", newClientPrefix, "]. Closing connection.");
+            socket.close();
+        }
+    }
+
+    void Forwarder::forwardTCPData(TCPShard& shard, int descriptor)
+    {
+        const TCPPeerLocation& location = shard.peers.at(descriptor);
+        TCPGroup& group = *location.group;
+
+        MessageBuffer* buffer = nullptr;
+        bool connected = true;
+        if (group.splice)
+        {
+            connected = spliceTCPData(shard, group, descriptor);
+        }
+        else if (group.framing == FramingMode::None)
+        {
+            buffer = shard.bufferPool.acquire();
+            // Buffers grown to hold a large frame are recycled through the same pool, so the read size is capped explicitly
+            ssize_t receivedAmount = recv(descriptor, buffer->data.data(), std::min<size_t>(buffer->data.size(), maxReadInSize), MSG_DONTWAIT);
+            if (receivedAmount > 0)
+            {
+                buffer->size = static_cast<size_t>(receivedAmount);
+            }
+            else
+            {
+                connected = !isDisconnected(receivedAmount);
+                shard.bufferPool.release(buffer);
+                buffer = nullptr;
+            }
+        }
+        else
+        {
+            buffer = readTCPFrames(shard, group, *group.members.get(location.handle), connected);
+        }
+
+        if (!connected)
+        {
+            if (debug)
+            {
+                logDebug("[TCP] - Group [", group.id, "], peer with descriptor [", descriptor, "] is no longer connected, removing from group.");
+            }
+            removeSocketFromTCPGroup(shard, descriptor);
+        }
+        else if (buffer != nullptr)
+        {
+            forwardTCPBuffer(shard, group, descriptor, buffer);
+        }
+    }
+
+    /**
+     * Reads from a peer of a framed group, returning a buffer that holds only the whole frames received so far, or nullptr if no frame was completed.
+     * The bytes of an incomplete frame are kept on the peer until the rest of the frame arrives, so every forwarded buffer starts and ends on a frame boundary.
+     * All whole frames from a single read are returned in one buffer so they are forwarded to each peer in one send.
+     * Sets connected to false if the peer has disconnected or sent an invalid frame.
+     */
+    MessageBuffer* Forwarder::readTCPFrames(TCPShard& shard, TCPGroup& group, TCPPeer& peer, bool& connected)
+    {
+        MessageBuffer* buffer = peer.partialFrame != nullptr ? peer.partialFrame : shard.bufferPool.acquire();
+        peer.partialFrame = nullptr;
+        if (buffer->size == buffer->data.size())
+        {
+            buffer->data.resize(buffer->size + maxReadInSize);
+        }
+
+        ssize_t receivedAmount = recv(peer.socket.getSocket(), buffer->data.data() + buffer->size, buffer->data.size() - buffer->size, MSG_DONTWAIT);
+        if (receivedAmount <= 0)
+        {
+            connected = !isDisconnected(receivedAmount);
+            if (connected && buffer->size > 0)
+            {
+                peer.partialFrame = buffer;
+            }
+            else
+            {
+                shard.bufferPool.release(buffer);
+            }
+            return nullptr;
+        }
+        buffer->size += static_cast<size_t>(receivedAmount);
+        return completeTCPFrames(shard, group, peer, buffer, connected);
+    }
+
+    /**
+     * Like readTCPFrames(), for bytes that have already been received into the provided buffer.
+     * The buffer is appended to any incomplete frame held by the peer, so the bytes are only copied when a frame spans multiple reads.
+     */
+    MessageBuffer* Forwarder::appendTCPFrames(TCPShard& shard, TCPGroup& group, TCPPeer& peer, MessageBuffer* received, bool& connected)
+    {
+        MessageBuffer* buffer = peer.partialFrame;
+        if (buffer == nullptr)
+        {
+            return completeTCPFrames(shard, group, peer, received, connected);
+        }
+
+        peer.partialFrame = nullptr;
+        if (buffer->data.size() < buffer->size + received->size)
+        {
+            buffer->data.resize(buffer->size + received->size);
+        }
+        std::memcpy(buffer->data.data() + buffer->size, received->data.data(), received->size);
+        buffer->size += received->size;
+        shard.bufferPool.release(received);
+        return completeTCPFrames(shard, group, peer, buffer, connected);
+    }
+
+    /**
+     * Splits the buffer, which starts on a frame boundary, into the whole frames it holds and the start of the next frame which is kept on the peer.
+     */
+    MessageBuffer* Forwarder::completeTCPFrames(TCPShard& shard, TCPGroup& group, TCPPeer& peer, MessageBuffer* buffer, bool& connected)
+    {
+        FrameScan scan = scanFrames(group.framing, buffer->data.data(), buffer->size, tcpMaxFrameSize);
+        if (scan.invalid)
+        {
+            logInfo("[TCP] - Group [", group.id, "] - Peer [", peer.socket.getSocket(), "] sent an invalid frame header or a frame larger than [", tcpMaxFrameSize, "] bytes.");
+            shard.bufferPool.release(buffer);
+            connected = false;
+            return nullptr;
+        }
+
+        if (scan.completeBytes == 0)
+        {
+            // The buffer only grows as the frame's bytes arrive, so a header announcing a large frame does not hold memory the peer never sends
+            peer.partialFrame = buffer;
+            return nullptr;
+        }
+
+        if (scan.completeBytes < buffer->size)
+        {
+            // Only the start of the next frame is copied, the whole frames are forwarded straight from the buffer they were read into
+            const size_t remainderSize = buffer->size - scan.completeBytes;
+            MessageBuffer* remainder = shard.bufferPool.acquire();
+            if (remainder->data.size() < remainderSize)
+            {
+                remainder->data.resize(remainderSize);
+            }
+            std::memcpy(remainder->data.data(), buffer->data.data() + scan.completeBytes, remainderSize);
+            remainder->size = remainderSize;
+            peer.partialFrame = remainder;
+            buffer->size = scan.completeBytes;
+        }
+
+        if (debug)
+        {
+            logDebug("[TCP] - Group [", group.id, "] - Peer [", peer.socket.getSocket(), "] completed [", scan.frameCount, "] frame(s) totalling [", scan.completeBytes, "] bytes.");
+        }
+        return buffer;
+    }
+
+    /**
+     * Queues the provided buffer for every member of the group other than the sender, then drops the caller's reference to the buffer.
+     */
+    void Forwarder::forwardTCPBuffer(TCPShard& shard, TCPGroup& group, int descriptor, MessageBuffer* buffer)
+    {
+        const std::string& groupID = group.id;
+
+        const uint64_t traceId = tracer->sample(debug);
+        tracer->record(traceId, TraceEventType::Receive, descriptor, buffer->size);
+        group.counters->recordReceived(buffer->size);
+        if (debug)
+        {
+            logDebug("[TCP - ", traceIdToString(traceId), "] - Group [", groupID, "] with [", group.members.size(), "] nodes. Received content [", std::string_view(buffer->data.data(), buffer->size), "] from peer [", descriptor, "] forwarding to other peers...");
+        }
+
+        // Collect handles rather than positions, since erasing a member moves another member into its position
+        std::vector<SlotHandle> toRemove;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        MessageDelivery* delivery = shard.deliveryPool.acquire(start);
+        for (size_t i = 0; i < group.members.size(); i++)
+        {
+            TCPPeer& peer = group.members[i];
+            const int forwardToSocket = peer.socket.getSocket();
+            if (forwardToSocket != descriptor)
+            {
+                if (queueForTCPPeer(shard, group, peer, buffer, delivery, start, traceId))
+                {
+                    if (debug)
+                    {
+                        logDebug("[TCP - ", traceIdToString(traceId), "] - Group [", groupID, "], successfully queued for peer [", forwardToSocket, "] with [", peer.outboundQueue.getQueuedBytes(), "] bytes queued");
+                    }
+                }
+                else
+                {
+                    if (debug)
+                    {
+                        logDebug("[TCP - ", traceIdToString(traceId), "] - Group [", groupID, "], failed to send to peer [", forwardToSocket, "], marking for removal from group.");
+                    }
+                    toRemove.push_back(group.members.handleAt(i));
+                }
+            }
+        }
+        if (debug)
+        {
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            logDebug("[TCP - ", traceIdToString(traceId), "] - Group [", groupID, "] took [", std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), "us] to queue message for [", group.members.size() - 1, "] peers.");
+        }
+
+        // Drop the references taken when the buffer and delivery were acquired, the peers' queues and any zero copy sends hold their own references
+        shard.bufferPool.release(buffer);
+        shard.deliveryPool.release(delivery);
+
+        for (SlotHandle handle : toRemove)
+        {
+            removeSocketFromTCPGroup(shard, group.members.get(handle)->socket.getSocket());
+        }
+    }
+
+    /**
+     * Moves the available data from the sender into the shard's receive pipe, duplicates it into every other member's pipe with tee()
+     * and splices each member's pipe into its socket, so the data is never copied into user space.
+     * A member whose pipe cannot take all of the data is disconnected whatever the slow consumer policy, since dropping part of a stream would corrupt it.
+     * Returns false if the sender has disconnected.
+     */
+    bool Forwarder::spliceTCPData(TCPShard& shard, TCPGroup& group, int descriptor)
+    {
+        ssize_t receivedAmount = shard.receivePipe.spliceFrom(descriptor, maxReadInSize);
+        if (receivedAmount <= 0)
+        {
+            return !isDisconnected(receivedAmount);
+        }
+        const size_t amount = static_cast<size_t>(receivedAmount);
+
+        const uint64_t traceId = tracer->sample(debug);
+        tracer->record(traceId, TraceEventType::Receive, descriptor, amount);
+        group.counters->recordReceived(amount);
+        if (debug)
+        {
+            logDebug("[TCP - ", traceIdToString(traceId), "] - Group [", group.id, "] with [", group.members.size(), "] nodes. Spliced [", amount, "] bytes from peer [", descriptor, "] forwarding to other peers...");
+        }
+
+        std::vector<SlotHandle> toRemove;
+        for (size_t i = 0; i < group.members.size(); i++)
+        {
+            TCPPeer& peer = group.members[i];
+            if (peer.socket.getSocket() == descriptor)
+            {
+                continue;
+            }
+
+            ssize_t duplicated = shard.receivePipe.teeTo(*peer.splicePipe, amount);
+            if (duplicated >= 0 && static_cast<size_t>(duplicated) < amount)
+            {
+                // The pipe holds a byte stream with no message boundaries, dropping what did not fit would corrupt the stream
+                tracer->record(traceId, TraceEventType::Drop, peer.socket.getSocket(), amount - static_cast<size_t>(duplicated));
+                logWarning("[TCP] - Group [", group.id, "] - Peer [", peer.socket.getSocket(), "] exceeded its splice pipe capacity with [", peer.splicePipe->getQueuedBytes(), "] bytes queued, disconnecting.");
+                toRemove.push_back(group.members.handleAt(i));
+                continue;
+            }
+
+            if (duplicated > 0)
+            {
+                tracer->record(traceId, TraceEventType::Send, peer.socket.getSocket(), static_cast<size_t>(duplicated));
+                group.counters->recordSent(static_cast<size_t>(duplicated));
+            }
+
+            if (duplicated < 0)
+            {
+                tracer->record(traceId, TraceEventType::Drop, peer.socket.getSocket(), amount);
+                group.counters->recordSendFailure();
+                if (debug)
+                {
+                    logDebug("[TCP] - Group [", group.id, "], failed to splice to peer [", peer.socket.getSocket(), "], marking for removal from group.");
+                }
+                toRemove.push_back(group.members.handleAt(i));
+            }
+            else if (!peer.waitingForWritable)
+            {
+                scheduleTCPFlush(shard, peer, std::chrono::steady_clock::now() + group.flushWindow);
+            }
+        }
+
+        // Every peer now holds its own reference to the pages, release the receive pipe's copy for the next read
+        shard.receivePipe.discard(shard.nullDescriptor);
+
+        for (SlotHandle handle : toRemove)
+        {
+            removeSocketFromTCPGroup(shard, group.members.get(handle)->socket.getSocket());
+        }
+        return true;
+    }
+
+    /**
+     * Queues the message for the peer and schedules the peer's queue to be written once the group's flush window has passed.
+     * A sampled message is traced as sent to the peer once it is queued, or as dropped if the slow consumer policy dropped it.
+     * Returns false if the peer should be removed because the slow consumer policy disconnected it.
+     */
+    bool Forwarder::queueForTCPPeer(TCPShard& shard, TCPGroup& group, TCPPeer& peer, MessageBuffer* buffer, MessageDelivery* delivery, const std::chrono::steady_clock::time_point now, const uint64_t traceId)
+    {
+        const PushResult result = peer.outboundQueue.push(buffer, shard.bufferPool, tcpSlowConsumerPolicy, tcpMaxQueuedBytes, tcpMaxLag, now, delivery);
+        if (result == PushResult::Disconnect)
+        {
+            tracer->record(traceId, TraceEventType::Drop, peer.socket.getSocket(), buffer->size);
+            logWarning("[TCP] - Group [", peer.groupId, "] - Peer [", peer.socket.getSocket(), "] exceeded its outbound queue limits with [", peer.outboundQueue.getQueuedBytes(), "] bytes queued, disconnecting.");
+            return false;
+        }
+
+        const bool queued = result != PushResult::Rejected;
+        tracer->record(traceId, queued ? TraceEventType::Send : TraceEventType::Drop, peer.socket.getSocket(), buffer->size);
+        if (queued)
+        {
+            group.counters->recordSent(buffer->size);
+        }
+        if (result != PushResult::Queued)
+        {
+            getLogger().log(shard.slowConsumerLog, LogLevel::Warning, "[TCP] - Group [", peer.groupId, "] - Peer [", peer.socket.getSocket(), "] is a slow consumer, [", peer.outboundQueue.getDroppedMessages(), "] messages dropped in total.");
+        }
+        publishTCPPeerCounters(peer);
+
+        // If the peer is already waiting for its socket to become writable there is no point trying to write until it is
+        if (!peer.waitingForWritable)
+        {
+            scheduleTCPFlush(shard, peer, now + group.flushWindow);
+        }
+        return true;
+    }
+
+    /**
+     * Schedules the peer's queue to be written by flushScheduledTCPPeers() once the provided deadline has passed.
+     * A peer that is already scheduled keeps its earlier deadline, so messages wait no longer than the flush window.
+     */
+    void Forwarder::scheduleTCPFlush(TCPShard& shard, TCPPeer& peer, const std::chrono::steady_clock::time_point deadline)
+    {
+        if (!peer.flushScheduled)
+        {
+            peer.flushScheduled = true;
+            peer.flushDeadline = deadline;
+            shard.scheduledFlushes.push_back(peer.socket.getSocket());
+        }
+    }
+
+    /**
+     * Writes the queue of every scheduled peer whose flush deadline has passed, so all of the messages forwarded to a peer within its group's
+     * flush window are written with as few system calls as possible. Called at the end of every worker loop iteration.
+     * Returns how long until the next scheduled deadline, or a negative duration if nothing is scheduled.
+     */
+    std::chrono::microseconds Forwarder::flushScheduledTCPPeers(TCPShard& shard)
+    {
+        if (shard.scheduledFlushes.empty())
+        {
+            return std::chrono::microseconds(-1);
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::optional<std::chrono::steady_clock::time_point> nextDeadline = std::nullopt;
+        std::vector<int> toRemove;
+        size_t remaining = 0;
+        for (const int descriptor : shard.scheduledFlushes)
+        {
+            // Removed peers are skipped, as are peers that were already flushed after becoming writable
+            TCPPeer* peer = shard.findPeer(descriptor);
+            if (peer == nullptr || !peer->flushScheduled)
+            {
+                continue;
+            }
+
+            if (peer->flushDeadline > now)
+            {
+                shard.scheduledFlushes[remaining++] = descriptor;
+                nextDeadline = nextDeadline.has_value() ? std::min(*nextDeadline, peer->flushDeadline) : peer->flushDeadline;
+                continue;
+            }
+
+            peer->flushScheduled = false;
+            if (!flushTCPPeer(shard, *peer))
+            {
+                if (debug)
+                {
+                    logDebug("[TCP] - Group [", peer->groupId, "], failed to send to peer [", descriptor, "], removing from group.");
+                }
+                toRemove.push_back(descriptor);
+            }
+        }
+        shard.scheduledFlushes.resize(remaining);
+
+        for (const int descriptor : toRemove)
+        {
+            removeSocketFromTCPGroup(shard, descriptor);
+        }
+
+        if (!nextDeadline.has_value())
+        {
+            return std::chrono::microseconds(-1);
+        }
+        return std::chrono::ceil<std::chrono::microseconds>(*nextDeadline - now);
+    }
+
+    /**
+     * Applies the slow consumer policy to every peer whose oldest queued message is over the lag limit. The lag is otherwise only checked when a
+     * message is queued, so without this a peer that stopped reading in a quiet group would hold its queue forever. The queues are checked once
+     * per lag limit, so a stalled peer is dealt with within twice the limit.
+     * Returns how long until the next check, or a negative duration if there is no lag limit.
+     */
+    std::chrono::microseconds Forwarder::expireLaggingTCPPeers(TCPShard& shard)
+    {
+        if (tcpMaxLag.count() <= 0)
+        {
+            return std::chrono::microseconds(-1);
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (shard.nextLagCheck > now)
+        {
+            return std::chrono::ceil<std::chrono::microseconds>(shard.nextLagCheck - now);
+        }
+        shard.nextLagCheck = now + tcpMaxLag;
+
+        std::vector<int> toRemove;
+        for (const std::pair<const int, TCPPeerLocation>& location : shard.peers)
+        {
+            TCPPeer& peer = *location.second.group->members.get(location.second.handle);
+            if (peer.outboundQueue.empty())
+            {
+                continue;
+            }
+
+            uint64_t droppedBefore = peer.outboundQueue.getDroppedMessages();
+            if (!peer.outboundQueue.expire(shard.bufferPool, tcpSlowConsumerPolicy, tcpMaxLag, now))
+            {
+                logWarning("[TCP] - Group [", peer.groupId, "] - Peer [", location.first, "] exceeded its outbound queue lag limit with [", peer.outboundQueue.getQueuedBytes(), "] bytes queued, disconnecting.");
+                toRemove.push_back(location.first);
+            }
+            else if (peer.outboundQueue.getDroppedMessages() != droppedBefore)
+            {
+                getLogger().log(shard.slowConsumerLog, LogLevel::Warning, "[TCP] - Group [", peer.groupId, "] - Peer [", location.first, "] is a slow consumer, [", peer.outboundQueue.getDroppedMessages(), "] messages dropped in total.");
+                publishTCPPeerCounters(peer);
+            }
+        }
+
+        for (const int descriptor : toRemove)
+        {
+            removeSocketFromTCPGroup(shard, descriptor);
+        }
+        return std::chrono::ceil<std::chrono::microseconds>(tcpMaxLag);
+    }
+
+    /**
+     * Writes the peer's queue without blocking, registering interest in the socket becoming writable while anything is left queued.
+     * Returns false if the socket has failed.
+     */
+    bool Forwarder::flushTCPPeer(TCPShard& shard, TCPPeer& peer)
+    {
+        if (shard.ring.isOpen())
+        {
+            if (!submitTCPSend(shard, peer))
+            {
+                recordTCPSendFailure(shard, peer.socket.getSocket());
+                return false;
+            }
+            return true;
+        }
+
+        FlushResult result;
+        if (peer.splicePipe.has_value())
+        {
+            result = peer.splicePipe->flush(peer.socket.getSocket());
+        }
+        else
+        {
+            ZeroCopyTracker* zeroCopyTracker = peer.zeroCopyTracker.has_value() ? &peer.zeroCopyTracker.value() : nullptr;
+            // Only a queue that needs more than one write is corked, so the tail of each write is sent with the next instead of as a short segment
+            const bool cork = tcpCork && peer.outboundQueue.size() > TCP_MAX_SEND_BATCH;
+            if (cork)
+            {
+                setCork(peer.socket.getSocket(), true);
+            }
+            result = peer.outboundQueue.flush(peer.socket.getSocket(), shard.bufferPool, zeroCopyTracker, tcpZeroCopyThreshold);
+            if (cork)
+            {
+                setCork(peer.socket.getSocket(), false);
+            }
+        }
+        publishTCPPeerCounters(peer);
+        if (result == FlushResult::Failed)
+        {
+            recordTCPSendFailure(shard, peer.socket.getSocket());
+            return false;
+        }
+
+        bool waitForWritable = result == FlushResult::WouldBlock;
+        if (waitForWritable != peer.waitingForWritable)
+        {
+            shard.eventLoop.modify(peer.socket.getSocket(), EPOLLIN | EPOLLRDHUP | (waitForWritable ? EPOLLOUT : 0));
+            peer.waitingForWritable = waitForWritable;
+        }
+        return true;
+    }
+
+    /**
+     * Counts a failed send in the metrics of the peer's group. Only called when a send fails, so the peer's group is looked up rather than kept on each peer.
+     */
+    void Forwarder::recordTCPSendFailure(TCPShard& shard, int descriptor)
+    {
+        auto location = shard.peers.find(descriptor);
+        if (location != shard.peers.end())
+        {
+            location->second.group->counters->recordSendFailure();
+        }
+    }
+
+    void Forwarder::removeSocketFromTCPGroup(TCPShard& shard, int descriptor)
+    {
+        auto location = shard.peers.find(descriptor);
+        if (location == shard.peers.end())
+        {
+            return;
+        }
+
+        TCPGroup& group = *location->second.group;
+        TCPPeer& peer = *group.members.get(location->second.handle);
+        kt::SocketAddress address = peer.socket.getSocketAddress();
+        logInfo("[TCP] - Group [", group.id, "] - Closing and removing socket with address [", kt::getAddress(address).value_or(""), ":", kt::getPortNumber(address), "].");
+        if (debug && peer.outboundQueue.getSendCount() > 0)
+        {
+            logDebug("[TCP] - Group [", group.id, "] - Socket [", descriptor, "] was sent [", peer.outboundQueue.getSentMessages(), "] messages in [", peer.outboundQueue.getSendCount(), "] writes, an average of [", static_cast<double>(peer.outboundQueue.getSentMessages()) / peer.outboundQueue.getSendCount(), "] messages per write.");
+        }
+
+        if (peer.receiving || peer.sending)
+        {
+            // The kernel may still be reading from the peer's buffers, shutting the socket down completes its operations with an error
+            // and the socket is closed once they have all completed. Until then the descriptor number cannot be re-used by another connection.
+            shutdown(descriptor, SHUT_RDWR);
+            shard.closingPeers.emplace(descriptor, std::move(peer));
+        }
+        else
+        {
+            // Removing from the epoll set before closing, since the descriptor number can be re-used by the next accepted connection
+            shard.eventLoop.remove(descriptor);
+            releaseTCPPeer(shard, peer);
+        }
+
+        group.counters->recordRemoval();
+        // Swap and pop, this moves the last member of the group into the removed member's position
+        group.members.erase(location->second.handle);
+        shard.peers.erase(location);
+        shard.changedGroups.insert(group.id);
+    }
+
+    /**
+     * Copies the peer's queue counters to its shared counters, so statistics can be read from other threads while the worker is running.
+     */
+    void Forwarder::publishTCPPeerCounters(const TCPPeer& peer)
+    {
+        TCPPeerCounters& counters = *peer.counters;
+        if (peer.splicePipe.has_value())
+        {
+            counters.queuedBytes.store(peer.splicePipe->getQueuedBytes(), std::memory_order_relaxed);
+        }
+        else
+        {
+            counters.queuedBytes.store(peer.outboundQueue.getQueuedBytes(), std::memory_order_relaxed);
+            counters.droppedMessages.store(peer.outboundQueue.getDroppedMessages(), std::memory_order_relaxed);
+            counters.droppedBytes.store(peer.outboundQueue.getDroppedBytes(), std::memory_order_relaxed);
+            counters.sendCount.store(peer.outboundQueue.getSendCount(), std::memory_order_relaxed);
+            counters.sentMessages.store(peer.outboundQueue.getSentMessages(), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Publishes a new version of the shard's registry if any members joined or left during this loop iteration.
+     * Only the groups that changed are copied, every other group's view is shared with the previous version.
+     */
+    void Forwarder::publishTCPRegistry(TCPShard& shard)
+    {
+        if (shard.changedGroups.empty())
+        {
+            return;
+        }
+
+        shard.registry.update([&shard](TCPGroupRegistry& registry)
+        {
+            for (const std::string& groupId : shard.changedGroups)
+            {
+                auto group = shard.sessions.find(groupId);
+                if (group == shard.sessions.end())
+                {
+                    registry.erase(groupId);
+                    continue;
+                }
+
+                std::shared_ptr<TCPGroupSnapshot> snapshot = std::make_shared<TCPGroupSnapshot>();
+                snapshot->members.reserve(group->second.members.size());
+                for (const TCPPeer& peer : group->second.members)
+                {
+                    snapshot->members.push_back(peer.counters);
+                }
+                registry[groupId] = std::move(snapshot);
+            }
+        });
+        shard.changedGroups.clear();
+    }
+
+    /**
+     * Returns every buffer the peer holds to the pool and closes its socket.
+     */
+    void Forwarder::releaseTCPPeer(TCPShard& shard, TCPPeer& peer)
+    {
+        peer.outboundQueue.clear(shard.bufferPool);
+        if (peer.zeroCopyTracker.has_value())
+        {
+            peer.zeroCopyTracker->releaseAll(shard.bufferPool);
+        }
+        if (peer.partialFrame != nullptr)
+        {
+            shard.bufferPool.release(peer.partialFrame);
+            peer.partialFrame = nullptr;
+        }
+        if (peer.splicePipe.has_value())
+        {
+            peer.splicePipe->close();
+        }
+        peer.socket.close();
+    }
+
+    /**
+     * The io_uring equivalent of startTCPWorker(). Instead of waiting for sockets to become ready and then reading and writing them,
+     * every accept, receive and send is queued to the shard's ring and all operations queued while handling a batch of completions
+     * are submitted with the next wait, so many sockets are serviced per system call.
+     * Receives are multishot and pick their buffers from a ring of pooled buffers, so each received message is forwarded straight from the buffer the kernel received it into.
+     */
+    void Forwarder::startTCPUringWorker(TCPShard& shard)
+    {
+        // The ring is only ever used by the thread that created it
+        if (!shard.ring.open(TCP_RING_ENTRIES) || !shard.ring.registerBufferRing(TCP_BUFFER_GROUP, TCP_PROVIDED_BUFFER_COUNT))
+        {
+            logWarning("[TCP] - Failed to set up io_uring for worker [", shard.index, "], falling back to epoll.");
+            shard.ring.close();
+            if (shard.listeningSocket != -1)
+            {
+                shard.eventLoop.add(shard.listeningSocket, EPOLLIN);
+            }
+            startTCPWorker(shard);
+            return;
+        }
+
+        logInfo("[TCP] - Starting io_uring TCP worker [", shard.index, "]...");
+        shard.providedBuffers.resize(TCP_PROVIDED_BUFFER_COUNT, nullptr);
+        for (uint16_t id = 0; id < TCP_PROVIDED_BUFFER_COUNT; id++)
+        {
+            provideTCPBuffer(shard, id);
+        }
+
+        if (shard.listeningSocket != -1)
+        {
+            shard.ring.prepareAccept(shard.listeningSocket, true, encodeUringOperation(UringOperation::Accept, shard.listeningSocket));
+        }
+        shard.ring.preparePoll(shard.eventLoop.getWakeDescriptor(), POLLIN, true, encodeUringOperation(UringOperation::Wake, shard.eventLoop.getWakeDescriptor()));
+
+        std::chrono::microseconds waitTimeout = std::chrono::microseconds(-1);
+        while (forwarderIsRunning)
+        {
+            shard.ring.commitBuffers();
+            shard.ring.submit(1, waitTimeout);
+
+            io_uring_cqe* entry = nullptr;
+            while ((entry = shard.ring.peekCompletion()) != nullptr)
+            {
+                // Copied out so the completion queue entry can be returned to the kernel before handling queues more submissions
+                io_uring_cqe completion = *entry;
+                shard.ring.advanceCompletion();
+                handleTCPUringCompletion(shard, completion);
+            }
+
+            // The sends queued by the flush are submitted with the next wait, which lasts no longer than the next flush, handshake or lag check deadline
+            waitTimeout = earliestTimeout(earliestTimeout(flushScheduledTCPPeers(shard), expireTCPHandshakes(shard)), expireLaggingTCPPeers(shard));
+            publishTCPRegistry(shard);
+        }
+
+        // Closing the ring cancels every operation in flight, so the buffers and sockets can be released
+        shard.ring.close();
+        closeTCPShard(shard);
+    }
+
+    void Forwarder::handleTCPUringCompletion(TCPShard& shard, const io_uring_cqe& completion)
+    {
+        const UringOperation operation = static_cast<UringOperation>(completion.user_data >> 32);
+        const int descriptor = static_cast<int>(completion.user_data & 0xFFFFFFFF);
+        const bool more = (completion.flags & IORING_CQE_F_MORE) != 0;
+
+        if (operation == UringOperation::Accept)
+        {
+            if (completion.res >= 0)
+            {
+                std::optional<kt::TCPSocket> accepted = wrapTCPConnection(completion.res);
+                if (accepted.has_value())
+                {
+                    handleAcceptedTCPConnection(shard, accepted.value());
+                }
+                else
+                {
+                    close(completion.res);
+                }
+            }
+            else
+            {
+                getLogger().log(shard.acceptErrorLog, LogLevel::Warning, "[TCP] - Failed to accept incoming client on worker [", shard.index, "] with error [", -completion.res, "].");
+            }
+            if (!more)
+            {
+                shard.ring.prepareAccept(descriptor, true, completion.user_data);
+            }
+        }
+        else if (operation == UringOperation::Wake)
+        {
+            shard.eventLoop.clearWake();
+            addHandedOffTCPSockets(shard);
+            if (!more)
+            {
+                shard.ring.preparePoll(descriptor, POLLIN, true, completion.user_data);
+            }
+        }
+        else if (operation == UringOperation::Handshake)
+        {
+            MessageBuffer* buffer = (completion.flags & IORING_CQE_F_BUFFER) != 0 ? takeProvidedTCPBuffer(shard, completion) : nullptr;
+            if (completion.res == -ENOBUFS)
+            {
+                // No provided buffers were available, try again once buffers have been returned to the ring
+                shard.ring.prepareReceive(descriptor, TCP_BUFFER_GROUP, false, completion.user_data);
+            }
+            else
+            {
+                // Failed receives are reported as a disconnect
+                errno = completion.res < 0 ? -completion.res : 0;
+                continueTCPHandshake(shard, descriptor, buffer != nullptr ? buffer->data.data() : nullptr, completion.res < 0 ? -1 : completion.res);
+            }
+            if (buffer != nullptr)
+            {
+                shard.bufferPool.release(buffer);
+            }
+        }
+        else if (operation == UringOperation::Receive)
+        {
+            receiveTCPUring(shard, descriptor, completion);
+        }
+        else if (operation == UringOperation::Send)
+        {
+            completeTCPUringSend(shard, descriptor, completion);
+        }
+    }
+
+    void Forwarder::receiveTCPUring(TCPShard& shard, int descriptor, const io_uring_cqe& completion)
+    {
+        const bool more = (completion.flags & IORING_CQE_F_MORE) != 0;
+        MessageBuffer* buffer = (completion.flags & IORING_CQE_F_BUFFER) != 0 ? takeProvidedTCPBuffer(shard, completion) : nullptr;
+
+        auto location = shard.peers.find(descriptor);
+        if (location == shard.peers.end())
+        {
+            // Received after the peer was removed from its group
+            if (buffer != nullptr)
+            {
+                shard.bufferPool.release(buffer);
+            }
+            releaseClosingTCPPeer(shard, descriptor, !more, false);
+            return;
+        }
+
+        TCPGroup& group = *location->second.group;
+        TCPPeer* peer = group.members.get(location->second.handle);
+        peer->receiving = more;
+
+        // When the provided buffers run out the receive stops without failing, it is re-armed once buffers have been returned to the ring
+        bool connected = completion.res > 0 || completion.res == -ENOBUFS;
+        if (buffer != nullptr && completion.res > 0)
+        {
+            if (group.framing != FramingMode::None)
+            {
+                buffer = appendTCPFrames(shard, group, *peer, buffer, connected);
+            }
+            if (buffer != nullptr)
+            {
+                forwardTCPBuffer(shard, group, descriptor, buffer);
+            }
+        }
+        else if (buffer != nullptr)
+        {
+            shard.bufferPool.release(buffer);
+        }
+
+        if (!connected)
+        {
+            if (debug)
+            {
+                logDebug("[TCP] - Group [", group.id, "], peer with descriptor [", descriptor, "] is no longer connected, removing from group.");
+            }
+            removeSocketFromTCPGroup(shard, descriptor);
+            return;
+        }
+
+        // Forwarding can remove other members of the group, which moves this peer within the group
+        peer = shard.findPeer(descriptor);
+        if (peer != nullptr && !peer->receiving)
+        {
+            armTCPReceive(shard, *peer);
+        }
+    }
+
+    void Forwarder::completeTCPUringSend(TCPShard& shard, int descriptor, const io_uring_cqe& completion)
+    {
+        TCPPeer* peer = shard.findPeer(descriptor);
+        if (peer == nullptr)
+        {
+            releaseClosingTCPPeer(shard, descriptor, false, true);
+            return;
+        }
+
+        peer->sending = false;
+        if (completion.res < 0 && completion.res != -EAGAIN && completion.res != -EINTR)
+        {
+            if (debug)
+            {
+                logDebug("[TCP] - Group [", peer->groupId, "], failed to send to peer [", descriptor, "] with error [", -completion.res, "], removing from group.");
+            }
+            recordTCPSendFailure(shard, descriptor);
+            peer->outboundQueue.consume(0, shard.bufferPool);
+            removeSocketFromTCPGroup(shard, descriptor);
+            return;
+        }
+
+        // A short send leaves the rest of the partially written message at the front of the queue, it is sent with the next batch
+        peer->outboundQueue.consume(completion.res > 0 ? static_cast<size_t>(completion.res) : 0, shard.bufferPool);
+        publishTCPPeerCounters(*peer);
+        if (!submitTCPSend(shard, *peer))
+        {
+            removeSocketFromTCPGroup(shard, descriptor);
+        }
+    }
+
+    /**
+     * Takes the buffer that the completion was received into out of the provided buffer ring, and provides a fresh buffer with the same ID in its place.
+     */
+    MessageBuffer* Forwarder::takeProvidedTCPBuffer(TCPShard& shard, const io_uring_cqe& completion)
+    {
+        const uint16_t id = static_cast<uint16_t>(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+        MessageBuffer* buffer = shard.providedBuffers[id];
+        buffer->size = completion.res > 0 ? static_cast<size_t>(completion.res) : 0;
+        provideTCPBuffer(shard, id);
+        return buffer;
+    }
+
+    /**
+     * Returned buffers are only visible to the kernel once the ring's buffers are committed, which happens before each submit.
+     */
+    void Forwarder::provideTCPBuffer(TCPShard& shard, const uint16_t id)
+    {
+        MessageBuffer* buffer = shard.bufferPool.acquire();
+        shard.providedBuffers[id] = buffer;
+        // Buffers grown to hold a large frame are recycled through the same pool, so the read size is capped explicitly
+        shard.ring.provideBuffer(buffer->data.data(), static_cast<unsigned>(std::min<size_t>(buffer->data.size(), maxReadInSize)), id);
+    }
+
+    void Forwarder::armTCPReceive(TCPShard& shard, TCPPeer& peer)
+    {
+        const int descriptor = peer.socket.getSocket();
+        peer.receiving = shard.ring.prepareReceive(descriptor, TCP_BUFFER_GROUP, true, encodeUringOperation(UringOperation::Receive, descriptor));
+    }
+
+    /**
+     * Queues a single send of as much of the peer's outbound queue as fits in one batch. Only one send is in flight per peer so its messages are written in order,
+     * the next batch is queued when the send completes. The sends of every peer a message was forwarded to are submitted together with the worker's next wait.
+     * Returns false if the send could not be queued.
+     */
+    bool Forwarder::submitTCPSend(TCPShard& shard, TCPPeer& peer)
+    {
+        if (peer.sending || peer.outboundQueue.empty())
+        {
+            return true;
+        }
+
+        if (peer.pendingSend == nullptr)
+        {
+            peer.pendingSend = std::make_unique<TCPPendingSend>();
+        }
+        TCPPendingSend& send = *peer.pendingSend;
+        send.message = msghdr{};
+        send.message.msg_iov = send.vectors;
+        send.message.msg_iovlen = peer.outboundQueue.prepare(send.vectors, send.buffers, TCP_MAX_SEND_BATCH);
+
+        const int descriptor = peer.socket.getSocket();
+        peer.sending = shard.ring.prepareSendMessage(descriptor, &send.message, MSG_NOSIGNAL, encodeUringOperation(UringOperation::Send, descriptor));
+        if (!peer.sending)
+        {
+            peer.outboundQueue.consume(0, shard.bufferPool);
+        }
+        return peer.sending;
+    }
+
+    /**
+     * Marks an operation of a removed peer as completed, the peer's socket is closed and its buffers released once none of its operations are in flight.
+     */
+    void Forwarder::releaseClosingTCPPeer(TCPShard& shard, int descriptor, const bool receiveCompleted, const bool sendCompleted)
+    {
+        auto closing = shard.closingPeers.find(descriptor);
+        if (closing == shard.closingPeers.end())
+        {
+            return;
+        }
+
+        TCPPeer& peer = closing->second;
+        peer.receiving = peer.receiving && !receiveCompleted;
+        peer.sending = peer.sending && !sendCompleted;
+        if (!peer.receiving && !peer.sending)
+        {
+            releaseTCPPeer(shard, peer);
+            shard.closingPeers.erase(closing);
+        }
+    }
+
+    /**
+     * Group lookups from other threads read the owning shard's published registry, so they never race with the worker changing its groups.
+     * Members that joined or left during the worker's current loop iteration are visible once that iteration ends.
+     */
+    bool Forwarder::tcpGroupWithIdExists(std::string& groupId)
+    {
+        if (tcpShards.empty())
+        {
+            return false;
+        }
+        std::shared_ptr<const TCPGroupRegistry> registry = getTCPShardForGroup(groupId).registry.load();
+        return registry->find(groupId) != registry->end();
+    }
+
+    size_t Forwarder::tcpGroupMemberCount(std::string& groupId)
+    {
+        if (tcpShards.empty())
+        {
+            return 0;
+        }
+        std::shared_ptr<const TCPGroupRegistry> registry = getTCPShardForGroup(groupId).registry.load();
+        auto group = registry->find(groupId);
+        return group != registry->end() ? group->second->members.size() : 0;
+    }
+
+    std::vector<TCPPeerStatistics> Forwarder::tcpGroupPeerStatistics(std::string& groupId)
+    {
+        std::vector<TCPPeerStatistics> statistics;
+        if (tcpShards.empty())
+        {
+            return statistics;
+        }
+
+        std::shared_ptr<const TCPGroupRegistry> registry = getTCPShardForGroup(groupId).registry.load();
+        auto group = registry->find(groupId);
+        if (group != registry->end())
+        {
+            for (const std::shared_ptr<const TCPPeerCounters>& peer : group->second->members)
+            {
+                statistics.push_back({ peer->address, peer->queuedBytes.load(std::memory_order_relaxed), peer->droppedMessages.load(std::memory_order_relaxed),
+                    peer->droppedBytes.load(std::memory_order_relaxed), peer->sendCount.load(std::memory_order_relaxed), peer->sentMessages.load(std::memory_order_relaxed) });
+            }
+        }
+        return statistics;
+    }
+
+    void Forwarder::startUDPForwarder()
+    {
+        forwarderIsRunning = true;
+
+        if (udpPeerTTL.count() > 0)
+        {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(udpGroupsMutex);
+            udpPeerExpiry.emplace(std::clamp<std::chrono::steady_clock::duration>(udpPeerTTL / 32, UDP_PEER_EXPIRY_MIN_TICK, UDP_PEER_EXPIRY_MAX_TICK), now);
+            // Peers added before starting, e.g. preconfigured addresses, are idle from the start rather than from when they were added
+            for (const std::shared_ptr<const UDPGroupPeers>& peers : udpGroups.load()->peers)
+            {
+                for (const std::shared_ptr<UDPPeerLiveness>& liveness : peers->liveness)
+                {
+                    liveness->lastSeen.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+                    scheduleUDPPeerExpiry(liveness);
+                }
+            }
+            udpRunningThreads.emplace_back(&Forwarder::startUDPPeerExpiry, this);
+        }
+
+        if (ioEngine == IOEngine::IoUring)
+        {
+            // A single thread both receives and forwards, since receiving and sending no longer block each other
+            if (udpReceiverCount > 1)
+            {
+                logWarning("[UDP] - Only a single UDP receiver is used with the io_uring I/O engine, ignoring receiver count [", udpReceiverCount, "].");
+            }
+            udpRunningThreads.emplace_back(&Forwarder::startUDPUringForwarder, this);
+        }
+        else
+        {
+            udpMessageRing = std::make_unique<DatagramRing>(udpQueueSize, maxReadInSize, udpOverflowPolicy);
+            // Every receiver pushes into the same queue and joins into the same groups, so a peer can join through any of the sockets
+            const int listeningSocket = udpRecieveSocket->getListeningSocket();
+            for (size_t i = 1; i < udpReceiverCount; i++)
+            {
+                std::optional<int> descriptor = setUpReusePortUDPSocket(listeningSocket);
+                if (!descriptor.has_value())
+                {
+                    logWarning("[UDP] - Failed to create SO_REUSEPORT socket for receiver [", i, "], datagrams will be received by the other receivers.");
+                    break;
+                }
+                udpReusePortSockets.push_back(*descriptor);
+            }
+            if (udpCPUSteering && !udpReusePortSockets.empty() && !setReusePortCPUSteering(listeningSocket, udpReusePortSockets.size() + 1))
+            {
+                logWarning("[UDP] - Failed to attach the CPU steering program, datagrams will be spread by their addresses.");
+            }
+
+            udpRunningThreads.emplace_back(&Forwarder::startUDPListener, this, listeningSocket);
+            for (const int descriptor : udpReusePortSockets)
+            {
+                udpRunningThreads.emplace_back(&Forwarder::startUDPListener, this, descriptor);
+            }
+            udpRunningThreads.emplace_back(&Forwarder::startUDPDataForwarder, this);
+        }
+    }
+
+    void Forwarder::startUDPListener(const int descriptor)
+    {
+        logInfo("[UDP] - Starting UDP forwarder connection listener on socket [", descriptor, "]...");
+        std::vector<std::shared_ptr<ForwardingCounters>> counters;
+        // Coalesced reads need room for every datagram in them, each is still cut off at the max read in size once split
+        const bool gro = isUDPGROEnabled(descriptor);
+        DatagramReceiveBatch batch(UDP_RECEIVE_BATCH_SIZE, gro ? std::max<size_t>(UDP_GRO_BUFFER_SIZE, maxReadInSize) : maxReadInSize);
+        LogRateLimiter dropLog;
+        LogRateLimiter malformedLog;
+        std::shared_ptr<const UDPGroups> groups;
+        std::chrono::steady_clock::time_point receivedAt;
+        const auto handleDatagram = [&](const char* payload, const size_t payloadSize, const kt::SocketAddress& address)
+        {
+            if (debug)
+            {
+                std::string addressString = kt::getAddress(address).value_or("") + ":" + std::to_string(kt::getPortNumber(address));
+                logDebug("[UDP] - Received message [", std::string_view(payload, payloadSize), "] from address: [", addressString, "]");
+            }
+
+            if (payloadSize >= newClientPrefix.size() && std::memcmp(payload, newClientPrefix.data(), newClientPrefix.size()) == 0)
+            {
+                registerUDPClient(std::string(payload, payloadSize), address);
+                // Reloaded so the rest of the batch can be forwarded to a group created by the join
+                groups = udpGroups.load();
+                return;
+            }
+
+            size_t headerSize = 0;
+            std::optional<uint32_t> group = findUDPGroup(*groups, payload, payloadSize, headerSize);
+            if (!group.has_value())
+            {
+                getLogger().log(malformedLog, LogLevel::Warning, "[UDP] - Dropping message with a malformed channel header or an unknown group from address [", kt::getAddress(address).value_or(""), ":", kt::getPortNumber(address), "].");
+                return;
+            }
+            if (udpPeerTTL.count() > 0)
+            {
+                refreshUDPPeer(*groups->peers[*group], address, receivedAt);
+            }
+            // Empty datagrams are not forwarded, they only keep their sender alive
+            if (payloadSize > headerSize)
+            {
+                ForwardingCounters& groupCounters = getUDPGroupCounters(counters, *groups, *group);
+                groupCounters.recordReceived(payloadSize - headerSize);
+                const DatagramPushResult result = udpMessageRing->push(payload + headerSize, payloadSize - headerSize, address, receivedAt, *group);
+                if (result.evicted)
+                {
+                    getUDPGroupCounters(counters, *groups, result.evictedChannel).recordDropped(1, result.evictedBytes);
+                }
+                if (!result.queued)
+                {
+                    groupCounters.recordDropped(1, payloadSize - headerSize);
+                }
+                if (result.droppedMessages > 0)
+                {
+                    getLogger().log(dropLog, LogLevel::Warning, "[UDP] - Forwarding queue is full, [", udpMessageRing->getDroppedMessages(), "] messages dropped in total.");
+                }
+            }
+        };
+
+        pollfd readiness{ descriptor, POLLIN, 0 };
+        while (forwarderIsRunning)
+        {
+            // Bounded so the thread notices the forwarder stopping
+            if (poll(&readiness, 1, 100) <= 0)
+            {
+                continue;
+            }
+
+            // Keep draining while the batches come back full, as more datagrams are likely already queued on the socket
+            int received = 0;
+            do
+            {
+                received = batch.receive(descriptor);
+                receivedAt = std::chrono::steady_clock::now();
+                groups = udpGroups.load();
+                for (int i = 0; i < received; i++)
+                {
+                    const size_t segmentSize = batch.segmentSize(i);
+                    if (segmentSize == 0)
+                    {
+                        handleDatagram(batch.data(i), std::min<size_t>(batch.size(i), maxReadInSize), batch.address(i));
+                        continue;
+                    }
+                    // A coalesced read is split back into the datagrams that were sent
+                    for (size_t offset = 0; offset < batch.size(i); offset += segmentSize)
+                    {
+                        handleDatagram(batch.data(i) + offset, std::min({ segmentSize, batch.size(i) - offset, static_cast<size_t>(maxReadInSize) }), batch.address(i));
+                    }
+                }
+            } while (forwarderIsRunning && received == static_cast<int>(batch.capacity()));
+        }
+    }
+
+    /**
+     * Forwards the queued UDP messages to every known peer. Up to UDP_MAX_SEND_MESSAGES messages are taken from the queue at a time and their
+     * sends to every peer are put into a single batch, sent with as few sendmmsg() calls as the batch's capacity allows. Runs of equal sized
+     * messages to the same group are sent to each peer with a single UDP_SEGMENT send, until the kernel rejects one.
+     */
+    void Forwarder::startUDPDataForwarder()
+    {
+        logInfo("[UDP] - Starting UDP data forwarder listener...");
+        // A sendmmsg() call goes through a single socket, so IPv4 and IPv6 peers are batched separately
+        const int sendSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        const int sendSocketIPv6 = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        DatagramSendBatch batch(UDP_SEND_BATCH_SIZE);
+        DatagramSendBatch batchIPv6(UDP_SEND_BATCH_SIZE);
+        std::vector<DatagramSlot*> messages;
+        messages.reserve(UDP_MAX_SEND_MESSAGES);
+        std::vector<iovec> payloads(UDP_MAX_SEND_MESSAGES);
+        std::vector<UDPMessageDelivery> deliveries(UDP_MAX_SEND_MESSAGES);
+        std::vector<UDPMessageRun> runs;
+        runs.reserve(UDP_MAX_SEND_MESSAGES);
+        bool gso = udpOffload && isUDPGSOSupported(sendSocket);
+        // Lowered whenever a segment size is rejected, e.g. because it does not fit in a single packet on the way to a peer
+        size_t gsoMaxSegmentSize = maxReadInSize;
+        LogRateLimiter gsoLog;
+        // Only used to trace which socket messages were received on
+        const int receiveDescriptor = udpRecieveSocket->getListeningSocket();
+        LogRateLimiter sendErrorLog;
+        std::vector<std::shared_ptr<ForwardingCounters>> counters;
+
+        // Records how a single message's send to a single peer went, the peer's send time is from the datagram being handed to the kernel until the send call returned
+        const auto recordSend = [&](const size_t index, const kt::SocketAddress& addr, const bool messageSent, const int descriptor,
+            const std::chrono::steady_clock::time_point handed, const std::chrono::steady_clock::time_point sent)
+        {
+            UDPMessageDelivery& delivery = deliveries[index];
+            ForwardingCounters& groupCounters = *delivery.counters;
+            const size_t messageSize = messages[index]->size;
+            tracer->record(delivery.traceId, messageSent ? TraceEventType::Send : TraceEventType::Drop, descriptor, messageSize);
+            if (messageSent)
+            {
+                groupCounters.recordSent(messageSize);
+                groupCounters.peerSend.record(sent - handed);
+                if (!delivery.firstSendRecorded)
+                {
+                    delivery.firstSendRecorded = true;
+                    groupCounters.receiveToFirstSend.record(sent - messages[index]->receivedAt);
+                }
+            }
+            else
+            {
+                delivery.deliveryIncomplete = true;
+                groupCounters.recordSendFailure();
+                getLogger().log(sendErrorLog, LogLevel::Warning, "[UDP] - Failed to forward message to peer with address [", kt::getAddress(addr).value_or(""), ":", kt::getPortNumber(addr), "].");
+            }
+            if (debug)
+            {
+                logDebug("[UDP - ", traceIdToString(delivery.traceId), "] - Forwarded to peer with address: [", kt::getAddress(addr).value_or(""), ":", kt::getPortNumber(addr), "]. With result [", messageSent, "]");
+            }
+
+            delivery.pendingSends--;
+            if (delivery.pendingSends == 0 && delivery.firstSendRecorded && !delivery.deliveryIncomplete)
+            {
+                groupCounters.receiveToLastSend.record(sent - messages[index]->receivedAt);
+            }
+        };
+
+        // Sends everything in the batch, every datagram sent by a sendmmsg() call is timed by that call alone
+        const auto flush = [&](DatagramSendBatch& target, const int descriptor)
+        {
+            while (target.remaining() > 0)
+            {
+                const size_t from = target.completed();
+                const std::chrono::steady_clock::time_point handed = std::chrono::steady_clock::now();
+                const int result = target.send(descriptor);
+                const int sendError = result < 0 ? errno : 0;
+                const std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+
+                for (size_t entry = from; entry < target.completed(); entry++)
+                {
+                    const kt::SocketAddress& addr = target.address(entry);
+                    // A rejected UDP_SEGMENT send is sent again one message at a time
+                    const bool resend = !target.sent(entry) && target.segments(entry) > 1
+                        && (sendError == EINVAL || sendError == EIO || sendError == ENOPROTOOPT || sendError == EOPNOTSUPP);
+                    if (resend)
+                    {
+                        const size_t segmentSize = messages[target.tag(entry)]->size;
+                        if (sendError == EINVAL)
+                        {
+                            gsoMaxSegmentSize = std::min(gsoMaxSegmentSize, segmentSize - 1);
+                        }
+                        else
+                        {
+                            gso = false;
+                        }
+                        getLogger().log(gsoLog, LogLevel::Info, "[UDP] - UDP_SEGMENT send of [", segmentSize, "] byte segments rejected with error [", sendError, "], sending them one at a time.");
+                    }
+
+                    for (size_t segment = 0; segment < target.segments(entry); segment++)
+                    {
+                        const size_t index = target.tag(entry) + segment;
+                        if (resend)
+                        {
+                            const std::chrono::steady_clock::time_point resendHanded = std::chrono::steady_clock::now();
+                            const bool messageSent = sendto(descriptor, payloads[index].iov_base, payloads[index].iov_len, MSG_NOSIGNAL, &addr.address, kt::getAddressLength(addr)) >= 0;
+                            recordSend(index, addr, messageSent, descriptor, resendHanded, std::chrono::steady_clock::now());
+                        }
+                        else
+                        {
+                            recordSend(index, addr, target.sent(entry), descriptor, handed, sent);
+                        }
+                    }
+                }
+            }
+            target.clear();
+        };
+
+        while (forwarderIsRunning)
+        {
+            // Bounded like udpSocket.ready(), so the thread notices the forwarder stopping
+            if (!udpMessageRing->wait(std::chrono::milliseconds(100)))
+            {
+                continue;
+            }
+
+            messages.clear();
+            DatagramSlot* slot = nullptr;
+            while (messages.size() < UDP_MAX_SEND_MESSAGES && (slot = udpMessageRing->acquire()) != nullptr)
+            {
+                messages.push_back(slot);
+            }
+
+            std::shared_ptr<const UDPGroups> groups = udpGroups.load();
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            size_t sendCount = 0;
+            for (size_t i = 0; i < messages.size(); i++)
+            {
+                DatagramSlot& message = *messages[i];
+                const AddressTable& peers = groups->peers[message.channel]->addresses;
+                ForwardingCounters& groupCounters = getUDPGroupCounters(counters, *groups, message.channel);
+                // Every send is counted up front, so the message is not seen as delivered when the batch fills and is sent part way through its peers
+                deliveries[i] = { tracer->sample(debug), &groupCounters, peers.size(), false, false };
+                tracer->record(deliveries[i].traceId, TraceEventType::Receive, receiveDescriptor, message.size);
+                groupCounters.queueResidency.record(start - message.receivedAt);
+                // Every peer's entry points at this one vector, so the payload is sent straight from the ring and never copied per peer
+                payloads[i] = { message.data, message.size };
+                sendCount += peers.size();
+
+                if (debug)
+                {
+                    logDebug("[UDP - ", traceIdToString(deliveries[i].traceId), "] - Received message [", std::string_view(message.data, message.size), "] forwarding to [", peers.size(), "] peer(s) in group [", groups->ids[message.channel], "].");
+                }
+            }
+
+            // A run only grows while every message in it so far is the size of its first, the last message may be smaller
+            runs.clear();
+            for (size_t i = 0; i < messages.size(); i++)
+            {
+                const DatagramSlot& message = *messages[i];
+                if (gso && !runs.empty())
+                {
+                    UDPMessageRun& run = runs.back();
+                    const DatagramSlot& first = *messages[run.first];
+                    if (message.channel == first.channel && messages[i - 1]->size == first.size && message.size <= first.size && first.size <= gsoMaxSegmentSize
+                        && run.count < UDP_GSO_MAX_SEGMENTS && run.bytes + message.size <= UDP_GSO_MAX_BYTES)
+                    {
+                        run.count++;
+                        run.bytes += message.size;
+                        continue;
+                    }
+                }
+                runs.push_back({ i, 1, message.size });
+            }
+
+            for (const UDPMessageRun& run : runs)
+            {
+                for (const kt::SocketAddress& addr : groups->peers[messages[run.first]->channel]->addresses)
+                {
+                    const bool ipv6 = addr.address.sa_family == AF_INET6;
+                    DatagramSendBatch& target = ipv6 ? batchIPv6 : batch;
+                    if (target.full())
+                    {
+                        flush(target, ipv6 ? sendSocketIPv6 : sendSocket);
+                    }
+                    target.add(&payloads[run.first], run.count, static_cast<uint16_t>(messages[run.first]->size), addr, run.first);
+                }
+            }
+            flush(batch, sendSocket);
+            flush(batchIPv6, sendSocketIPv6);
+            for (DatagramSlot* message : messages)
+            {
+                udpMessageRing->release(message);
+            }
+
+            if (debug)
+            {
+                logDebug("[UDP] - Took [", std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), "us] to forward [", messages.size(), "] message(s) in [", runs.size(), "] run(s) with [", sendCount, "] sends.");
+            }
+        }
+
+        if (sendSocket != -1)
+        {
+            close(sendSocket);
+        }
+        if (sendSocketIPv6 != -1)
+        {
+            close(sendSocketIPv6);
+        }
+    }
+
+    /**
+     * Removes the UDP peers that have not been heard from for the TTL. Refreshing a peer only stores the time it was heard from, each peer's
+     * entry in the wheel is checked once it falls due and scheduled again if the peer was heard from since, so receivers never touch the wheel.
+     */
+    void Forwarder::startUDPPeerExpiry()
+    {
+        logInfo("[UDP] - Starting UDP peer expiry, peers are removed after [", udpPeerTTL.count(), "ms] without a datagram.");
+        const std::chrono::steady_clock::duration tick = std::clamp<std::chrono::steady_clock::duration>(udpPeerTTL / 32, UDP_PEER_EXPIRY_MIN_TICK, UDP_PEER_EXPIRY_MAX_TICK);
+        std::vector<std::shared_ptr<UDPPeerLiveness>> expired;
+        while (forwarderIsRunning)
+        {
+            std::this_thread::sleep_for(tick);
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(udpGroupsMutex);
+            expired.clear();
+            udpPeerExpiry->advance(now, [&](std::shared_ptr<UDPPeerLiveness> liveness)
+            {
+                const std::chrono::steady_clock::time_point lastSeen(std::chrono::steady_clock::duration(liveness->lastSeen.load(std::memory_order_relaxed)));
+                if (lastSeen + udpPeerTTL > now)
+                {
+                    udpPeerExpiry->schedule(std::move(liveness), lastSeen + udpPeerTTL);
+                    return;
+                }
+                expired.push_back(std::move(liveness));
+            });
+            if (expired.empty())
+            {
+                continue;
+            }
+
+            udpGroups.update([&](UDPGroups& groups)
+            {
+                // Each changed group is copied once however many of its peers expired
+                std::unordered_map<uint32_t, std::shared_ptr<UDPGroupPeers>> changed;
+                for (const std::shared_ptr<UDPPeerLiveness>& liveness : expired)
+                {
+                    std::shared_ptr<UDPGroupPeers>& peers = changed[liveness->group];
+                    if (peers == nullptr)
+                    {
+                        peers = std::make_shared<UDPGroupPeers>(*groups.peers[liveness->group]);
+                    }
+                    std::optional<size_t> position = peers->addresses.erase(liveness->address);
+                    if (position.has_value())
+                    {
+                        peers->liveness[*position] = std::move(peers->liveness.back());
+                        peers->liveness.pop_back();
+                    }
+                    logInfo("[UDP] - Removing peer [", kt::getAddress(liveness->address).value_or(""), ":", kt::getPortNumber(liveness->address), "] from UDP group [", groups.ids[liveness->group], "] after [", udpPeerTTL.count(), "ms] without a datagram.");
+                }
+                for (std::pair<const uint32_t, std::shared_ptr<UDPGroupPeers>>& group : changed)
+                {
+                    groups.peers[group.first] = std::move(group.second);
+                }
+            });
+        }
+    }
+
+    /**
+     * Adds a peer to the expiry wheel, due once it may have been idle for the TTL. Preconfigured peers never expire unless configured to.
+     */
+    void Forwarder::scheduleUDPPeerExpiry(std::shared_ptr<UDPPeerLiveness> liveness)
+    {
+        if (liveness->preconfigured && !udpExpirePreconfigured)
+        {
+            return;
+        }
+        const std::chrono::steady_clock::time_point lastSeen(std::chrono::steady_clock::duration(liveness->lastSeen.load(std::memory_order_relaxed)));
+        udpPeerExpiry->schedule(std::move(liveness), lastSeen + udpPeerTTL);
+    }
+
+    /**
+     * Marks the sender of a datagram as heard from if it is a peer of the group the datagram was sent to. Peers are stored under the port
+     * they asked to receive on, so a peer that sends from a different port is only kept alive by joining again.
+     */
+    void Forwarder::refreshUDPPeer(const UDPGroupPeers& peers, const kt::SocketAddress& address, const std::chrono::steady_clock::time_point now)
+    {
+        std::optional<size_t> position = peers.addresses.find(address);
+        if (position.has_value())
+        {
+            peers.liveness[*position]->lastSeen.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Adds the sender of a join message to the UDP group named in the message, returns false if the message is not a join message.
+     * The join message is the new client prefix followed by "<groupId>:<port>", or just the port to join the default group.
+     */
+    bool Forwarder::registerUDPClient(const std::string& message, kt::SocketAddress address)
+    {
+        // This is a new client, check their first message content
+        if (message.rfind(newClientPrefix, 0) != 0)
+        {
+            return false;
+        }
+
+        std::string addressString = kt::getAddress(address).value_or("") + ":" + std::to_string(kt::getPortNumber(address));
+        const std::string request = message.substr(newClientPrefix.size());
+        const size_t separator = request.rfind(':');
+        const std::string groupId = separator == std::string::npos ? "" : request.substr(0, separator);
+        std::string recievingPort = separator == std::string::npos ? request : request.substr(separator + 1);
+        logInfo("[UDP] - New client joined UDP group [", groupId, "] from address [", addressString, "] with request reply port [", recievingPort, "]");
+
+        address.ipv4.sin_port = htons(std::atoi(recievingPort.c_str()));
+        addAddressToUDPGroup(groupId, address);
+        return true;
+    }
+
+    /**
+     * Returns the index of the group a received UDP datagram is sent to and sets the size of its channel header, or nullopt if the channel
+     * header is cut short or names a group that nobody has joined.
+     */
+    std::optional<uint32_t> Forwarder::findUDPGroup(const UDPGroups& groups, const char* data, const size_t size, size_t& headerSize)
+    {
+        std::optional<UDPChannel> channel = parseUDPChannel(data, size);
+        if (!channel.has_value())
+        {
+            return std::nullopt;
+        }
+        headerSize = channel->headerSize;
+        if (channel->groupId.empty())
+        {
+            return std::make_optional<uint32_t>(0);
+        }
+
+        std::unordered_map<std::string, uint32_t>::const_iterator group = groups.indexes.find(std::string(channel->groupId));
+        if (group == groups.indexes.end())
+        {
+            return std::nullopt;
+        }
+        return std::make_optional(group->second);
+    }
+
+    /**
+     * Returns the calling thread's counters for the provided UDP group, creating them the first time the thread counts for the group.
+     */
+    ForwardingCounters& Forwarder::getUDPGroupCounters(std::vector<std::shared_ptr<ForwardingCounters>>& counters, const UDPGroups& groups, const uint32_t group)
+    {
+        if (group >= counters.size())
+        {
+            counters.resize(group + 1);
+        }
+        if (counters[group] == nullptr)
+        {
+            counters[group] = metrics.createCounters({ METRICS_PROTOCOL_UDP, groups.ids[group] });
+        }
+        return *counters[group];
+    }
+
+    /**
+     * The io_uring equivalent of startUDPListener() and startUDPDataForwarder() running on a single thread.
+     * Messages are received by a multishot receive into pooled buffers, and each message is sent to every known peer straight from the buffer it was received into.
+     * The sends for every peer are queued to the ring and submitted with a single system call, the buffer is recycled once all of them have completed.
+     */
+    void Forwarder::startUDPUringForwarder()
+    {
+        kt::UDPSocket& udpSocket = udpRecieveSocket.value();
+
+        IoUring ring;
+        if (!ring.open(UDP_RING_ENTRIES) || !ring.registerBufferRing(UDP_BUFFER_GROUP, UDP_PROVIDED_BUFFER_COUNT))
+        {
+            logWarning("[UDP] - Failed to set up io_uring, falling back to epoll.");
+            ring.close();
+            std::thread listeningThread(&Forwarder::startUDPListener, this, udpSocket.getListeningSocket());
+            startUDPDataForwarder();
+            listeningThread.join();
+            return;
+        }
+
+        logInfo("[UDP] - Starting io_uring UDP forwarder...");
+        // The provided buffers only fit a single datagram, so coalesced reads would be cut off
+        setUDPGRO(udpSocket.getListeningSocket(), false);
+        // Every received buffer starts with the io_uring_recvmsg_out header and the sender's address, followed by the message
+        const size_t headerSize = sizeof(io_uring_recvmsg_out) + sizeof(kt::SocketAddress);
+        BufferPool bufferPool(headerSize + maxReadInSize);
+        std::vector<MessageBuffer*> providedBuffers(UDP_PROVIDED_BUFFER_COUNT, nullptr);
+        auto provideBuffer = [&](const uint16_t id)
+        {
+            providedBuffers[id] = bufferPool.acquire();
+            ring.provideBuffer(providedBuffers[id]->data.data(), static_cast<unsigned>(headerSize + maxReadInSize), id);
+        };
+        for (uint16_t id = 0; id < UDP_PROVIDED_BUFFER_COUNT; id++)
+        {
+            provideBuffer(id);
+        }
+
+        // Messages are forwarded from unbound sockets, like the kt::UDPSocket used by startUDPDataForwarder()
+        const int sendSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        const int sendSocketIPv6 = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+        msghdr receiveMessage{};
+        receiveMessage.msg_namelen = sizeof(kt::SocketAddress);
+        ring.prepareReceiveMessage(udpSocket.getListeningSocket(), &receiveMessage, UDP_BUFFER_GROUP, true, UDP_RECEIVE_USER_DATA);
+
+        size_t outstandingSends = 0;
+        LogRateLimiter sendErrorLog;
+        LogRateLimiter malformedLog;
+        std::vector<std::shared_ptr<ForwardingCounters>> counters;
+        // Recycled once every send of their message has completed, so forwarding a message does not need to allocate
+        std::vector<std::unique_ptr<UDPUringSend>> allocatedSends;
+        std::vector<UDPUringSend*> availableSends;
+        auto releaseSend = [&](UDPUringSend* send)
+        {
+            bufferPool.release(send->buffer);
+            availableSends.push_back(send);
+        };
+        // The sends point at the peers' addresses, the kernel only copies them once they are submitted, so the versions of the groups holding
+        // them are kept until then in case a join replaces them
+        std::vector<std::shared_ptr<const UDPGroups>> unsubmittedGroups;
+        // The messages with sends prepared since the last submit, stamped with the time they are handed to the kernel
+        std::vector<UDPUringSend*> unsubmittedSends;
+        auto submit = [&]()
+        {
+            const std::chrono::steady_clock::time_point submittedAt = std::chrono::steady_clock::now();
+            for (UDPUringSend* send : unsubmittedSends)
+            {
+                send->submittedAt = submittedAt;
+            }
+            unsubmittedSends.clear();
+            // There is nothing to wake this thread when the forwarder is stopped, so the wait is bounded like udpSocket.ready()
+            ring.submit(1, std::chrono::milliseconds(100));
+            unsubmittedGroups.clear();
+        };
+        auto handleCompletion = [&](const io_uring_cqe& completion)
+        {
+            if (completion.user_data != UDP_RECEIVE_USER_DATA)
+            {
+                // The user data of a send is the message it was sent from
+                UDPUringSend* send = reinterpret_cast<UDPUringSend*>(completion.user_data);
+                UDPMessageDelivery& delivery = send->delivery;
+                ForwardingCounters& groupCounters = *delivery.counters;
+                delivery.pendingSends--;
+                if (completion.res < 0)
+                {
+                    delivery.deliveryIncomplete = true;
+                    groupCounters.recordSendFailure();
+                    getLogger().log(sendErrorLog, LogLevel::Warning, "[UDP] - Failed to forward message to peer with error [", -completion.res, "].");
+                }
+                else
+                {
+                    groupCounters.recordSent(static_cast<size_t>(completion.res));
+                    const std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+                    const std::chrono::steady_clock::duration sinceReceived = sent - send->receivedAt;
+                    groupCounters.peerSend.record(sent - send->submittedAt);
+                    if (!delivery.firstSendRecorded)
+                    {
+                        delivery.firstSendRecorded = true;
+                        groupCounters.receiveToFirstSend.record(sinceReceived);
+                    }
+                    if (delivery.pendingSends == 0 && !delivery.deliveryIncomplete)
+                    {
+                        groupCounters.receiveToLastSend.record(sinceReceived);
+                    }
+                }
+                if (delivery.pendingSends == 0)
+                {
+                    releaseSend(send);
+                }
+                outstandingSends--;
+                return;
+            }
+
+            if ((completion.flags & IORING_CQE_F_MORE) == 0 && forwarderIsRunning)
+            {
+                ring.prepareReceiveMessage(udpSocket.getListeningSocket(), &receiveMessage, UDP_BUFFER_GROUP, true, UDP_RECEIVE_USER_DATA);
+            }
+            if ((completion.flags & IORING_CQE_F_BUFFER) == 0)
+            {
+                return;
+            }
+
+            const uint16_t id = static_cast<uint16_t>(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+            MessageBuffer* buffer = providedBuffers[id];
+            provideBuffer(id);
+            if (completion.res < static_cast<int>(headerSize))
+            {
+                bufferPool.release(buffer);
+                return;
+            }
+
+            const io_uring_recvmsg_out* header = reinterpret_cast<const io_uring_recvmsg_out*>(buffer->data.data());
+            kt::SocketAddress address{};
+            std::memcpy(&address, buffer->data.data() + sizeof(io_uring_recvmsg_out), std::min<size_t>(header->namelen, sizeof(kt::SocketAddress)));
+            const char* payload = buffer->data.data() + headerSize;
+            const size_t payloadSize = std::min<size_t>(header->payloadlen, maxReadInSize);
+
+            if (debug)
+            {
+                std::string addressString = kt::getAddress(address).value_or("") + ":" + std::to_string(kt::getPortNumber(address));
+                logDebug("[UDP] - Received message [", std::string_view(payload, payloadSize), "] from address: [", addressString, "]");
+            }
+
+            if (payloadSize >= newClientPrefix.size() && std::memcmp(payload, newClientPrefix.data(), newClientPrefix.size()) == 0)
+            {
+                registerUDPClient(std::string(payload, payloadSize), address);
+                bufferPool.release(buffer);
+                return;
+            }
+
+            std::shared_ptr<const UDPGroups> groups = udpGroups.load();
+            size_t channelHeaderSize = 0;
+            std::optional<uint32_t> group = findUDPGroup(*groups, payload, payloadSize, channelHeaderSize);
+            if (!group.has_value())
+            {
+                getLogger().log(malformedLog, LogLevel::Warning, "[UDP] - Dropping message with a malformed channel header or an unknown group from address [", kt::getAddress(address).value_or(""), ":", kt::getPortNumber(address), "].");
+                bufferPool.release(buffer);
+                return;
+            }
+
+            if (udpPeerTTL.count() > 0)
+            {
+                refreshUDPPeer(*groups->peers[*group], address, std::chrono::steady_clock::now());
+            }
+            if (payloadSize == channelHeaderSize)
+            {
+                // Empty datagrams are not forwarded, they only keep their sender alive
+                bufferPool.release(buffer);
+                return;
+            }
+
+            const char* message = payload + channelHeaderSize;
+            const size_t messageSize = payloadSize - channelHeaderSize;
+            const uint64_t traceId = tracer->sample(debug);
+            tracer->record(traceId, TraceEventType::Receive, udpSocket.getListeningSocket(), messageSize);
+            ForwardingCounters& groupCounters = getUDPGroupCounters(counters, *groups, *group);
+            groupCounters.recordReceived(messageSize);
+
+            UDPUringSend* send = nullptr;
+            if (availableSends.empty())
+            {
+                allocatedSends.push_back(std::make_unique<UDPUringSend>());
+                send = allocatedSends.back().get();
+            }
+            else
+            {
+                send = availableSends.back();
+                availableSends.pop_back();
+            }
+            // The message takes over the receive's reference to the buffer
+            send->buffer = buffer;
+            send->receivedAt = std::chrono::steady_clock::now();
+            send->delivery = { traceId, &groupCounters, 0, false, false };
+
+            const AddressTable& peers = groups->peers[*group]->addresses;
+            if (!peers.empty() && (unsubmittedGroups.empty() || unsubmittedGroups.back() != groups))
+            {
+                unsubmittedGroups.push_back(groups);
+            }
+            for (const kt::SocketAddress& peer : peers)
+            {
+                const int peerSocket = peer.address.sa_family == AF_INET6 ? sendSocketIPv6 : sendSocket;
+                if (ring.prepareSendTo(peerSocket, message, messageSize, &peer.address, kt::getAddressLength(peer), reinterpret_cast<uint64_t>(send)))
+                {
+                    tracer->record(traceId, TraceEventType::Send, peerSocket, messageSize);
+                    send->delivery.pendingSends++;
+                    outstandingSends++;
+                }
+                else
+                {
+                    tracer->record(traceId, TraceEventType::Drop, peerSocket, messageSize);
+                    send->delivery.deliveryIncomplete = true;
+                    groupCounters.recordSendFailure();
+                }
+            }
+            if (debug)
+            {
+                logDebug("[UDP - ", traceIdToString(traceId), "] - Forwarding message to [", peers.size(), "] peer(s) in group [", groups->ids[*group], "].");
+            }
+            if (send->delivery.pendingSends == 0)
+            {
+                releaseSend(send);
+            }
+            else
+            {
+                unsubmittedSends.push_back(send);
+            }
+        };
+
+        while (forwarderIsRunning)
+        {
+            ring.commitBuffers();
+            submit();
+
+            io_uring_cqe* entry = nullptr;
+            while ((entry = ring.peekCompletion()) != nullptr)
+            {
+                io_uring_cqe completion = *entry;
+                ring.advanceCompletion();
+                handleCompletion(completion);
+            }
+        }
+
+        // The kernel is still reading from the buffers of any send in flight, give them a moment to complete before they are released
+        for (int attempt = 0; attempt < 10 && outstandingSends > 0; attempt++)
+        {
+            submit();
+            io_uring_cqe* entry = nullptr;
+            while ((entry = ring.peekCompletion()) != nullptr)
+            {
+                io_uring_cqe completion = *entry;
+                ring.advanceCompletion();
+                handleCompletion(completion);
+            }
+        }
+
+        ring.close();
+        for (MessageBuffer* buffer : providedBuffers)
+        {
+            bufferPool.release(buffer);
+        }
+        if (sendSocket != -1)
+        {
+            close(sendSocket);
+        }
+        if (sendSocketIPv6 != -1)
+        {
+            close(sendSocketIPv6);
+        }
+    }
+
+    size_t Forwarder::udpGroupMemberCount(const std::string& groupId)
+    {
+        std::shared_ptr<const UDPGroups> groups = udpGroups.load();
+        std::unordered_map<std::string, uint32_t>::const_iterator group = groups->indexes.find(groupId);
+        return group == groups->indexes.end() ? 0 : groups->peers[group->second]->addresses.size();
+    }
+
+    /**
+     * Returns the trace events currently held by the trace ring, oldest first. Safe to call from any thread while the forwarder is running.
+     */
+    std::vector<TraceEvent> Forwarder::traceEvents() const
+    {
+        return tracer->snapshot();
+    }
+
+    void Forwarder::dumpTraces(std::ostream& stream) const
+    {
+        tracer->dump(stream);
+    }
+
+    /**
+     * Returns the forwarding counters of every TCP group and of UDP, added up across the threads that counted them.
+     */
+    std::map<MetricsSeries, ForwardingTotals> Forwarder::forwardingTotals() const
+    {
+        return metrics.totals();
+    }
+
+    /**
+     * Writes the forwarding counters and the current groups and members in the Prometheus text format. Safe to call from any thread once the forwarder has started.
+     */
+    void Forwarder::writeMetrics(std::ostream& stream) const
+    {
+        std::map<MetricsSeries, size_t> memberCounts;
+        for (const std::unique_ptr<TCPShard>& shard : tcpShards)
+        {
+            std::shared_ptr<const TCPGroupRegistry> registry = shard->registry.load();
+            for (const auto& group : *registry)
+            {
+                memberCounts[{ METRICS_PROTOCOL_TCP, group.first }] = group.second->members.size();
+            }
+        }
+        if (udpRecieveSocket.has_value())
+        {
+            std::shared_ptr<const UDPGroups> groups = udpGroups.load();
+            for (size_t group = 0; group < groups->ids.size(); group++)
+            {
+                memberCounts[{ METRICS_PROTOCOL_UDP, groups->ids[group] }] = groups->peers[group]->addresses.size();
+            }
+        }
+        metrics.write(stream, memberCounts);
+    }
+
+    void Forwarder::stop()
+    {
+        forwarderIsRunning = false;
+        for (std::unique_ptr<TCPShard>& shard : tcpShards)
+        {
+            shard->eventLoop.wake();
+        }
+    }
+
+    void Forwarder::join()
+    {
+        for (std::unique_ptr<TCPShard>& shard : tcpShards)
+        {
+            if (shard->thread.has_value())
+            {
+                shard->thread->join();
+                shard->thread = std::nullopt;
+            }
+            shard->eventLoop.close();
+        }
+
+        for (std::thread& thread : udpRunningThreads)
+        {
+            thread.join();
+        }
+        udpRunningThreads.clear();
+        // Closed once the UDP threads have stopped, so no receiver is left reading from a closed socket
+        if (udpRecieveSocket.has_value())
+        {
+            udpRecieveSocket->close();
+        }
+        for (const int descriptor : udpReusePortSockets)
+        {
+            close(descriptor);
+        }
+        udpReusePortSockets.clear();
+        // Cleared once the UDP threads have stopped, since the receivers and the expiry thread publish the groups while running
+        std::lock_guard<std::mutex> lock(udpGroupsMutex);
+        udpPeerExpiry.reset();
+        udpGroups.publish(std::make_shared<const UDPGroups>());
     }
 }
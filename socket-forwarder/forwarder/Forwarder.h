@@ -5,43 +5,332 @@
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
-#include <queue>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <ostream>
 
 #include <serversocket/ServerSocket.h>
 #include <socket/TCPSocket.h>
 #include <socket/UDPSocket.h>
 
+#include "../eventloop/EventLoop.h"
+#include "../buffer/DatagramBatch.h"
+#include "../buffer/DatagramRing.h"
+#include "../buffer/MessageBuffer.h"
+#include "../buffer/OutboundQueue.h"
+#include "../buffer/SplicePipe.h"
+#include "../container/AddressTable.h"
+#include "../container/SlotMap.h"
+#include "../container/Snapshot.h"
+#include "../container/TimingWheel.h"
+#include "../framing/Framing.h"
+#include "../uring/IoUring.h"
+#include "../tracing/Tracer.h"
+#include "../logging/Logger.h"
+#include "../metrics/Metrics.h"
+
 namespace forwarder
 {
+    /**
+     * A send queued to io_uring, the kernel reads the message header and vectors when the send is issued so they are kept at a fixed address until it completes.
+     */
+    struct TCPPendingSend
+    {
+        msghdr message;
+        iovec vectors[TCP_MAX_SEND_BATCH];
+        MessageBuffer* buffers[TCP_MAX_SEND_BATCH];
+    };
+
+    /**
+     * A peer's outbound counters, written by the worker that owns the peer and readable from any thread through the group registry.
+     */
+    struct TCPPeerCounters
+    {
+        std::string address;
+        std::atomic<size_t> queuedBytes{ 0 };
+        std::atomic<uint64_t> droppedMessages{ 0 };
+        std::atomic<uint64_t> droppedBytes{ 0 };
+        std::atomic<uint64_t> sendCount{ 0 };
+        std::atomic<uint64_t> sentMessages{ 0 };
+
+        TCPPeerCounters(const std::string& peerAddress) : address(peerAddress) {}
+    };
+
+    /**
+     * A socket that has joined a TCP group. The socket is non-blocking and messages that it cannot accept immediately
+     * wait in its outbound queue until it becomes writable, so a slow peer never blocks the rest of the worker.
+     */
+    struct TCPPeer
+    {
+        kt::TCPSocket socket;
+        std::string groupId;
+        OutboundQueue outboundQueue;
+        // Tracks the buffers the kernel still references after zero copy sends, only set when SO_ZEROCOPY is enabled for this socket
+        std::optional<ZeroCopyTracker> zeroCopyTracker = std::nullopt;
+        bool waitingForWritable = false;
+        // In framed groups, the bytes received from this peer after its last whole frame, held until the rest of the frame arrives
+        MessageBuffer* partialFrame = nullptr;
+        // In splice groups, the pipe that holds this peer's outbound data in place of its outbound queue
+        std::optional<SplicePipe> splicePipe = std::nullopt;
+        // Whether this peer is in its shard's scheduled flushes, and when its queue must be written by
+        bool flushScheduled = false;
+        std::chrono::steady_clock::time_point flushDeadline;
+
+        // With the io_uring engine, whether this socket's multishot receive and a send are in flight
+        bool receiving = false;
+        bool sending = false;
+        std::unique_ptr<TCPPendingSend> pendingSend;
+
+        std::shared_ptr<TCPPeerCounters> counters;
+    };
+
+    /**
+     * The members of a TCP group, packed contiguously so that forwarding a message iterates over a dense array.
+     */
+    struct TCPGroup
+    {
+        std::string id;
+        FramingMode framing = FramingMode::None;
+        // Whether messages are moved between the group's sockets in the kernel using splice() and tee()
+        bool splice = false;
+        // How long messages forwarded to a member can wait for more messages to be written with them, 0 writes them at the end of the current loop iteration
+        std::chrono::microseconds flushWindow = std::chrono::microseconds(0);
+        SlotMap<TCPPeer> members;
+        // Only written by the shard that owns the group, and kept by the forwarder's metrics once the group is gone
+        std::shared_ptr<ForwardingCounters> counters;
+    };
+
+    /**
+     * An immutable view of a group's members, published to the shard's registry whenever members join or leave.
+     */
+    struct TCPGroupSnapshot
+    {
+        std::vector<std::shared_ptr<const TCPPeerCounters>> members;
+    };
+
+    // Each group's view is shared between versions of the registry, so publishing a change only copies the changed groups
+    using TCPGroupRegistry = std::unordered_map<std::string, std::shared_ptr<const TCPGroupSnapshot>>;
+
+    /**
+     * The progress of a UDP message being sent to every peer in a batch, so its latencies are recorded once its first and last sends complete.
+     */
+    struct UDPMessageDelivery
+    {
+        uint64_t traceId = 0;
+        ForwardingCounters* counters = nullptr;
+        size_t pendingSends = 0;
+        bool firstSendRecorded = false;
+        bool deliveryIncomplete = false;
+    };
+
+    /**
+     * A UDP message whose sends to every peer are queued to io_uring. Each send's user data points at it, so the completions record the message's
+     * latencies into its group's counters. It holds the message's buffer until the last send has completed.
+     */
+    struct UDPUringSend
+    {
+        MessageBuffer* buffer = nullptr;
+        std::chrono::steady_clock::time_point receivedAt;
+        // When the message's sends were submitted to the kernel, each peer's send time is measured from here to its completion
+        std::chrono::steady_clock::time_point submittedAt;
+        UDPMessageDelivery delivery;
+    };
+
+    /**
+     * Consecutive UDP messages to the same group that are sent to each peer with a single UDP_SEGMENT send.
+     * Every message in the run but the last is the size of the first.
+     */
+    struct UDPMessageRun
+    {
+        size_t first = 0;
+        size_t count = 0;
+        size_t bytes = 0;
+    };
+
+    /**
+     * When a UDP peer was last heard from. Shared by every version of its group, so receivers refresh it without locking and a refresh
+     * is never lost to a join copying the group.
+     */
+    struct UDPPeerLiveness
+    {
+        kt::SocketAddress address;
+        uint32_t group;
+        bool preconfigured;
+        // The time since the steady clock's epoch of the last datagram or join received from the peer
+        std::atomic<std::chrono::steady_clock::rep> lastSeen;
+
+        UDPPeerLiveness(const kt::SocketAddress& peerAddress, const uint32_t peerGroup, const bool isPreconfigured, const std::chrono::steady_clock::time_point now) :
+            address(peerAddress), group(peerGroup), preconfigured(isPreconfigured), lastSeen(now.time_since_epoch().count()) {}
+    };
+
+    /**
+     * The peers of a UDP group, with each peer's liveness at the same position as its address.
+     */
+    struct UDPGroupPeers
+    {
+        AddressTable addresses;
+        std::vector<std::shared_ptr<UDPPeerLiveness>> liveness;
+    };
+
+    /**
+     * Where a socket's peer is stored, the handle stays valid while other members join and leave the group.
+     */
+    struct TCPPeerLocation
+    {
+        TCPGroup* group;
+        SlotHandle handle;
+    };
+
+    /**
+     * An accepted connection that has not yet sent the whole prefix of its join message.
+     */
+    struct TCPPendingHandshake
+    {
+        kt::TCPSocket socket;
+        // The bytes of the join message received so far
+        std::string received;
+        // When the connection is closed if it has not joined a group, the maximum time point if handshakes do not time out
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    struct TCPPeerStatistics
+    {
+        std::string address;
+        size_t queuedBytes;
+        uint64_t droppedMessages;
+        uint64_t droppedBytes;
+        // The amount of writes to the socket and the amount of messages they completed, their ratio is the average amount of messages per write
+        uint64_t sendCount;
+        uint64_t sentMessages;
+    };
+
+    /**
+     * The state owned by a single TCP worker thread.
+     * Each group is pinned to exactly one shard by the hash of its group ID, and only that shard's thread reads from, writes to and closes the group's sockets.
+     */
+    struct TCPShard
+    {
+        size_t index = 0;
+        EventLoop eventLoop;
+        std::optional<std::thread> thread = std::nullopt;
+        // The listening socket this shard accepts new connections from, -1 if this shard does not accept connections
+        int listeningSocket = -1;
+
+        std::unordered_map<std::string, TCPGroup> sessions;
+        // The location of every group member by socket descriptor, so epoll events can be dispatched to the owning peer and group
+        std::unordered_map<int, TCPPeerLocation> peers;
+        // Accepted sockets that have not yet sent their first message to join a group
+        std::unordered_map<int, TCPPendingHandshake> pendingHandshakes;
+        // The deadline of each pending handshake in the order they were accepted, which is also the order they expire in
+        std::deque<std::pair<int, std::chrono::steady_clock::time_point>> handshakeDeadlines;
+        // Join messages are read into this buffer before being copied into their pending handshake, so each read does not allocate
+        std::vector<char> handshakeBuffer;
+        // The descriptors of peers with messages queued that are written once their flush deadline passes
+        std::vector<int> scheduledFlushes;
+        // When the outbound queues are next checked against the lag limit, so peers that stopped reading are caught while nothing is pushed to them
+        std::chrono::steady_clock::time_point nextLagCheck;
+
+        // Received messages are read once into a pooled buffer that is shared by every peer forwarding it
+        BufferPool bufferPool;
+        // Each forwarded message's progress towards every peer, shared by the peers' queues to record its receive to send latencies
+        DeliveryPool deliveryPool;
+
+        // Splice groups read into this pipe before it is duplicated to each peer, only opened once the shard owns a splice group
+        SplicePipe receivePipe;
+        // Opened to /dev/null, anything left in the receive pipe after it has been duplicated to each peer is spliced here
+        int nullDescriptor = -1;
+
+        // With the io_uring engine every socket operation is queued to this ring instead of waiting for readiness from the event loop,
+        // the event loop's wake descriptor is still polled through the ring so stop() and handoffs wake the worker the same way
+        IoUring ring;
+        // The pooled buffer behind each provided buffer ID, a received message is forwarded straight from the buffer the kernel received it into
+        std::vector<MessageBuffer*> providedBuffers;
+        // Removed members whose socket still has operations in flight, they are closed once every operation has completed
+        std::unordered_map<int, TCPPeer> closingPeers;
+
+        // The shard's groups as seen by other threads. Only the shard's thread publishes it, once per loop iteration in which members joined or left
+        Snapshot<TCPGroupRegistry> registry;
+        std::unordered_set<std::string> changedGroups;
+
+        // Limit the messages logged for events that can repeat once per message or connection attempt
+        LogRateLimiter slowConsumerLog;
+        LogRateLimiter acceptErrorLog;
+
+        // Sockets accepted by other shards that belong to a group owned by this shard, drained when the event loop is woken
+        std::mutex handoffMutex;
+        std::vector<std::pair<std::string, kt::TCPSocket>> handoffQueue;
+
+        TCPPeer* findPeer(const int descriptor)
+        {
+            auto location = peers.find(descriptor);
+            return location == peers.end() ? nullptr : location->second.group->members.get(location->second.handle);
+        }
+    };
+
     class Forwarder
     {
     protected:
-        std::unordered_map<std::string, std::vector<kt::TCPSocket>> tcpSessions;
+        std::vector<std::unique_ptr<TCPShard>> tcpShards;
+        size_t tcpWorkerCount = 1;
+        bool tcpReusePort = false;
+        // Messages of at least this size are sent using MSG_ZEROCOPY, 0 disables zero copy sends
+        size_t tcpZeroCopyThreshold = 0;
+        SlowConsumerPolicy tcpSlowConsumerPolicy = SlowConsumerPolicy::Disconnect;
+        size_t tcpMaxQueuedBytes = 4194304;
+        std::chrono::milliseconds tcpMaxLag = std::chrono::milliseconds(0);
+        std::unordered_map<std::string, FramingMode> tcpGroupFraming;
+        size_t tcpMaxFrameSize = 1048576;
+        std::unordered_set<std::string> tcpSpliceGroups;
+        std::chrono::microseconds tcpFlushWindow = std::chrono::microseconds(0);
+        std::unordered_map<std::string, std::chrono::microseconds> tcpGroupFlushWindows;
+        bool tcpCork = false;
+        // Connections that have not sent their join message within this time are closed, 0 never times out
+        std::chrono::milliseconds tcpHandshakeTimeout = std::chrono::milliseconds(5000);
+        IOEngine ioEngine = IOEngine::Epoll;
+        // Replaced by setTracing(), so it must not be called once the forwarder has started
+        std::unique_ptr<Tracer> tracer = std::make_unique<Tracer>();
+        Metrics metrics;
 
-        struct AddressHash
+        /**
+         * Every UDP group, named by the channel header of the datagrams sent to it. Groups are never removed, so a group keeps its index for the
+         * forwarder's lifetime and queued messages refer to their group by index. Each group's peers are shared between versions, so a join
+         * only copies the peers of the group it changes. The default group, which datagrams without a channel header are sent to, always exists.
+         */
+        struct UDPGroups
         {
-            std::size_t operator()(const kt::SocketAddress& k) const
-            {
-                return std::hash<std::string>()(kt::getAddress(k).value_or("") + ":" + std::to_string(kt::getPortNumber(k)));
-            }
-        };
+            std::unordered_map<std::string, uint32_t> indexes;
+            std::vector<std::string> ids;
+            std::vector<std::shared_ptr<const UDPGroupPeers>> peers;
 
-        struct AddressEqual
-        {
-            bool operator()(const kt::SocketAddress& lhs, const kt::SocketAddress& rhs) const
-            {
-                return std::memcmp(&lhs, &rhs, sizeof(lhs));
-            }
+            UDPGroups() : indexes{ { "", 0 } }, ids{ "" }, peers{ std::make_shared<const UDPGroupPeers>() } {}
         };
 
-        // For UDP since we don't know who is sending specific messages from, ALL UDP connections will be treated as the same group
-        std::unordered_set<kt::SocketAddress, AddressHash, AddressEqual> udpKnownPeers;
-        std::queue<std::string> udpMessageQueue;
+        // Joins publish a new version of the groups, so the forwarding thread iterates its current version without locking
+        Snapshot<UDPGroups> udpGroups;
+        // Created when the UDP forwarder starts, since its size is only known once the setters have been called
+        std::unique_ptr<DatagramRing> udpMessageRing;
+        size_t udpQueueSize = 1024;
+        OverflowPolicy udpOverflowPolicy = OverflowPolicy::DropNewest;
+        bool udpOffload = true;
+        size_t udpReceiverCount = 1;
+        bool udpCPUSteering = false;
+        // The SO_REUSEPORT sockets bound next to the provided UDP socket, closed once the receivers have stopped
+        std::vector<int> udpReusePortSockets;
+        // Receivers join peers concurrently, while Snapshot only allows a single publisher at a time. Also guards the expiry wheel
+        std::mutex udpGroupsMutex;
+        // Peers that have not been heard from for this long are removed from their group, 0 never removes them
+        std::chrono::milliseconds udpPeerTTL = std::chrono::milliseconds(0);
+        bool udpExpirePreconfigured = false;
+        // Holds each expiring peer until it may have been idle for the TTL, only created while the UDP forwarder runs with a TTL
+        std::optional<TimingWheel<std::shared_ptr<UDPPeerLiveness>>> udpPeerExpiry;
 
-        std::optional<std::pair<std::thread, std::thread>> tcpRunningThreads = std::nullopt;
-        std::optional<std::pair<std::thread, std::thread>> udpRunningThreads = std::nullopt;
+        std::vector<std::thread> udpRunningThreads;
 
-        bool forwarderIsRunning = false;
+        std::atomic<bool> forwarderIsRunning{ false };
         std::string newClientPrefix;
         unsigned short maxReadInSize;
         bool debug = false;
@@ -49,32 +338,99 @@ namespace forwarder
         std::optional<kt::UDPSocket> udpRecieveSocket = std::nullopt;
         std::optional<kt::ServerSocket> tcpServerSocket = std::nullopt;
 
-        std::unordered_map<kt::SocketAddress, std::string, AddressHash, AddressEqual> tcpPreconfigured;
+        AddressTable tcpPreconfigured;
+        // The group of each preconfigured address, by its position in tcpPreconfigured
+        std::vector<std::string> tcpPreconfiguredGroups;
 
         void startUDPForwarder();
-        void startUDPListener();
+        void startUDPListener(const int);
         void startUDPDataForwarder();
+        void startUDPPeerExpiry();
+        void scheduleUDPPeerExpiry(std::shared_ptr<UDPPeerLiveness>);
+        void refreshUDPPeer(const UDPGroupPeers&, const kt::SocketAddress&, const std::chrono::steady_clock::time_point);
 
         void startTCPForwarder();
-        void startTCPConnectionListener();
-        void startTCPDataForwarder();
+        void startTCPWorker(TCPShard&);
+        void closeTCPShard(TCPShard&);
+        void addHandedOffTCPSockets(TCPShard&);
+        void acceptTCPConnections(TCPShard&);
+        void handleAcceptedTCPConnection(TCPShard&, kt::TCPSocket);
+        void completeTCPHandshake(TCPShard&, int);
+        void continueTCPHandshake(TCPShard&, int, const char*, const ssize_t);
+        std::chrono::microseconds expireTCPHandshakes(TCPShard&);
+        void joinTCPGroup(TCPShard&, kt::TCPSocket, const std::string&);
+        void forwardTCPData(TCPShard&, int);
+        MessageBuffer* readTCPFrames(TCPShard&, TCPGroup&, TCPPeer&, bool&);
+        MessageBuffer* appendTCPFrames(TCPShard&, TCPGroup&, TCPPeer&, MessageBuffer*, bool&);
+        MessageBuffer* completeTCPFrames(TCPShard&, TCPGroup&, TCPPeer&, MessageBuffer*, bool&);
+        void forwardTCPBuffer(TCPShard&, TCPGroup&, int, MessageBuffer*);
+        bool spliceTCPData(TCPShard&, TCPGroup&, int);
+        bool queueForTCPPeer(TCPShard&, TCPGroup&, TCPPeer&, MessageBuffer*, MessageDelivery*, const std::chrono::steady_clock::time_point, const uint64_t);
+        void scheduleTCPFlush(TCPShard&, TCPPeer&, const std::chrono::steady_clock::time_point);
+        std::chrono::microseconds flushScheduledTCPPeers(TCPShard&);
+        std::chrono::microseconds expireLaggingTCPPeers(TCPShard&);
+        bool flushTCPPeer(TCPShard&, TCPPeer&);
+        void recordTCPSendFailure(TCPShard&, int);
+
+        TCPShard& getTCPShardForGroup(const std::string&);
+        void dispatchSocketToTCPGroup(TCPShard&, const std::string&, kt::TCPSocket);
+        void addSocketToTCPGroup(TCPShard&, const std::string&, kt::TCPSocket);
+        void removeSocketFromTCPGroup(TCPShard&, int);
+        void releaseTCPPeer(TCPShard&, TCPPeer&);
+        void publishTCPPeerCounters(const TCPPeer&);
+        void publishTCPRegistry(TCPShard&);
 
-        void addSocketToTCPGroup(const std::string&, kt::TCPSocket);
+        void startTCPUringWorker(TCPShard&);
+        void handleTCPUringCompletion(TCPShard&, const io_uring_cqe&);
+        void receiveTCPUring(TCPShard&, int, const io_uring_cqe&);
+        void completeTCPUringSend(TCPShard&, int, const io_uring_cqe&);
+        MessageBuffer* takeProvidedTCPBuffer(TCPShard&, const io_uring_cqe&);
+        void provideTCPBuffer(TCPShard&, const uint16_t);
+        void armTCPReceive(TCPShard&, TCPPeer&);
+        bool submitTCPSend(TCPShard&, TCPPeer&);
+        void releaseClosingTCPPeer(TCPShard&, int, const bool, const bool);
+
+        void startUDPUringForwarder();
+        bool registerUDPClient(const std::string&, kt::SocketAddress);
+        std::optional<uint32_t> findUDPGroup(const UDPGroups&, const char*, const size_t, size_t&);
+        ForwardingCounters& getUDPGroupCounters(std::vector<std::shared_ptr<ForwardingCounters>>&, const UDPGroups&, const uint32_t);
 
     public:
         Forwarder(std::optional<kt::ServerSocket>, std::optional<kt::UDPSocket>, const std::string, const unsigned short, const bool);
 
+        void setTCPWorkerCount(const size_t);
+        void setTCPReusePort(const bool);
+        void setTCPZeroCopyThreshold(const size_t);
+        void setTCPSlowConsumerPolicy(const SlowConsumerPolicy, const size_t, const std::chrono::milliseconds);
+        void setTCPGroupFraming(const std::string&, const FramingMode);
+        void setTCPMaxFrameSize(const size_t);
+        void setTCPGroupSplice(const std::string&, const bool);
+        void setTCPFlushWindow(const std::chrono::microseconds);
+        void setTCPGroupFlushWindow(const std::string&, const std::chrono::microseconds);
+        void setTCPCork(const bool);
+        void setTCPHandshakeTimeout(const std::chrono::milliseconds);
+        void setUDPQueue(const size_t, const OverflowPolicy);
+        void setUDPOffload(const bool);
+        void setUDPReceivers(const size_t, const bool);
+        void setUDPPeerExpiry(const std::chrono::milliseconds, const bool);
+        void setIOEngine(const IOEngine);
+        void setTracing(const uint64_t, const size_t);
+
         void preConfigureTCPAddress(const std::string&, kt::SocketAddress);
-        void addAddressToUDPGroup(kt::SocketAddress);
+        void preConfigureUDPAddress(const std::string&, kt::SocketAddress);
+        void addAddressToUDPGroup(const std::string&, kt::SocketAddress, const bool = false);
 
         bool tcpGroupWithIdExists(std::string&);
         size_t tcpGroupMemberCount(std::string&);
-        size_t udpGroupMemberCount();
+        std::vector<TCPPeerStatistics> tcpGroupPeerStatistics(std::string&);
+        size_t udpGroupMemberCount(const std::string& = "");
+        std::vector<TraceEvent> traceEvents() const;
+        void dumpTraces(std::ostream&) const;
+        std::map<MetricsSeries, ForwardingTotals> forwardingTotals() const;
+        void writeMetrics(std::ostream&) const;
         
         void start();
         void join();
         void stop();
     };
-
-    std::string getNewUUID();
 }
@@ -0,0 +1,214 @@
+#include "Framing.h"
+#include "../environment/Environment.h"
+#include "../sockets/Sockets.h"
+#include "../logging/Logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace forwarder
+{
+    // A 64 bit length never needs more than 10 varint bytes
+    const size_t MAX_VARINT_HEADER_SIZE = 10;
+    const size_t UINT32_HEADER_SIZE = 4;
+
+    std::optional<FramingMode> parseFramingMode(const std::string& mode)
+    {
+        if (mode == "none")
+        {
+            return std::make_optional(FramingMode::None);
+        }
+        else if (mode == "varint")
+        {
+            return std::make_optional(FramingMode::Varint);
+        }
+        else if (mode == "u32")
+        {
+            return std::make_optional(FramingMode::UInt32);
+        }
+        return std::nullopt;
+    }
+
+    std::string framingModeToString(const FramingMode mode)
+    {
+        switch (mode)
+        {
+            case FramingMode::Varint:
+                return "varint";
+            case FramingMode::UInt32:
+                return "u32";
+            default:
+                return "none";
+        }
+    }
+
+    /**
+     * Scans the provided buffer from its start for whole frames. A maximum frame size of 0 is unlimited.
+     * Scanning stops at the first incomplete frame, so the bytes after FrameScan::completeBytes are the start of the next frame.
+     */
+    FrameScan scanFrames(const FramingMode mode, const char* data, const size_t size, const size_t maxFrameSize)
+    {
+        FrameScan scan;
+        if (mode == FramingMode::None)
+        {
+            scan.completeBytes = size;
+            scan.frameCount = size > 0 ? 1 : 0;
+            return scan;
+        }
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        size_t offset = 0;
+        while (offset < size)
+        {
+            const size_t remaining = size - offset;
+            size_t headerSize = 0;
+            uint64_t payloadSize = 0;
+
+            if (mode == FramingMode::Varint)
+            {
+                for (size_t i = 0; i < MAX_VARINT_HEADER_SIZE && i < remaining; i++)
+                {
+                    payloadSize |= static_cast<uint64_t>(bytes[offset + i] & 0x7F) << (7 * i);
+                    if ((bytes[offset + i] & 0x80) == 0)
+                    {
+                        headerSize = i + 1;
+                        break;
+                    }
+                }
+                if (headerSize == 0)
+                {
+                    // Either the header is still arriving, or it is longer than any valid length
+                    scan.invalid = remaining >= MAX_VARINT_HEADER_SIZE;
+                    break;
+                }
+            }
+            else
+            {
+                if (remaining < UINT32_HEADER_SIZE)
+                {
+                    break;
+                }
+                payloadSize = (static_cast<uint64_t>(bytes[offset]) << 24) | (static_cast<uint64_t>(bytes[offset + 1]) << 16)
+                    | (static_cast<uint64_t>(bytes[offset + 2]) << 8) | static_cast<uint64_t>(bytes[offset + 3]);
+                headerSize = UINT32_HEADER_SIZE;
+            }
+
+            if ((maxFrameSize > 0 && payloadSize > maxFrameSize) || payloadSize > std::numeric_limits<size_t>::max() - headerSize)
+            {
+                scan.invalid = true;
+                break;
+            }
+
+            const size_t frameSize = headerSize + static_cast<size_t>(payloadSize);
+            if (remaining < frameSize)
+            {
+                scan.nextFrameSize = frameSize;
+                break;
+            }
+            offset += frameSize;
+            scan.frameCount++;
+        }
+
+        scan.completeBytes = offset;
+        return scan;
+    }
+
+    /**
+     * Creates the header that prefixes a payload of the provided size, clients use this to frame the messages they send.
+     */
+    std::string encodeFrameHeader(const FramingMode mode, const size_t payloadSize)
+    {
+        std::string header;
+        if (mode == FramingMode::Varint)
+        {
+            uint64_t remaining = payloadSize;
+            do
+            {
+                unsigned char byte = remaining & 0x7F;
+                remaining >>= 7;
+                header.push_back(static_cast<char>(remaining > 0 ? byte | 0x80 : byte));
+            } while (remaining > 0);
+        }
+        else if (mode == FramingMode::UInt32)
+        {
+            const uint32_t size = static_cast<uint32_t>(payloadSize);
+            header.push_back(static_cast<char>((size >> 24) & 0xFF));
+            header.push_back(static_cast<char>((size >> 16) & 0xFF));
+            header.push_back(static_cast<char>((size >> 8) & 0xFF));
+            header.push_back(static_cast<char>(size & 0xFF));
+        }
+        return header;
+    }
+
+    /**
+     * Returns the group a UDP datagram is sent to, the default group if it has no channel header or its header has an empty group ID,
+     * or nullopt if its channel header is cut short. The returned group ID points into the datagram.
+     */
+    std::optional<UDPChannel> parseUDPChannel(const char* data, const size_t size)
+    {
+        if (size == 0 || static_cast<unsigned char>(data[0]) != UDP_CHANNEL_MARKER)
+        {
+            return std::make_optional(UDPChannel{});
+        }
+        if (size < 2)
+        {
+            return std::nullopt;
+        }
+        const size_t groupIdSize = static_cast<unsigned char>(data[1]);
+        if (size < 2 + groupIdSize)
+        {
+            return std::nullopt;
+        }
+        return std::make_optional(UDPChannel{ std::string_view(data + 2, groupIdSize), 2 + groupIdSize });
+    }
+
+    /**
+     * Returns the channel header a client puts before its payload to send it to the provided group, group IDs are cut off at 255 bytes.
+     * The header for the default group is only needed when the payload itself starts with the channel marker.
+     */
+    std::string encodeUDPChannelHeader(const std::string& groupId)
+    {
+        const size_t groupIdSize = std::min(groupId.size(), UDP_CHANNEL_MAX_GROUP_ID_SIZE);
+        std::string header;
+        header.reserve(2 + groupIdSize);
+        header.push_back(static_cast<char>(UDP_CHANNEL_MARKER));
+        header.push_back(static_cast<char>(groupIdSize));
+        header.append(groupId, 0, groupIdSize);
+        return header;
+    }
+
+    std::unordered_map<std::string, FramingMode> getTCPGroupFraming(const std::string defaultValue)
+    {
+        std::unordered_map<std::string, FramingMode> framing;
+        std::vector<std::string> entries = split(getEnvironmentVariableValueOrDefault(TCP_FRAMING, defaultValue), ",");
+
+        for (const std::string& entry : entries)
+        {
+            std::vector<std::string> parts = split(entry, ":");
+            if (parts.size() == 1 && parts[0].empty())
+            {
+                // Skip
+            }
+            else if (parts.size() != 2)
+            {
+                logWarning("[TCP] - Unable to parse framing entry [", entry, "], expected format to be \"<groupId>:<varint|u32>\".");
+            }
+            else
+            {
+                std::optional<FramingMode> mode = parseFramingMode(parts[1]);
+                if (!mode.has_value())
+                {
+                    logWarning("[TCP] - Unknown framing mode [", parts[1], "] for group [", parts[0], "], messages in this group will not be framed.");
+                }
+                else
+                {
+                    logInfo("[TCP] - Group [", parts[0], "] will use [", framingModeToString(*mode), "] framing.");
+                    framing[parts[0]] = *mode;
+                }
+            }
+        }
+
+        return framing;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <unordered_map>
+#include <cstddef>
+
+namespace forwarder
+{
+    /**
+     * How the messages sent by members of a TCP group are delimited within the byte stream.
+     */
+    enum class FramingMode
+    {
+        // No framing, whatever is read from the socket is forwarded as is
+        None,
+        // Each frame is prefixed with its payload length as an unsigned LEB128 varint
+        Varint,
+        // Each frame is prefixed with its payload length as a 4 byte big endian unsigned integer
+        UInt32
+    };
+
+    std::optional<FramingMode> parseFramingMode(const std::string&);
+    std::string framingModeToString(const FramingMode);
+
+    /**
+     * The result of scanning a buffer for frames.
+     */
+    struct FrameScan
+    {
+        // The amount of bytes from the start of the buffer that make up whole frames
+        size_t completeBytes = 0;
+        // The amount of whole frames found
+        size_t frameCount = 0;
+        // The total size (header and payload) of the first incomplete frame, 0 if its header has not been fully received
+        size_t nextFrameSize = 0;
+        // Set when a frame header is malformed or declares a payload larger than the maximum frame size
+        bool invalid = false;
+    };
+
+    FrameScan scanFrames(const FramingMode, const char*, const size_t, const size_t);
+    std::string encodeFrameHeader(const FramingMode, const size_t);
+
+    std::unordered_map<std::string, FramingMode> getTCPGroupFraming(const std::string = "");
+
+    // The first byte of a UDP datagram that starts with a channel header, followed by the group ID's length as a single byte and the group ID.
+    // No UTF-8 text starts with this byte, datagrams without a channel header are forwarded to the default group. A header with an empty group ID
+    // also names the default group, so a default group payload that starts with this byte is sent behind one
+    const unsigned char UDP_CHANNEL_MARKER = 0xFF;
+    const size_t UDP_CHANNEL_MAX_GROUP_ID_SIZE = 255;
+
+    struct UDPChannel
+    {
+        std::string_view groupId;
+        // The amount of bytes the channel header takes up at the start of the datagram, 0 if it has none
+        size_t headerSize = 0;
+    };
+
+    std::optional<UDPChannel> parseUDPChannel(const char*, const size_t);
+    std::string encodeUDPChannelHeader(const std::string&);
+}
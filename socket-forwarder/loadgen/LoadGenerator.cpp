@@ -0,0 +1,361 @@
+#include "LoadGenerator.h"
+
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <cerrno>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <socketexceptions/SocketException.hpp>
+
+#include "../logging/Logger.h"
+#include "../sockets/Sockets.h"
+
+namespace forwarder
+{
+    static void writeLittleEndian(char* data, const uint64_t value, const size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    static uint64_t readLittleEndian(const char* data, const size_t size)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    /**
+     * Writes the header to the start of the provided payload, which must be at least LOAD_PAYLOAD_HEADER_SIZE bytes. The rest of the payload is left as it is.
+     */
+    void encodeLoadPayload(char* data, const size_t size, const LoadPayloadHeader& header)
+    {
+        if (size < LOAD_PAYLOAD_HEADER_SIZE)
+        {
+            return;
+        }
+        writeLittleEndian(data, LOAD_PAYLOAD_MAGIC, 4);
+        writeLittleEndian(data + 4, header.publisherId, 4);
+        writeLittleEndian(data + 8, header.sequence, 8);
+        writeLittleEndian(data + 16, header.sentAtNanoseconds, 8);
+    }
+
+    /**
+     * Reads the header from the start of the provided payload, returns an empty optional if the payload was not written by encodeLoadPayload().
+     */
+    std::optional<LoadPayloadHeader> decodeLoadPayload(const char* data, const size_t size)
+    {
+        if (size < LOAD_PAYLOAD_HEADER_SIZE || readLittleEndian(data, 4) != LOAD_PAYLOAD_MAGIC)
+        {
+            return std::nullopt;
+        }
+        LoadPayloadHeader header;
+        header.publisherId = static_cast<uint32_t>(readLittleEndian(data + 4, 4));
+        header.sequence = readLittleEndian(data + 8, 8);
+        header.sentAtNanoseconds = readLittleEndian(data + 16, 8);
+        return std::make_optional(header);
+    }
+
+    /**
+     * Records that the message with the provided sequence number was received, returns true if it arrived after a message with a higher sequence number.
+     * Messages that never arrive are not reordered, they are counted as lost once the run ends.
+     */
+    bool SequenceTracker::record(const uint64_t sequence)
+    {
+        if (sequence < nextExpected)
+        {
+            return true;
+        }
+        nextExpected = sequence + 1;
+        return false;
+    }
+
+    uint64_t LoadReport::getLost() const
+    {
+        return expected > received ? expected - received : 0;
+    }
+
+    double LoadReport::getSendRate() const
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0 ? static_cast<double>(sent) / seconds : 0;
+    }
+
+    LoadGenerator::LoadGenerator(const LoadGeneratorConfig& loadGeneratorConfig) : config(loadGeneratorConfig) {}
+
+    /**
+     * Connects and joins every client, publishes for the configured duration and waits for the remaining messages to arrive.
+     * Returns false if the clients could not connect to the forwarder, otherwise the provided reports hold the results of each protocol.
+     */
+    bool LoadGenerator::run(LoadReport& tcpReport, LoadReport& udpReport)
+    {
+        if (config.messageSize < LOAD_PAYLOAD_HEADER_SIZE || config.rate <= 0)
+        {
+            logWarning("Message size must be at least [", LOAD_PAYLOAD_HEADER_SIZE, "] bytes and the rate must be above 0.");
+            return false;
+        }
+
+        std::vector<kt::TCPSocket> tcpClients;
+        std::vector<int> tcpPublishers;
+        std::vector<kt::UDPSocket> udpPeers;
+        std::vector<Receiver> receivers;
+        int udpPublisher = -1;
+        sockaddr_in udpForwarderAddress{};
+
+        auto closeClients = [&]()
+        {
+            for (kt::TCPSocket& client : tcpClients)
+            {
+                client.close();
+            }
+            for (kt::UDPSocket& peer : udpPeers)
+            {
+                peer.close();
+            }
+            if (udpPublisher != -1)
+            {
+                close(udpPublisher);
+            }
+        };
+
+        if (config.tcpPort.has_value())
+        {
+            try
+            {
+                for (size_t group = 0; group < config.tcpGroups; group++)
+                {
+                    const std::string groupId = "loadgenerator-" + std::to_string(group);
+                    for (size_t i = 0; i < config.tcpClientsPerGroup; i++)
+                    {
+                        tcpClients.emplace_back(config.hostAddress, *config.tcpPort);
+                        kt::TCPSocket& client = tcpClients.back();
+                        setNoDelay(client.getSocket());
+                        client.send(config.newClientPrefix + groupId);
+                        if (i == 0)
+                        {
+                            tcpPublishers.push_back(client.getSocket());
+                        }
+                        else
+                        {
+                            setNonBlocking(client.getSocket());
+                            receivers.push_back({ client.getSocket(), true, SequenceTracker(), std::vector<char>(config.messageSize), 0 });
+                        }
+                    }
+                }
+            }
+            catch (const kt::SocketException& e)
+            {
+                logWarning("[TCP] - Failed to connect client [", tcpClients.size(), "] to [", config.hostAddress, ":", *config.tcpPort, "]. ", e.what());
+                closeClients();
+                return false;
+            }
+            logInfo("[TCP] - Joined [", tcpClients.size(), "] clients to [", config.tcpGroups, "] groups.");
+        }
+
+        if (config.udpPort.has_value())
+        {
+            udpForwarderAddress.sin_family = AF_INET;
+            udpForwarderAddress.sin_port = htons(*config.udpPort);
+            udpPublisher = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            if (inet_pton(AF_INET, config.hostAddress.c_str(), &udpForwarderAddress.sin_addr) != 1 || udpPublisher == -1)
+            {
+                logWarning("[UDP] - Unable to send to address [", config.hostAddress, "], an IPv4 address is required.");
+                closeClients();
+                return false;
+            }
+
+            for (size_t i = 0; i < config.udpPeers; i++)
+            {
+                udpPeers.emplace_back();
+                kt::UDPSocket& peer = udpPeers.back();
+                if (!peer.bind().first)
+                {
+                    logWarning("[UDP] - Failed to bind peer [", i, "].");
+                    closeClients();
+                    return false;
+                }
+                // Sent from the peer's own socket, so the forwarder sees the peer's address
+                const std::string join = config.newClientPrefix + std::to_string(peer.getListeningPort().value());
+                sendto(peer.getListeningSocket(), join.data(), join.size(), 0, reinterpret_cast<const sockaddr*>(&udpForwarderAddress), sizeof(udpForwarderAddress));
+                setNonBlocking(peer.getListeningSocket());
+                receivers.push_back({ peer.getListeningSocket(), false, SequenceTracker(), std::vector<char>(), 0 });
+            }
+            logInfo("[UDP] - Joined [", udpPeers.size(), "] peers.");
+        }
+
+        std::this_thread::sleep_for(config.joinWait);
+
+        receiving = true;
+        std::thread receiverThread(&LoadGenerator::receive, this, std::ref(receivers), std::ref(tcpReport), std::ref(udpReport));
+
+        std::vector<char> payload(config.messageSize, 'x');
+        std::vector<uint64_t> tcpSent(tcpPublishers.size(), 0);
+        uint64_t udpSent = 0;
+        const std::chrono::steady_clock::duration interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / config.rate));
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const std::chrono::steady_clock::time_point end = start + config.duration;
+        uint64_t sequence = 0;
+        // Messages are sent on a fixed schedule, a publisher that falls behind sends the missed messages straight away to catch up
+        for (std::chrono::steady_clock::time_point scheduled = start; scheduled < end; scheduled += interval, sequence++)
+        {
+            std::this_thread::sleep_until(scheduled);
+            const uint64_t sentAt = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(scheduled.time_since_epoch()).count());
+
+            for (size_t i = 0; i < tcpPublishers.size(); i++)
+            {
+                if (tcpPublishers[i] == -1)
+                {
+                    continue;
+                }
+                encodeLoadPayload(payload.data(), payload.size(), { static_cast<uint32_t>(i), sequence, sentAt });
+                size_t written = 0;
+                while (written < payload.size())
+                {
+                    ssize_t result = send(tcpPublishers[i], payload.data() + written, payload.size() - written, MSG_NOSIGNAL);
+                    if (result <= 0 && errno != EINTR)
+                    {
+                        logWarning("[TCP] - Publisher for group [loadgenerator-", i, "] failed to send, it will stop publishing.");
+                        tcpPublishers[i] = -1;
+                        break;
+                    }
+                    written += result > 0 ? static_cast<size_t>(result) : 0;
+                }
+                tcpSent[i] += written == payload.size() ? 1 : 0;
+            }
+
+            if (udpPublisher != -1)
+            {
+                encodeLoadPayload(payload.data(), payload.size(), { 0, sequence, sentAt });
+                if (sendto(udpPublisher, payload.data(), payload.size(), 0, reinterpret_cast<const sockaddr*>(&udpForwarderAddress), sizeof(udpForwarderAddress)) == static_cast<ssize_t>(payload.size()))
+                {
+                    udpSent++;
+                }
+            }
+        }
+        const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+
+        std::this_thread::sleep_for(config.drain);
+        receiving = false;
+        receiverThread.join();
+        closeClients();
+
+        for (const uint64_t sent : tcpSent)
+        {
+            tcpReport.sent += sent;
+            tcpReport.expected += sent * (config.tcpClientsPerGroup - 1);
+        }
+        tcpReport.elapsed = elapsed;
+        tcpReport.latency = tcpLatency.snapshot();
+        udpReport.sent = udpSent;
+        udpReport.expected = udpSent * udpPeers.size();
+        udpReport.elapsed = elapsed;
+        udpReport.latency = udpLatency.snapshot();
+        return true;
+    }
+
+    /**
+     * Reads from every receiver until the run stops, counting and timing each message that arrives.
+     */
+    void LoadGenerator::receive(std::vector<Receiver>& receivers, LoadReport& tcpReport, LoadReport& udpReport)
+    {
+        const int epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+        for (size_t i = 0; i < receivers.size(); i++)
+        {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, receivers[i].descriptor, &event);
+        }
+
+        const size_t maxEvents = 64;
+        epoll_event events[maxEvents];
+        std::vector<char> buffer(std::max<size_t>(65536, config.messageSize));
+        while (receiving)
+        {
+            const int eventCount = epoll_wait(epollDescriptor, events, maxEvents, 100);
+            for (int i = 0; i < eventCount; i++)
+            {
+                Receiver& receiver = receivers[events[i].data.u64];
+                LoadReport& report = receiver.tcp ? tcpReport : udpReport;
+                ssize_t readAmount;
+                while ((readAmount = recv(receiver.descriptor, buffer.data(), buffer.size(), 0)) > 0)
+                {
+                    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    const size_t amount = static_cast<size_t>(readAmount);
+                    if (!receiver.tcp)
+                    {
+                        if (amount == config.messageSize)
+                        {
+                            receiveMessage(receiver, buffer.data(), report, now);
+                        }
+                        else
+                        {
+                            report.malformed++;
+                        }
+                        continue;
+                    }
+
+                    // Complete the message started by an earlier read, then take every whole message straight from the buffer
+                    size_t offset = 0;
+                    if (receiver.partialSize > 0)
+                    {
+                        const size_t copied = std::min(amount, config.messageSize - receiver.partialSize);
+                        std::copy(buffer.data(), buffer.data() + copied, receiver.partial.data() + receiver.partialSize);
+                        receiver.partialSize += copied;
+                        offset = copied;
+                        if (receiver.partialSize == config.messageSize)
+                        {
+                            receiveMessage(receiver, receiver.partial.data(), report, now);
+                            receiver.partialSize = 0;
+                        }
+                    }
+                    for (; offset + config.messageSize <= amount; offset += config.messageSize)
+                    {
+                        receiveMessage(receiver, buffer.data() + offset, report, now);
+                    }
+                    if (offset < amount)
+                    {
+                        std::copy(buffer.data() + offset, buffer.data() + amount, receiver.partial.data());
+                        receiver.partialSize = amount - offset;
+                    }
+                }
+
+                if (readAmount == 0)
+                {
+                    logWarning("[TCP] - Receiver [", receiver.descriptor, "] was disconnected by the forwarder.");
+                    epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, receiver.descriptor, nullptr);
+                }
+            }
+        }
+        close(epollDescriptor);
+    }
+
+    void LoadGenerator::receiveMessage(Receiver& receiver, const char* data, LoadReport& report, const std::chrono::steady_clock::time_point now)
+    {
+        std::optional<LoadPayloadHeader> header = decodeLoadPayload(data, config.messageSize);
+        if (!header.has_value())
+        {
+            report.malformed++;
+            return;
+        }
+
+        report.received++;
+        if (receiver.sequences.record(header->sequence))
+        {
+            report.reordered++;
+        }
+        const std::chrono::steady_clock::time_point sentAt(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(header->sentAtNanoseconds)));
+        (receiver.tcp ? tcpLatency : udpLatency).record(now - sentAt);
+    }
+}
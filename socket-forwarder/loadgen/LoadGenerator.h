@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+#include "../environment/Environment.h"
+#include "../metrics/Histogram.h"
+
+namespace forwarder
+{
+    const uint32_t LOAD_PAYLOAD_MAGIC = 0x53464c47;
+    // The magic, the publisher ID, the sequence number and the send time, every payload is at least this large
+    const size_t LOAD_PAYLOAD_HEADER_SIZE = 24;
+
+    /**
+     * The header at the start of every message the load generator publishes, written in little endian byte order.
+     * The send time is the time the message was scheduled to be sent on the steady clock, so a publisher that falls behind its rate
+     * shows up as latency rather than hiding it.
+     */
+    struct LoadPayloadHeader
+    {
+        uint32_t publisherId = 0;
+        uint64_t sequence = 0;
+        uint64_t sentAtNanoseconds = 0;
+    };
+
+    void encodeLoadPayload(char*, const size_t, const LoadPayloadHeader&);
+    std::optional<LoadPayloadHeader> decodeLoadPayload(const char*, const size_t);
+
+    /**
+     * Follows the sequence numbers of a single publisher's messages at a single receiver.
+     * A message with a lower sequence number than one already received arrived out of order.
+     */
+    class SequenceTracker
+    {
+    protected:
+        uint64_t nextExpected = 0;
+
+    public:
+        bool record(const uint64_t);
+    };
+
+    struct LoadGeneratorConfig
+    {
+        std::string hostAddress = LOAD_GENERATOR_HOST_ADDRESS_DEFAULT;
+        std::string newClientPrefix = NEW_CLIENT_PREFIX_DEFAULT;
+        std::optional<unsigned short> tcpPort = std::nullopt;
+        std::optional<unsigned short> udpPort = std::nullopt;
+        // Each TCP group has a single publisher and clientsPerGroup - 1 receivers
+        size_t tcpGroups = LOAD_GENERATOR_TCP_GROUPS_DEFAULT;
+        size_t tcpClientsPerGroup = LOAD_GENERATOR_TCP_CLIENTS_PER_GROUP_DEFAULT;
+        size_t udpPeers = LOAD_GENERATOR_UDP_PEERS_DEFAULT;
+        // Messages per second sent by each publisher
+        double rate = LOAD_GENERATOR_RATE_DEFAULT;
+        size_t messageSize = LOAD_GENERATOR_MESSAGE_SIZE_DEFAULT;
+        std::chrono::milliseconds duration = std::chrono::milliseconds(LOAD_GENERATOR_DURATION_MS_DEFAULT);
+        // How long to wait for the forwarder to add every client to its group before publishing
+        std::chrono::milliseconds joinWait = std::chrono::milliseconds(LOAD_GENERATOR_JOIN_WAIT_MS_DEFAULT);
+        // How long to keep receiving once publishing stops, messages that have not arrived by then are counted as lost
+        std::chrono::milliseconds drain = std::chrono::milliseconds(LOAD_GENERATOR_DRAIN_MS_DEFAULT);
+    };
+
+    /**
+     * The result of a load generator run for a single protocol.
+     */
+    struct LoadReport
+    {
+        uint64_t sent = 0;
+        // The amount of messages the receivers should have received, each published message is expected once at every receiver
+        uint64_t expected = 0;
+        uint64_t received = 0;
+        uint64_t reordered = 0;
+        uint64_t malformed = 0;
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+        HistogramSnapshot latency;
+
+        uint64_t getLost() const;
+        double getSendRate() const;
+    };
+
+    /**
+     * Publishes messages through a running forwarder over loopback at a fixed rate and measures how they arrive at the receivers.
+     * TCP clients join their groups with the new client prefix and UDP peers join with the new client prefix followed by their port,
+     * the same way as any other client of the forwarder.
+     */
+    class LoadGenerator
+    {
+    protected:
+        struct Receiver
+        {
+            int descriptor;
+            bool tcp;
+            SequenceTracker sequences;
+            // TCP is a stream, so a message can arrive over several reads
+            std::vector<char> partial;
+            size_t partialSize = 0;
+        };
+
+        LoadGeneratorConfig config;
+        std::atomic<bool> receiving{ false };
+        LatencyHistogram tcpLatency;
+        LatencyHistogram udpLatency;
+
+        void receive(std::vector<Receiver>&, LoadReport&, LoadReport&);
+        void receiveMessage(Receiver&, const char*, LoadReport&, const std::chrono::steady_clock::time_point);
+
+    public:
+        LoadGenerator(const LoadGeneratorConfig&);
+
+        bool run(LoadReport&, LoadReport&);
+    };
+}
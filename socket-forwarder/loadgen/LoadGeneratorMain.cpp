@@ -0,0 +1,83 @@
+#include <optional>
+#include <cstdlib>
+#include <string>
+
+#include "../environment/Environment.h"
+#include "../logging/Logger.h"
+#include "LoadGenerator.h"
+
+static std::optional<unsigned short> getPort(const std::string& variable, const int argc, char** argv, const int argument)
+{
+    std::optional<std::string> port = forwarder::getEnvironmentVariableValue(variable);
+    if (!port.has_value() && argc > argument)
+    {
+        port = std::string(argv[argument]);
+    }
+    return port.has_value() ? std::make_optional(static_cast<unsigned short>(std::atoi(port->c_str()))) : std::nullopt;
+}
+
+static void logReport(const std::string& protocol, const forwarder::LoadReport& report)
+{
+    forwarder::logInfo(protocol, " - Sent [", report.sent, "] messages at [", static_cast<uint64_t>(report.getSendRate()), "] per second. Received [", report.received, "] of [",
+        report.expected, "] expected, lost [", report.getLost(), "], reordered [", report.reordered, "], malformed [", report.malformed, "].");
+    forwarder::logInfo(protocol, " - Latency p50 [", report.latency.valueAtPercentile(50.0) / 1000, "us], p99 [", report.latency.valueAtPercentile(99.0) / 1000,
+        "us], p999 [", report.latency.valueAtPercentile(99.9) / 1000, "us], max [", report.latency.max / 1000, "us].");
+}
+
+/**
+ * Publishes messages through a forwarder listening on the provided TCP and UDP ports and reports how they arrive.
+ * Exits with 1 if the clients could not connect and 2 if any message was lost or malformed.
+ */
+int main(int argc, char** argv)
+{
+    forwarder::LoadGeneratorConfig config;
+    config.hostAddress = forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_HOST_ADDRESS, forwarder::LOAD_GENERATOR_HOST_ADDRESS_DEFAULT);
+    config.newClientPrefix = forwarder::getEnvironmentVariableValueOrDefault(forwarder::NEW_CLIENT_PREFIX, forwarder::NEW_CLIENT_PREFIX_DEFAULT);
+    config.tcpPort = getPort(forwarder::LOAD_GENERATOR_TCP_PORT, argc, argv, 1);
+    config.udpPort = getPort(forwarder::LOAD_GENERATOR_UDP_PORT, argc, argv, 2);
+    config.tcpGroups = std::atoll(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_TCP_GROUPS, std::to_string(forwarder::LOAD_GENERATOR_TCP_GROUPS_DEFAULT)).c_str());
+    config.tcpClientsPerGroup = std::atoll(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_TCP_CLIENTS_PER_GROUP, std::to_string(forwarder::LOAD_GENERATOR_TCP_CLIENTS_PER_GROUP_DEFAULT)).c_str());
+    config.udpPeers = std::atoll(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_UDP_PEERS, std::to_string(forwarder::LOAD_GENERATOR_UDP_PEERS_DEFAULT)).c_str());
+    config.rate = std::atof(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_RATE, std::to_string(forwarder::LOAD_GENERATOR_RATE_DEFAULT)).c_str());
+    config.messageSize = std::atoll(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_MESSAGE_SIZE, std::to_string(forwarder::LOAD_GENERATOR_MESSAGE_SIZE_DEFAULT)).c_str());
+    config.duration = std::chrono::milliseconds(std::atol(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_DURATION_MS, std::to_string(forwarder::LOAD_GENERATOR_DURATION_MS_DEFAULT)).c_str()));
+    config.joinWait = std::chrono::milliseconds(std::atol(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_JOIN_WAIT_MS, std::to_string(forwarder::LOAD_GENERATOR_JOIN_WAIT_MS_DEFAULT)).c_str()));
+    config.drain = std::chrono::milliseconds(std::atol(forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOAD_GENERATOR_DRAIN_MS, std::to_string(forwarder::LOAD_GENERATOR_DRAIN_MS_DEFAULT)).c_str()));
+
+    if (!config.tcpPort.has_value() && !config.udpPort.has_value())
+    {
+        forwarder::logWarning("No TCP or UDP port was provided, nothing to generate load for.");
+        forwarder::getLogger().flush();
+        return 1;
+    }
+
+    forwarder::logInfo("Generating load against [", config.hostAddress, "] for [", config.duration.count(), "ms] at [", config.rate, "] messages per second per publisher of [", config.messageSize, "] bytes.");
+    if (config.tcpPort.has_value())
+    {
+        forwarder::logInfo("[TCP] - Using port [", *config.tcpPort, "] with [", config.tcpGroups, "] groups of [", config.tcpClientsPerGroup, "] clients, each with a single publisher.");
+    }
+    if (config.udpPort.has_value())
+    {
+        forwarder::logInfo("[UDP] - Using port [", *config.udpPort, "] with [", config.udpPeers, "] peers and a single publisher.");
+    }
+
+    forwarder::LoadGenerator generator(config);
+    forwarder::LoadReport tcpReport;
+    forwarder::LoadReport udpReport;
+    if (!generator.run(tcpReport, udpReport))
+    {
+        forwarder::getLogger().flush();
+        return 1;
+    }
+
+    if (config.tcpPort.has_value())
+    {
+        logReport("[TCP]", tcpReport);
+    }
+    if (config.udpPort.has_value())
+    {
+        logReport("[UDP]", udpReport);
+    }
+    forwarder::getLogger().flush();
+    return tcpReport.getLost() > 0 || udpReport.getLost() > 0 || tcpReport.malformed > 0 || udpReport.malformed > 0 ? 2 : 0;
+}
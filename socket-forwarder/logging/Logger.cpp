@@ -0,0 +1,277 @@
+#include "Logger.h"
+
+#include <iostream>
+#include <ctime>
+#include <cstdio>
+#include <time.h>
+
+namespace forwarder
+{
+    static std::atomic<uint64_t> nextLoggerId{ 1 };
+
+    thread_local Logger::Producer Logger::producer;
+
+    std::optional<LogLevel> parseLogLevel(const std::string& level)
+    {
+        if (level == "debug")
+        {
+            return LogLevel::Debug;
+        }
+        else if (level == "info")
+        {
+            return LogLevel::Info;
+        }
+        else if (level == "warning")
+        {
+            return LogLevel::Warning;
+        }
+        else if (level == "error")
+        {
+            return LogLevel::Error;
+        }
+        return std::nullopt;
+    }
+
+    std::string logLevelToString(const LogLevel level)
+    {
+        switch (level)
+        {
+            case LogLevel::Debug:
+                return "debug";
+            case LogLevel::Info:
+                return "info";
+            case LogLevel::Warning:
+                return "warning";
+            case LogLevel::Error:
+                return "error";
+        }
+        return "unknown";
+    }
+
+    LogRing::LogRing() : records(std::make_unique<LogRecord[]>(LOG_RING_CAPACITY)) {}
+
+    /**
+     * Returns the number of records dropped because the ring was full since this was last called.
+     */
+    uint64_t LogRing::takeDropped()
+    {
+        return dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Marks the ring as no longer used by its thread, so the writing thread releases it once its remaining records are written.
+     */
+    void LogRing::abandon()
+    {
+        abandoned.store(true, std::memory_order_release);
+    }
+
+    bool LogRing::isAbandoned() const
+    {
+        return abandoned.load(std::memory_order_acquire);
+    }
+
+    LogRateLimiter::LogRateLimiter(const std::chrono::milliseconds limit) : interval(limit) {}
+
+    /**
+     * Returns true if the message may be logged now, in which case the amount of messages suppressed since the last allowed message is
+     * written to the provided count.
+     */
+    bool LogRateLimiter::allow(uint64_t& suppressedCount)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now < nextAllowed)
+        {
+            suppressed++;
+            return false;
+        }
+        nextAllowed = now + interval;
+        suppressedCount = suppressed;
+        suppressed = 0;
+        return true;
+    }
+
+    Logger::Producer::~Producer()
+    {
+        if (ring != nullptr)
+        {
+            ring->abandon();
+        }
+    }
+
+    Logger::Logger(std::ostream& stream) : id(nextLoggerId.fetch_add(1, std::memory_order_relaxed)), output(&stream)
+    {
+        writer = std::thread(&Logger::run, this);
+    }
+
+    /**
+     * Stops the writing thread once it has written every record logged so far.
+     */
+    Logger::~Logger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wakeCondition.notify_all();
+        writer.join();
+    }
+
+    void Logger::setLevel(const LogLevel newLevel)
+    {
+        level.store(newLevel, std::memory_order_relaxed);
+    }
+
+    LogLevel Logger::getLevel() const
+    {
+        return level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Writes every record logged so far to the current output, then switches to the provided output.
+     */
+    void Logger::setOutput(std::ostream& stream)
+    {
+        flush();
+        std::lock_guard<std::mutex> lock(mutex);
+        output = &stream;
+    }
+
+    /**
+     * Returns the calling thread's ring, creating and registering it the first time the thread logs to this logger.
+     */
+    LogRing& Logger::threadRing()
+    {
+        Producer& current = producer;
+        if (current.loggerId != id)
+        {
+            if (current.ring != nullptr)
+            {
+                current.ring->abandon();
+            }
+            current.ring = std::make_shared<LogRing>();
+            current.loggerId = id;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            rings.push_back(current.ring);
+        }
+        return *current.ring;
+    }
+
+    /**
+     * Returns the wall clock time in nanoseconds from the coarse clock, which is only accurate to the kernel tick (a few milliseconds) but is
+     * a fraction of the cost of the precise clock, which would otherwise be half of the cost of a log call.
+     */
+    uint64_t Logger::coarseTimestamp()
+    {
+        timespec now{};
+        clock_gettime(CLOCK_REALTIME_COARSE, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+    }
+
+    /**
+     * Blocks until every record logged before the call has been written.
+     */
+    void Logger::flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const uint64_t target = ++flushRequested;
+        wakeCondition.notify_all();
+        flushedCondition.wait(lock, [&]() { return flushCompleted >= target || !running; });
+    }
+
+    void Logger::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running)
+        {
+            const uint64_t requested = flushRequested;
+            drain();
+            flushCompleted = requested;
+            flushedCondition.notify_all();
+            wakeCondition.wait_for(lock, LOG_DRAIN_INTERVAL, [&]() { return !running || flushRequested != flushCompleted; });
+        }
+
+        drain();
+        flushCompleted = flushRequested;
+        flushedCondition.notify_all();
+    }
+
+    /**
+     * Writes the records of every ring as a single batch. Called by the writing thread with the mutex held.
+     */
+    void Logger::drain()
+    {
+        for (size_t i = 0; i < rings.size();)
+        {
+            LogRing& ring = *rings[i];
+            // Checked before draining so that any record the thread published before it exited is still written
+            const bool abandoned = ring.isAbandoned();
+            ring.drain([this](const LogRecord& record) { format(record); });
+
+            const uint64_t dropped = ring.takeDropped();
+            if (dropped > 0)
+            {
+                LogRecord record;
+                record.timestampNanos = coarseTimestamp();
+                record.level = LogLevel::Warning;
+                RecordWriter writer(record);
+                append(writer, "[LOG] - Dropped [");
+                append(writer, std::to_string(dropped));
+                append(writer, "] log message(s), the logging thread produced them faster than they could be written.");
+                writer.finish(record);
+                format(record);
+            }
+
+            if (abandoned)
+            {
+                rings[i] = rings.back();
+                rings.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        if (!batch.empty())
+        {
+            output->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            output->flush();
+            batch.clear();
+        }
+    }
+
+    /**
+     * Appends the record to the batch as "<UTC timestamp> <LEVEL> <message>".
+     */
+    void Logger::format(const LogRecord& record)
+    {
+        const time_t seconds = static_cast<time_t>(record.timestampNanos / 1000000000);
+        const unsigned long millis = static_cast<unsigned long>((record.timestampNanos % 1000000000) / 1000000);
+        tm utc{};
+        gmtime_r(&seconds, &utc);
+
+        char prefix[64];
+        size_t length = std::strftime(prefix, sizeof(prefix), "%Y-%m-%dT%H:%M:%S", &utc);
+        static const char* levelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+        length += static_cast<size_t>(std::snprintf(prefix + length, sizeof(prefix) - length, ".%03luZ %-5s ", millis, levelNames[static_cast<size_t>(record.level)]));
+
+        batch.append(prefix, length);
+        batch.append(record.text, record.length);
+        if (record.truncated)
+        {
+            batch.append("...");
+        }
+        batch.push_back('\n');
+    }
+
+    /**
+     * Returns the process wide logger, which writes to stdout.
+     */
+    Logger& getLogger()
+    {
+        static Logger logger(std::cout);
+        return logger;
+    }
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <ostream>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace forwarder
+{
+    const size_t LOG_RECORD_TEXT_SIZE = 480;
+    const size_t LOG_RING_CAPACITY = 512;
+    const std::chrono::milliseconds LOG_DRAIN_INTERVAL = std::chrono::milliseconds(5);
+
+    enum class LogLevel : uint8_t
+    {
+        Debug,
+        Info,
+        Warning,
+        Error
+    };
+
+    std::optional<LogLevel> parseLogLevel(const std::string&);
+    std::string logLevelToString(const LogLevel);
+
+    /**
+     * A log message formatted by the thread that logged it. Text that does not fit is cut off and the record is marked as truncated.
+     */
+    struct LogRecord
+    {
+        uint64_t timestampNanos;
+        LogLevel level;
+        bool truncated;
+        uint16_t length;
+        char text[LOG_RECORD_TEXT_SIZE];
+    };
+
+    /**
+     * A fixed size queue of records from a single logging thread to the logger's writing thread.
+     * The logging thread never waits, when the ring is full the record is dropped and counted instead.
+     */
+    class LogRing
+    {
+    protected:
+        std::unique_ptr<LogRecord[]> records;
+        // Only written by the logging thread
+        alignas(64) std::atomic<uint64_t> head{ 0 };
+        uint64_t cachedTail = 0;
+        // Only written by the writing thread
+        alignas(64) std::atomic<uint64_t> tail{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<bool> abandoned{ false };
+
+    public:
+        LogRing();
+
+        inline LogRecord* claim()
+        {
+            const uint64_t position = head.load(std::memory_order_relaxed);
+            if (position - cachedTail >= LOG_RING_CAPACITY)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (position - cachedTail >= LOG_RING_CAPACITY)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+            }
+            return &records[position % LOG_RING_CAPACITY];
+        }
+
+        inline void publish()
+        {
+            head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * Passes every published record to the provided function, oldest first, then frees their slots. Only called by the writing thread.
+         */
+        template <typename Consumer>
+        size_t drain(Consumer&& consume)
+        {
+            const uint64_t begin = tail.load(std::memory_order_relaxed);
+            const uint64_t end = head.load(std::memory_order_acquire);
+            for (uint64_t position = begin; position < end; position++)
+            {
+                consume(records[position % LOG_RING_CAPACITY]);
+            }
+            tail.store(end, std::memory_order_release);
+            return static_cast<size_t>(end - begin);
+        }
+
+        uint64_t takeDropped();
+        void abandon();
+        bool isAbandoned() const;
+    };
+
+    /**
+     * Limits how often a repeated message is logged, allowing one message per interval and counting the ones suppressed in between.
+     * Not thread safe, each thread logging the message should use its own limiter.
+     */
+    class LogRateLimiter
+    {
+    protected:
+        std::chrono::steady_clock::duration interval;
+        std::chrono::steady_clock::time_point nextAllowed{};
+        uint64_t suppressed = 0;
+
+    public:
+        LogRateLimiter(const std::chrono::milliseconds = std::chrono::milliseconds(1000));
+
+        bool allow(uint64_t&);
+    };
+
+    /**
+     * Writes log messages from a background thread so that logging never blocks the forwarding threads on the output.
+     *
+     * Each logging thread formats its message straight into a record in its own LogRing, converting numbers with std::to_chars and copying
+     * strings without allocating, and the writing thread drains every ring, formats the timestamp and level and writes the records in batches.
+     * A thread keeps a single ring, for the logger it most recently logged to, which is released once the thread exits.
+     */
+    class Logger
+    {
+    protected:
+        struct Producer
+        {
+            uint64_t loggerId = 0;
+            std::shared_ptr<LogRing> ring;
+
+            ~Producer();
+        };
+
+        static thread_local Producer producer;
+
+        const uint64_t id;
+        std::atomic<LogLevel> level{ LogLevel::Info };
+
+        std::mutex mutex;
+        std::condition_variable wakeCondition;
+        std::condition_variable flushedCondition;
+        std::vector<std::shared_ptr<LogRing>> rings;
+        std::ostream* output;
+        std::string batch;
+        uint64_t flushRequested = 0;
+        uint64_t flushCompleted = 0;
+        bool running = true;
+        std::thread writer;
+
+        LogRing& threadRing();
+        static uint64_t coarseTimestamp();
+        void run();
+        void drain();
+        void format(const LogRecord&);
+
+        /**
+         * Appends to a record through a local cursor, so the compiler can keep it in a register instead of updating the record per argument.
+         */
+        struct RecordWriter
+        {
+            char* cursor;
+            char* end;
+            bool truncated = false;
+
+            explicit RecordWriter(LogRecord& record) : cursor(record.text), end(record.text + LOG_RECORD_TEXT_SIZE) {}
+
+            void finish(LogRecord& record) const
+            {
+                record.length = static_cast<uint16_t>(cursor - record.text);
+                record.truncated = truncated;
+            }
+        };
+
+        static void append(RecordWriter& writer, const char* value, const size_t length)
+        {
+            // Kept as two branches rather than copying the smaller of the two lengths, since a copy whose size the compiler knows is bounded
+            // by the record size is inlined as a "rep movs", which costs more than the rest of a log call
+            const size_t available = static_cast<size_t>(writer.end - writer.cursor);
+            if (length <= available)
+            {
+                std::memcpy(writer.cursor, value, length);
+                writer.cursor += length;
+            }
+            else
+            {
+                std::memcpy(writer.cursor, value, available);
+                writer.cursor += available;
+                writer.truncated = true;
+            }
+        }
+
+        template <typename T>
+        static void append(RecordWriter& writer, const T& value)
+        {
+            using Type = std::decay_t<T>;
+            if constexpr (std::is_same_v<Type, bool>)
+            {
+                append(writer, value ? "1" : "0", 1);
+            }
+            else if constexpr (std::is_same_v<Type, char>)
+            {
+                append(writer, &value, 1);
+            }
+            else if constexpr (std::is_arithmetic_v<Type>)
+            {
+                char digits[32];
+                std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+                append(writer, digits, static_cast<size_t>(result.ptr - digits));
+            }
+            else
+            {
+                std::string_view view(value);
+                append(writer, view.data(), view.size());
+            }
+        }
+
+    public:
+        Logger(std::ostream&);
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        void setLevel(const LogLevel);
+        LogLevel getLevel() const;
+        void setOutput(std::ostream&);
+
+        inline bool isEnabled(const LogLevel messageLevel) const
+        {
+            return messageLevel >= level.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Formats the arguments, in order, into a single message. Strings are copied as is and numbers are written in decimal.
+         */
+        template <typename... Args>
+        void log(const LogLevel messageLevel, const Args&... args)
+        {
+            if (!isEnabled(messageLevel))
+            {
+                return;
+            }
+
+            LogRing& ring = threadRing();
+            LogRecord* record = ring.claim();
+            if (record == nullptr)
+            {
+                return;
+            }
+            record->timestampNanos = coarseTimestamp();
+            record->level = messageLevel;
+            RecordWriter writer(*record);
+            (append(writer, args), ...);
+            writer.finish(*record);
+            ring.publish();
+        }
+
+        /**
+         * Logs the message unless the limiter has suppressed it, noting how many messages were suppressed since the last one was logged.
+         */
+        template <typename... Args>
+        void log(LogRateLimiter& limiter, const LogLevel messageLevel, const Args&... args)
+        {
+            uint64_t suppressed = 0;
+            if (!isEnabled(messageLevel) || !limiter.allow(suppressed))
+            {
+                return;
+            }
+            if (suppressed > 0)
+            {
+                log(messageLevel, args..., " [", suppressed, "] similar message(s) suppressed.");
+            }
+            else
+            {
+                log(messageLevel, args...);
+            }
+        }
+
+        void flush();
+    };
+
+    Logger& getLogger();
+
+    template <typename... Args>
+    void logDebug(const Args&... args)
+    {
+        getLogger().log(LogLevel::Debug, args...);
+    }
+
+    template <typename... Args>
+    void logInfo(const Args&... args)
+    {
+        getLogger().log(LogLevel::Info, args...);
+    }
+
+    template <typename... Args>
+    void logWarning(const Args&... args)
+    {
+        getLogger().log(LogLevel::Warning, args...);
+    }
+
+    template <typename... Args>
+    void logError(const Args&... args)
+    {
+        getLogger().log(LogLevel::Error, args...);
+    }
+}
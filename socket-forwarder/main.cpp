@@ -4,46 +4,256 @@
 #include <string>
 #include <thread>
 #include <algorithm>
+#include <chrono>
+#include <csignal>
+
+#include <pthread.h>
 
 #include "sockets/Sockets.h"
 #include "environment/Environment.h"
 #include "forwarder/Forwarder.h"
+#include "framing/Framing.h"
+#include "logging/Logger.h"
+#include "metrics/MetricsServer.h"
 
 // Make sure version of built image matches
 const std::string VERSION = "0.3.0";
 
 int main(int argc, char** argv)
 {
-    std::cout << "Running SocketForwarder v" << VERSION << std::endl;
+    // Blocked before any thread is started, including the logger's, so every thread inherits the mask and only the dumping thread receives it
+    sigset_t traceDumpSignals;
+    sigemptyset(&traceDumpSignals);
+    sigaddset(&traceDumpSignals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &traceDumpSignals, nullptr);
+
+    forwarder::logInfo("Running SocketForwarder v", VERSION);
 
     const std::string newClientPrefix = forwarder::getEnvironmentVariableValueOrDefault(forwarder::NEW_CLIENT_PREFIX, forwarder::NEW_CLIENT_PREFIX_DEFAULT);
     const unsigned short maxReadInSize = std::atoi(forwarder::getEnvironmentVariableValueOrDefault(forwarder::MAX_READ_IN_SIZE, std::to_string(forwarder::MAX_READ_IN_DEFAULT)).c_str());
     const bool debug = forwarder::getEnvironmentVariableValue(forwarder::DEBUG).has_value();
+    const std::string tcpWorkerCountString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_WORKER_COUNT, std::to_string(forwarder::TCP_WORKER_COUNT_DEFAULT));
+    const bool tcpReusePort = forwarder::getEnvironmentVariableValue(forwarder::TCP_REUSE_PORT).has_value();
+    const std::string tcpZeroCopyThresholdString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_ZERO_COPY_THRESHOLD, std::to_string(forwarder::TCP_ZERO_COPY_THRESHOLD_DEFAULT));
+    const std::string tcpSlowConsumerPolicyString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_SLOW_CONSUMER_POLICY, forwarder::TCP_SLOW_CONSUMER_POLICY_DEFAULT);
+    const std::string tcpMaxQueuedBytesString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_MAX_QUEUED_BYTES, std::to_string(forwarder::TCP_MAX_QUEUED_BYTES_DEFAULT));
+    const std::string tcpMaxLagMsString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_MAX_LAG_MS, std::to_string(forwarder::TCP_MAX_LAG_MS_DEFAULT));
+    const std::string tcpMaxFrameSizeString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_MAX_FRAME_SIZE, std::to_string(forwarder::TCP_MAX_FRAME_SIZE_DEFAULT));
+    const std::string tcpFlushWindowUsString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_FLUSH_WINDOW_US, std::to_string(forwarder::TCP_FLUSH_WINDOW_US_DEFAULT));
+    const std::string tcpHandshakeTimeoutMsString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_HANDSHAKE_TIMEOUT_MS, std::to_string(forwarder::TCP_HANDSHAKE_TIMEOUT_MS_DEFAULT));
+    const bool tcpCork = forwarder::getEnvironmentVariableValue(forwarder::TCP_USE_CORK).has_value();
+    const bool udpDisableOffload = forwarder::getEnvironmentVariableValue(forwarder::UDP_DISABLE_OFFLOAD).has_value();
+    const std::string udpReceiverCountString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::UDP_RECEIVER_COUNT, std::to_string(forwarder::UDP_RECEIVER_COUNT_DEFAULT));
+    const bool udpCPUSteering = forwarder::getEnvironmentVariableValue(forwarder::UDP_CPU_STEERING).has_value();
+    const std::string udpPeerTTLMsString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::UDP_PEER_TTL_MS, std::to_string(forwarder::UDP_PEER_TTL_MS_DEFAULT));
+    const bool udpExpirePreconfigured = forwarder::getEnvironmentVariableValue(forwarder::UDP_EXPIRE_PRECONFIGURED).has_value();
+    const std::string udpQueueSizeString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::UDP_QUEUE_SIZE, std::to_string(forwarder::UDP_QUEUE_SIZE_DEFAULT));
+    const std::string udpOverflowPolicyString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::UDP_OVERFLOW_POLICY, forwarder::UDP_OVERFLOW_POLICY_DEFAULT);
+    const unsigned long traceSampleRate = std::strtoul(forwarder::getEnvironmentVariableValueOrDefault(forwarder::TRACE_SAMPLE_RATE, std::to_string(forwarder::TRACE_SAMPLE_RATE_DEFAULT)).c_str(), nullptr, 10);
+    const std::string traceBufferSizeString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::TRACE_BUFFER_SIZE, std::to_string(forwarder::TRACE_BUFFER_SIZE_DEFAULT));
+    const std::string ioEngineString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::IO_ENGINE, forwarder::IO_ENGINE_DEFAULT);
+    const std::string logLevelString = forwarder::getEnvironmentVariableValueOrDefault(forwarder::LOG_LEVEL, forwarder::LOG_LEVEL_DEFAULT);
+
+    std::optional<forwarder::LogLevel> logLevel = forwarder::parseLogLevel(logLevelString);
+    if (!logLevel.has_value())
+    {
+        forwarder::logWarning("Unknown log level [", logLevelString, "], using [", forwarder::LOG_LEVEL_DEFAULT, "].");
+        logLevel = forwarder::parseLogLevel(forwarder::LOG_LEVEL_DEFAULT);
+    }
+    // The debug messages are only logged when the debug flag is set, so the flag also lowers the level to show them
+    if (debug)
+    {
+        logLevel = forwarder::LogLevel::Debug;
+    }
+    forwarder::getLogger().setLevel(*logLevel);
+
+    std::optional<size_t> tcpWorkerCount = forwarder::parseSize(tcpWorkerCountString, 1, forwarder::TCP_WORKER_COUNT_MAX);
+    if (!tcpWorkerCount.has_value())
+    {
+        forwarder::logWarning("Invalid TCP worker count [", tcpWorkerCountString, "], expected a value from [1] to [", forwarder::TCP_WORKER_COUNT_MAX, "], using [", forwarder::TCP_WORKER_COUNT_DEFAULT, "].");
+        tcpWorkerCount = forwarder::TCP_WORKER_COUNT_DEFAULT;
+    }
+
+    std::optional<size_t> tcpMaxFrameSize = forwarder::parseSize(tcpMaxFrameSizeString, 1, forwarder::TCP_MAX_FRAME_SIZE_MAX);
+    if (!tcpMaxFrameSize.has_value())
+    {
+        forwarder::logWarning("Invalid TCP max frame size [", tcpMaxFrameSizeString, "], expected a value from [1] to [", forwarder::TCP_MAX_FRAME_SIZE_MAX, "], using [", forwarder::TCP_MAX_FRAME_SIZE_DEFAULT, "].");
+        tcpMaxFrameSize = forwarder::TCP_MAX_FRAME_SIZE_DEFAULT;
+    }
+
+    std::optional<size_t> tcpZeroCopyThreshold = forwarder::parseSize(tcpZeroCopyThresholdString, 0, forwarder::TCP_ZERO_COPY_THRESHOLD_MAX);
+    if (!tcpZeroCopyThreshold.has_value())
+    {
+        forwarder::logWarning("Invalid TCP zero copy threshold [", tcpZeroCopyThresholdString, "], expected a value from [0] to [", forwarder::TCP_ZERO_COPY_THRESHOLD_MAX, "], using [", forwarder::TCP_ZERO_COPY_THRESHOLD_DEFAULT, "].");
+        tcpZeroCopyThreshold = forwarder::TCP_ZERO_COPY_THRESHOLD_DEFAULT;
+    }
+
+    std::optional<size_t> tcpMaxQueuedBytes = forwarder::parseSize(tcpMaxQueuedBytesString, 0, forwarder::TCP_MAX_QUEUED_BYTES_MAX);
+    if (!tcpMaxQueuedBytes.has_value())
+    {
+        forwarder::logWarning("Invalid TCP max queued bytes [", tcpMaxQueuedBytesString, "], expected a value from [0] to [", forwarder::TCP_MAX_QUEUED_BYTES_MAX, "], using [", forwarder::TCP_MAX_QUEUED_BYTES_DEFAULT, "].");
+        tcpMaxQueuedBytes = forwarder::TCP_MAX_QUEUED_BYTES_DEFAULT;
+    }
+
+    std::optional<size_t> tcpMaxLagMs = forwarder::parseSize(tcpMaxLagMsString, 0, forwarder::TCP_MAX_LAG_MS_MAX);
+    if (!tcpMaxLagMs.has_value())
+    {
+        forwarder::logWarning("Invalid TCP max lag [", tcpMaxLagMsString, "], expected a value from [0] to [", forwarder::TCP_MAX_LAG_MS_MAX, "], using [", forwarder::TCP_MAX_LAG_MS_DEFAULT, "].");
+        tcpMaxLagMs = forwarder::TCP_MAX_LAG_MS_DEFAULT;
+    }
+
+    std::optional<size_t> tcpFlushWindowUs = forwarder::parseSize(tcpFlushWindowUsString, 0, forwarder::TCP_FLUSH_WINDOW_US_MAX);
+    if (!tcpFlushWindowUs.has_value())
+    {
+        forwarder::logWarning("Invalid TCP flush window [", tcpFlushWindowUsString, "], expected a value from [0] to [", forwarder::TCP_FLUSH_WINDOW_US_MAX, "], using [", forwarder::TCP_FLUSH_WINDOW_US_DEFAULT, "].");
+        tcpFlushWindowUs = forwarder::TCP_FLUSH_WINDOW_US_DEFAULT;
+    }
+
+    std::optional<size_t> tcpHandshakeTimeoutMs = forwarder::parseSize(tcpHandshakeTimeoutMsString, 0, forwarder::TCP_HANDSHAKE_TIMEOUT_MS_MAX);
+    if (!tcpHandshakeTimeoutMs.has_value())
+    {
+        forwarder::logWarning("Invalid TCP handshake timeout [", tcpHandshakeTimeoutMsString, "], expected a value from [0] to [", forwarder::TCP_HANDSHAKE_TIMEOUT_MS_MAX, "], using [", forwarder::TCP_HANDSHAKE_TIMEOUT_MS_DEFAULT, "].");
+        tcpHandshakeTimeoutMs = forwarder::TCP_HANDSHAKE_TIMEOUT_MS_DEFAULT;
+    }
+
+    std::optional<size_t> udpPeerTTLMs = forwarder::parseSize(udpPeerTTLMsString, 0, forwarder::UDP_PEER_TTL_MS_MAX);
+    if (!udpPeerTTLMs.has_value())
+    {
+        forwarder::logWarning("Invalid UDP peer TTL [", udpPeerTTLMsString, "], expected a value from [0] to [", forwarder::UDP_PEER_TTL_MS_MAX, "], using [", forwarder::UDP_PEER_TTL_MS_DEFAULT, "].");
+        udpPeerTTLMs = forwarder::UDP_PEER_TTL_MS_DEFAULT;
+    }
+
+    std::optional<forwarder::SlowConsumerPolicy> tcpSlowConsumerPolicy = forwarder::parseSlowConsumerPolicy(tcpSlowConsumerPolicyString);
+    if (!tcpSlowConsumerPolicy.has_value())
+    {
+        forwarder::logWarning("Unknown TCP slow consumer policy [", tcpSlowConsumerPolicyString, "], using [", forwarder::TCP_SLOW_CONSUMER_POLICY_DEFAULT, "].");
+        tcpSlowConsumerPolicy = forwarder::parseSlowConsumerPolicy(forwarder::TCP_SLOW_CONSUMER_POLICY_DEFAULT);
+    }
+
+    std::optional<size_t> udpReceiverCount = forwarder::parseSize(udpReceiverCountString, 1, forwarder::UDP_RECEIVER_COUNT_MAX);
+    if (!udpReceiverCount.has_value())
+    {
+        forwarder::logWarning("Invalid UDP receiver count [", udpReceiverCountString, "], expected a value from [1] to [", forwarder::UDP_RECEIVER_COUNT_MAX, "], using [", forwarder::UDP_RECEIVER_COUNT_DEFAULT, "].");
+        udpReceiverCount = forwarder::UDP_RECEIVER_COUNT_DEFAULT;
+    }
 
-    std::cout << "Using new client prefix: [" << newClientPrefix << "].\n" 
-        << "Using max read in size: [" << maxReadInSize << "].\n"
-        << "DEBUG flag set to [" << debug << "].\n"
-        << "Binding to host address [" << forwarder::getEnvironmentVariableValueOrDefault(forwarder::HOST_ADDRESS, forwarder::HOST_ADDRESS_DEFAULT) << "]." << std::endl;
+    std::optional<size_t> udpQueueSize = forwarder::parseSize(udpQueueSizeString, 1, forwarder::UDP_QUEUE_SIZE_MAX);
+    if (!udpQueueSize.has_value())
+    {
+        forwarder::logWarning("Invalid UDP queue size [", udpQueueSizeString, "], expected a value from [1] to [", forwarder::UDP_QUEUE_SIZE_MAX, "], using [", forwarder::UDP_QUEUE_SIZE_DEFAULT, "].");
+        udpQueueSize = forwarder::UDP_QUEUE_SIZE_DEFAULT;
+    }
+
+    std::optional<forwarder::OverflowPolicy> udpOverflowPolicy = forwarder::parseOverflowPolicy(udpOverflowPolicyString);
+    if (!udpOverflowPolicy.has_value())
+    {
+        forwarder::logWarning("Unknown UDP overflow policy [", udpOverflowPolicyString, "], using [", forwarder::UDP_OVERFLOW_POLICY_DEFAULT, "].");
+        udpOverflowPolicy = forwarder::parseOverflowPolicy(forwarder::UDP_OVERFLOW_POLICY_DEFAULT);
+    }
+
+    std::optional<forwarder::IOEngine> ioEngine = forwarder::parseIOEngine(ioEngineString);
+    if (!ioEngine.has_value())
+    {
+        forwarder::logWarning("Unknown I/O engine [", ioEngineString, "], using [", forwarder::IO_ENGINE_DEFAULT, "].");
+        ioEngine = forwarder::parseIOEngine(forwarder::IO_ENGINE_DEFAULT);
+    }
+
+    std::optional<size_t> traceBufferSize = forwarder::parseSize(traceBufferSizeString, 1, forwarder::TRACE_BUFFER_SIZE_MAX);
+    if (!traceBufferSize.has_value())
+    {
+        forwarder::logWarning("Invalid trace buffer size [", traceBufferSizeString, "], expected a value from [1] to [", forwarder::TRACE_BUFFER_SIZE_MAX, "], using [", forwarder::TRACE_BUFFER_SIZE_DEFAULT, "].");
+        traceBufferSize = forwarder::TRACE_BUFFER_SIZE_DEFAULT;
+    }
+
+    forwarder::logInfo("Using new client prefix: [", newClientPrefix, "].");
+    forwarder::logInfo("Using max read in size: [", maxReadInSize, "].");
+    forwarder::logInfo("DEBUG flag set to [", debug, "].");
+    forwarder::logInfo("Using log level: [", forwarder::logLevelToString(*logLevel), "].");
+    forwarder::logInfo("Using I/O engine: [", forwarder::ioEngineToString(*ioEngine), "].");
+    forwarder::logInfo("Using TCP worker count: [", *tcpWorkerCount, "].");
+    forwarder::logInfo("TCP SO_REUSEPORT flag set to [", tcpReusePort, "].");
+    forwarder::logInfo("Using TCP zero copy threshold: [", *tcpZeroCopyThreshold, "].");
+    forwarder::logInfo("Using TCP slow consumer policy: [", forwarder::slowConsumerPolicyToString(*tcpSlowConsumerPolicy), "] with max queued bytes [", *tcpMaxQueuedBytes, "] and max lag [", *tcpMaxLagMs, "ms].");
+    forwarder::logInfo("Using TCP max frame size: [", *tcpMaxFrameSize, "].");
+    forwarder::logInfo("Using TCP handshake timeout: [", *tcpHandshakeTimeoutMs, "ms].");
+    forwarder::logInfo("Using TCP flush window: [", *tcpFlushWindowUs, "us].");
+    forwarder::logInfo("TCP_CORK flag set to [", tcpCork, "].");
+    forwarder::logInfo("Using UDP queue size: [", *udpQueueSize, "] with overflow policy [", forwarder::overflowPolicyToString(*udpOverflowPolicy), "].");
+    forwarder::logInfo("UDP disable offload flag set to [", udpDisableOffload, "].");
+    forwarder::logInfo("Using [", *udpReceiverCount, "] UDP receivers with CPU steering flag set to [", udpCPUSteering, "].");
+    forwarder::logInfo("Using UDP peer TTL: [", *udpPeerTTLMs, "ms] with expire preconfigured flag set to [", udpExpirePreconfigured, "].");
+    forwarder::logInfo("Tracing one in [", traceSampleRate, "] messages into a buffer of [", *traceBufferSize, "] events, send SIGUSR1 to dump them.");
+    forwarder::logInfo("Binding to host address [", forwarder::getEnvironmentVariableValueOrDefault(forwarder::HOST_ADDRESS, forwarder::HOST_ADDRESS_DEFAULT), "].");
 
     std::optional<kt::ServerSocket> serverSocket = forwarder::setUpTcpServerSocket(argc > 1 ? std::make_optional(std::string(argv[1])) : std::nullopt);
     std::optional<kt::UDPSocket> udpSocket = forwarder::setUpUDPSocket(argc > 2 ? std::make_optional(std::string(argv[2])) : std::nullopt);
 
     forwarder::Forwarder forwarder(serverSocket, udpSocket, newClientPrefix, maxReadInSize, debug);
+    forwarder.setTCPWorkerCount(*tcpWorkerCount);
+    forwarder.setTCPReusePort(tcpReusePort);
+    forwarder.setTCPZeroCopyThreshold(*tcpZeroCopyThreshold);
+    forwarder.setTCPSlowConsumerPolicy(*tcpSlowConsumerPolicy, *tcpMaxQueuedBytes, std::chrono::milliseconds(*tcpMaxLagMs));
+    forwarder.setTCPMaxFrameSize(*tcpMaxFrameSize);
+    forwarder.setTCPHandshakeTimeout(std::chrono::milliseconds(*tcpHandshakeTimeoutMs));
+    forwarder.setTCPFlushWindow(std::chrono::microseconds(*tcpFlushWindowUs));
+    forwarder.setTCPCork(tcpCork);
+    forwarder.setUDPQueue(*udpQueueSize, *udpOverflowPolicy);
+    forwarder.setUDPOffload(!udpDisableOffload);
+    forwarder.setUDPReceivers(*udpReceiverCount, udpCPUSteering);
+    forwarder.setUDPPeerExpiry(std::chrono::milliseconds(*udpPeerTTLMs), udpExpirePreconfigured);
+    forwarder.setIOEngine(*ioEngine);
+    forwarder.setTracing(traceSampleRate, *traceBufferSize);
+
+    for (const auto& it : forwarder::getTCPGroupFraming())
+    {
+        forwarder.setTCPGroupFraming(it.first, it.second);
+    }
+
+    for (const std::string& groupId : forwarder::split(forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_SPLICE_GROUPS, ""), ","))
+    {
+        if (!groupId.empty())
+        {
+            forwarder::logInfo("TCP group [", groupId, "] will forward using splice.");
+            forwarder.setTCPGroupSplice(groupId, true);
+        }
+    }
 
-    std::vector<kt::SocketAddress> udpPreconfiguredAddresses = forwarder::getPreconfiguredUDPAddresses();
+    for (const std::string& entry : forwarder::split(forwarder::getEnvironmentVariableValueOrDefault(forwarder::TCP_GROUP_FLUSH_WINDOW_US, ""), ","))
+    {
+        std::vector<std::string> parts = forwarder::split(entry, ":");
+        std::optional<size_t> groupFlushWindowUs = parts.size() == 2 ? forwarder::parseSize(parts[1], 0, forwarder::TCP_FLUSH_WINDOW_US_MAX) : std::nullopt;
+        if (groupFlushWindowUs.has_value())
+        {
+            forwarder::logInfo("TCP group [", parts[0], "] will use flush window [", *groupFlushWindowUs, "us].");
+            forwarder.setTCPGroupFlushWindow(parts[0], std::chrono::microseconds(*groupFlushWindowUs));
+        }
+        else if (parts.size() == 2)
+        {
+            forwarder::logWarning("Invalid TCP flush window [", parts[1], "] for group [", parts[0], "], expected a value from [0] to [", forwarder::TCP_FLUSH_WINDOW_US_MAX, "], using the global flush window.");
+        }
+        else if (!entry.empty())
+        {
+            forwarder::logWarning("Unable to parse TCP flush window entry [", entry, "], expected format to be \"<groupId>:<microseconds>\".");
+        }
+    }
+
+    std::unordered_map<std::string, std::vector<kt::SocketAddress>> udpPreconfiguredAddresses = forwarder::getPreconfiguredUDPAddresses();
     if (!udpPreconfiguredAddresses.empty())
     {
-        std::cout << "UDP preconfigured addresses provided, setting into forwarder..." << std::endl;
-        for (const kt::SocketAddress& addr : udpPreconfiguredAddresses)
+        forwarder::logInfo("UDP preconfigured addresses provided, setting into forwarder...");
+        for (const auto& it : udpPreconfiguredAddresses)
         {
-            forwarder.addAddressToUDPGroup(addr);
+            for (const kt::SocketAddress& addr : it.second)
+            {
+                forwarder.preConfigureUDPAddress(it.first, addr);
+            }
         }
     }
 
     std::unordered_map<std::string, std::vector<kt::SocketAddress>> tcpPreconfiguredAddresses = forwarder::getPreconfiguredTCPAddresses();
     if (!tcpPreconfiguredAddresses.empty())
     {
-        std::cout << "TCP preconfigured addresses provided, setting into forwarder..." << std::endl;
+        forwarder::logInfo("TCP preconfigured addresses provided, setting into forwarder...");
         for (const auto& it : tcpPreconfiguredAddresses)
         {
             for (const kt::SocketAddress& addr : it.second)
@@ -53,6 +263,31 @@ int main(int argc, char** argv)
         }
     }
 
+    std::thread traceDumpThread([&forwarder, traceDumpSignals]()
+    {
+        int signal = 0;
+        while (sigwait(&traceDumpSignals, &signal) == 0)
+        {
+            // Written straight to stdout rather than through the logger, which would drop most of a large dump
+            forwarder::getLogger().flush();
+            forwarder.dumpTraces(std::cout);
+        }
+    });
+    traceDumpThread.detach();
+
     forwarder.start();
+
+    // Started once the forwarder has started, since scrapes read the forwarder's workers
+    forwarder::MetricsServer metricsServer([&forwarder](std::ostream& stream) { forwarder.writeMetrics(stream); });
+    std::optional<std::string> metricsPort = forwarder::getEnvironmentVariableValue(forwarder::METRICS_PORT);
+    if (metricsPort.has_value())
+    {
+        metricsServer.start(forwarder::getEnvironmentVariableValueOrDefault(forwarder::METRICS_HOST_ADDRESS, forwarder::METRICS_HOST_ADDRESS_DEFAULT), static_cast<unsigned short>(std::atoi(metricsPort->c_str())));
+    }
+    else
+    {
+        forwarder::logInfo("Skipping metrics server creation since value for [", forwarder::METRICS_PORT, "] was not provided.");
+    }
+
     forwarder.join();
 }
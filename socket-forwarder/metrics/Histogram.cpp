@@ -0,0 +1,77 @@
+#include "Histogram.h"
+
+#include <algorithm>
+
+namespace forwarder
+{
+    HistogramSnapshot& HistogramSnapshot::operator+=(const HistogramSnapshot& other)
+    {
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            counts[i] += other.counts[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        max = std::max(max, other.max);
+        return *this;
+    }
+
+    /**
+     * Returns the highest value that falls into the same bucket as the value at the provided percentile (0 to 100), so the result is never
+     * lower than the recorded value. Never returns more than the maximum recorded value, and returns 0 if nothing was recorded.
+     */
+    uint64_t HistogramSnapshot::valueAtPercentile(const double percentile) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        // Rounded to the nearest rank, as rounding up turns 99.9% of 1000 values into the 1000th value once the percentile is a double
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                return std::min(LatencyHistogram::bucketHighestValue(i), max);
+            }
+        }
+        return max;
+    }
+
+    /**
+     * Returns the highest value counted in the provided bucket.
+     */
+    uint64_t LatencyHistogram::bucketHighestValue(const size_t index)
+    {
+        if (index < HISTOGRAM_SUB_BUCKETS)
+        {
+            return index;
+        }
+        if (index >= HISTOGRAM_BUCKET_COUNT - 1)
+        {
+            return UINT64_MAX;
+        }
+        const uint64_t shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+        const uint64_t subBucket = index % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS;
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+    /**
+     * Copies the histogram's counts. Values recorded while the copy is taken may be missing from some of its totals.
+     */
+    HistogramSnapshot LatencyHistogram::snapshot() const
+    {
+        HistogramSnapshot snapshot;
+        for (size_t i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count = count.load(std::memory_order_relaxed);
+        snapshot.sum = sum.load(std::memory_order_relaxed);
+        snapshot.max = max.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+}
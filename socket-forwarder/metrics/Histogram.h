@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace forwarder
+{
+    // Each power of two range of values is split into 2^HISTOGRAM_SUB_BUCKET_BITS buckets, so a recorded value is off by at most 1/16th
+    const unsigned HISTOGRAM_SUB_BUCKET_BITS = 4;
+    const uint64_t HISTOGRAM_SUB_BUCKETS = uint64_t(1) << HISTOGRAM_SUB_BUCKET_BITS;
+    // Values of 2^36 nanoseconds (roughly 68 seconds) and above are counted in an extra last bucket, the maximum is still kept exactly
+    const unsigned HISTOGRAM_HIGHEST_POWER = 35;
+    const size_t HISTOGRAM_BUCKET_COUNT = (HISTOGRAM_HIGHEST_POWER - HISTOGRAM_SUB_BUCKET_BITS + 2) * HISTOGRAM_SUB_BUCKETS + 1;
+
+    /**
+     * A copy of a histogram's counts that can be merged with other copies and queried for percentiles.
+     */
+    struct HistogramSnapshot
+    {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(HISTOGRAM_BUCKET_COUNT, 0);
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        HistogramSnapshot& operator+=(const HistogramSnapshot&);
+        uint64_t valueAtPercentile(const double) const;
+    };
+
+    /**
+     * A log-linear histogram of durations in nanoseconds, in the style of an HDR histogram. Recording is a bucket lookup and a few relaxed
+     * stores, as only a single thread may record into each histogram. Any thread can take a snapshot while it is being recorded into.
+     */
+    class LatencyHistogram
+    {
+    protected:
+        std::atomic<uint64_t> counts[HISTOGRAM_BUCKET_COUNT] = {};
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+
+        static inline void add(std::atomic<uint64_t>& counter, const uint64_t amount)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+    public:
+        static inline size_t bucketIndex(const uint64_t value)
+        {
+            if (value < HISTOGRAM_SUB_BUCKETS)
+            {
+                return static_cast<size_t>(value);
+            }
+            const unsigned power = 63 - static_cast<unsigned>(__builtin_clzll(value));
+            if (power > HISTOGRAM_HIGHEST_POWER)
+            {
+                return HISTOGRAM_BUCKET_COUNT - 1;
+            }
+            const unsigned shift = power - HISTOGRAM_SUB_BUCKET_BITS;
+            return static_cast<size_t>((shift + 1) * HISTOGRAM_SUB_BUCKETS + (value >> shift) - HISTOGRAM_SUB_BUCKETS);
+        }
+
+        static uint64_t bucketHighestValue(const size_t);
+
+        inline void record(const uint64_t nanoseconds)
+        {
+            add(counts[bucketIndex(nanoseconds)], 1);
+            add(count, 1);
+            add(sum, nanoseconds);
+            if (nanoseconds > max.load(std::memory_order_relaxed))
+            {
+                max.store(nanoseconds, std::memory_order_relaxed);
+            }
+        }
+
+        inline void record(const std::chrono::steady_clock::duration duration)
+        {
+            const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            record(nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+        }
+
+        HistogramSnapshot snapshot() const;
+    };
+}
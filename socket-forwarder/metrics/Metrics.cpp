@@ -0,0 +1,192 @@
+#include "Metrics.h"
+
+#include <set>
+
+namespace forwarder
+{
+    /**
+     * Returns counters for the provided series that only the calling thread may write to. A thread counting for several series uses
+     * separate counters for each of them.
+     */
+    std::shared_ptr<ForwardingCounters> Metrics::createCounters(const MetricsSeries& series)
+    {
+        std::shared_ptr<ForwardingCounters> created = std::make_shared<ForwardingCounters>();
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.emplace_back(series, created);
+        return created;
+    }
+
+    /**
+     * Adds together the counters of every thread for each series. Counters that are being written while they are read may be one update behind.
+     */
+    std::map<MetricsSeries, ForwardingTotals> Metrics::totals() const
+    {
+        std::map<MetricsSeries, ForwardingTotals> totals;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::pair<MetricsSeries, std::shared_ptr<const ForwardingCounters>>& entry : counters)
+        {
+            ForwardingTotals& total = totals[entry.first];
+            const ForwardingCounters& counter = *entry.second;
+            total.messagesIn += counter.messagesIn.load(std::memory_order_relaxed);
+            total.bytesIn += counter.bytesIn.load(std::memory_order_relaxed);
+            total.messagesOut += counter.messagesOut.load(std::memory_order_relaxed);
+            total.bytesOut += counter.bytesOut.load(std::memory_order_relaxed);
+            total.sendFailures += counter.sendFailures.load(std::memory_order_relaxed);
+            total.removals += counter.removals.load(std::memory_order_relaxed);
+            total.droppedMessages += counter.droppedMessages.load(std::memory_order_relaxed);
+            total.droppedBytes += counter.droppedBytes.load(std::memory_order_relaxed);
+            total.receiveToFirstSend += counter.receiveToFirstSend.snapshot();
+            total.receiveToLastSend += counter.receiveToLastSend.snapshot();
+            total.queueResidency += counter.queueResidency.snapshot();
+            total.peerSend += counter.peerSend.snapshot();
+        }
+        return totals;
+    }
+
+    std::string escapeMetricsLabel(const std::string& value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (const char character : value)
+        {
+            if (character == '\\' || character == '"')
+            {
+                escaped.push_back('\\');
+                escaped.push_back(character);
+            }
+            else if (character == '\n')
+            {
+                escaped.append("\\n");
+            }
+            else
+            {
+                escaped.push_back(character);
+            }
+        }
+        return escaped;
+    }
+
+    static std::string seriesLabels(const MetricsSeries& series, const std::string& extraLabels = "")
+    {
+        std::string labels = "{protocol=\"" + escapeMetricsLabel(series.protocol) + "\"";
+        if (!series.groupId.empty())
+        {
+            labels += ",group=\"" + escapeMetricsLabel(series.groupId) + "\"";
+        }
+        return labels + extraLabels + "}";
+    }
+
+    static double toMicroseconds(const uint64_t nanoseconds)
+    {
+        return static_cast<double>(nanoseconds) / 1000.0;
+    }
+
+    /**
+     * Writes every series in the Prometheus text format, along with the provided amount of members in each group.
+     * Groups that have no members left keep their counters, groups that have not forwarded anything yet are written with zeroed counters.
+     */
+    void Metrics::write(std::ostream& stream, const std::map<MetricsSeries, size_t>& memberCounts) const
+    {
+        std::map<MetricsSeries, ForwardingTotals> allTotals = totals();
+        for (const std::pair<const MetricsSeries, size_t>& group : memberCounts)
+        {
+            allTotals.emplace(group.first, ForwardingTotals{});
+        }
+
+        struct CounterMetric
+        {
+            const char* name;
+            const char* help;
+            uint64_t ForwardingTotals::* value;
+        };
+        static const CounterMetric counterMetrics[] = {
+            { "socketforwarder_messages_in_total", "Messages received from clients and forwarded.", &ForwardingTotals::messagesIn },
+            { "socketforwarder_bytes_in_total", "Bytes received from clients and forwarded.", &ForwardingTotals::bytesIn },
+            { "socketforwarder_messages_out_total", "Messages forwarded to clients, counted once per receiving client.", &ForwardingTotals::messagesOut },
+            { "socketforwarder_bytes_out_total", "Bytes forwarded to clients, counted once per receiving client.", &ForwardingTotals::bytesOut },
+            { "socketforwarder_send_failures_total", "Sends to clients that failed.", &ForwardingTotals::sendFailures },
+            { "socketforwarder_removals_total", "Clients removed from their group.", &ForwardingTotals::removals },
+            { "socketforwarder_dropped_messages_total", "UDP messages dropped because the forwarding queue was full.", &ForwardingTotals::droppedMessages },
+            { "socketforwarder_dropped_bytes_total", "Bytes of UDP messages dropped because the forwarding queue was full.", &ForwardingTotals::droppedBytes }
+        };
+
+        for (const CounterMetric& metric : counterMetrics)
+        {
+            stream << "# HELP " << metric.name << " " << metric.help << "\n";
+            stream << "# TYPE " << metric.name << " counter\n";
+            for (const std::pair<const MetricsSeries, ForwardingTotals>& series : allTotals)
+            {
+                stream << metric.name << seriesLabels(series.first) << " " << series.second.*metric.value << "\n";
+            }
+        }
+
+        struct LatencyMetric
+        {
+            const char* interval;
+            HistogramSnapshot ForwardingTotals::* histogram;
+        };
+        static const LatencyMetric latencyMetrics[] = {
+            { "receive_to_first_send", &ForwardingTotals::receiveToFirstSend },
+            { "receive_to_last_send", &ForwardingTotals::receiveToLastSend },
+            { "queue_residency", &ForwardingTotals::queueResidency },
+            { "peer_send", &ForwardingTotals::peerSend }
+        };
+        static const std::pair<const char*, double> quantiles[] = { { "0.5", 50.0 }, { "0.99", 99.0 }, { "0.999", 99.9 } };
+
+        // Intervals that were never recorded for a series are left out rather than written as zeroes
+        stream << "# HELP socketforwarder_latency_microseconds Forwarding latency of each interval, accurate to within 1/16th of the value.\n";
+        stream << "# TYPE socketforwarder_latency_microseconds summary\n";
+        for (const std::pair<const MetricsSeries, ForwardingTotals>& series : allTotals)
+        {
+            for (const LatencyMetric& metric : latencyMetrics)
+            {
+                const HistogramSnapshot& histogram = series.second.*metric.histogram;
+                if (histogram.count == 0)
+                {
+                    continue;
+                }
+                const std::string interval = std::string(",interval=\"") + metric.interval + "\"";
+                for (const std::pair<const char*, double>& quantile : quantiles)
+                {
+                    stream << "socketforwarder_latency_microseconds" << seriesLabels(series.first, interval + ",quantile=\"" + quantile.first + "\"") << " "
+                        << toMicroseconds(histogram.valueAtPercentile(quantile.second)) << "\n";
+                }
+                stream << "socketforwarder_latency_microseconds_sum" << seriesLabels(series.first, interval) << " " << toMicroseconds(histogram.sum) << "\n";
+                stream << "socketforwarder_latency_microseconds_count" << seriesLabels(series.first, interval) << " " << histogram.count << "\n";
+            }
+        }
+        stream << "# HELP socketforwarder_latency_max_microseconds Highest forwarding latency of each interval.\n";
+        stream << "# TYPE socketforwarder_latency_max_microseconds gauge\n";
+        for (const std::pair<const MetricsSeries, ForwardingTotals>& series : allTotals)
+        {
+            for (const LatencyMetric& metric : latencyMetrics)
+            {
+                const HistogramSnapshot& histogram = series.second.*metric.histogram;
+                if (histogram.count != 0)
+                {
+                    stream << "socketforwarder_latency_max_microseconds" << seriesLabels(series.first, std::string(",interval=\"") + metric.interval + "\"") << " "
+                        << toMicroseconds(histogram.max) << "\n";
+                }
+            }
+        }
+
+        std::map<std::string, size_t> groupCounts;
+        for (const std::pair<const MetricsSeries, size_t>& group : memberCounts)
+        {
+            groupCounts[group.first.protocol]++;
+        }
+        stream << "# HELP socketforwarder_groups Groups that currently exist.\n";
+        stream << "# TYPE socketforwarder_groups gauge\n";
+        for (const std::pair<const std::string, size_t>& protocol : groupCounts)
+        {
+            stream << "socketforwarder_groups{protocol=\"" << escapeMetricsLabel(protocol.first) << "\"} " << protocol.second << "\n";
+        }
+
+        stream << "# HELP socketforwarder_group_members Clients currently in each group.\n";
+        stream << "# TYPE socketforwarder_group_members gauge\n";
+        for (const std::pair<const MetricsSeries, size_t>& group : memberCounts)
+        {
+            stream << "socketforwarder_group_members" << seriesLabels(group.first) << " " << group.second << "\n";
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+#include "Histogram.h"
+
+namespace forwarder
+{
+    const std::string METRICS_PROTOCOL_TCP = "tcp";
+    const std::string METRICS_PROTOCOL_UDP = "udp";
+
+    /**
+     * Identifies a series of forwarding metrics. UDP has a single series, which has no group ID.
+     */
+    struct MetricsSeries
+    {
+        std::string protocol;
+        std::string groupId;
+
+        bool operator<(const MetricsSeries& other) const
+        {
+            return protocol != other.protocol ? protocol < other.protocol : groupId < other.groupId;
+        }
+    };
+
+    /**
+     * The forwarding counters of a series written by a single thread. Each thread that counts for a series has its own set of counters on its own
+     * cache line, so a counter is updated with a plain load and store rather than an atomic increment and no other thread's writes contend with it.
+     * The counters of every thread are only added together when the metrics are read.
+     */
+    struct alignas(64) ForwardingCounters
+    {
+        std::atomic<uint64_t> messagesIn{ 0 };
+        std::atomic<uint64_t> bytesIn{ 0 };
+        std::atomic<uint64_t> messagesOut{ 0 };
+        std::atomic<uint64_t> bytesOut{ 0 };
+        std::atomic<uint64_t> sendFailures{ 0 };
+        std::atomic<uint64_t> removals{ 0 };
+        std::atomic<uint64_t> droppedMessages{ 0 };
+        std::atomic<uint64_t> droppedBytes{ 0 };
+
+        // Time from a message being received to its first and its last receiving client accepting it, skipped for messages that were not
+        // delivered to every client
+        LatencyHistogram receiveToFirstSend;
+        LatencyHistogram receiveToLastSend;
+        // Time a UDP message waits between the listener and the forwarder thread
+        LatencyHistogram queueResidency;
+        // Time taken to hand a message to a single client, from being queued for it to the client accepting all of it
+        LatencyHistogram peerSend;
+
+        inline void recordReceived(const size_t bytes)
+        {
+            add(messagesIn, 1);
+            add(bytesIn, bytes);
+        }
+
+        inline void recordSent(const size_t bytes)
+        {
+            add(messagesOut, 1);
+            add(bytesOut, bytes);
+        }
+
+        inline void recordSendFailure()
+        {
+            add(sendFailures, 1);
+        }
+
+        inline void recordRemoval()
+        {
+            add(removals, 1);
+        }
+
+        inline void recordDropped(const uint64_t messages, const uint64_t bytes)
+        {
+            add(droppedMessages, messages);
+            add(droppedBytes, bytes);
+        }
+
+    protected:
+        // Only the owning thread writes the counter, so it does not need a locked read-modify-write
+        static inline void add(std::atomic<uint64_t>& counter, const uint64_t amount)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    };
+
+    struct ForwardingTotals
+    {
+        uint64_t messagesIn = 0;
+        uint64_t bytesIn = 0;
+        uint64_t messagesOut = 0;
+        uint64_t bytesOut = 0;
+        uint64_t sendFailures = 0;
+        uint64_t removals = 0;
+        uint64_t droppedMessages = 0;
+        uint64_t droppedBytes = 0;
+        HistogramSnapshot receiveToFirstSend;
+        HistogramSnapshot receiveToLastSend;
+        HistogramSnapshot queueResidency;
+        HistogramSnapshot peerSend;
+    };
+
+    /**
+     * Holds the counters of every thread for every series. Creating counters takes a lock, reading and writing them does not.
+     */
+    class Metrics
+    {
+    protected:
+        mutable std::mutex mutex;
+        std::vector<std::pair<MetricsSeries, std::shared_ptr<const ForwardingCounters>>> counters;
+
+    public:
+        std::shared_ptr<ForwardingCounters> createCounters(const MetricsSeries&);
+        std::map<MetricsSeries, ForwardingTotals> totals() const;
+        void write(std::ostream&, const std::map<MetricsSeries, size_t>&) const;
+    };
+
+    std::string escapeMetricsLabel(const std::string&);
+}
@@ -0,0 +1,126 @@
+#include "MetricsServer.h"
+#include "../logging/Logger.h"
+
+#include <sstream>
+
+#include <sys/socket.h>
+
+#include <socketexceptions/SocketException.hpp>
+#include <socketexceptions/BindingException.hpp>
+#include <socketexceptions/TimeoutException.hpp>
+
+namespace forwarder
+{
+    MetricsServer::MetricsServer(std::function<void(std::ostream&)> metricsWriter) : writeMetrics(metricsWriter) {}
+
+    MetricsServer::~MetricsServer()
+    {
+        stop();
+    }
+
+    /**
+     * Binds to the provided address and port, 0 binds to any free port, and starts serving requests. Returns false if the socket could not be bound.
+     */
+    bool MetricsServer::start(const std::string& hostAddress, const unsigned short port)
+    {
+        try
+        {
+            serverSocket.emplace(kt::SocketType::Wifi, hostAddress, port);
+        }
+        catch (const kt::BindingException& e)
+        {
+            logWarning("[METRICS] - Failed to bind metrics server on [", hostAddress, ":", port, "]. ", e.what());
+            return false;
+        }
+        catch (const kt::SocketException& e)
+        {
+            logWarning("[METRICS] - Failed to create metrics server socket: ", e.what());
+            return false;
+        }
+
+        logInfo("[METRICS] - Serving metrics on [", hostAddress, ":", serverSocket->getPort(), "/metrics].");
+        running = true;
+        thread = std::thread(&MetricsServer::run, this);
+        return true;
+    }
+
+    void MetricsServer::stop()
+    {
+        running = false;
+        if (thread.has_value())
+        {
+            thread->join();
+            thread = std::nullopt;
+        }
+        if (serverSocket.has_value())
+        {
+            serverSocket->close();
+            serverSocket = std::nullopt;
+        }
+    }
+
+    unsigned short MetricsServer::getPort() const
+    {
+        return serverSocket.has_value() ? serverSocket->getPort() : 0;
+    }
+
+    void MetricsServer::run()
+    {
+        while (running)
+        {
+            try
+            {
+                // Accepting times out so the server notices it has been stopped
+                kt::TCPSocket socket = serverSocket->acceptTCPConnection(std::chrono::duration_cast<std::chrono::microseconds>(METRICS_ACCEPT_TIMEOUT).count());
+                handle(socket);
+                socket.close();
+            }
+            catch (const kt::TimeoutException&)
+            {
+            }
+            catch (const kt::SocketException& e)
+            {
+                logWarning("[METRICS] - Failed to accept metrics request: ", e.what());
+            }
+        }
+    }
+
+    /**
+     * Reads the request's headers and writes a single response, the connection is closed afterwards. The request's body, if any, is ignored.
+     */
+    void MetricsServer::handle(kt::TCPSocket& socket)
+    {
+        std::string request;
+        const unsigned long timeout = static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::microseconds>(METRICS_REQUEST_TIMEOUT).count());
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < METRICS_REQUEST_SIZE_LIMIT && socket.ready(timeout))
+        {
+            std::string received = socket.receiveAmount(static_cast<unsigned int>(METRICS_REQUEST_SIZE_LIMIT - request.size()));
+            if (received.empty())
+            {
+                break;
+            }
+            request += received;
+        }
+
+        std::string status = "200 OK";
+        std::ostringstream body;
+        const std::string requestLine = request.substr(0, request.find("\r\n"));
+        if (requestLine.rfind("GET ", 0) != 0)
+        {
+            status = "405 Method Not Allowed";
+        }
+        else if (requestLine.rfind("GET /metrics ", 0) != 0 && requestLine.rfind("GET /metrics?", 0) != 0)
+        {
+            status = "404 Not Found";
+        }
+        else
+        {
+            writeMetrics(body);
+        }
+
+        const std::string content = body.str();
+        std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: "
+            + std::to_string(content.size()) + "\r\nConnection: close\r\n\r\n" + content;
+        socket.send(response, MSG_NOSIGNAL);
+    }
+}
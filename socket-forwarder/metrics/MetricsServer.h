@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <optional>
+#include <functional>
+#include <string>
+#include <ostream>
+#include <chrono>
+
+#include <serversocket/ServerSocket.h>
+#include <socket/TCPSocket.h>
+
+namespace forwarder
+{
+    const size_t METRICS_REQUEST_SIZE_LIMIT = 8192;
+    const std::chrono::milliseconds METRICS_ACCEPT_TIMEOUT = std::chrono::milliseconds(100);
+    const std::chrono::milliseconds METRICS_REQUEST_TIMEOUT = std::chrono::milliseconds(1000);
+
+    /**
+     * A minimal HTTP server that answers "GET /metrics" with the text written by the provided function, one connection at a time on its own thread.
+     */
+    class MetricsServer
+    {
+    protected:
+        std::function<void(std::ostream&)> writeMetrics;
+        std::optional<kt::ServerSocket> serverSocket = std::nullopt;
+        std::atomic<bool> running{ false };
+        std::optional<std::thread> thread = std::nullopt;
+
+        void run();
+        void handle(kt::TCPSocket&);
+
+    public:
+        MetricsServer(std::function<void(std::ostream&)>);
+        ~MetricsServer();
+
+        MetricsServer(const MetricsServer&) = delete;
+        MetricsServer& operator=(const MetricsServer&) = delete;
+
+        bool start(const std::string&, const unsigned short);
+        void stop();
+        unsigned short getPort() const;
+    };
+}
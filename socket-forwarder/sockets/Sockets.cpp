@@ -1,9 +1,18 @@
 #include <optional>
 
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <linux/filter.h>
+
 #include <socketexceptions/SocketException.hpp>
 #include <socketexceptions/BindingException.hpp>
 
 #include "../environment/Environment.h"
+#include "../logging/Logger.h"
 #include "Sockets.h"
 
 namespace forwarder
@@ -14,7 +23,7 @@ namespace forwarder
 
         if (!tcpPort.has_value() && !defaultPort.has_value())
         {
-            std::cout << "Skipping TCP socket creation since value for [" + forwarder::TCP_PORT + "] was not provided." << std::endl;
+            logInfo("Skipping TCP socket creation since value for [", forwarder::TCP_PORT, "] was not provided.");
             return std::nullopt;
         }
 
@@ -28,14 +37,187 @@ namespace forwarder
         }
         catch(const kt::BindingException e)
         {
-            std::cout << "[TCP] - Failed to bind server socket on port [" << portNumber << "]. " << e.what() << std::endl;
+            logWarning("[TCP] - Failed to bind server socket on port [", portNumber, "]. ", e.what());
             return std::nullopt;
         }
         catch (const kt::SocketException e)
         {
-            std::cout << "[TCP] - Failed to create server socket: " << e.what() << std::endl;
+            logWarning("[TCP] - Failed to create server socket: ", e.what());
+            return std::nullopt;
+        }
+    }
+
+    /**
+     * Creates another listening socket bound to the same address as the provided listening socket using SO_REUSEPORT,
+     * so the kernel distributes incoming connections between them. SO_REUSEPORT is also enabled on the provided socket.
+     */
+    std::optional<int> setUpReusePortTCPListener(const int existingListener)
+    {
+        const int enabled = 1;
+        kt::SocketAddress address{};
+        socklen_t addressLength = sizeof(address);
+        if (setsockopt(existingListener, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) != 0
+            || getsockname(existingListener, &address.address, &addressLength) != 0)
+        {
+            return std::nullopt;
+        }
+
+        int listener = socket(address.address.sa_family, SOCK_STREAM, 0);
+        if (listener == -1)
+        {
+            return std::nullopt;
+        }
+
+        if (setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) != 0
+            || bind(listener, &address.address, addressLength) != 0
+            || listen(listener, SOMAXCONN) != 0)
+        {
+            close(listener);
+            return std::nullopt;
+        }
+        return std::make_optional(listener);
+    }
+
+    /**
+     * Accepts a pending connection from the provided listening socket descriptor and wraps it in a kt::TCPSocket.
+     * The accepted socket is non-blocking. Returns std::nullopt with errno set if no connection could be accepted.
+     */
+    std::optional<kt::TCPSocket> acceptTCPConnection(const int listeningSocket)
+    {
+        kt::SocketAddress address{};
+        socklen_t addressLength = sizeof(address);
+        int descriptor = accept4(listeningSocket, &address.address, &addressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (descriptor == -1)
+        {
+            return std::nullopt;
+        }
+
+        kt::InternetProtocolVersion version = address.address.sa_family == AF_INET6 ? kt::InternetProtocolVersion::IPV6 : kt::InternetProtocolVersion::IPV4;
+        return std::make_optional(kt::TCPSocket(descriptor, kt::getAddress(address).value_or(""), kt::getPortNumber(address), version, address));
+    }
+
+    /**
+     * Creates a socket for a connection that has already been accepted, such as one accepted through io_uring, using the address of its peer.
+     */
+    std::optional<kt::TCPSocket> wrapTCPConnection(const int descriptor)
+    {
+        kt::SocketAddress address{};
+        socklen_t addressLength = sizeof(address);
+        if (getpeername(descriptor, &address.address, &addressLength) != 0)
+        {
+            return std::nullopt;
+        }
+
+        kt::InternetProtocolVersion version = address.address.sa_family == AF_INET6 ? kt::InternetProtocolVersion::IPV6 : kt::InternetProtocolVersion::IPV4;
+        return std::make_optional(kt::TCPSocket(descriptor, kt::getAddress(address).value_or(""), kt::getPortNumber(address), version, address));
+    }
+
+    bool setNonBlocking(const int descriptor)
+    {
+        int flags = fcntl(descriptor, F_GETFL, 0);
+        return flags != -1 && fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    bool setNoDelay(const int descriptor)
+    {
+        int enabled = 1;
+        return setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled)) == 0;
+    }
+
+    /**
+     * Only wakes accept() for a new connection once its first data has arrived, or once the provided amount of seconds have passed.
+     */
+    bool setDeferAccept(const int listeningSocket, const int seconds)
+    {
+        return setsockopt(listeningSocket, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) == 0;
+    }
+
+    /**
+     * While corked the socket only sends full segments, uncorking sends whatever is left immediately.
+     */
+    bool setCork(const int descriptor, const bool corked)
+    {
+        int enabled = corked ? 1 : 0;
+        return setsockopt(descriptor, IPPROTO_TCP, TCP_CORK, &enabled, sizeof(enabled)) == 0;
+    }
+
+    /**
+     * While enabled the kernel may coalesce datagrams from the same sender into a single larger read, reporting the size they are split at.
+     */
+    bool setUDPGRO(const int descriptor, const bool enabled)
+    {
+        int value = enabled ? 1 : 0;
+        return setsockopt(descriptor, SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0;
+    }
+
+    /**
+     * Returns false only if the kernel reports UDP_GRO as disabled. Older kernels can enable it but not report it, so it is assumed to be
+     * enabled when it cannot be read, a reader then never sizes its buffers too small for a coalesced read.
+     */
+    bool isUDPGROEnabled(const int descriptor)
+    {
+        int value = 0;
+        socklen_t size = sizeof(value);
+        return getsockopt(descriptor, SOL_UDP, UDP_GRO, &value, &size) != 0 || value != 0;
+    }
+
+    /**
+     * Returns whether the kernel accepts UDP_SEGMENT on the provided socket, setting a segment size of 0 leaves its sends unsegmented.
+     */
+    bool isUDPGSOSupported(const int descriptor)
+    {
+        int segmentSize = 0;
+        return setsockopt(descriptor, SOL_UDP, UDP_SEGMENT, &segmentSize, sizeof(segmentSize)) == 0;
+    }
+
+    /**
+     * Creates another UDP socket bound to the same address as the provided socket using SO_REUSEPORT, so the kernel distributes incoming
+     * datagrams between them by their source and destination. SO_REUSEPORT is also enabled on the provided socket, and UDP_GRO is enabled
+     * on the new socket if it is enabled on the provided one.
+     */
+    std::optional<int> setUpReusePortUDPSocket(const int existingSocket)
+    {
+        const int enabled = 1;
+        kt::SocketAddress address{};
+        socklen_t addressLength = sizeof(address);
+        if (setsockopt(existingSocket, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) != 0
+            || getsockname(existingSocket, &address.address, &addressLength) != 0)
+        {
+            return std::nullopt;
+        }
+
+        int descriptor = socket(address.address.sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (descriptor == -1)
+        {
             return std::nullopt;
         }
+
+        if (setsockopt(descriptor, SOL_SOCKET, SO_REUSEPORT, &enabled, sizeof(enabled)) != 0
+            || bind(descriptor, &address.address, addressLength) != 0)
+        {
+            close(descriptor);
+            return std::nullopt;
+        }
+        if (isUDPGROEnabled(existingSocket))
+        {
+            setUDPGRO(descriptor, true);
+        }
+        return std::make_optional(descriptor);
+    }
+
+    /**
+     * Attaches a program to the provided socket's SO_REUSEPORT group that picks the socket by the CPU a datagram is received on, modulo
+     * the provided amount of sockets in the group, instead of by a hash of its addresses.
+     */
+    bool setReusePortCPUSteering(const int descriptor, const size_t socketCount)
+    {
+        sock_filter code[] = {
+            { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+            { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(socketCount) },
+            { BPF_RET | BPF_A, 0, 0, 0 }
+        };
+        sock_fprog program{ static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+        return socketCount > 0 && setsockopt(descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
     }
 
     std::optional<kt::UDPSocket> setUpUDPSocket(std::optional<std::string> defaultPort)
@@ -44,7 +226,7 @@ namespace forwarder
 
         if (!udpPort.has_value() && !defaultPort.has_value())
         {
-            std::cout << "Skipping UDP socket creation since value for [" + forwarder::UDP_PORT + "] was not provided." << std::endl;
+            logInfo("Skipping UDP socket creation since value for [", forwarder::UDP_PORT, "] was not provided.");
             return std::nullopt;
         }
 
@@ -56,19 +238,23 @@ namespace forwarder
             kt::UDPSocket udpSocket;
             if (!udpSocket.bind(getEnvironmentVariableValueOrDefault(HOST_ADDRESS, HOST_ADDRESS_DEFAULT), portNumber).first)
             {
-                std::cout << "[UDP] - Failed to bind to provided port [" << portNumber << "].\n";
+                logWarning("[UDP] - Failed to bind to provided port [", portNumber, "].");
                 return std::nullopt;
             }
+            if (!getEnvironmentVariableValue(UDP_DISABLE_OFFLOAD).has_value() && !setUDPGRO(udpSocket.getListeningSocket(), true))
+            {
+                logInfo("[UDP] - UDP_GRO is not supported, datagrams will be received one at a time.");
+            }
             return std::make_optional(udpSocket);
         }
         catch(const kt::BindingException e)
         {
-            std::cout << "[UDP] - Failed to bind UDP socket on port: [" << portNumber << "]. " << e.what() << std::endl;
+            logWarning("[UDP] - Failed to bind UDP socket on port: [", portNumber, "]. ", e.what());
             return std::nullopt;
         }
         catch (const kt::SocketException e)
         {
-            std::cout << "[UDP] - Failed to create UDP socket: " << e.what() << std::endl;
+            logWarning("[UDP] - Failed to create UDP socket: ", e.what());
             return std::nullopt;
         }
     }
@@ -90,13 +276,13 @@ namespace forwarder
             }
             else if (parts.size() < 3)
             {
-                std::cout << "[TCP] - Unable to add address [" << s << "], expected format to be \"<groupId>:<address>:<port number>\"." << std::endl;
+                logWarning("[TCP] - Unable to add address [", s, "], expected format to be \"<groupId>:<address>:<port number>\".");
             }
             else
             {
                 if (parts.size() > 3)
                 {
-                    std::cout << "[TCP] - Multiple ':' provided in address string [" << s << "]. Attempting to parse and add address to group [" << parts[0] << "] using second and third elements as the address [" << parts[1] << ", " << parts[2] << "]." << std::endl;
+                    logWarning("[TCP] - Multiple ':' provided in address string [", s, "]. Attempting to parse and add address to group [", parts[0], "] using second and third elements as the address [", parts[1], ", ", parts[2], "].");
                 }
 
                 unsigned short portNumber = static_cast<unsigned short>(std::atoi(parts[2].c_str()));
@@ -104,12 +290,12 @@ namespace forwarder
                 std::pair<std::vector<kt::SocketAddress>, int> resolvedAddresses = kt::resolveToAddresses(parts[1], portNumber, info);
                 if (resolvedAddresses.first.empty())
                 {
-                    std::cout << "[TCP] - Failed to resolve address [" << parts[1] << ":" << portNumber << "]. Address will not be added to TCP group [" << parts[0] << "]." << std::endl;
+                    logWarning("[TCP] - Failed to resolve address [", parts[1], ":", portNumber, "]. Address will not be added to TCP group [", parts[0], "].");
                 }
                 else
                 {
                     kt::SocketAddress addr = resolvedAddresses.first.at(0);
-                    std::cout << "[TCP] - Resolved and added pre-configured address [" << kt::getAddress(addr).value_or("") + ":" + std::to_string(kt::getPortNumber(addr)) << "] to group [" << parts[0] << "]." << std::endl;
+                    logInfo("[TCP] - Resolved and added pre-configured address [", kt::getAddress(addr).value_or(""), ":", kt::getPortNumber(addr), "] to group [", parts[0], "].");
 
                     if (addresses.find(parts[0]) == addresses.end())
                     {
@@ -128,11 +314,12 @@ namespace forwarder
     }
 
     /**
-     * Expected format for UDP connections is "<address>:<port>,<address2>:<port2>".
+     * Expected format for UDP connections is "<groupID>:<address>:<port>,<groupID2>:<address2>:<port2>", the same as for TCP.
+     * Entries without a group ID, "<address>:<port>", are added to the default group.
      */
-    std::vector<kt::SocketAddress> getPreconfiguredUDPAddresses(const std::string defaultValue)
+    std::unordered_map<std::string, std::vector<kt::SocketAddress>> getPreconfiguredUDPAddresses(const std::string defaultValue)
     {
-        std::vector<kt::SocketAddress> addresses;
+        std::unordered_map<std::string, std::vector<kt::SocketAddress>> addresses;
         std::vector<std::string> addressStrings = split(getEnvironmentVariableValueOrDefault(PRECONFIG_UDP_ADDRESSES, defaultValue), ",");
 
         for (const std::string& s : addressStrings)
@@ -144,27 +331,31 @@ namespace forwarder
             }
             else if (parts.size() < 2)
             {
-                std::cout << "[UDP] - Unable to add address [" << s << "], expected format to be \"<address>:<port number>\"." << std::endl;
+                logWarning("[UDP] - Unable to add address [", s, "], expected format to be \"<groupId>:<address>:<port number>\" or \"<address>:<port number>\".");
             }
             else
             {
-                if (parts.size() > 2)
+                if (parts.size() == 2)
+                {
+                    parts.insert(parts.begin(), "");
+                }
+                else if (parts.size() > 3)
                 {
-                    std::cout << "[UDP] - Multiple ':' provided in address string [" << s << "]. Attempting to parse as address using first two elements [" << parts[0] << ", " << parts[1] << "]." << std::endl;
+                    logWarning("[UDP] - Multiple ':' provided in address string [", s, "]. Attempting to parse and add address to group [", parts[0], "] using second and third elements as the address [", parts[1], ", ", parts[2], "].");
                 }
 
-                unsigned short portNumber = static_cast<unsigned short>(std::atoi(parts[1].c_str()));
+                unsigned short portNumber = static_cast<unsigned short>(std::atoi(parts[2].c_str()));
                 addrinfo info = kt::createUdpHints();
-                std::pair<std::vector<kt::SocketAddress>, int> resolvedAddresses = kt::resolveToAddresses(parts[0], portNumber, info);
+                std::pair<std::vector<kt::SocketAddress>, int> resolvedAddresses = kt::resolveToAddresses(parts[1], portNumber, info);
                 if (resolvedAddresses.first.empty())
                 {
-                    std::cout << "[UDP] - Failed to resolve address [" << parts[0] << ":" << portNumber << "]. Address will not be added to UDP group." << std::endl;
+                    logWarning("[UDP] - Failed to resolve address [", parts[1], ":", portNumber, "]. Address will not be added to UDP group [", parts[0], "].");
                 }
                 else
                 {
                     kt::SocketAddress addr = resolvedAddresses.first.at(0);
-                    std::cout << "[UDP] - Resolved and added pre-configured address [" << kt::getAddress(addr).value_or("") + ":" + std::to_string(kt::getPortNumber(addr)) << "] to UDP group." << std::endl;
-                    addresses.push_back(addr);
+                    logInfo("[UDP] - Resolved and added pre-configured address [", kt::getAddress(addr).value_or(""), ":", kt::getPortNumber(addr), "] to UDP group [", parts[0], "].");
+                    addresses[parts[0]].push_back(addr);
                 }
             }
         }
@@ -5,17 +5,42 @@
 #include <vector>
 
 #include <serversocket/ServerSocket.h>
+#include <socket/TCPSocket.h>
 #include <socket/UDPSocket.h>
 
 namespace forwarder
 {
     std::optional<kt::ServerSocket> setUpTcpServerSocket(std::optional<std::string> = std::nullopt);
 
+    std::optional<int> setUpReusePortTCPListener(const int);
+
+    std::optional<kt::TCPSocket> acceptTCPConnection(const int);
+
+    std::optional<kt::TCPSocket> wrapTCPConnection(const int);
+
+    bool setNonBlocking(const int);
+
+    bool setNoDelay(const int);
+
+    bool setCork(const int, const bool);
+
+    bool setDeferAccept(const int, const int);
+
+    bool setUDPGRO(const int, const bool);
+
+    bool isUDPGROEnabled(const int);
+
+    bool isUDPGSOSupported(const int);
+
+    std::optional<int> setUpReusePortUDPSocket(const int);
+
+    bool setReusePortCPUSteering(const int, const size_t);
+
     std::optional<kt::UDPSocket> setUpUDPSocket(std::optional<std::string> = std::nullopt);
 
     std::unordered_map<std::string, std::vector<kt::SocketAddress>> getPreconfiguredTCPAddresses(const std::string = "");
 
-    std::vector<kt::SocketAddress> getPreconfiguredUDPAddresses(const std::string = "");
+    std::unordered_map<std::string, std::vector<kt::SocketAddress>> getPreconfiguredUDPAddresses(const std::string = "");
 
     std::vector<std::string> split(const std::string&, const std::string&);
 }
@@ -0,0 +1,164 @@
+#include "Tracer.h"
+
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace forwarder
+{
+    const unsigned TRACE_THREAD_INDEX_SHIFT = 48;
+    const uint64_t TRACE_SEQUENCE_MASK = (uint64_t(1) << TRACE_THREAD_INDEX_SHIFT) - 1;
+
+    // Thread indexes start at 1 so that a trace ID is never 0
+    static std::atomic<uint64_t> nextThreadIndex{ 1 };
+
+    thread_local Tracer::ThreadState Tracer::threadState{};
+
+    std::string traceEventTypeToString(const TraceEventType type)
+    {
+        switch (type)
+        {
+            case TraceEventType::Receive:
+                return "receive";
+            case TraceEventType::Send:
+                return "send";
+            case TraceEventType::Drop:
+                return "drop";
+        }
+        return "unknown";
+    }
+
+    std::string traceIdToString(const uint64_t traceId)
+    {
+        std::ostringstream stream;
+        stream << std::hex << std::setw(16) << std::setfill('0') << traceId;
+        return stream.str();
+    }
+
+    /**
+     * Creates a tracer that samples one in every sampleRate messages, 0 disables sampling unless it is forced.
+     * The capacity is rounded up to a power of two, and is at most TRACE_BUFFER_SIZE_MAX.
+     */
+    Tracer::Tracer(const uint64_t rate, const size_t requestedCapacity) : sampleRate(rate), capacity(1)
+    {
+        while (capacity < std::min(requestedCapacity, TRACE_BUFFER_SIZE_MAX))
+        {
+            capacity <<= 1;
+        }
+        slots = std::make_unique<Slot[]>(capacity);
+    }
+
+    uint64_t Tracer::nextTraceId()
+    {
+        ThreadState& state = threadState;
+        if (state.index == 0)
+        {
+            state.index = nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        }
+        state.untilSample = sampleRate != 0 ? sampleRate - 1 : 0;
+        state.sequence++;
+        return (state.index << TRACE_THREAD_INDEX_SHIFT) | (state.sequence & TRACE_SEQUENCE_MASK);
+    }
+
+    void Tracer::write(const uint64_t traceId, const TraceEventType type, const int descriptor, const size_t size)
+    {
+        const uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[index & (capacity - 1)];
+        const uint64_t timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+        // An odd sequence marks the slot as being written, the even sequence published afterwards identifies which event the slot holds.
+        // Writers a lap apart can reach the same slot at once, so the slot is claimed before it is written and events are never mixed together.
+        // The event of a writer that is lapped before claiming its slot is already outside the window and is not written.
+        uint64_t current = slot.sequence.load(std::memory_order_relaxed);
+        while (true)
+        {
+            if (current > index * 2)
+            {
+                return;
+            }
+            if ((current & 1) != 0)
+            {
+                // The previous lap's writer is still writing, which only takes a few stores
+                current = slot.sequence.load(std::memory_order_relaxed);
+            }
+            else if (slot.sequence.compare_exchange_weak(current, index * 2 + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.traceId.store(traceId, std::memory_order_relaxed);
+        slot.timestampNanos.store(timestamp, std::memory_order_relaxed);
+        slot.type.store(static_cast<uint32_t>(type), std::memory_order_relaxed);
+        slot.descriptor.store(descriptor, std::memory_order_relaxed);
+        slot.size.store(size, std::memory_order_relaxed);
+        slot.sequence.store(index * 2 + 2, std::memory_order_release);
+    }
+
+    /**
+     * Returns a copy of the events currently held by the ring, oldest first.
+     * Events that are being written, or are overwritten while they are copied, are left out.
+     */
+    std::vector<TraceEvent> Tracer::snapshot() const
+    {
+        const uint64_t end = head.load(std::memory_order_acquire);
+        const uint64_t begin = end > capacity ? end - capacity : 0;
+
+        std::vector<TraceEvent> events;
+        events.reserve(static_cast<size_t>(end - begin));
+        for (uint64_t index = begin; index < end; index++)
+        {
+            const Slot& slot = slots[index & (capacity - 1)];
+            const uint64_t expected = index * 2 + 2;
+            if (slot.sequence.load(std::memory_order_acquire) != expected)
+            {
+                continue;
+            }
+
+            TraceEvent event;
+            event.traceId = slot.traceId.load(std::memory_order_relaxed);
+            event.timestampNanos = slot.timestampNanos.load(std::memory_order_relaxed);
+            event.type = static_cast<TraceEventType>(slot.type.load(std::memory_order_relaxed));
+            event.descriptor = slot.descriptor.load(std::memory_order_relaxed);
+            event.size = static_cast<size_t>(slot.size.load(std::memory_order_relaxed));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == expected)
+            {
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+
+    void Tracer::dump(std::ostream& stream) const
+    {
+        std::vector<TraceEvent> events = snapshot();
+        stream << "[TRACE] - Dumping [" << events.size() << "] trace event(s).\n";
+        for (const TraceEvent& event : events)
+        {
+            stream << "[TRACE - " << traceIdToString(event.traceId) << "] - [" << event.timestampNanos << "ns] [" << traceEventTypeToString(event.type)
+                << "] descriptor [" << event.descriptor << "] size [" << event.size << "]\n";
+        }
+        stream << std::flush;
+    }
+
+    uint64_t Tracer::getSampleRate() const
+    {
+        return sampleRate;
+    }
+
+    size_t Tracer::getCapacity() const
+    {
+        return capacity;
+    }
+
+    /**
+     * Returns the number of events recorded since the tracer was created, including those that have since been overwritten.
+     */
+    uint64_t Tracer::getRecordedCount() const
+    {
+        return head.load(std::memory_order_relaxed);
+    }
+}
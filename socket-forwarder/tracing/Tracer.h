@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+namespace forwarder
+{
+    const size_t TRACE_BUFFER_SIZE_DEFAULT = 65536;
+    const size_t TRACE_BUFFER_SIZE_MAX = 4194304;
+
+    enum class TraceEventType : uint32_t
+    {
+        Receive,
+        Send,
+        Drop
+    };
+
+    std::string traceEventTypeToString(const TraceEventType);
+    std::string traceIdToString(const uint64_t);
+
+    struct TraceEvent
+    {
+        uint64_t traceId = 0;
+        uint64_t timestampNanos = 0;
+        TraceEventType type = TraceEventType::Receive;
+        // The socket the message was received from or sent to, -1 if the sending socket is not known
+        int descriptor = -1;
+        size_t size = 0;
+    };
+
+    /**
+     * Records the receive, send and drop events of a sample of the forwarded messages into a fixed size ring that overwrites its oldest events.
+     *
+     * A message is sampled by calling sample() once when it is received, which returns its trace ID or 0 if it was not sampled.
+     * Trace IDs hold the index of the thread that sampled them in the top 16 bits and a per thread sequence in the rest, so they increase
+     * monotonically per thread and never need to be coordinated between threads. Deciding not to sample a message only counts down a thread local.
+     *
+     * Any number of threads may record concurrently, and snapshot() may be called from any thread while they do.
+     */
+    class Tracer
+    {
+    protected:
+        // Each slot is guarded by its own sequence so readers can detect, and skip, an event that is overwritten while they copy it
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{ 0 };
+            std::atomic<uint64_t> traceId{ 0 };
+            std::atomic<uint64_t> timestampNanos{ 0 };
+            std::atomic<uint32_t> type{ 0 };
+            std::atomic<int> descriptor{ -1 };
+            std::atomic<uint64_t> size{ 0 };
+        };
+
+        struct ThreadState
+        {
+            uint64_t index;
+            uint64_t sequence;
+            uint64_t untilSample;
+        };
+
+        static thread_local ThreadState threadState;
+
+        uint64_t sampleRate;
+        size_t capacity;
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<uint64_t> head{ 0 };
+
+        uint64_t nextTraceId();
+        void write(const uint64_t, const TraceEventType, const int, const size_t);
+
+    public:
+        Tracer(const uint64_t = 0, const size_t = TRACE_BUFFER_SIZE_DEFAULT);
+
+        /**
+         * Returns the trace ID of a newly received message, or 0 if the message is not sampled.
+         * One in every sampleRate messages received by a thread is sampled, or every message when forced.
+         */
+        inline uint64_t sample(const bool force = false)
+        {
+            if (force || (sampleRate != 0 && --threadState.untilSample >= sampleRate))
+            {
+                return nextTraceId();
+            }
+            return 0;
+        }
+
+        /**
+         * Records an event for a sampled message. Events for a trace ID of 0, messages that were not sampled, are ignored.
+         */
+        inline void record(const uint64_t traceId, const TraceEventType type, const int descriptor, const size_t size)
+        {
+            if (traceId != 0)
+            {
+                write(traceId, type, descriptor, size);
+            }
+        }
+
+        std::vector<TraceEvent> snapshot() const;
+        void dump(std::ostream&) const;
+
+        uint64_t getSampleRate() const;
+        size_t getCapacity() const;
+        uint64_t getRecordedCount() const;
+    };
+}
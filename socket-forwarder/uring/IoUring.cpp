@@ -0,0 +1,368 @@
+#include "IoUring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace forwarder
+{
+    static int setupRing(const unsigned entries, io_uring_params* params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    /**
+     * Creates the ring with the provided amount of submission entries, the completion queue is sized to hold 4 completions per submission
+     * since every multishot operation produces many completions.
+     */
+    bool IoUring::open(const unsigned entries)
+    {
+        io_uring_params params{};
+        // Task work only runs when this thread waits for completions, which avoids interrupting the worker while it is forwarding
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+        params.cq_entries = entries * 4;
+        ringDescriptor = setupRing(entries, &params);
+        if (ringDescriptor < 0 && errno == EINVAL)
+        {
+            // Kernels older than 6.1 do not support deferred task work
+            params = io_uring_params{};
+            params.flags = IORING_SETUP_CQSIZE;
+            params.cq_entries = entries * 4;
+            ringDescriptor = setupRing(entries, &params);
+        }
+        if (ringDescriptor < 0)
+        {
+            ringDescriptor = -1;
+            return false;
+        }
+        setupFlags = params.flags;
+
+        submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+        {
+            submissionRingSize = completionRingSize = std::max(submissionRingSize, completionRingSize);
+        }
+
+        submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQ_RING);
+        completionRing = singleMap ? submissionRing : mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_CQ_RING);
+        submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+        submissionEntries = static_cast<io_uring_sqe*>(mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES));
+        if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED || submissionEntries == MAP_FAILED)
+        {
+            submissionRing = submissionRing == MAP_FAILED ? nullptr : submissionRing;
+            completionRing = completionRing == MAP_FAILED ? nullptr : completionRing;
+            submissionEntries = submissionEntries == MAP_FAILED ? nullptr : submissionEntries;
+            close();
+            return false;
+        }
+
+        char* submissionBase = static_cast<char*>(submissionRing);
+        submissionHead = reinterpret_cast<unsigned*>(submissionBase + params.sq_off.head);
+        submissionTail = reinterpret_cast<unsigned*>(submissionBase + params.sq_off.tail);
+        submissionMask = *reinterpret_cast<unsigned*>(submissionBase + params.sq_off.ring_mask);
+        submissionEntryCount = params.sq_entries;
+        preparedTail = *submissionTail;
+
+        // Submission entries are always used in ring order, so the indirection array is set up once as an identity mapping
+        unsigned* submissionArray = reinterpret_cast<unsigned*>(submissionBase + params.sq_off.array);
+        for (unsigned i = 0; i < params.sq_entries; i++)
+        {
+            submissionArray[i] = i;
+        }
+
+        char* completionBase = static_cast<char*>(completionRing);
+        completionHead = reinterpret_cast<unsigned*>(completionBase + params.cq_off.head);
+        completionTail = reinterpret_cast<unsigned*>(completionBase + params.cq_off.tail);
+        completionMask = *reinterpret_cast<unsigned*>(completionBase + params.cq_off.ring_mask);
+        completionEntries = reinterpret_cast<io_uring_cqe*>(completionBase + params.cq_off.cqes);
+        return true;
+    }
+
+    bool IoUring::isOpen() const
+    {
+        return ringDescriptor != -1;
+    }
+
+    /**
+     * Returns a cleared submission entry, submitting the already prepared entries first if the submission queue is full.
+     * Returns nullptr if the queue is still full after submitting.
+     */
+    io_uring_sqe* IoUring::getSubmission()
+    {
+        if (preparedTail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE) >= submissionEntryCount)
+        {
+            submit();
+            if (preparedTail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE) >= submissionEntryCount)
+            {
+                return nullptr;
+            }
+        }
+
+        io_uring_sqe* entry = &submissionEntries[preparedTail & submissionMask];
+        std::memset(entry, 0, sizeof(io_uring_sqe));
+        preparedTail++;
+        return entry;
+    }
+
+    /**
+     * Accepts connections from the listening socket, a multishot accept keeps posting a completion for every accepted connection.
+     */
+    bool IoUring::prepareAccept(const int listeningSocket, const bool multishot, const uint64_t userData)
+    {
+        io_uring_sqe* entry = getSubmission();
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        entry->opcode = IORING_OP_ACCEPT;
+        entry->fd = listeningSocket;
+        entry->accept_flags = SOCK_CLOEXEC;
+        entry->ioprio = multishot ? IORING_ACCEPT_MULTISHOT : 0;
+        entry->user_data = userData;
+        return true;
+    }
+
+    /**
+     * Receives into a buffer picked from the provided buffer ring, the buffer ID is reported in the upper 16 bits of the completion flags.
+     * A multishot receive keeps posting a completion for every read until it fails, the socket is closed or the buffer ring runs out of buffers.
+     */
+    bool IoUring::prepareReceive(const int socket, const uint16_t bufferGroup, const bool multishot, const uint64_t userData)
+    {
+        io_uring_sqe* entry = getSubmission();
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        entry->opcode = IORING_OP_RECV;
+        entry->fd = socket;
+        entry->flags = IOSQE_BUFFER_SELECT;
+        entry->buf_group = bufferGroup;
+        entry->ioprio = multishot ? IORING_RECV_MULTISHOT : 0;
+        entry->user_data = userData;
+        return true;
+    }
+
+    /**
+     * Like prepareReceive(), but each buffer starts with an io_uring_recvmsg_out header followed by the sender's address and the payload.
+     * The message header must stay valid until the operation completes, its msg_namelen decides how much space is reserved for the address.
+     */
+    bool IoUring::prepareReceiveMessage(const int socket, msghdr* message, const uint16_t bufferGroup, const bool multishot, const uint64_t userData)
+    {
+        io_uring_sqe* entry = getSubmission();
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        entry->opcode = IORING_OP_RECVMSG;
+        entry->fd = socket;
+        entry->addr = reinterpret_cast<uint64_t>(message);
+        entry->len = 1;
+        entry->flags = IOSQE_BUFFER_SELECT;
+        entry->buf_group = bufferGroup;
+        entry->ioprio = multishot ? IORING_RECV_MULTISHOT : 0;
+        entry->user_data = userData;
+        return true;
+    }
+
+    /**
+     * The message header and everything it points to must stay valid until the operation completes.
+     */
+    bool IoUring::prepareSendMessage(const int socket, const msghdr* message, const int flags, const uint64_t userData)
+    {
+        io_uring_sqe* entry = getSubmission();
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        entry->opcode = IORING_OP_SENDMSG;
+        entry->fd = socket;
+        entry->addr = reinterpret_cast<uint64_t>(message);
+        entry->len = 1;
+        entry->msg_flags = static_cast<uint32_t>(flags);
+        entry->user_data = userData;
+        return true;
+    }
+
+    /**
+     * Sends the buffer to the provided address. The buffer must stay valid until the operation completes, the address is copied when the entry is submitted.
+     */
+    bool IoUring::prepareSendTo(const int socket, const void* buffer, const size_t length, const sockaddr* address, const socklen_t addressLength, const uint64_t userData)
+    {
+        io_uring_sqe* entry = getSubmission();
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        entry->opcode = IORING_OP_SEND;
+        entry->fd = socket;
+        entry->addr = reinterpret_cast<uint64_t>(buffer);
+        entry->len = static_cast<uint32_t>(length);
+        entry->addr2 = reinterpret_cast<uint64_t>(address);
+        entry->addr_len = static_cast<uint16_t>(addressLength);
+        entry->msg_flags = MSG_NOSIGNAL;
+        entry->user_data = userData;
+        return true;
+    }
+
+    bool IoUring::preparePoll(const int descriptor, const uint32_t events, const bool multishot, const uint64_t userData)
+    {
+        io_uring_sqe* entry = getSubmission();
+        if (entry == nullptr)
+        {
+            return false;
+        }
+        entry->opcode = IORING_OP_POLL_ADD;
+        entry->fd = descriptor;
+        entry->poll32_events = events;
+        entry->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+        entry->user_data = userData;
+        return true;
+    }
+
+    /**
+     * Passes every prepared entry to the kernel and waits until at least the provided amount of completions are available,
+     * or the timeout (negative for no timeout) expires. Returns the amount of entries submitted, or -1 with errno set.
+     */
+    int IoUring::submit(const unsigned waitFor, const std::chrono::microseconds timeout)
+    {
+        __atomic_store_n(submissionTail, preparedTail, __ATOMIC_RELEASE);
+        const unsigned toSubmit = preparedTail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+
+        unsigned flags = (waitFor > 0 || (setupFlags & IORING_SETUP_DEFER_TASKRUN) != 0) ? IORING_ENTER_GETEVENTS : 0;
+        io_uring_getevents_arg argument{};
+        __kernel_timespec waitTimeout{};
+        void* argumentPointer = nullptr;
+        size_t argumentSize = 0;
+        if (waitFor > 0 && timeout.count() >= 0)
+        {
+            waitTimeout.tv_sec = timeout.count() / 1000000;
+            waitTimeout.tv_nsec = static_cast<long long>(timeout.count() % 1000000) * 1000;
+            argument.sigmask_sz = _NSIG / 8;
+            argument.ts = reinterpret_cast<uint64_t>(&waitTimeout);
+            argumentPointer = &argument;
+            argumentSize = sizeof(argument);
+            flags |= IORING_ENTER_EXT_ARG;
+        }
+
+        int result = static_cast<int>(syscall(__NR_io_uring_enter, ringDescriptor, toSubmit, waitFor, flags, argumentPointer, argumentSize));
+        if (result < 0 && (errno == ETIME || errno == EINTR))
+        {
+            return 0;
+        }
+        return result;
+    }
+
+    /**
+     * Returns the next completion, or nullptr if there are none. advanceCompletion() must be called once the completion has been handled.
+     */
+    io_uring_cqe* IoUring::peekCompletion()
+    {
+        unsigned head = *completionHead;
+        if (head == __atomic_load_n(completionTail, __ATOMIC_ACQUIRE))
+        {
+            return nullptr;
+        }
+        return &completionEntries[head & completionMask];
+    }
+
+    void IoUring::advanceCompletion()
+    {
+        __atomic_store_n(completionHead, *completionHead + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Registers a ring of provided buffers under the provided group ID, the amount of entries must be a power of 2.
+     * The ring starts empty, buffers are added with provideBuffer() and made visible to the kernel with commitBuffers().
+     */
+    bool IoUring::registerBufferRing(const uint16_t bufferGroup, const unsigned entries)
+    {
+        bufferRingSize = entries * sizeof(io_uring_buf);
+        void* memory = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            return false;
+        }
+
+        io_uring_buf_reg registration{};
+        registration.ring_addr = reinterpret_cast<uint64_t>(memory);
+        registration.ring_entries = entries;
+        registration.bgid = bufferGroup;
+        if (syscall(__NR_io_uring_register, ringDescriptor, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+        {
+            munmap(memory, bufferRingSize);
+            return false;
+        }
+
+        bufferRing = static_cast<io_uring_buf_ring*>(memory);
+        bufferRingMask = entries - 1;
+        bufferRingTail = 0;
+        return true;
+    }
+
+    void IoUring::provideBuffer(void* address, const unsigned length, const uint16_t bufferId)
+    {
+        // Not using bufferRing->bufs, in C++ the kernel header's flexible array follows an empty struct that takes up space, so it is not at the start of the ring
+        io_uring_buf* buffer = reinterpret_cast<io_uring_buf*>(bufferRing) + (bufferRingTail & bufferRingMask);
+        buffer->addr = reinterpret_cast<uint64_t>(address);
+        buffer->len = length;
+        buffer->bid = bufferId;
+        bufferRingTail++;
+    }
+
+    void IoUring::commitBuffers()
+    {
+        __atomic_store_n(&bufferRing->tail, bufferRingTail, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Closing the ring cancels every operation that is still in flight.
+     */
+    void IoUring::close()
+    {
+        if (submissionEntries != nullptr)
+        {
+            munmap(submissionEntries, submissionEntriesSize);
+        }
+        if (completionRing != nullptr && completionRing != submissionRing)
+        {
+            munmap(completionRing, completionRingSize);
+        }
+        if (submissionRing != nullptr)
+        {
+            munmap(submissionRing, submissionRingSize);
+        }
+        if (ringDescriptor != -1)
+        {
+            ::close(ringDescriptor);
+        }
+        // The buffer ring is unregistered when the ring is closed
+        if (bufferRing != nullptr)
+        {
+            munmap(bufferRing, bufferRingSize);
+        }
+
+        ringDescriptor = -1;
+        submissionRing = nullptr;
+        completionRing = nullptr;
+        submissionEntries = nullptr;
+        bufferRing = nullptr;
+    }
+
+    /**
+     * Checks whether io_uring can be used, it may be missing from the kernel or disabled by a sysctl or seccomp policy.
+     */
+    bool isIoUringSupported()
+    {
+        IoUring ring;
+        bool supported = ring.open(2);
+        ring.close();
+        return supported;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+namespace forwarder
+{
+    /**
+     * A minimal wrapper around an io_uring instance using the raw system calls, along with a single ring of provided buffers
+     * that multishot receives pick their buffers from.
+     *
+     * Submissions are only queued by the prepare methods, nothing is passed to the kernel until submit() is called, so every operation prepared
+     * while handling a batch of completions is submitted with a single system call. The ring must only be used by the thread that opened it.
+     *
+     * Like the kt socket types, this is a handle to the underlying ring, close() must be called explicitly to release it.
+     */
+    class IoUring
+    {
+    protected:
+        int ringDescriptor = -1;
+        unsigned setupFlags = 0;
+
+        void* submissionRing = nullptr;
+        size_t submissionRingSize = 0;
+        void* completionRing = nullptr;
+        size_t completionRingSize = 0;
+        io_uring_sqe* submissionEntries = nullptr;
+        size_t submissionEntriesSize = 0;
+
+        unsigned* submissionHead = nullptr;
+        unsigned* submissionTail = nullptr;
+        unsigned submissionMask = 0;
+        unsigned submissionEntryCount = 0;
+        // The tail including entries that have been prepared but not yet published to the kernel
+        unsigned preparedTail = 0;
+
+        unsigned* completionHead = nullptr;
+        unsigned* completionTail = nullptr;
+        unsigned completionMask = 0;
+        io_uring_cqe* completionEntries = nullptr;
+
+        io_uring_buf_ring* bufferRing = nullptr;
+        size_t bufferRingSize = 0;
+        unsigned bufferRingMask = 0;
+        uint16_t bufferRingTail = 0;
+
+        io_uring_sqe* getSubmission();
+
+    public:
+        bool open(const unsigned);
+        bool isOpen() const;
+
+        bool prepareAccept(const int, const bool, const uint64_t);
+        bool prepareReceive(const int, const uint16_t, const bool, const uint64_t);
+        bool prepareReceiveMessage(const int, msghdr*, const uint16_t, const bool, const uint64_t);
+        bool prepareSendMessage(const int, const msghdr*, const int, const uint64_t);
+        bool prepareSendTo(const int, const void*, const size_t, const sockaddr*, const socklen_t, const uint64_t);
+        bool preparePoll(const int, const uint32_t, const bool, const uint64_t);
+
+        int submit(const unsigned = 0, const std::chrono::microseconds = std::chrono::microseconds(-1));
+        io_uring_cqe* peekCompletion();
+        void advanceCompletion();
+
+        bool registerBufferRing(const uint16_t, const unsigned);
+        void provideBuffer(void*, const unsigned, const uint16_t);
+        void commitBuffers();
+
+        void close();
+    };
+
+    bool isIoUringSupported();
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <socket/UDPSocket.h>
+
+#include "../../../socket-forwarder/buffer/DatagramBatch.h"
+#include "../../../socket-forwarder/sockets/Sockets.h"
+
+namespace forwarder
+{
+    class DatagramBatchTest : public ::testing::Test
+    {
+    protected:
+        kt::UDPSocket receiver;
+        kt::UDPSocket sender;
+
+    protected:
+        void SetUp() override
+        {
+            receiver.bind();
+            sender.bind();
+        }
+
+        void TearDown() override
+        {
+            receiver.close();
+            sender.close();
+        }
+
+        kt::SocketAddress loopback(const unsigned short port)
+        {
+            kt::SocketAddress address{};
+            address.ipv4.sin_family = AF_INET;
+            address.ipv4.sin_port = htons(port);
+            address.ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return address;
+        }
+
+        void send(const std::string& message)
+        {
+            sender.sendTo("localhost", receiver.getListeningPort().value(), message);
+        }
+    };
+
+    TEST_F(DatagramBatchTest, Receive_ReadsQueuedDatagramsInOneCall)
+    {
+        DatagramReceiveBatch batch(8, 64);
+        send("first");
+        send("second");
+        send("third");
+        ASSERT_TRUE(receiver.ready());
+
+        ASSERT_EQ(3, batch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ("first", std::string(batch.data(0), batch.size(0)));
+        ASSERT_EQ("second", std::string(batch.data(1), batch.size(1)));
+        ASSERT_EQ("third", std::string(batch.data(2), batch.size(2)));
+        ASSERT_NE(0, kt::getPortNumber(batch.address(0)));
+        ASSERT_FALSE(batch.truncated(0));
+
+        // Nothing is left queued, so the next receive does not block
+        ASSERT_EQ(-1, batch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ(EAGAIN, errno);
+    }
+
+    TEST_F(DatagramBatchTest, Receive_StopsAtCapacity)
+    {
+        DatagramReceiveBatch batch(2, 64);
+        send("1");
+        send("2");
+        send("3");
+        ASSERT_TRUE(receiver.ready());
+
+        ASSERT_EQ(2, batch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ(1, batch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ("3", std::string(batch.data(0), batch.size(0)));
+    }
+
+    TEST_F(DatagramBatchTest, Receive_TruncatesLargeDatagrams)
+    {
+        DatagramReceiveBatch batch(1, 4);
+        send("truncated");
+        ASSERT_TRUE(receiver.ready());
+
+        ASSERT_EQ(1, batch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ("trun", std::string(batch.data(0), batch.size(0)));
+        ASSERT_TRUE(batch.truncated(0));
+    }
+
+    TEST_F(DatagramBatchTest, Send_SharesPayloadAcrossPeers)
+    {
+        kt::UDPSocket secondReceiver;
+        secondReceiver.bind();
+        kt::SocketAddress first = loopback(receiver.getListeningPort().value());
+        kt::SocketAddress second = loopback(secondReceiver.getListeningPort().value());
+
+        std::string message = "shared";
+        iovec payload{ message.data(), message.size() };
+        DatagramSendBatch batch(2);
+        ASSERT_TRUE(batch.add(&payload, first, 7));
+        ASSERT_TRUE(batch.add(&payload, second, 7));
+        ASSERT_TRUE(batch.full());
+        ASSERT_FALSE(batch.add(&payload, second, 8));
+
+        const int descriptor = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_EQ(2, batch.send(descriptor));
+        ASSERT_EQ(0, batch.remaining());
+        ASSERT_TRUE(batch.sent(0));
+        ASSERT_TRUE(batch.sent(1));
+        ASSERT_EQ(7, batch.tag(1));
+        ASSERT_EQ(secondReceiver.getListeningPort().value(), kt::getPortNumber(batch.address(1)));
+
+        ASSERT_TRUE(receiver.ready());
+        ASSERT_EQ(message, receiver.receiveFrom(64).first.value());
+        ASSERT_TRUE(secondReceiver.ready());
+        ASSERT_EQ(message, secondReceiver.receiveFrom(64).first.value());
+
+        batch.clear();
+        ASSERT_EQ(0, batch.size());
+        close(descriptor);
+        secondReceiver.close();
+    }
+
+    TEST_F(DatagramBatchTest, Send_SkipsFailedEntry)
+    {
+        kt::SocketAddress reachable = loopback(receiver.getListeningPort().value());
+        // An IPv6 address cannot be sent to through an IPv4 socket
+        kt::SocketAddress unreachable{};
+        unreachable.ipv6.sin6_family = AF_INET6;
+        unreachable.ipv6.sin6_port = htons(receiver.getListeningPort().value());
+        unreachable.ipv6.sin6_addr = in6addr_loopback;
+
+        std::string message = "after";
+        iovec payload{ message.data(), message.size() };
+        DatagramSendBatch batch(2);
+        batch.add(&payload, unreachable, 0);
+        batch.add(&payload, reachable, 1);
+
+        const int descriptor = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_EQ(-1, batch.send(descriptor));
+        ASSERT_EQ(1, batch.completed());
+        ASSERT_FALSE(batch.sent(0));
+        ASSERT_EQ(1, batch.send(descriptor));
+        ASSERT_TRUE(batch.sent(1));
+        ASSERT_EQ(0, batch.remaining());
+
+        ASSERT_TRUE(receiver.ready());
+        ASSERT_EQ(message, receiver.receiveFrom(64).first.value());
+        close(descriptor);
+    }
+
+    TEST_F(DatagramBatchTest, Send_SegmentsRunIntoSeparateDatagrams)
+    {
+        const int descriptor = socket(AF_INET, SOCK_DGRAM, 0);
+        if (!isUDPGSOSupported(descriptor))
+        {
+            close(descriptor);
+            GTEST_SKIP() << "UDP_SEGMENT is not supported on this system.";
+        }
+
+        std::string first = "aaaa";
+        std::string second = "bbbb";
+        std::string last = "cc";
+        iovec payloads[] = { { first.data(), first.size() }, { second.data(), second.size() }, { last.data(), last.size() } };
+        DatagramSendBatch batch(1);
+        ASSERT_TRUE(batch.add(payloads, 3, 4, loopback(receiver.getListeningPort().value()), 5));
+        ASSERT_EQ(3, batch.segments(0));
+        ASSERT_EQ(1, batch.send(descriptor));
+        ASSERT_TRUE(batch.sent(0));
+
+        // The receiver does not have UDP_GRO enabled, so the kernel splits the send back into a datagram per payload
+        DatagramReceiveBatch receiveBatch(8, 64);
+        ASSERT_TRUE(receiver.ready());
+        ASSERT_EQ(3, receiveBatch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ(first, std::string(receiveBatch.data(0), receiveBatch.size(0)));
+        ASSERT_EQ(second, std::string(receiveBatch.data(1), receiveBatch.size(1)));
+        ASSERT_EQ(last, std::string(receiveBatch.data(2), receiveBatch.size(2)));
+        ASSERT_EQ(0, receiveBatch.segmentSize(0));
+        close(descriptor);
+    }
+
+    TEST_F(DatagramBatchTest, Receive_ReportsCoalescedSegmentSize)
+    {
+        const int descriptor = socket(AF_INET, SOCK_DGRAM, 0);
+        if (!isUDPGSOSupported(descriptor) || !setUDPGRO(receiver.getListeningSocket(), true))
+        {
+            close(descriptor);
+            GTEST_SKIP() << "UDP_SEGMENT or UDP_GRO is not supported on this system.";
+        }
+        ASSERT_TRUE(isUDPGROEnabled(receiver.getListeningSocket()));
+
+        std::string first = "aaaa";
+        std::string second = "bbbb";
+        std::string last = "cc";
+        iovec payloads[] = { { first.data(), first.size() }, { second.data(), second.size() }, { last.data(), last.size() } };
+        DatagramSendBatch batch(1);
+        ASSERT_TRUE(batch.add(payloads, 3, 4, loopback(receiver.getListeningPort().value()), 0));
+        ASSERT_EQ(1, batch.send(descriptor));
+
+        // Over loopback a segmented send reaches a UDP_GRO socket still coalesced
+        DatagramReceiveBatch receiveBatch(8, 64);
+        ASSERT_TRUE(receiver.ready());
+        ASSERT_EQ(1, receiveBatch.receive(receiver.getListeningSocket()));
+        ASSERT_EQ(first + second + last, std::string(receiveBatch.data(0), receiveBatch.size(0)));
+        ASSERT_EQ(4, receiveBatch.segmentSize(0));
+        close(descriptor);
+    }
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "../../../socket-forwarder/buffer/DatagramRing.h"
+
+using namespace std::chrono_literals;
+
+namespace forwarder
+{
+    static DatagramPushResult push(DatagramRing& ring, const std::string& message, const uint32_t channel = 0)
+    {
+        kt::SocketAddress address{};
+        address.ipv4.sin_family = AF_INET;
+        address.ipv4.sin_port = htons(12345);
+        return ring.push(message.data(), message.size(), address, std::chrono::steady_clock::now(), channel);
+    }
+
+    static std::string take(DatagramRing& ring)
+    {
+        DatagramSlot* slot = ring.acquire();
+        if (slot == nullptr)
+        {
+            return "";
+        }
+        std::string message(slot->data, slot->size);
+        ring.release(slot);
+        return message;
+    }
+
+    TEST(DatagramRingTest, Constructor_RoundsCapacityUpToPowerOfTwo)
+    {
+        DatagramRing ring(5, 16, OverflowPolicy::DropNewest);
+        ASSERT_EQ(8, ring.capacity());
+        ASSERT_EQ(16, ring.getSlotSize());
+        ASSERT_TRUE(ring.empty());
+    }
+
+    TEST(DatagramRingTest, Push_KeepsDatagramAndAddressInOrder)
+    {
+        DatagramRing ring(4, 16, OverflowPolicy::DropNewest);
+        ASSERT_TRUE(push(ring, "first").queued);
+        ASSERT_TRUE(push(ring, "second", 3).queued);
+
+        DatagramSlot* slot = ring.acquire();
+        ASSERT_NE(nullptr, slot);
+        ASSERT_EQ("first", std::string(slot->data, slot->size));
+        ASSERT_EQ(12345, kt::getPortNumber(slot->address));
+        ASSERT_EQ(0, slot->channel);
+        ring.release(slot);
+        slot = ring.acquire();
+        ASSERT_EQ(3, slot->channel);
+        ASSERT_EQ("second", std::string(slot->data, slot->size));
+        ring.release(slot);
+        ASSERT_EQ(nullptr, ring.acquire());
+    }
+
+    TEST(DatagramRingTest, Push_TruncatesToSlotSize)
+    {
+        DatagramRing ring(2, 4, OverflowPolicy::DropNewest);
+        ASSERT_TRUE(push(ring, "truncated").queued);
+        ASSERT_EQ("trun", take(ring));
+    }
+
+    TEST(DatagramRingTest, Push_DropNewestWhenFull)
+    {
+        DatagramRing ring(2, 16, OverflowPolicy::DropNewest);
+        ASSERT_TRUE(push(ring, "1").queued);
+        ASSERT_TRUE(push(ring, "2").queued);
+
+        DatagramPushResult result = push(ring, "333");
+        ASSERT_FALSE(result.queued);
+        ASSERT_EQ(1, result.droppedMessages);
+        ASSERT_EQ(3, result.droppedBytes);
+        ASSERT_EQ(1, ring.getDroppedMessages());
+        ASSERT_EQ(3, ring.getDroppedBytes());
+        ASSERT_FALSE(result.evicted);
+
+        ASSERT_EQ("1", take(ring));
+        ASSERT_EQ("2", take(ring));
+        ASSERT_TRUE(ring.empty());
+    }
+
+    TEST(DatagramRingTest, Push_DropOldestWhenFull)
+    {
+        DatagramRing ring(2, 16, OverflowPolicy::DropOldest);
+        ASSERT_TRUE(push(ring, "1", 2).queued);
+        ASSERT_TRUE(push(ring, "22").queued);
+
+        // The evicted datagram belongs to another channel than the new one, so its drop is reported against its own channel
+        DatagramPushResult result = push(ring, "3");
+        ASSERT_TRUE(result.queued);
+        ASSERT_EQ(1, result.droppedMessages);
+        ASSERT_EQ(1, result.droppedBytes);
+        ASSERT_TRUE(result.evicted);
+        ASSERT_EQ(2, result.evictedChannel);
+        ASSERT_EQ(1, result.evictedBytes);
+
+        ASSERT_EQ("22", take(ring));
+        ASSERT_EQ("3", take(ring));
+        ASSERT_TRUE(ring.empty());
+    }
+
+    TEST(DatagramRingTest, Push_DropOldestKeepsSlotHeldByConsumer)
+    {
+        DatagramRing ring(2, 16, OverflowPolicy::DropOldest);
+        ASSERT_TRUE(push(ring, "1").queued);
+        ASSERT_TRUE(push(ring, "2").queued);
+        DatagramSlot* held = ring.acquire();
+
+        // The slot the new datagram needs is still being sent from, so the new datagram is dropped rather than overwriting it
+        DatagramPushResult result = push(ring, "3");
+        ASSERT_FALSE(result.queued);
+        ASSERT_EQ(1, result.droppedMessages);
+        ASSERT_EQ("1", std::string(held->data, held->size));
+        ring.release(held);
+
+        ASSERT_TRUE(push(ring, "4").queued);
+        ASSERT_EQ("2", take(ring));
+        ASSERT_EQ("4", take(ring));
+    }
+
+    TEST(DatagramRingTest, Wait_WakesWhenDatagramPushed)
+    {
+        DatagramRing ring(4, 16, OverflowPolicy::DropNewest);
+        ASSERT_FALSE(ring.wait(1ms));
+
+        std::thread producer([&ring]()
+        {
+            std::this_thread::sleep_for(20ms);
+            push(ring, "wake");
+        });
+        ASSERT_TRUE(ring.wait(5s));
+        ASSERT_EQ("wake", take(ring));
+        producer.join();
+    }
+
+    TEST(DatagramRingTest, Push_ConcurrentProducersKeepEveryDatagram)
+    {
+        const size_t producerCount = 4;
+        const size_t messagesPerProducer = 10000;
+        DatagramRing ring(64, 16, OverflowPolicy::DropNewest);
+
+        std::vector<std::thread> producers;
+        for (size_t producer = 0; producer < producerCount; producer++)
+        {
+            producers.emplace_back([&ring, producer, messagesPerProducer]()
+            {
+                for (size_t i = 0; i < messagesPerProducer; i++)
+                {
+                    const std::string message = std::to_string(producer) + ":" + std::to_string(i);
+                    while (!push(ring, message).queued)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::vector<size_t> nextExpected(producerCount, 0);
+        size_t received = 0;
+        while (received < producerCount * messagesPerProducer)
+        {
+            if (!ring.wait(5s))
+            {
+                break;
+            }
+            const std::string message = take(ring);
+            const size_t separator = message.find(':');
+            const size_t producer = std::stoul(message.substr(0, separator));
+            // Each producer's datagrams come out in the order it pushed them
+            ASSERT_EQ(nextExpected[producer], std::stoul(message.substr(separator + 1)));
+            nextExpected[producer]++;
+            received++;
+        }
+        for (std::thread& producer : producers)
+        {
+            producer.join();
+        }
+        ASSERT_EQ(producerCount * messagesPerProducer, received);
+    }
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "../../../socket-forwarder/buffer/MessageBuffer.h"
+
+namespace forwarder
+{
+    TEST(MessageBufferTest, BufferPool_ReleasedBufferIsRecycled)
+    {
+        BufferPool pool(128);
+
+        MessageBuffer* buffer = pool.acquire();
+        ASSERT_EQ(128, buffer->data.size());
+        ASSERT_EQ(1, buffer->references);
+        ASSERT_EQ(1, pool.getAllocatedCount());
+        ASSERT_EQ(0, pool.getAvailableCount());
+
+        pool.release(buffer);
+        ASSERT_EQ(1, pool.getAvailableCount());
+
+        MessageBuffer* recycled = pool.acquire();
+        ASSERT_EQ(buffer, recycled);
+        ASSERT_EQ(1, pool.getAllocatedCount());
+        ASSERT_EQ(0, recycled->size);
+        pool.release(recycled);
+    }
+
+    TEST(MessageBufferTest, BufferPool_RetainedBufferIsNotRecycled)
+    {
+        BufferPool pool(16);
+
+        MessageBuffer* buffer = pool.acquire();
+        pool.retain(buffer);
+        pool.release(buffer);
+        ASSERT_EQ(0, pool.getAvailableCount());
+
+        MessageBuffer* other = pool.acquire();
+        ASSERT_NE(buffer, other);
+        ASSERT_EQ(2, pool.getAllocatedCount());
+
+        pool.release(buffer);
+        pool.release(other);
+        ASSERT_EQ(2, pool.getAvailableCount());
+    }
+
+    TEST(MessageBufferTest, BufferPool_GrownBufferIsShrunkOnRelease)
+    {
+        BufferPool pool(16);
+
+        MessageBuffer* buffer = pool.acquire();
+        buffer->data.resize(4096);
+        pool.release(buffer);
+
+        MessageBuffer* recycled = pool.acquire();
+        ASSERT_EQ(buffer, recycled);
+        ASSERT_EQ(16, recycled->data.size());
+        ASSERT_LT(recycled->data.capacity(), 4096);
+        pool.release(recycled);
+    }
+
+    TEST(MessageBufferTest, ZeroCopyTracker_CompletionReleasesInclusiveRange)
+    {
+        BufferPool pool(16);
+        ZeroCopyTracker tracker;
+
+        MessageBuffer* first = pool.acquire();
+        MessageBuffer* second = pool.acquire();
+        tracker.sent(first, pool);
+        tracker.sent(first, pool);
+        tracker.sent(second, pool);
+        pool.release(first);
+        pool.release(second);
+        ASSERT_EQ(3, tracker.getPendingCount());
+        ASSERT_EQ(0, pool.getAvailableCount());
+
+        // Sequence numbers 0 and 1 belong to the first buffer
+        ASSERT_EQ(2, tracker.complete(0, 1, pool));
+        ASSERT_EQ(1, tracker.getPendingCount());
+        ASSERT_EQ(1, pool.getAvailableCount());
+
+        ASSERT_EQ(1, tracker.complete(2, 2, pool));
+        ASSERT_EQ(0, tracker.getPendingCount());
+        ASSERT_EQ(2, pool.getAvailableCount());
+    }
+
+    TEST(MessageBufferTest, ZeroCopyTracker_OutOfOrderCompletionKeepsEarlierSends)
+    {
+        BufferPool pool(16);
+        ZeroCopyTracker tracker;
+
+        MessageBuffer* first = pool.acquire();
+        MessageBuffer* second = pool.acquire();
+        tracker.sent(first, pool);
+        tracker.sent(second, pool);
+        pool.release(first);
+        pool.release(second);
+
+        // Only the second send has completed, the first buffer may still be read by the kernel
+        ASSERT_EQ(1, tracker.complete(1, 1, pool));
+        ASSERT_EQ(1, tracker.getPendingCount());
+        ASSERT_EQ(1, pool.getAvailableCount());
+
+        ASSERT_EQ(1, tracker.complete(0, 0, pool));
+        ASSERT_EQ(0, tracker.getPendingCount());
+        ASSERT_EQ(2, pool.getAvailableCount());
+    }
+
+    TEST(MessageBufferTest, ZeroCopyTracker_ReleaseAll)
+    {
+        BufferPool pool(16);
+        ZeroCopyTracker tracker;
+
+        MessageBuffer* buffer = pool.acquire();
+        tracker.sent(buffer, pool);
+        tracker.sent(buffer, pool);
+        pool.release(buffer);
+
+        tracker.releaseAll(pool);
+        ASSERT_EQ(0, tracker.getPendingCount());
+        ASSERT_EQ(1, pool.getAvailableCount());
+    }
+}
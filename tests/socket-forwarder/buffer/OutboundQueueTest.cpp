@@ -0,0 +1,287 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../../socket-forwarder/buffer/OutboundQueue.h"
+
+using namespace std::chrono_literals;
+
+namespace forwarder
+{
+    class OutboundQueueTest : public ::testing::Test
+    {
+    protected:
+        BufferPool pool;
+        OutboundQueue queue;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    protected:
+        OutboundQueueTest() : pool(64) {}
+
+        MessageBuffer* createMessage(const std::string& content)
+        {
+            MessageBuffer* buffer = pool.acquire();
+            std::copy(content.begin(), content.end(), buffer->data.begin());
+            buffer->size = content.size();
+            return buffer;
+        }
+
+        void TearDown() override
+        {
+            queue.clear(pool);
+            ASSERT_EQ(pool.getAllocatedCount(), pool.getAvailableCount());
+        }
+    };
+
+    TEST_F(OutboundQueueTest, ParseSlowConsumerPolicy)
+    {
+        ASSERT_EQ(SlowConsumerPolicy::DropOldest, parseSlowConsumerPolicy("drop_oldest"));
+        ASSERT_EQ(SlowConsumerPolicy::DropNewest, parseSlowConsumerPolicy("drop_newest"));
+        ASSERT_EQ(SlowConsumerPolicy::Disconnect, parseSlowConsumerPolicy("disconnect"));
+        ASSERT_EQ(std::nullopt, parseSlowConsumerPolicy("something-else"));
+    }
+
+    TEST_F(OutboundQueueTest, DropNewest_OverByteLimit)
+    {
+        MessageBuffer* first = createMessage("0123456789");
+        MessageBuffer* second = createMessage("abcdefghij");
+
+        ASSERT_EQ(PushResult::Queued, queue.push(first, pool, SlowConsumerPolicy::DropNewest, 15, 0ms, now));
+        ASSERT_EQ(PushResult::Rejected, queue.push(second, pool, SlowConsumerPolicy::DropNewest, 15, 0ms, now));
+        pool.release(first);
+        pool.release(second);
+
+        ASSERT_EQ(1, queue.size());
+        ASSERT_EQ(10, queue.getQueuedBytes());
+        ASSERT_EQ(1, queue.getDroppedMessages());
+        ASSERT_EQ(10, queue.getDroppedBytes());
+    }
+
+    TEST_F(OutboundQueueTest, DropOldest_OverByteLimit)
+    {
+        MessageBuffer* first = createMessage("0123456789");
+        MessageBuffer* second = createMessage("abcdefghij");
+
+        ASSERT_EQ(PushResult::Queued, queue.push(first, pool, SlowConsumerPolicy::DropOldest, 15, 0ms, now));
+        ASSERT_EQ(PushResult::QueuedWithEvictions, queue.push(second, pool, SlowConsumerPolicy::DropOldest, 15, 0ms, now));
+        pool.release(first);
+        pool.release(second);
+
+        ASSERT_EQ(1, queue.size());
+        ASSERT_EQ(1, queue.getDroppedMessages());
+
+        // The remaining message is the newest one
+        int sockets[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+        ASSERT_EQ(FlushResult::Drained, queue.flush(sockets[0], pool, nullptr, 0));
+        char received[20] = {};
+        ASSERT_EQ(10, read(sockets[1], received, sizeof(received)));
+        ASSERT_EQ("abcdefghij", std::string(received));
+        close(sockets[0]);
+        close(sockets[1]);
+    }
+
+    TEST_F(OutboundQueueTest, Disconnect_OverLagLimit)
+    {
+        MessageBuffer* first = createMessage("first");
+        MessageBuffer* second = createMessage("second");
+
+        ASSERT_EQ(PushResult::Queued, queue.push(first, pool, SlowConsumerPolicy::Disconnect, 0, 10ms, now));
+        ASSERT_EQ(PushResult::Queued, queue.push(second, pool, SlowConsumerPolicy::Disconnect, 0, 10ms, now + 5ms));
+        ASSERT_EQ(PushResult::Disconnect, queue.push(second, pool, SlowConsumerPolicy::Disconnect, 0, 10ms, now + 11ms));
+        pool.release(first);
+        pool.release(second);
+
+        ASSERT_EQ(2, queue.size());
+    }
+
+    TEST_F(OutboundQueueTest, Expire_DisconnectOverLagLimit)
+    {
+        MessageBuffer* first = createMessage("first");
+
+        ASSERT_EQ(PushResult::Queued, queue.push(first, pool, SlowConsumerPolicy::Disconnect, 0, 10ms, now));
+        pool.release(first);
+
+        ASSERT_TRUE(queue.expire(pool, SlowConsumerPolicy::Disconnect, 10ms, now + 10ms));
+        ASSERT_FALSE(queue.expire(pool, SlowConsumerPolicy::Disconnect, 10ms, now + 11ms));
+        ASSERT_TRUE(queue.expire(pool, SlowConsumerPolicy::Disconnect, 0ms, now + 11ms));
+    }
+
+    TEST_F(OutboundQueueTest, Expire_DropOldestOverLagLimit)
+    {
+        MessageBuffer* first = createMessage("first");
+        MessageBuffer* second = createMessage("second");
+
+        ASSERT_EQ(PushResult::Queued, queue.push(first, pool, SlowConsumerPolicy::DropOldest, 0, 10ms, now));
+        ASSERT_EQ(PushResult::Queued, queue.push(second, pool, SlowConsumerPolicy::DropOldest, 0, 10ms, now + 5ms));
+        pool.release(first);
+        pool.release(second);
+
+        ASSERT_TRUE(queue.expire(pool, SlowConsumerPolicy::DropOldest, 10ms, now + 12ms));
+        ASSERT_EQ(1, queue.size());
+        ASSERT_EQ(6, queue.getQueuedBytes());
+        ASSERT_EQ(1, queue.getDroppedMessages());
+
+        ASSERT_TRUE(queue.expire(pool, SlowConsumerPolicy::DropOldest, 10ms, now + 20ms));
+        ASSERT_TRUE(queue.empty());
+        ASSERT_EQ(2, queue.getDroppedMessages());
+    }
+
+    TEST_F(OutboundQueueTest, Flush_BatchesQueuedMessages)
+    {
+        int sockets[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+        std::string expected;
+        for (size_t i = 0; i < 100; i++)
+        {
+            std::string content = "message-" + std::to_string(i) + ";";
+            expected += content;
+            MessageBuffer* buffer = createMessage(content);
+            ASSERT_EQ(PushResult::Queued, queue.push(buffer, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now));
+            pool.release(buffer);
+        }
+
+        ASSERT_EQ(FlushResult::Drained, queue.flush(sockets[0], pool, nullptr, 0));
+        ASSERT_TRUE(queue.empty());
+        ASSERT_EQ(0, queue.getQueuedBytes());
+
+        std::string received(expected.size(), '\0');
+        ASSERT_EQ(expected.size(), read(sockets[1], received.data(), received.size()));
+        ASSERT_EQ(expected, received);
+
+        close(sockets[0]);
+        close(sockets[1]);
+    }
+
+    /**
+     * Every send that writes any bytes is counted once, messages are only counted as sent once they have been fully written.
+     */
+    TEST_F(OutboundQueueTest, Flush_CountsMessagesPerSend)
+    {
+        int sockets[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+        for (size_t i = 0; i < 100; i++)
+        {
+            MessageBuffer* buffer = createMessage("message-" + std::to_string(i));
+            ASSERT_EQ(PushResult::Queued, queue.push(buffer, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now));
+            pool.release(buffer);
+        }
+
+        // The queue sends at most 64 messages per sendmsg() call
+        ASSERT_EQ(FlushResult::Drained, queue.flush(sockets[0], pool, nullptr, 0));
+        ASSERT_EQ(2, queue.getSendCount());
+        ASSERT_EQ(100, queue.getSentMessages());
+
+        MessageBuffer* buffer = createMessage("partial");
+        ASSERT_EQ(PushResult::Queued, queue.push(buffer, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now));
+        pool.release(buffer);
+        iovec vectors[1];
+        MessageBuffer* buffers[1];
+        ASSERT_EQ(1, queue.prepare(vectors, buffers, 1));
+        queue.consume(3, pool);
+        ASSERT_EQ(3, queue.getSendCount());
+        ASSERT_EQ(100, queue.getSentMessages());
+
+        ASSERT_EQ(1, queue.prepare(vectors, buffers, 1));
+        queue.consume(0, pool);
+        ASSERT_EQ(3, queue.getSendCount());
+
+        ASSERT_EQ(1, queue.prepare(vectors, buffers, 1));
+        queue.consume(vectors[0].iov_len, pool);
+        ASSERT_EQ(4, queue.getSendCount());
+        ASSERT_EQ(101, queue.getSentMessages());
+
+        close(sockets[0]);
+        close(sockets[1]);
+    }
+
+    TEST_F(OutboundQueueTest, Flush_WouldBlockKeepsRemainder)
+    {
+        int sockets[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+        int bufferSize = 4096;
+        setsockopt(sockets[0], SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+        std::string content(64, 'x');
+        FlushResult result = FlushResult::Drained;
+        size_t pushed = 0;
+        while (result == FlushResult::Drained && pushed < 100000)
+        {
+            MessageBuffer* buffer = createMessage(content);
+            ASSERT_EQ(PushResult::Queued, queue.push(buffer, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now));
+            pool.release(buffer);
+            result = queue.flush(sockets[0], pool, nullptr, 0);
+            pushed++;
+        }
+        ASSERT_EQ(FlushResult::WouldBlock, result);
+        ASSERT_FALSE(queue.empty());
+
+        close(sockets[1]);
+        MessageBuffer* buffer = createMessage(content);
+        ASSERT_EQ(PushResult::Queued, queue.push(buffer, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now));
+        pool.release(buffer);
+        ASSERT_EQ(FlushResult::Failed, queue.flush(sockets[0], pool, nullptr, 0));
+        close(sockets[0]);
+    }
+
+    /**
+     * A message pushed to several queues records its first send when the first queue writes it and its last send when the last queue does,
+     * unless any queue dropped it.
+     */
+    TEST_F(OutboundQueueTest, Consume_RecordsDeliveryLatencies)
+    {
+        LatencyHistogram peerSend;
+        LatencyHistogram firstSend;
+        LatencyHistogram lastSend;
+        DeliveryPool deliveries;
+        OutboundQueue other;
+        queue.setLatencies({ &peerSend, &firstSend, &lastSend, &deliveries });
+        other.setLatencies({ &peerSend, &firstSend, &lastSend, &deliveries });
+        iovec vectors[1];
+        MessageBuffer* buffers[1];
+
+        MessageBuffer* delivered = createMessage("delivered");
+        MessageDelivery* delivery = deliveries.acquire(now - 1ms);
+        ASSERT_EQ(PushResult::Queued, queue.push(delivered, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now, delivery));
+        ASSERT_EQ(PushResult::Queued, other.push(delivered, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now, delivery));
+        pool.release(delivered);
+        deliveries.release(delivery);
+
+        ASSERT_EQ(1, queue.prepare(vectors, buffers, 1));
+        queue.consume(vectors[0].iov_len, pool);
+        ASSERT_EQ(1, peerSend.snapshot().count);
+        ASSERT_EQ(1, firstSend.snapshot().count);
+        ASSERT_GE(firstSend.snapshot().max, 1000000);
+        ASSERT_EQ(0, lastSend.snapshot().count);
+
+        ASSERT_EQ(1, other.prepare(vectors, buffers, 1));
+        other.consume(vectors[0].iov_len, pool);
+        ASSERT_EQ(2, peerSend.snapshot().count);
+        ASSERT_EQ(1, firstSend.snapshot().count);
+        ASSERT_EQ(1, lastSend.snapshot().count);
+
+        // A message dropped from one queue is never recorded as delivered to every peer
+        MessageBuffer* dropped = createMessage("dropped");
+        delivery = deliveries.acquire(now);
+        ASSERT_EQ(PushResult::Queued, queue.push(dropped, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now, delivery));
+        ASSERT_EQ(PushResult::Queued, other.push(dropped, pool, SlowConsumerPolicy::Disconnect, 0, 0ms, now, delivery));
+        pool.release(dropped);
+        deliveries.release(delivery);
+        other.clear(pool);
+
+        ASSERT_EQ(1, queue.prepare(vectors, buffers, 1));
+        queue.consume(vectors[0].iov_len, pool);
+        ASSERT_EQ(3, peerSend.snapshot().count);
+        ASSERT_EQ(2, firstSend.snapshot().count);
+        ASSERT_EQ(1, lastSend.snapshot().count);
+
+        // Every delivery is recycled once each queue has written or dropped its message
+        ASSERT_EQ(1, deliveries.getAllocatedCount());
+        ASSERT_EQ(1, deliveries.getAvailableCount());
+    }
+}
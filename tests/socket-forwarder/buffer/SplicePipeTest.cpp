@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../../socket-forwarder/buffer/SplicePipe.h"
+
+namespace forwarder
+{
+    class SplicePipeTest : public ::testing::Test
+    {
+    protected:
+        int source[2];
+        int firstDestination[2];
+        int secondDestination[2];
+        int nullDescriptor;
+        SplicePipe receivePipe;
+        SplicePipe firstPipe;
+        SplicePipe secondPipe;
+
+    protected:
+        void SetUp() override
+        {
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, source));
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, firstDestination));
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, secondDestination));
+            nullDescriptor = open("/dev/null", O_WRONLY);
+            ASSERT_NE(-1, nullDescriptor);
+
+            ASSERT_TRUE(receivePipe.open());
+            ASSERT_TRUE(firstPipe.open());
+            ASSERT_TRUE(secondPipe.open());
+        }
+
+        void TearDown() override
+        {
+            receivePipe.close();
+            firstPipe.close();
+            secondPipe.close();
+            for (int descriptor : { source[0], source[1], firstDestination[0], firstDestination[1], secondDestination[0], secondDestination[1], nullDescriptor })
+            {
+                close(descriptor);
+            }
+        }
+
+        std::string receive(const int descriptor, const size_t amount)
+        {
+            std::string received(amount, '\0');
+            ssize_t result = recv(descriptor, &received[0], amount, MSG_DONTWAIT);
+            received.resize(result > 0 ? static_cast<size_t>(result) : 0);
+            return received;
+        }
+    };
+
+    TEST_F(SplicePipeTest, TeeToEveryPeerThenFlush)
+    {
+        const std::string message = "SplicePipeTest message";
+        ASSERT_EQ(message.size(), send(source[0], message.data(), message.size(), 0));
+
+        ASSERT_EQ(message.size(), receivePipe.spliceFrom(source[1], 1024));
+        ASSERT_EQ(message.size(), receivePipe.getQueuedBytes());
+
+        ASSERT_EQ(message.size(), receivePipe.teeTo(firstPipe, message.size()));
+        ASSERT_EQ(message.size(), receivePipe.teeTo(secondPipe, message.size()));
+        // Duplicating does not consume the data from the receiving pipe
+        ASSERT_EQ(message.size(), receivePipe.getQueuedBytes());
+        receivePipe.discard(nullDescriptor);
+        ASSERT_EQ(0, receivePipe.getQueuedBytes());
+
+        ASSERT_EQ(FlushResult::Drained, firstPipe.flush(firstDestination[0]));
+        ASSERT_EQ(FlushResult::Drained, secondPipe.flush(secondDestination[0]));
+        ASSERT_EQ(0, firstPipe.getQueuedBytes());
+
+        ASSERT_EQ(message, receive(firstDestination[1], 1024));
+        ASSERT_EQ(message, receive(secondDestination[1], 1024));
+    }
+
+    /**
+     * A pipe holds whatever its socket cannot accept until the socket is read from.
+     */
+    TEST_F(SplicePipeTest, FlushWouldBlockWhenSocketIsFull)
+    {
+        const std::string message(4096, 'x');
+        bool blocked = false;
+        for (size_t i = 0; i < 1024 && !blocked; i++)
+        {
+            ASSERT_EQ(message.size(), send(source[0], message.data(), message.size(), 0));
+            ASSERT_EQ(message.size(), receivePipe.spliceFrom(source[1], message.size()));
+            ASSERT_EQ(message.size(), receivePipe.teeTo(firstPipe, message.size()));
+            receivePipe.discard(nullDescriptor);
+
+            FlushResult result = firstPipe.flush(firstDestination[0]);
+            ASSERT_NE(FlushResult::Failed, result);
+            blocked = result == FlushResult::WouldBlock;
+        }
+        ASSERT_TRUE(blocked);
+        ASSERT_GT(firstPipe.getQueuedBytes(), 0);
+
+        while (!receive(firstDestination[1], 65536).empty())
+        {
+            if (firstPipe.flush(firstDestination[0]) == FlushResult::Drained)
+            {
+                break;
+            }
+        }
+        ASSERT_EQ(0, firstPipe.getQueuedBytes());
+    }
+
+    TEST_F(SplicePipeTest, SpliceFromClosedSocket)
+    {
+        close(source[0]);
+        source[0] = -1;
+        ASSERT_EQ(0, receivePipe.spliceFrom(source[1], 1024));
+    }
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "../../../socket-forwarder/container/AddressTable.h"
+
+namespace forwarder
+{
+    static kt::SocketAddress ipv4Address(const char* address, const unsigned short port)
+    {
+        kt::SocketAddress result{};
+        result.ipv4.sin_family = AF_INET;
+        result.ipv4.sin_port = htons(port);
+        inet_pton(AF_INET, address, &result.ipv4.sin_addr);
+        return result;
+    }
+
+    static kt::SocketAddress ipv6Address(const char* address, const unsigned short port)
+    {
+        kt::SocketAddress result{};
+        result.ipv6.sin6_family = AF_INET6;
+        result.ipv6.sin6_port = htons(port);
+        inet_pton(AF_INET6, address, &result.ipv6.sin6_addr);
+        return result;
+    }
+
+    TEST(AddressTableTest, InsertAndFind)
+    {
+        AddressTable table;
+        ASSERT_TRUE(table.empty());
+        ASSERT_FALSE(table.find(ipv4Address("127.0.0.1", 1000)).has_value());
+
+        std::pair<size_t, bool> result = table.insert(ipv4Address("127.0.0.1", 1000));
+        ASSERT_EQ(0, result.first);
+        ASSERT_TRUE(result.second);
+        ASSERT_TRUE(table.insert(ipv4Address("127.0.0.1", 1001)).second);
+        ASSERT_TRUE(table.insert(ipv6Address("::1", 1000)).second);
+
+        // Inserting an address that is already present returns its position
+        result = table.insert(ipv4Address("127.0.0.1", 1001));
+        ASSERT_EQ(1, result.first);
+        ASSERT_FALSE(result.second);
+
+        ASSERT_EQ(3, table.size());
+        ASSERT_EQ(0, table.find(ipv4Address("127.0.0.1", 1000)).value());
+        ASSERT_EQ(2, table.find(ipv6Address("::1", 1000)).value());
+        ASSERT_FALSE(table.contains(ipv4Address("127.0.0.2", 1000)));
+        ASSERT_FALSE(table.contains(ipv6Address("::1", 1001)));
+        ASSERT_EQ(htons(1001), table[1].ipv4.sin_port);
+    }
+
+    TEST(AddressTableTest, IgnoresUnusedAddressBytes)
+    {
+        AddressTable table;
+        table.insert(ipv4Address("10.0.0.1", 5000));
+
+        // Addresses returned by the kernel can leave anything past the IPv4 address, that must not make the same peer look different
+        kt::SocketAddress sameAddress = ipv4Address("10.0.0.1", 5000);
+        std::memset(sameAddress.ipv4.sin_zero, 0xAB, sizeof(sameAddress.ipv4.sin_zero));
+        ASSERT_TRUE(table.contains(sameAddress));
+        ASSERT_FALSE(table.insert(sameAddress).second);
+        ASSERT_EQ(1, table.size());
+    }
+
+    TEST(AddressTableTest, GrowingKeepsInsertionOrder)
+    {
+        AddressTable table;
+        const size_t amount = 5000;
+        for (size_t i = 0; i < amount; i++)
+        {
+            ASSERT_TRUE(table.insert(ipv4Address("127.0.0.1", static_cast<unsigned short>(i + 1))).second);
+        }
+
+        ASSERT_EQ(amount, table.size());
+        size_t position = 0;
+        for (const kt::SocketAddress& address : table)
+        {
+            ASSERT_EQ(htons(static_cast<unsigned short>(position + 1)), address.ipv4.sin_port);
+            ASSERT_EQ(&address, table.data() + position);
+            ASSERT_EQ(position, table.find(address).value());
+            position++;
+        }
+        ASSERT_FALSE(table.contains(ipv4Address("127.0.0.1", static_cast<unsigned short>(amount + 1))));
+    }
+
+    TEST(AddressTableTest, EraseMovesLastAddressAndKeepsOthersReachable)
+    {
+        AddressTable table;
+        const size_t amount = 1000;
+        for (size_t i = 0; i < amount; i++)
+        {
+            table.insert(ipv4Address("127.0.0.1", static_cast<unsigned short>(i + 1)));
+        }
+
+        // The last address is moved into the erased position, so the dense array stays packed
+        ASSERT_EQ(0, table.erase(ipv4Address("127.0.0.1", 1)).value());
+        ASSERT_EQ(htons(static_cast<unsigned short>(amount)), table[0].ipv4.sin_port);
+        ASSERT_FALSE(table.erase(ipv4Address("127.0.0.1", 1)).has_value());
+
+        // Erase every other address up to the one moved to the front, the rest must still be found through probe sequences that passed the erased buckets
+        for (size_t i = 2; i < amount; i += 2)
+        {
+            ASSERT_TRUE(table.erase(ipv4Address("127.0.0.1", static_cast<unsigned short>(i))).has_value());
+        }
+        ASSERT_EQ(amount / 2, table.size());
+        for (size_t i = 1; i <= amount; i++)
+        {
+            std::optional<size_t> position = table.find(ipv4Address("127.0.0.1", static_cast<unsigned short>(i)));
+            ASSERT_EQ((i % 2 == 1 && i != 1) || i == amount, position.has_value());
+            if (position.has_value())
+            {
+                ASSERT_EQ(htons(static_cast<unsigned short>(i)), table[*position].ipv4.sin_port);
+            }
+        }
+        ASSERT_TRUE(table.insert(ipv4Address("127.0.0.1", 2)).second);
+        ASSERT_EQ(table.size() - 1, table.find(ipv4Address("127.0.0.1", 2)).value());
+    }
+}
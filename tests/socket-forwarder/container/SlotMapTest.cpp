@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../../../socket-forwarder/container/SlotMap.h"
+
+namespace forwarder
+{
+    TEST(SlotMapTest, InsertAndGet)
+    {
+        SlotMap<std::string> map;
+        SlotHandle first = map.insert("first");
+        SlotHandle second = map.insert("second");
+
+        ASSERT_EQ(2, map.size());
+        ASSERT_NE(first, second);
+        ASSERT_EQ("first", *map.get(first));
+        ASSERT_EQ("second", *map.get(second));
+    }
+
+    TEST(SlotMapTest, EraseMovesLastValueAndKeepsHandlesValid)
+    {
+        SlotMap<std::string> map;
+        SlotHandle first = map.insert("first");
+        SlotHandle second = map.insert("second");
+        SlotHandle third = map.insert("third");
+
+        ASSERT_TRUE(map.erase(first));
+        ASSERT_EQ(2, map.size());
+        ASSERT_FALSE(map.contains(first));
+        ASSERT_EQ(nullptr, map.get(first));
+
+        // The last value is moved into the erased position, so the dense array stays packed
+        ASSERT_EQ("third", map[0]);
+        ASSERT_EQ("second", map[1]);
+        ASSERT_EQ(third, map.handleAt(0));
+        ASSERT_EQ("second", *map.get(second));
+        ASSERT_EQ("third", *map.get(third));
+    }
+
+    TEST(SlotMapTest, StaleHandleDoesNotResolveToReusedSlot)
+    {
+        SlotMap<std::string> map;
+        SlotHandle first = map.insert("first");
+        ASSERT_TRUE(map.erase(first));
+
+        SlotHandle reused = map.insert("reused");
+        ASSERT_EQ(first.index, reused.index);
+        ASSERT_NE(first.generation, reused.generation);
+
+        ASSERT_EQ(nullptr, map.get(first));
+        ASSERT_FALSE(map.erase(first));
+        ASSERT_EQ("reused", *map.get(reused));
+        ASSERT_EQ(1, map.size());
+    }
+
+    TEST(SlotMapTest, ChurnKeepsEveryLiveValueReachable)
+    {
+        SlotMap<int> map;
+        std::vector<std::pair<SlotHandle, int>> live;
+        for (int i = 0; i < 1000; i++)
+        {
+            live.emplace_back(map.insert(i), i);
+            if (i % 3 == 0)
+            {
+                size_t position = (i * 7) % live.size();
+                ASSERT_TRUE(map.erase(live[position].first));
+                live.erase(live.begin() + position);
+            }
+        }
+
+        ASSERT_EQ(live.size(), map.size());
+        for (const std::pair<SlotHandle, int>& entry : live)
+        {
+            ASSERT_NE(nullptr, map.get(entry.first));
+            ASSERT_EQ(entry.second, *map.get(entry.first));
+        }
+
+        long long sum = 0;
+        long long expected = 0;
+        for (int value : map)
+        {
+            sum += value;
+        }
+        for (const std::pair<SlotHandle, int>& entry : live)
+        {
+            expected += entry.second;
+        }
+        ASSERT_EQ(expected, sum);
+    }
+
+    TEST(SlotMapTest, Clear)
+    {
+        SlotMap<int> map;
+        SlotHandle handle = map.insert(1);
+        map.insert(2);
+        map.clear();
+
+        ASSERT_TRUE(map.empty());
+        ASSERT_FALSE(map.contains(handle));
+        SlotHandle reused = map.insert(3);
+        ASSERT_EQ(3, *map.get(reused));
+    }
+}
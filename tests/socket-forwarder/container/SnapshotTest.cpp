@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "../../../socket-forwarder/container/Snapshot.h"
+
+namespace forwarder
+{
+    TEST(SnapshotTest, ReadersKeepTheVersionTheyLoaded)
+    {
+        Snapshot<std::vector<int>> snapshot;
+        ASSERT_TRUE(snapshot.load()->empty());
+
+        snapshot.update([](std::vector<int>& values) { values.push_back(1); });
+        std::shared_ptr<const std::vector<int>> first = snapshot.load();
+
+        snapshot.update([](std::vector<int>& values) { values.push_back(2); });
+        ASSERT_EQ(1, first->size());
+        ASSERT_EQ(2, snapshot.load()->size());
+
+        snapshot.publish(std::make_shared<const std::vector<int>>());
+        ASSERT_TRUE(snapshot.load()->empty());
+        ASSERT_EQ(1, first->size());
+    }
+
+    /**
+     * Readers running alongside a writer only ever see whole versions, every published vector holds the values 0 to size - 1.
+     * Run under ThreadSanitizer to check that loading and publishing do not race.
+     */
+    TEST(SnapshotTest, ConcurrentReadersSeeWholeVersions)
+    {
+        Snapshot<std::vector<size_t>> snapshot;
+        std::atomic<bool> writing{ true };
+        std::atomic<size_t> inconsistentReads{ 0 };
+
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < 4; i++)
+        {
+            readers.emplace_back([&]()
+            {
+                size_t lastSize = 0;
+                while (writing.load())
+                {
+                    std::shared_ptr<const std::vector<size_t>> current = snapshot.load();
+                    for (size_t index = 0; index < current->size(); index++)
+                    {
+                        if ((*current)[index] != index)
+                        {
+                            inconsistentReads++;
+                        }
+                    }
+                    // A single writer only grows the vector, so versions are never observed going backwards
+                    if (current->size() < lastSize)
+                    {
+                        inconsistentReads++;
+                    }
+                    lastSize = current->size();
+                }
+            });
+        }
+
+        for (size_t i = 0; i < 2000; i++)
+        {
+            snapshot.update([i](std::vector<size_t>& values) { values.push_back(i); });
+        }
+        writing = false;
+        for (std::thread& reader : readers)
+        {
+            reader.join();
+        }
+
+        ASSERT_EQ(0, inconsistentReads.load());
+        ASSERT_EQ(2000, snapshot.load()->size());
+    }
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <chrono>
+
+#include "../../../socket-forwarder/container/TimingWheel.h"
+
+using namespace std::chrono_literals;
+
+namespace forwarder
+{
+    TEST(TimingWheelTest, ExpiresOnlyOnceTheDeadlineHasPassed)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TimingWheel<int> wheel(1ms, start);
+        wheel.schedule(1, start + 10ms);
+        wheel.schedule(2, start + 5ms);
+        ASSERT_EQ(2, wheel.size());
+
+        std::vector<int> expired;
+        wheel.advance(start + 4ms, [&expired](int value) { expired.push_back(value); });
+        ASSERT_TRUE(expired.empty());
+
+        wheel.advance(start + 5ms, [&expired](int value) { expired.push_back(value); });
+        ASSERT_EQ(std::vector<int>{ 2 }, expired);
+
+        wheel.advance(start + 20ms, [&expired](int value) { expired.push_back(value); });
+        ASSERT_EQ((std::vector<int>{ 2, 1 }), expired);
+        ASSERT_TRUE(wheel.empty());
+    }
+
+    TEST(TimingWheelTest, CascadesDeadlinesBeyondTheFirstLevel)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TimingWheel<int> wheel(1ms, start);
+        // Past the first level (64 ticks), the second (4096 ticks) and the third (262144 ticks)
+        const std::vector<std::chrono::milliseconds> deadlines = { 100ms, 5000ms, 300000ms };
+        for (size_t i = 0; i < deadlines.size(); i++)
+        {
+            wheel.schedule(static_cast<int>(i), start + deadlines[i]);
+        }
+
+        std::vector<int> expired;
+        for (size_t i = 0; i < deadlines.size(); i++)
+        {
+            wheel.advance(start + deadlines[i] - 1ms, [&expired](int value) { expired.push_back(value); });
+            ASSERT_EQ(i, expired.size());
+            wheel.advance(start + deadlines[i], [&expired](int value) { expired.push_back(value); });
+            ASSERT_EQ(i + 1, expired.size());
+            ASSERT_EQ(static_cast<int>(i), expired.back());
+        }
+    }
+
+    TEST(TimingWheelTest, DeadlinesBeyondTheTopLevelAreParkedUntilReachable)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TimingWheel<int> wheel(1s, start);
+        // The 4 levels reach 2^24 ticks
+        const std::chrono::seconds deadline((1 << 24) + 1000);
+        wheel.schedule(1, start + deadline);
+
+        std::vector<int> expired;
+        for (std::chrono::seconds now = 0s; now < deadline; now += 60s)
+        {
+            wheel.advance(start + now, [&expired](int value) { expired.push_back(value); });
+        }
+        ASSERT_TRUE(expired.empty());
+        wheel.advance(start + deadline, [&expired](int value) { expired.push_back(value); });
+        ASSERT_EQ(std::vector<int>{ 1 }, expired);
+    }
+
+    TEST(TimingWheelTest, CallbackCanScheduleAgain)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        TimingWheel<int> wheel(1ms, start);
+        wheel.schedule(0, start + 1ms);
+        wheel.schedule(100, start);
+
+        // Each value is scheduled again 10ms later until it has expired 3 times, like a refreshed peer that is pushed back
+        std::vector<int> expired;
+        for (std::chrono::milliseconds now = 1ms; now <= 100ms; now += 1ms)
+        {
+            wheel.advance(start + now, [&](int value)
+            {
+                expired.push_back(value);
+                if (value < 2)
+                {
+                    wheel.schedule(value + 1, start + now + 10ms);
+                }
+            });
+        }
+        ASSERT_EQ((std::vector<int>{ 0, 100, 1, 2 }), expired);
+        ASSERT_TRUE(wheel.empty());
+    }
+}
@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+
+#include "../../../socket-forwarder/environment/Environment.h"
+
+namespace forwarder
+{
+    TEST(EnvironmentTest, ParseSizeAcceptsValuesInRange)
+    {
+        ASSERT_EQ(1, parseSize("1", 1, 10).value());
+        ASSERT_EQ(10, parseSize("10", 1, 10).value());
+        ASSERT_EQ(0, parseSize("0", 0, 10).value());
+    }
+
+    TEST(EnvironmentTest, ParseSizeRejectsInvalidValues)
+    {
+        ASSERT_FALSE(parseSize("0", 1, 10).has_value());
+        ASSERT_FALSE(parseSize("11", 1, 10).has_value());
+        // strtoull() would wrap these around to huge values
+        ASSERT_FALSE(parseSize("-1", 0, SIZE_MAX).has_value());
+        ASSERT_FALSE(parseSize(" -1", 0, SIZE_MAX).has_value());
+        ASSERT_FALSE(parseSize("99999999999999999999999", 0, SIZE_MAX).has_value());
+        ASSERT_FALSE(parseSize("", 0, 10).has_value());
+        ASSERT_FALSE(parseSize("4abc", 0, 10).has_value());
+    }
+}
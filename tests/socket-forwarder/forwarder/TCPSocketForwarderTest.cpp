@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <sstream>
 
 #include <csignal>
 
@@ -130,6 +132,50 @@ namespace forwarder
 		client2.close();
 	}
 
+	TEST_F(TCPSocketForwarderTest, TestForwardingIsCountedInMetrics)
+	{
+		std::string groupId = "TestForwardingIsCountedInMetrics-group";
+		std::vector<kt::TCPSocket> clients;
+		for (size_t i = 0; i < 3; i++)
+		{
+			clients.emplace_back("localhost", serverSocket.getPort());
+			ASSERT_TRUE(clients[i].send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		}
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(3, forwarder.tcpGroupMemberCount(groupId));
+
+		std::string content = "TestForwardingIsCountedInMetrics";
+		ASSERT_TRUE(clients[0].send(content).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(content, clients[1].receiveAmount(content.size()));
+		ASSERT_EQ(content, clients[2].receiveAmount(content.size()));
+
+		clients[2].close();
+		std::this_thread::sleep_for(50ms);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(groupId));
+
+		ForwardingTotals totals = forwarder.forwardingTotals()[{ METRICS_PROTOCOL_TCP, groupId }];
+		ASSERT_EQ(1, totals.messagesIn);
+		ASSERT_EQ(content.size(), totals.bytesIn);
+		ASSERT_EQ(2, totals.messagesOut);
+		ASSERT_EQ(content.size() * 2, totals.bytesOut);
+		ASSERT_EQ(0, totals.sendFailures);
+		ASSERT_EQ(1, totals.removals);
+		ASSERT_EQ(2, totals.peerSend.count);
+		ASSERT_EQ(1, totals.receiveToFirstSend.count);
+		ASSERT_EQ(1, totals.receiveToLastSend.count);
+		ASSERT_LE(totals.receiveToFirstSend.max, totals.receiveToLastSend.max);
+
+		std::ostringstream stream;
+		forwarder.writeMetrics(stream);
+		ASSERT_NE(std::string::npos, stream.str().find("socketforwarder_messages_out_total{protocol=\"tcp\",group=\"" + groupId + "\"} 2\n"));
+		ASSERT_NE(std::string::npos, stream.str().find("socketforwarder_group_members{protocol=\"tcp\",group=\"" + groupId + "\"} 2\n"));
+		ASSERT_NE(std::string::npos, stream.str().find("socketforwarder_latency_microseconds_count{protocol=\"tcp\",group=\"" + groupId + "\",interval=\"receive_to_last_send\"} 1\n"));
+
+		clients[0].close();
+		clients[1].close();
+	}
+
 	TEST_F(TCPSocketForwarderTest, TestNumerousClients)
 	{
 		const size_t amountOfClients = 200;
@@ -178,4 +224,782 @@ namespace forwarder
 			socket.close();
 		}
 	}
+
+	class TCPSocketForwarderShardedTest : public ::testing::Test
+	{
+	protected:
+        kt::ServerSocket serverSocket;
+		forwarder::Forwarder forwarder;
+    protected:
+        TCPSocketForwarderShardedTest() : serverSocket(kt::SocketType::Wifi), forwarder(serverSocket, std::nullopt, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, true) {}
+        void SetUp() override
+		{
+			forwarder.setTCPWorkerCount(4);
+			forwarder.setTCPReusePort(true);
+			forwarder.start();
+		}
+
+        void TearDown() override
+        {
+			forwarder.stop();
+			forwarder.join();
+
+			serverSocket.close();
+        }
+    };
+
+	/**
+	 * Connections are accepted by whichever worker the kernel picks and need to be handed to the worker owning their group,
+	 * so make sure every group still receives its own messages and only its own messages.
+	 */
+	TEST_F(TCPSocketForwarderShardedTest, TestManyGroupsAcrossWorkers)
+	{
+		const size_t amountOfGroups = 16;
+		const size_t clientsPerGroup = 3;
+		std::vector<std::vector<kt::TCPSocket>> groups(amountOfGroups);
+
+		for (size_t groupIndex = 0; groupIndex < amountOfGroups; groupIndex++)
+		{
+			std::string groupId = "TestManyGroupsAcrossWorkers-" + std::to_string(groupIndex);
+			for (size_t i = 0; i < clientsPerGroup; i++)
+			{
+				kt::TCPSocket client("localhost", serverSocket.getPort());
+				ASSERT_TRUE(client.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+				groups[groupIndex].push_back(client);
+			}
+		}
+		std::this_thread::sleep_for(50ms);
+
+		for (size_t groupIndex = 0; groupIndex < amountOfGroups; groupIndex++)
+		{
+			std::string groupId = "TestManyGroupsAcrossWorkers-" + std::to_string(groupIndex);
+			ASSERT_TRUE(forwarder.tcpGroupWithIdExists(groupId));
+			ASSERT_EQ(clientsPerGroup, forwarder.tcpGroupMemberCount(groupId));
+		}
+
+		for (size_t groupIndex = 0; groupIndex < amountOfGroups; groupIndex++)
+		{
+			ASSERT_TRUE(groups[groupIndex][0].send("message-" + std::to_string(groupIndex)).first);
+		}
+		std::this_thread::sleep_for(50ms);
+
+		for (size_t groupIndex = 0; groupIndex < amountOfGroups; groupIndex++)
+		{
+			std::string expected = "message-" + std::to_string(groupIndex);
+			ASSERT_FALSE(groups[groupIndex][0].ready());
+			for (size_t i = 1; i < clientsPerGroup; i++)
+			{
+				ASSERT_TRUE(groups[groupIndex][i].ready());
+				ASSERT_EQ(expected, groups[groupIndex][i].receiveAmount(100));
+			}
+		}
+
+		for (std::vector<kt::TCPSocket>& group : groups)
+		{
+			for (kt::TCPSocket& client : group)
+			{
+				client.close();
+			}
+		}
+	}
+
+	/**
+	 * Members join and leave groups on every worker while other threads read the group registry and a group keeps forwarding.
+	 * Run under ThreadSanitizer to check that reading the registry from other threads does not race with the workers.
+	 */
+	TEST_F(TCPSocketForwarderShardedTest, TestRegistryReadsWhileMembersChurn)
+	{
+		const size_t churnThreads = 4;
+		const size_t joinsPerThread = 50;
+		std::string streamGroupId = "TestRegistryReadsWhileMembersChurn-stream";
+		kt::TCPSocket sender("localhost", serverSocket.getPort());
+		kt::TCPSocket receiver("localhost", serverSocket.getPort());
+		ASSERT_TRUE(sender.send(NEW_CLIENT_PREFIX_DEFAULT + streamGroupId).first);
+		ASSERT_TRUE(receiver.send(NEW_CLIENT_PREFIX_DEFAULT + streamGroupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(streamGroupId));
+
+		std::atomic<bool> churning{ true };
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < churnThreads; t++)
+		{
+			threads.emplace_back([&, t]()
+			{
+				for (size_t i = 0; i < joinsPerThread; i++)
+				{
+					kt::TCPSocket client("localhost", serverSocket.getPort());
+					client.send(NEW_CLIENT_PREFIX_DEFAULT + "TestRegistryReadsWhileMembersChurn-" + std::to_string((t + i) % 8));
+					std::this_thread::sleep_for(100us);
+					client.close();
+				}
+			});
+		}
+
+		std::thread reader([&]()
+		{
+			while (churning)
+			{
+				for (size_t i = 0; i < 8; i++)
+				{
+					std::string groupId = "TestRegistryReadsWhileMembersChurn-" + std::to_string(i);
+					forwarder.tcpGroupWithIdExists(groupId);
+					forwarder.tcpGroupMemberCount(groupId);
+				}
+				forwarder.tcpGroupPeerStatistics(streamGroupId);
+			}
+		});
+
+		const std::string message = "message;";
+		const size_t messageCount = 200;
+		for (size_t i = 0; i < messageCount; i++)
+		{
+			ASSERT_TRUE(sender.send(message).first);
+		}
+
+		for (size_t t = 0; t < churnThreads; t++)
+		{
+			threads[t].join();
+		}
+		churning = false;
+		reader.join();
+
+		std::string received;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + 1s;
+		while (received.size() < message.size() * messageCount && std::chrono::steady_clock::now() < deadline)
+		{
+			if (receiver.ready())
+			{
+				received += receiver.receiveAmount(message.size() * messageCount - received.size());
+			}
+		}
+		ASSERT_EQ(message.size() * messageCount, received.size());
+
+		std::this_thread::sleep_for(50ms);
+		for (size_t i = 0; i < 8; i++)
+		{
+			std::string groupId = "TestRegistryReadsWhileMembersChurn-" + std::to_string(i);
+			ASSERT_TRUE(forwarder.tcpGroupWithIdExists(groupId));
+			ASSERT_EQ(0, forwarder.tcpGroupMemberCount(groupId));
+		}
+		ASSERT_EQ(2, forwarder.tcpGroupPeerStatistics(streamGroupId).size());
+
+		sender.close();
+		receiver.close();
+	}
+
+	class TCPSocketForwarderZeroCopyTest : public TCPSocketForwarderTest
+	{
+	protected:
+        void SetUp() override
+		{
+			// Every message is larger than the threshold so all forwarded messages go through the zero copy path
+			forwarder.setTCPZeroCopyThreshold(1);
+			forwarder.start();
+		}
+    };
+
+	TEST_F(TCPSocketForwarderZeroCopyTest, TestLargeMessagesAreForwardedToEveryPeer)
+	{
+		const size_t amountOfClients = 5;
+		std::string groupId = "TestLargeMessagesAreForwardedToEveryPeer-group";
+		std::vector<kt::TCPSocket> sockets;
+
+		for (size_t i = 0; i < amountOfClients; i++)
+		{
+			kt::TCPSocket socket("localhost", serverSocket.getPort());
+			ASSERT_TRUE(socket.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+			sockets.push_back(socket);
+		}
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(amountOfClients, forwarder.tcpGroupMemberCount(groupId));
+
+		const size_t messagesToSend = 10;
+		for (size_t i = 0; i < messagesToSend; i++)
+		{
+			std::string message(8000, static_cast<char>('a' + i));
+			ASSERT_TRUE(sockets[0].send(message).first);
+			std::this_thread::sleep_for(5ms);
+
+			for (size_t clientIndex = 1; clientIndex < amountOfClients; clientIndex++)
+			{
+				std::string received;
+				while (received.size() < message.size() && sockets[clientIndex].ready())
+				{
+					received += sockets[clientIndex].receiveAmount(message.size() - received.size());
+				}
+				ASSERT_EQ(message, received);
+			}
+		}
+
+		for (kt::TCPSocket& socket : sockets)
+		{
+			socket.close();
+		}
+	}
+
+	class TCPSocketForwarderSlowConsumerTest : public TCPSocketForwarderTest
+	{
+	protected:
+        void SetUp() override
+		{
+			forwarder.setTCPSlowConsumerPolicy(SlowConsumerPolicy::DropNewest, 65536, 0ms);
+			forwarder.start();
+		}
+    };
+
+	/**
+	 * One client never reads, make sure the other client still receives every message and the stuck client has its messages dropped.
+	 */
+	TEST_F(TCPSocketForwarderSlowConsumerTest, TestStuckClientDoesNotBlockGroup)
+	{
+		std::string groupId = "TestStuckClientDoesNotBlockGroup-group";
+		kt::TCPSocket sender("localhost", serverSocket.getPort());
+		kt::TCPSocket receiver("localhost", serverSocket.getPort());
+		kt::TCPSocket stuck("localhost", serverSocket.getPort());
+		ASSERT_TRUE(sender.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		ASSERT_TRUE(receiver.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		ASSERT_TRUE(stuck.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(3, forwarder.tcpGroupMemberCount(groupId));
+
+		const size_t messageSize = 8192;
+		const size_t messagesToSend = 2000;
+		std::thread sendingThread([&]()
+		{
+			std::string message(messageSize, 'm');
+			for (size_t i = 0; i < messagesToSend; i++)
+			{
+				sender.send(message);
+			}
+		});
+
+		size_t receivedBytes = 0;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + 10s;
+		while (receivedBytes < messageSize * messagesToSend && std::chrono::steady_clock::now() < deadline)
+		{
+			if (receiver.ready())
+			{
+				receivedBytes += receiver.receiveAmount(messageSize).size();
+			}
+		}
+		sendingThread.join();
+		ASSERT_EQ(messageSize * messagesToSend, receivedBytes);
+
+		std::vector<TCPPeerStatistics> statistics = forwarder.tcpGroupPeerStatistics(groupId);
+		ASSERT_EQ(3, statistics.size());
+		uint64_t droppedMessages = 0;
+		for (const TCPPeerStatistics& peer : statistics)
+		{
+			ASSERT_LE(peer.queuedBytes, 65536);
+			droppedMessages += peer.droppedMessages;
+		}
+		ASSERT_GT(droppedMessages, 0);
+
+		sender.close();
+		receiver.close();
+		stuck.close();
+	}
+
+	class TCPSocketForwarderFramingTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string groupId = "TCPSocketForwarderFramingTest-group";
+
+        void SetUp() override
+		{
+			forwarder.setTCPGroupFraming(groupId, FramingMode::UInt32);
+			forwarder.setTCPMaxFrameSize(65536);
+			forwarder.start();
+		}
+
+		std::string receiveAll(kt::TCPSocket& socket, const size_t amount)
+		{
+			std::string received;
+			while (received.size() < amount && socket.ready())
+			{
+				received += socket.receiveAmount(amount - received.size());
+			}
+			return received;
+		}
+    };
+
+	/**
+	 * A frame sent in pieces is only forwarded once it is whole, and frames larger than the read size are forwarded intact.
+	 */
+	TEST_F(TCPSocketForwarderFramingTest, TestOnlyWholeFramesAreForwarded)
+	{
+		kt::TCPSocket sender("localhost", serverSocket.getPort());
+		kt::TCPSocket receiver("localhost", serverSocket.getPort());
+		ASSERT_TRUE(sender.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		ASSERT_TRUE(receiver.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(groupId));
+
+		std::string frame = encodeFrameHeader(FramingMode::UInt32, 11) + "hello world";
+		ASSERT_TRUE(sender.send(frame.substr(0, 2)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_FALSE(receiver.ready());
+
+		ASSERT_TRUE(sender.send(frame.substr(2, 6)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_FALSE(receiver.ready());
+
+		ASSERT_TRUE(sender.send(frame.substr(8)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(frame, receiveAll(receiver, frame.size()));
+
+		// A frame larger than the max read in size, followed by small frames and the start of another frame in the same send
+		std::string largeFrame = encodeFrameHeader(FramingMode::UInt32, 40000) + std::string(40000, 'L');
+		std::string smallFrames = encodeFrameHeader(FramingMode::UInt32, 1) + "a" + encodeFrameHeader(FramingMode::UInt32, 1) + "b";
+		std::string lastFrame = encodeFrameHeader(FramingMode::UInt32, 5) + "final";
+		ASSERT_TRUE(sender.send(largeFrame + smallFrames + lastFrame.substr(0, 3)).first);
+		std::this_thread::sleep_for(20ms);
+		ASSERT_EQ(largeFrame + smallFrames, receiveAll(receiver, largeFrame.size() + smallFrames.size()));
+		ASSERT_FALSE(receiver.ready());
+
+		ASSERT_TRUE(sender.send(lastFrame.substr(3)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(lastFrame, receiveAll(receiver, lastFrame.size()));
+
+		sender.close();
+		receiver.close();
+	}
+
+	TEST_F(TCPSocketForwarderFramingTest, TestOversizedFrameDisconnectsSender)
+	{
+		kt::TCPSocket sender("localhost", serverSocket.getPort());
+		kt::TCPSocket receiver("localhost", serverSocket.getPort());
+		ASSERT_TRUE(sender.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		ASSERT_TRUE(receiver.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(groupId));
+
+		ASSERT_TRUE(sender.send(encodeFrameHeader(FramingMode::UInt32, 65537)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(1, forwarder.tcpGroupMemberCount(groupId));
+		ASSERT_FALSE(receiver.ready());
+
+		sender.close();
+		receiver.close();
+	}
+
+	class TCPSocketForwarderSpliceTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string groupId = "TCPSocketForwarderSpliceTest-group";
+
+        void SetUp() override
+		{
+			forwarder.setTCPGroupSplice(groupId, true);
+			forwarder.start();
+		}
+    };
+
+	TEST_F(TCPSocketForwarderSpliceTest, TestSplicedDataIsForwardedToEveryOtherPeer)
+	{
+		const size_t amountOfClients = 4;
+		std::vector<kt::TCPSocket> sockets;
+		for (size_t i = 0; i < amountOfClients; i++)
+		{
+			kt::TCPSocket socket("localhost", serverSocket.getPort());
+			ASSERT_TRUE(socket.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+			sockets.push_back(socket);
+		}
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(amountOfClients, forwarder.tcpGroupMemberCount(groupId));
+
+		for (size_t senderIndex = 0; senderIndex < amountOfClients; senderIndex++)
+		{
+			std::string message(20000, static_cast<char>('a' + senderIndex));
+			ASSERT_TRUE(sockets[senderIndex].send(message).first);
+			std::this_thread::sleep_for(10ms);
+
+			ASSERT_FALSE(sockets[senderIndex].ready());
+			for (size_t clientIndex = 0; clientIndex < amountOfClients; clientIndex++)
+			{
+				if (clientIndex != senderIndex)
+				{
+					std::string received;
+					while (received.size() < message.size() && sockets[clientIndex].ready())
+					{
+						received += sockets[clientIndex].receiveAmount(message.size() - received.size());
+					}
+					ASSERT_EQ(message, received);
+				}
+			}
+		}
+
+		sockets[0].close();
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(amountOfClients - 1, forwarder.tcpGroupMemberCount(groupId));
+
+		for (size_t i = 1; i < amountOfClients; i++)
+		{
+			sockets[i].close();
+		}
+	}
+
+	class TCPSocketForwarderSpliceSlowConsumerTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string groupId = "TCPSocketForwarderSpliceSlowConsumerTest-group";
+
+        void SetUp() override
+		{
+			forwarder.setTCPGroupSplice(groupId, true);
+			forwarder.setTCPSlowConsumerPolicy(SlowConsumerPolicy::DropNewest, 65536, 0ms);
+			forwarder.start();
+		}
+    };
+
+	/**
+	 * A spliced stream has no message boundaries, so a client whose pipe fills is disconnected even when the policy is to drop.
+	 */
+	TEST_F(TCPSocketForwarderSpliceSlowConsumerTest, TestFullPipeDisconnectsClientWithDropPolicy)
+	{
+		kt::TCPSocket sender("localhost", serverSocket.getPort());
+		kt::TCPSocket receiver("localhost", serverSocket.getPort());
+		kt::TCPSocket stuck("localhost", serverSocket.getPort());
+		ASSERT_TRUE(sender.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		ASSERT_TRUE(receiver.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		ASSERT_TRUE(stuck.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(3, forwarder.tcpGroupMemberCount(groupId));
+
+		const size_t messageSize = 8192;
+		const size_t messagesToSend = 2000;
+		std::thread sendingThread([&]()
+		{
+			std::string message(messageSize, 'm');
+			for (size_t i = 0; i < messagesToSend; i++)
+			{
+				sender.send(message);
+			}
+		});
+
+		size_t receivedBytes = 0;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + 10s;
+		while (receivedBytes < messageSize * messagesToSend && std::chrono::steady_clock::now() < deadline)
+		{
+			if (receiver.ready())
+			{
+				receivedBytes += receiver.receiveAmount(messageSize).size();
+			}
+		}
+		sendingThread.join();
+		ASSERT_EQ(messageSize * messagesToSend, receivedBytes);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(groupId));
+
+		sender.close();
+		receiver.close();
+		stuck.close();
+	}
+
+	class TCPSocketForwarderFlushWindowTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string batchedGroupId = "TCPSocketForwarderFlushWindowTest-batched-group";
+		std::string latencyGroupId = "TCPSocketForwarderFlushWindowTest-latency-group";
+
+        void SetUp() override
+		{
+			forwarder.setTCPFlushWindow(50ms);
+			forwarder.setTCPGroupFlushWindow(latencyGroupId, 0us);
+			forwarder.start();
+		}
+
+		std::vector<kt::TCPSocket> joinGroup(const std::string& groupId, const size_t amountOfClients)
+		{
+			std::vector<kt::TCPSocket> sockets;
+			for (size_t i = 0; i < amountOfClients; i++)
+			{
+				kt::TCPSocket socket("localhost", serverSocket.getPort());
+				socket.send(NEW_CLIENT_PREFIX_DEFAULT + groupId);
+				sockets.push_back(socket);
+			}
+			std::this_thread::sleep_for(10ms);
+			return sockets;
+		}
+    };
+
+	/**
+	 * Messages forwarded to a peer within the flush window are held back until the window passes and then written together.
+	 */
+	TEST_F(TCPSocketForwarderFlushWindowTest, TestMessagesWithinWindowAreWrittenTogether)
+	{
+		const size_t amountOfClients = 5;
+		std::vector<kt::TCPSocket> sockets = joinGroup(batchedGroupId, amountOfClients);
+		ASSERT_EQ(amountOfClients, forwarder.tcpGroupMemberCount(batchedGroupId));
+
+		std::string expected;
+		for (size_t i = 1; i < amountOfClients; i++)
+		{
+			std::string message = "message-" + std::to_string(i) + ";";
+			expected += message;
+			ASSERT_TRUE(sockets[i].send(message).first);
+		}
+		std::this_thread::sleep_for(10ms);
+		ASSERT_FALSE(sockets[0].ready());
+
+		std::this_thread::sleep_for(100ms);
+		std::string received;
+		while (received.size() < expected.size() && sockets[0].ready())
+		{
+			received += sockets[0].receiveAmount(expected.size() - received.size());
+		}
+		ASSERT_EQ(expected.size(), received.size());
+		for (size_t i = 1; i < amountOfClients; i++)
+		{
+			ASSERT_NE(std::string::npos, received.find("message-" + std::to_string(i) + ";"));
+		}
+
+		// Every peer was forwarded the messages of every other sender, and each peer's messages were written with a single send
+		uint64_t sentMessages = 0;
+		for (const TCPPeerStatistics& peer : forwarder.tcpGroupPeerStatistics(batchedGroupId))
+		{
+			ASSERT_EQ(1, peer.sendCount);
+			sentMessages += peer.sentMessages;
+		}
+		ASSERT_EQ((amountOfClients - 1) + (amountOfClients - 1) * (amountOfClients - 2), sentMessages);
+
+		for (kt::TCPSocket& socket : sockets)
+		{
+			socket.close();
+		}
+	}
+
+	TEST_F(TCPSocketForwarderFlushWindowTest, TestGroupWithoutWindowIsNotDelayed)
+	{
+		std::vector<kt::TCPSocket> sockets = joinGroup(latencyGroupId, 2);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(latencyGroupId));
+
+		std::string message = "latency sensitive";
+		ASSERT_TRUE(sockets[1].send(message).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_TRUE(sockets[0].ready());
+		ASSERT_EQ(message, sockets[0].receiveAmount(message.size()));
+
+		sockets[0].close();
+		sockets[1].close();
+	}
+
+	class TCPSocketForwarderHandshakeTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string groupId = "TCPSocketForwarderHandshakeTest-group";
+
+        void SetUp() override
+		{
+			forwarder.setTCPHandshakeTimeout(100ms);
+			forwarder.start();
+		}
+    };
+
+	TEST_F(TCPSocketForwarderHandshakeTest, TestJoinMessageSplitAcrossSegments)
+	{
+		std::string joinMessage = NEW_CLIENT_PREFIX_DEFAULT + groupId;
+		kt::TCPSocket client("localhost", serverSocket.getPort());
+		ASSERT_TRUE(client.send(joinMessage.substr(0, 6)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_FALSE(forwarder.tcpGroupWithIdExists(groupId));
+
+		ASSERT_TRUE(client.send(joinMessage.substr(6)).first);
+		std::this_thread::sleep_for(50ms);
+		ASSERT_EQ(1, forwarder.tcpGroupMemberCount(groupId));
+
+		client.close();
+	}
+
+	/**
+	 * A client that stalls part way through its join message does not delay other clients, and is disconnected once the handshake times out.
+	 */
+	TEST_F(TCPSocketForwarderHandshakeTest, TestStalledClientIsClosedAfterTimeout)
+	{
+		kt::TCPSocket stalled("localhost", serverSocket.getPort());
+		ASSERT_TRUE(stalled.send(NEW_CLIENT_PREFIX_DEFAULT.substr(0, 6)).first);
+
+		kt::TCPSocket client("localhost", serverSocket.getPort());
+		ASSERT_TRUE(client.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(1, forwarder.tcpGroupMemberCount(groupId));
+
+		char byte;
+		ASSERT_EQ(-1, recv(stalled.getSocket(), &byte, 1, MSG_DONTWAIT));
+		std::this_thread::sleep_for(200ms);
+		ASSERT_EQ(0, recv(stalled.getSocket(), &byte, 1, MSG_DONTWAIT));
+		ASSERT_EQ(1, forwarder.tcpGroupMemberCount(groupId));
+
+		stalled.close();
+		client.close();
+	}
+
+	class TCPSocketForwarderTracingTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string groupId = "TCPSocketForwarderTracingTest-group";
+
+        void SetUp() override
+		{
+			// Sampling is disabled, but the fixture's debug flag still traces every message
+			forwarder.setTracing(0, 64);
+			forwarder.start();
+		}
+    };
+
+	TEST_F(TCPSocketForwarderTracingTest, TestReceiveAndEachSendShareATraceId)
+	{
+		std::vector<kt::TCPSocket> clients;
+		for (size_t i = 0; i < 3; i++)
+		{
+			clients.emplace_back("localhost", serverSocket.getPort());
+			ASSERT_TRUE(clients[i].send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+		}
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(3, forwarder.tcpGroupMemberCount(groupId));
+		ASSERT_TRUE(forwarder.traceEvents().empty());
+
+		std::string content = "TestReceiveAndEachSendShareATraceId";
+		ASSERT_TRUE(clients[0].send(content).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(content, clients[1].receiveAmount(content.size()));
+		ASSERT_EQ(content, clients[2].receiveAmount(content.size()));
+
+		std::vector<TraceEvent> events = forwarder.traceEvents();
+		ASSERT_EQ(3, events.size());
+		ASSERT_EQ(TraceEventType::Receive, events[0].type);
+		ASSERT_NE(0, events[0].traceId);
+		ASSERT_EQ(content.size(), events[0].size);
+		for (size_t i = 1; i < events.size(); i++)
+		{
+			ASSERT_EQ(TraceEventType::Send, events[i].type);
+			ASSERT_EQ(events[0].traceId, events[i].traceId);
+			ASSERT_NE(events[0].descriptor, events[i].descriptor);
+			ASSERT_LE(events[0].timestampNanos, events[i].timestampNanos);
+		}
+
+		for (kt::TCPSocket& client : clients)
+		{
+			client.close();
+		}
+	}
+
+	class TCPSocketForwarderIoUringTest : public TCPSocketForwarderTest
+	{
+	protected:
+		std::string framedGroupId = "TCPSocketForwarderIoUringTest-framed-group";
+
+        void SetUp() override
+		{
+			if (!isIoUringSupported())
+			{
+				GTEST_SKIP() << "io_uring is not available on this system.";
+			}
+			forwarder.setIOEngine(IOEngine::IoUring);
+			forwarder.setTCPWorkerCount(2);
+			forwarder.setTCPGroupFraming(framedGroupId, FramingMode::Varint);
+			forwarder.setTCPHandshakeTimeout(100ms);
+			forwarder.start();
+		}
+
+		/**
+		 * Waits up to a second for the whole amount, the tail of a large message can be held back by Nagle's algorithm until the client acknowledges its start.
+		 */
+		std::string receiveAll(kt::TCPSocket& socket, const size_t amount)
+		{
+			std::string received;
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + 1s;
+			while (received.size() < amount && std::chrono::steady_clock::now() < deadline)
+			{
+				if (socket.ready())
+				{
+					received += socket.receiveAmount(amount - received.size());
+				}
+			}
+			return received;
+		}
+    };
+
+	TEST_F(TCPSocketForwarderIoUringTest, TestMessagesAreForwardedToEveryOtherPeer)
+	{
+		const size_t amountOfClients = 4;
+		std::string groupId = "TCPSocketForwarderIoUringTest-group";
+		std::vector<kt::TCPSocket> sockets;
+		for (size_t i = 0; i < amountOfClients; i++)
+		{
+			kt::TCPSocket socket("localhost", serverSocket.getPort());
+			ASSERT_TRUE(socket.send(NEW_CLIENT_PREFIX_DEFAULT + groupId).first);
+			sockets.push_back(socket);
+		}
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(amountOfClients, forwarder.tcpGroupMemberCount(groupId));
+
+		for (size_t senderIndex = 0; senderIndex < amountOfClients; senderIndex++)
+		{
+			// Larger than the max read in size, so the message is received into more than one provided buffer
+			std::string message(30000, static_cast<char>('a' + senderIndex));
+			ASSERT_TRUE(sockets[senderIndex].send(message).first);
+			std::this_thread::sleep_for(10ms);
+
+			ASSERT_FALSE(sockets[senderIndex].ready());
+			for (size_t clientIndex = 0; clientIndex < amountOfClients; clientIndex++)
+			{
+				if (clientIndex != senderIndex)
+				{
+					ASSERT_EQ(message, receiveAll(sockets[clientIndex], message.size()));
+				}
+			}
+		}
+
+		sockets[0].close();
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(amountOfClients - 1, forwarder.tcpGroupMemberCount(groupId));
+
+		std::string message = "after disconnect";
+		ASSERT_TRUE(sockets[1].send(message).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(message, receiveAll(sockets[2], message.size()));
+		ASSERT_EQ(message, receiveAll(sockets[3], message.size()));
+
+		for (size_t i = 1; i < amountOfClients; i++)
+		{
+			sockets[i].close();
+		}
+	}
+
+	TEST_F(TCPSocketForwarderIoUringTest, TestFramesSpanningReceivesAreForwardedWhole)
+	{
+		kt::TCPSocket sender("localhost", serverSocket.getPort());
+		kt::TCPSocket receiver("localhost", serverSocket.getPort());
+		ASSERT_TRUE(sender.send(NEW_CLIENT_PREFIX_DEFAULT + framedGroupId).first);
+		ASSERT_TRUE(receiver.send(NEW_CLIENT_PREFIX_DEFAULT + framedGroupId).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_EQ(2, forwarder.tcpGroupMemberCount(framedGroupId));
+
+		std::string frame = encodeFrameHeader(FramingMode::Varint, 20000) + std::string(20000, 'F');
+		ASSERT_TRUE(sender.send(frame.substr(0, 1)).first);
+		std::this_thread::sleep_for(10ms);
+		ASSERT_FALSE(receiver.ready());
+
+		ASSERT_TRUE(sender.send(frame.substr(1)).first);
+		std::this_thread::sleep_for(20ms);
+		ASSERT_EQ(frame, receiveAll(receiver, frame.size()));
+
+		sender.close();
+		receiver.close();
+	}
+
+	TEST_F(TCPSocketForwarderIoUringTest, TestStalledClientIsClosedAfterHandshakeTimeout)
+	{
+		std::string joinMessage = NEW_CLIENT_PREFIX_DEFAULT + "TCPSocketForwarderIoUringTest-handshake-group";
+		kt::TCPSocket stalled("localhost", serverSocket.getPort());
+		ASSERT_TRUE(stalled.send(joinMessage.substr(0, 6)).first);
+		std::this_thread::sleep_for(10ms);
+
+		char byte;
+		ASSERT_EQ(-1, recv(stalled.getSocket(), &byte, 1, MSG_DONTWAIT));
+		std::this_thread::sleep_for(200ms);
+		ASSERT_EQ(0, recv(stalled.getSocket(), &byte, 1, MSG_DONTWAIT));
+
+		stalled.close();
+	}
 }
@@ -2,9 +2,11 @@
 #include <thread>
 #include <chrono>
 #include <future>
+#include <sstream>
 
 #include "../../../socket-forwarder/environment/Environment.h"
 #include "../../../socket-forwarder/forwarder/Forwarder.h"
+#include "../../../socket-forwarder/sockets/Sockets.h"
 
 using namespace std::chrono_literals;
 
@@ -20,7 +22,7 @@ namespace forwarder
         UDPSocketForwarderTest() : udpSocket()
         {
             udpSocket.bind();
-            forwarder = forwarder::Forwarder(std::nullopt, udpSocket, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, true);
+            forwarder.emplace(std::nullopt, udpSocket, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, true);
         }
 
         void SetUp() override
@@ -98,6 +100,99 @@ namespace forwarder
 		client2.close();
 	}
 
+    TEST_F(UDPSocketForwarderTest, TestForwardingIsCountedInMetrics)
+    {
+        std::vector<kt::UDPSocket> clients(2);
+        for (kt::UDPSocket& client : clients)
+        {
+            ASSERT_TRUE(client.bind().first);
+            ASSERT_TRUE(client.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(client.getListeningPort().value())).first.first);
+        }
+        std::this_thread::sleep_for(10ms);
+        ASSERT_EQ(2, forwarder->udpGroupMemberCount());
+
+        std::string toSend = "TestForwardingIsCountedInMetrics";
+        ASSERT_TRUE(clients[0].sendTo("localhost", udpSocket.getListeningPort().value(), toSend).first.first);
+        std::this_thread::sleep_for(10ms);
+        for (kt::UDPSocket& client : clients)
+        {
+            ASSERT_TRUE(client.ready());
+            ASSERT_EQ(toSend, client.receiveFrom(50).first.value());
+        }
+
+        // Join messages are not counted as forwarded messages
+        ForwardingTotals totals = forwarder->forwardingTotals()[{ METRICS_PROTOCOL_UDP, "" }];
+        ASSERT_EQ(1, totals.messagesIn);
+        ASSERT_EQ(toSend.size(), totals.bytesIn);
+        ASSERT_EQ(2, totals.messagesOut);
+        ASSERT_EQ(toSend.size() * 2, totals.bytesOut);
+        ASSERT_EQ(0, totals.sendFailures);
+        ASSERT_EQ(1, totals.queueResidency.count);
+        ASSERT_EQ(2, totals.peerSend.count);
+        ASSERT_EQ(1, totals.receiveToFirstSend.count);
+        ASSERT_EQ(1, totals.receiveToLastSend.count);
+
+        std::ostringstream stream;
+        forwarder->writeMetrics(stream);
+        ASSERT_NE(std::string::npos, stream.str().find("socketforwarder_groups{protocol=\"udp\"} 1\n"));
+        ASSERT_NE(std::string::npos, stream.str().find("socketforwarder_group_members{protocol=\"udp\"} 2\n"));
+
+        for (kt::UDPSocket& client : clients)
+        {
+            client.close();
+        }
+    }
+
+    TEST_F(UDPSocketForwarderTest, TestChannelHeaderRoutesToNamedGroup)
+    {
+        kt::UDPSocket defaultPeer;
+        ASSERT_TRUE(defaultPeer.bind().first);
+        ASSERT_TRUE(defaultPeer.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(defaultPeer.getListeningPort().value())).first.first);
+
+        std::string groupId = "TestChannelHeaderRoutesToNamedGroup";
+        kt::UDPSocket groupPeer;
+        ASSERT_TRUE(groupPeer.bind().first);
+        ASSERT_TRUE(groupPeer.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + groupId + ":" + std::to_string(groupPeer.getListeningPort().value())).first.first);
+        std::this_thread::sleep_for(10ms);
+
+        ASSERT_EQ(1, forwarder->udpGroupMemberCount());
+        ASSERT_EQ(1, forwarder->udpGroupMemberCount(groupId));
+
+        // The channel header is removed and the message only reaches the named group
+        std::string toSend = "TestChannelHeaderRoutesToNamedGroup-message";
+        ASSERT_TRUE(defaultPeer.sendTo("localhost", udpSocket.getListeningPort().value(), encodeUDPChannelHeader(groupId) + toSend).first.first);
+        std::this_thread::sleep_for(10ms);
+        ASSERT_TRUE(groupPeer.ready());
+        ASSERT_EQ(toSend, groupPeer.receiveFrom(100).first.value());
+        ASSERT_FALSE(defaultPeer.ready());
+
+        // A default group message that starts with the channel marker is sent behind a header with an empty group ID
+        std::string markedMessage = "\xFF" + toSend;
+        ASSERT_TRUE(groupPeer.sendTo("localhost", udpSocket.getListeningPort().value(), encodeUDPChannelHeader("") + markedMessage).first.first);
+        std::this_thread::sleep_for(10ms);
+        ASSERT_TRUE(defaultPeer.ready());
+        ASSERT_EQ(markedMessage, defaultPeer.receiveFrom(100).first.value());
+        ASSERT_FALSE(groupPeer.ready());
+
+        // A message for a group that does not exist is dropped
+        ASSERT_TRUE(defaultPeer.sendTo("localhost", udpSocket.getListeningPort().value(), encodeUDPChannelHeader("missing") + toSend).first.first);
+        std::this_thread::sleep_for(10ms);
+        ASSERT_FALSE(groupPeer.ready());
+        ASSERT_FALSE(defaultPeer.ready());
+
+        ForwardingTotals totals = forwarder->forwardingTotals()[{ METRICS_PROTOCOL_UDP, groupId }];
+        ASSERT_EQ(1, totals.messagesIn);
+        ASSERT_EQ(toSend.size(), totals.bytesIn);
+        ASSERT_EQ(1, totals.messagesOut);
+
+        std::ostringstream stream;
+        forwarder->writeMetrics(stream);
+        ASSERT_NE(std::string::npos, stream.str().find("socketforwarder_groups{protocol=\"udp\"} 2\n"));
+
+        defaultPeer.close();
+        groupPeer.close();
+    }
+
     void receiveMessageAndAssertAsync(std::vector<kt::UDPSocket> sockets, size_t startIndex, unsigned long long endIndex, size_t messagesToReceive, std::string message)
     {
         ASSERT_GT(endIndex, startIndex);
@@ -217,4 +312,228 @@ namespace forwarder
         ASSERT_GT(receivedMessageCount, 0);
         ASSERT_LE(receivedMessageCount, messagesToSend * amountOfClients);
     }
+
+    class UDPSocketForwarderOffloadTest : public UDPSocketForwarderTest
+    {
+    protected:
+        void SetUp() override
+        {
+            // Enabled before starting, since the listener sizes its buffers for coalesced reads when it starts
+            if (!isUDPGSOSupported(udpSocket.getListeningSocket()) || !setUDPGRO(udpSocket.getListeningSocket(), true))
+            {
+                GTEST_SKIP() << "UDP_SEGMENT or UDP_GRO is not supported on this system.";
+            }
+            forwarder->start();
+        }
+    };
+
+    TEST_F(UDPSocketForwarderOffloadTest, TestCoalescedReadIsForwardedAsSeparateMessages)
+    {
+        kt::UDPSocket peer;
+        ASSERT_TRUE(peer.bind().first);
+        ASSERT_TRUE(peer.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(peer.getListeningPort().value())).first.first);
+        std::this_thread::sleep_for(10ms);
+        ASSERT_EQ(1, forwarder->udpGroupMemberCount());
+
+        // Sent as a single UDP_SEGMENT send, which reaches the forwarder as a single coalesced read over loopback
+        std::vector<std::string> toSend = { "segment-1", "segment-2", "segment-3", "last" };
+        std::vector<iovec> payloads;
+        for (std::string& message : toSend)
+        {
+            payloads.push_back({ message.data(), message.size() });
+        }
+        sockaddr_in forwarderAddress{};
+        forwarderAddress.sin_family = AF_INET;
+        forwarderAddress.sin_port = htons(udpSocket.getListeningPort().value());
+        forwarderAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        kt::SocketAddress address{};
+        address.ipv4 = forwarderAddress;
+        DatagramSendBatch batch(1);
+        ASSERT_TRUE(batch.add(payloads.data(), payloads.size(), static_cast<uint16_t>(toSend[0].size()), address, 0));
+        const int sender = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_EQ(1, batch.send(sender));
+        close(sender);
+        std::this_thread::sleep_for(20ms);
+
+        // The peer does not have UDP_GRO enabled, so whether or not the forwarder segments its sends every message arrives on its own
+        for (const std::string& message : toSend)
+        {
+            ASSERT_TRUE(peer.ready());
+            ASSERT_EQ(message, peer.receiveFrom(50).first.value());
+        }
+        ASSERT_FALSE(peer.ready());
+
+        ForwardingTotals totals = forwarder->forwardingTotals()[{ METRICS_PROTOCOL_UDP, "" }];
+        ASSERT_EQ(toSend.size(), totals.messagesIn);
+        ASSERT_EQ(toSend.size(), totals.messagesOut);
+        ASSERT_EQ(0, totals.sendFailures);
+        ASSERT_EQ(toSend.size(), totals.receiveToLastSend.count);
+        peer.close();
+    }
+
+    class UDPSocketForwarderReusePortTest : public UDPSocketForwarderTest
+    {
+    protected:
+        void SetUp() override
+        {
+            forwarder->setUDPReceivers(4, false);
+            forwarder->start();
+        }
+    };
+
+    TEST_F(UDPSocketForwarderReusePortTest, TestPeersJoiningThroughAnyReceiverShareTheGroup)
+    {
+        // Enough peers that the kernel's hash is very likely to spread their joins across several receivers
+        const size_t amountOfClients = 16;
+        std::vector<kt::UDPSocket> sockets;
+        for (size_t i = 0; i < amountOfClients; i++)
+        {
+            kt::UDPSocket socket;
+            ASSERT_TRUE(socket.bind().first);
+            ASSERT_TRUE(socket.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(socket.getListeningPort().value())).first.first);
+            sockets.push_back(socket);
+        }
+        std::this_thread::sleep_for(20ms);
+        ASSERT_EQ(amountOfClients, forwarder->udpGroupMemberCount());
+
+        // Each message is sent from a different peer, so it may be read by any receiver but still reaches everyone
+        for (size_t i = 0; i < amountOfClients; i++)
+        {
+            std::string toSend = "UDPSocketForwarderReusePortTest" + std::to_string(i);
+            ASSERT_TRUE(sockets[i].sendTo("localhost", udpSocket.getListeningPort().value(), toSend).first.first);
+            std::this_thread::sleep_for(5ms);
+            for (kt::UDPSocket& socket : sockets)
+            {
+                ASSERT_TRUE(socket.ready());
+                ASSERT_EQ(toSend, socket.receiveFrom(50).first.value());
+            }
+        }
+
+        ForwardingTotals totals = forwarder->forwardingTotals()[{ METRICS_PROTOCOL_UDP, "" }];
+        ASSERT_EQ(amountOfClients, totals.messagesIn);
+        for (kt::UDPSocket& socket : sockets)
+        {
+            socket.close();
+        }
+    }
+
+    class UDPSocketForwarderPeerExpiryTest : public UDPSocketForwarderTest
+    {
+    protected:
+        kt::UDPSocket preconfigured;
+
+        void SetUp() override
+        {
+            ASSERT_TRUE(preconfigured.bind().first);
+            kt::SocketAddress address{};
+            address.ipv4.sin_family = AF_INET;
+            address.ipv4.sin_port = htons(preconfigured.getListeningPort().value());
+            address.ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            forwarder->preConfigureUDPAddress("", address);
+            forwarder->setUDPPeerExpiry(200ms, false);
+            forwarder->start();
+        }
+
+        void TearDown() override
+        {
+            UDPSocketForwarderTest::TearDown();
+            preconfigured.close();
+        }
+    };
+
+    TEST_F(UDPSocketForwarderPeerExpiryTest, TestIdlePeersAreRemovedAndActivePeersKept)
+    {
+        kt::UDPSocket idle;
+        kt::UDPSocket active;
+        for (kt::UDPSocket* socket : { &idle, &active })
+        {
+            ASSERT_TRUE(socket->bind().first);
+            ASSERT_TRUE(socket->sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(socket->getListeningPort().value())).first.first);
+        }
+        std::this_thread::sleep_for(10ms);
+        ASSERT_EQ(3, forwarder->udpGroupMemberCount());
+
+        // Empty datagrams keep the active peer alive without being forwarded, well past the idle peer's TTL
+        sockaddr_in forwarderAddress{};
+        forwarderAddress.sin_family = AF_INET;
+        forwarderAddress.sin_port = htons(udpSocket.getListeningPort().value());
+        forwarderAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        for (int i = 0; i < 8; i++)
+        {
+            ASSERT_EQ(0, sendto(active.getListeningSocket(), "", 0, 0, reinterpret_cast<const sockaddr*>(&forwarderAddress), sizeof(forwarderAddress)));
+            std::this_thread::sleep_for(50ms);
+        }
+        ASSERT_EQ(2, forwarder->udpGroupMemberCount());
+        ASSERT_FALSE(active.ready());
+        ASSERT_FALSE(preconfigured.ready());
+
+        // The preconfigured address is exempt, so it still receives along with the active peer
+        std::string toSend = "UDPSocketForwarderPeerExpiryTest";
+        ASSERT_TRUE(active.sendTo("localhost", udpSocket.getListeningPort().value(), toSend).first.first);
+        std::this_thread::sleep_for(10ms);
+        for (kt::UDPSocket* socket : { &active, &preconfigured })
+        {
+            ASSERT_TRUE(socket->ready());
+            ASSERT_EQ(toSend, socket->receiveFrom(50).first.value());
+        }
+        ASSERT_FALSE(idle.ready());
+
+        // Joining again brings the idle peer back
+        ASSERT_TRUE(idle.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(idle.getListeningPort().value())).first.first);
+        std::this_thread::sleep_for(10ms);
+        ASSERT_EQ(3, forwarder->udpGroupMemberCount());
+
+        idle.close();
+        active.close();
+    }
+
+    class UDPSocketForwarderIoUringTest : public UDPSocketForwarderTest
+    {
+    protected:
+        void SetUp() override
+        {
+            if (!isIoUringSupported())
+            {
+                GTEST_SKIP() << "io_uring is not available on this system.";
+            }
+            forwarder->setIOEngine(IOEngine::IoUring);
+            forwarder->start();
+        }
+    };
+
+    TEST_F(UDPSocketForwarderIoUringTest, TestMessagesAreForwardedToEveryPeer)
+    {
+        const size_t amountOfClients = 3;
+        std::vector<kt::UDPSocket> sockets;
+        for (size_t i = 0; i < amountOfClients; i++)
+        {
+            kt::UDPSocket socket;
+            ASSERT_TRUE(socket.bind().first);
+            ASSERT_TRUE(socket.sendTo("localhost", udpSocket.getListeningPort().value(), NEW_CLIENT_PREFIX_DEFAULT + std::to_string(socket.getListeningPort().value())).first.first);
+            sockets.push_back(socket);
+        }
+        std::this_thread::sleep_for(10ms);
+        ASSERT_EQ(amountOfClients, forwarder->udpGroupMemberCount());
+
+        const size_t messagesToSend = 5;
+        for (size_t i = 0; i < messagesToSend; i++)
+        {
+            std::string toSend = "UDPSocketForwarderIoUringTest" + std::to_string(i);
+            ASSERT_TRUE(sockets[i % amountOfClients].sendTo("localhost", udpSocket.getListeningPort().value(), toSend).first.first);
+            std::this_thread::sleep_for(10ms);
+
+            for (kt::UDPSocket& socket : sockets)
+            {
+                ASSERT_TRUE(socket.ready());
+                std::pair<std::optional<std::string>, std::pair<int, kt::SocketAddress>> readResult = socket.receiveFrom(50);
+                ASSERT_NE(-1, readResult.second.first);
+                ASSERT_EQ(toSend, readResult.first.value());
+            }
+        }
+
+        for (kt::UDPSocket& socket : sockets)
+        {
+            socket.close();
+        }
+    }
 }
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../../../socket-forwarder/framing/Framing.h"
+
+namespace forwarder
+{
+    std::string frame(const FramingMode mode, const std::string& payload)
+    {
+        return encodeFrameHeader(mode, payload.size()) + payload;
+    }
+
+    TEST(FramingTest, ParseFramingMode)
+    {
+        ASSERT_EQ(FramingMode::None, parseFramingMode("none"));
+        ASSERT_EQ(FramingMode::Varint, parseFramingMode("varint"));
+        ASSERT_EQ(FramingMode::UInt32, parseFramingMode("u32"));
+        ASSERT_FALSE(parseFramingMode("u64").has_value());
+
+        ASSERT_EQ("varint", framingModeToString(FramingMode::Varint));
+        ASSERT_EQ("u32", framingModeToString(FramingMode::UInt32));
+    }
+
+    TEST(FramingTest, EncodeVarintHeader)
+    {
+        ASSERT_EQ(std::string(1, '\x00'), encodeFrameHeader(FramingMode::Varint, 0));
+        ASSERT_EQ(std::string(1, '\x7F'), encodeFrameHeader(FramingMode::Varint, 127));
+        ASSERT_EQ(std::string("\x80\x01", 2), encodeFrameHeader(FramingMode::Varint, 128));
+        ASSERT_EQ(std::string("\xAC\x02", 2), encodeFrameHeader(FramingMode::Varint, 300));
+        ASSERT_EQ(std::string("\x00\x00\x01\x2C", 4), encodeFrameHeader(FramingMode::UInt32, 300));
+    }
+
+    TEST(FramingTest, ScanMultipleWholeFrames)
+    {
+        for (FramingMode mode : { FramingMode::Varint, FramingMode::UInt32 })
+        {
+            std::string frames = frame(mode, "first") + frame(mode, "") + frame(mode, std::string(300, 'x'));
+            FrameScan scan = scanFrames(mode, frames.data(), frames.size(), 0);
+            ASSERT_FALSE(scan.invalid);
+            ASSERT_EQ(3, scan.frameCount);
+            ASSERT_EQ(frames.size(), scan.completeBytes);
+            ASSERT_EQ(0, scan.nextFrameSize);
+        }
+    }
+
+    /**
+     * Scanning stops at the first frame that has not been fully received, whether its header or its payload is incomplete.
+     */
+    TEST(FramingTest, ScanStopsAtIncompleteFrame)
+    {
+        for (FramingMode mode : { FramingMode::Varint, FramingMode::UInt32 })
+        {
+            std::string whole = frame(mode, "whole");
+            std::string next = frame(mode, std::string(200, 'y'));
+
+            std::string buffer = whole + next.substr(0, 1);
+            FrameScan scan = scanFrames(mode, buffer.data(), buffer.size(), 0);
+            ASSERT_FALSE(scan.invalid);
+            ASSERT_EQ(1, scan.frameCount);
+            ASSERT_EQ(whole.size(), scan.completeBytes);
+            ASSERT_EQ(0, scan.nextFrameSize);
+
+            buffer = whole + next.substr(0, next.size() - 1);
+            scan = scanFrames(mode, buffer.data(), buffer.size(), 0);
+            ASSERT_FALSE(scan.invalid);
+            ASSERT_EQ(1, scan.frameCount);
+            ASSERT_EQ(whole.size(), scan.completeBytes);
+            ASSERT_EQ(next.size(), scan.nextFrameSize);
+        }
+    }
+
+    TEST(FramingTest, ScanRejectsFramesOverMaximumSize)
+    {
+        for (FramingMode mode : { FramingMode::Varint, FramingMode::UInt32 })
+        {
+            std::string frames = frame(mode, "small") + encodeFrameHeader(mode, 1025);
+            FrameScan scan = scanFrames(mode, frames.data(), frames.size(), 1024);
+            ASSERT_TRUE(scan.invalid);
+            ASSERT_EQ(1, scan.frameCount);
+
+            scan = scanFrames(mode, frames.data(), frames.size(), 0);
+            ASSERT_FALSE(scan.invalid);
+        }
+    }
+
+    TEST(FramingTest, ScanRejectsOverlongVarint)
+    {
+        std::string header(11, '\xFF');
+        FrameScan scan = scanFrames(FramingMode::Varint, header.data(), header.size(), 0);
+        ASSERT_TRUE(scan.invalid);
+        ASSERT_EQ(0, scan.completeBytes);
+    }
+
+    TEST(FramingTest, ParseUDPChannel)
+    {
+        std::string message = encodeUDPChannelHeader("group-a") + "payload";
+        std::optional<UDPChannel> channel = parseUDPChannel(message.data(), message.size());
+        ASSERT_TRUE(channel.has_value());
+        ASSERT_EQ("group-a", channel->groupId);
+        ASSERT_EQ(2 + std::string("group-a").size(), channel->headerSize);
+        ASSERT_EQ("payload", message.substr(channel->headerSize));
+
+        // A message without the marker belongs to the default group
+        std::string plain = "payload";
+        channel = parseUDPChannel(plain.data(), plain.size());
+        ASSERT_TRUE(channel.has_value());
+        ASSERT_TRUE(channel->groupId.empty());
+        ASSERT_EQ(0, channel->headerSize);
+
+        // An empty group ID names the default group, so a default group payload can start with the marker
+        std::string escaped = encodeUDPChannelHeader("") + "\xFF" + "payload";
+        channel = parseUDPChannel(escaped.data(), escaped.size());
+        ASSERT_TRUE(channel.has_value());
+        ASSERT_TRUE(channel->groupId.empty());
+        ASSERT_EQ(2, channel->headerSize);
+        ASSERT_EQ("\xFFpayload", escaped.substr(channel->headerSize));
+
+        // A header that is cut short is rejected
+        ASSERT_FALSE(parseUDPChannel(message.data(), 1).has_value());
+        ASSERT_FALSE(parseUDPChannel(message.data(), 5).has_value());
+    }
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <chrono>
+
+#include "../../../socket-forwarder/environment/Environment.h"
+#include "../../../socket-forwarder/forwarder/Forwarder.h"
+#include "../../../socket-forwarder/loadgen/LoadGenerator.h"
+
+using namespace std::chrono_literals;
+
+namespace forwarder
+{
+    TEST(LoadGeneratorTest, Payload_RoundTrips)
+    {
+        std::vector<char> payload(32, 'x');
+        encodeLoadPayload(payload.data(), payload.size(), { 7, 123456789012345, 987654321 });
+
+        std::optional<LoadPayloadHeader> header = decodeLoadPayload(payload.data(), payload.size());
+        ASSERT_TRUE(header.has_value());
+        ASSERT_EQ(7, header->publisherId);
+        ASSERT_EQ(123456789012345, header->sequence);
+        ASSERT_EQ(987654321, header->sentAtNanoseconds);
+        // The rest of the payload is left as it was
+        ASSERT_EQ('x', payload[LOAD_PAYLOAD_HEADER_SIZE]);
+
+        ASSERT_FALSE(decodeLoadPayload(payload.data(), LOAD_PAYLOAD_HEADER_SIZE - 1).has_value());
+        payload[0] = 'x';
+        ASSERT_FALSE(decodeLoadPayload(payload.data(), payload.size()).has_value());
+    }
+
+    TEST(LoadGeneratorTest, SequenceTracker_CountsLateMessagesAsReordered)
+    {
+        SequenceTracker tracker;
+        ASSERT_FALSE(tracker.record(0));
+        ASSERT_FALSE(tracker.record(1));
+        // 2 and 3 are missing until they arrive late
+        ASSERT_FALSE(tracker.record(4));
+        ASSERT_TRUE(tracker.record(2));
+        ASSERT_TRUE(tracker.record(3));
+        ASSERT_FALSE(tracker.record(5));
+    }
+
+    TEST(LoadGeneratorTest, Run_ThroughForwarder)
+    {
+        kt::ServerSocket serverSocket(kt::SocketType::Wifi);
+        kt::UDPSocket udpSocket;
+        udpSocket.bind();
+        Forwarder forwarder(serverSocket, udpSocket, NEW_CLIENT_PREFIX_DEFAULT, MAX_READ_IN_DEFAULT, false);
+        forwarder.start();
+
+        LoadGeneratorConfig config;
+        config.tcpPort = serverSocket.getPort();
+        config.udpPort = udpSocket.getListeningPort();
+        config.tcpGroups = 2;
+        config.tcpClientsPerGroup = 3;
+        config.udpPeers = 3;
+        config.rate = 200;
+        config.messageSize = 100;
+        config.duration = 250ms;
+        config.joinWait = 100ms;
+        config.drain = 200ms;
+
+        LoadGenerator generator(config);
+        LoadReport tcp;
+        LoadReport udp;
+        ASSERT_TRUE(generator.run(tcp, udp));
+
+        ASSERT_GT(tcp.sent, 0);
+        // Every message is received by the 2 receivers in its group
+        ASSERT_EQ(tcp.sent * 2, tcp.expected);
+        ASSERT_EQ(tcp.expected, tcp.received);
+        ASSERT_EQ(0, tcp.getLost());
+        ASSERT_EQ(0, tcp.reordered);
+        ASSERT_EQ(0, tcp.malformed);
+        ASSERT_EQ(tcp.received, tcp.latency.count);
+
+        ASSERT_GT(udp.sent, 0);
+        ASSERT_EQ(udp.sent * 3, udp.expected);
+        ASSERT_EQ(udp.expected, udp.received);
+        ASSERT_EQ(0, udp.malformed);
+        ASSERT_EQ(udp.received, udp.latency.count);
+
+        forwarder.stop();
+        forwarder.join();
+        serverSocket.close();
+        udpSocket.close();
+    }
+
+    TEST(LoadGeneratorTest, Run_FailsWithoutForwarder)
+    {
+        kt::ServerSocket serverSocket(kt::SocketType::Wifi);
+        const unsigned short port = serverSocket.getPort();
+        serverSocket.close();
+
+        LoadGeneratorConfig config;
+        config.tcpPort = port;
+        LoadGenerator generator(config);
+        LoadReport tcp;
+        LoadReport udp;
+        ASSERT_FALSE(generator.run(tcp, udp));
+    }
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+
+#include "../../../socket-forwarder/logging/Logger.h"
+
+using namespace std::chrono_literals;
+
+namespace forwarder
+{
+    static std::vector<std::string> splitLines(const std::string& output)
+    {
+        std::vector<std::string> lines;
+        std::istringstream stream(output);
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    TEST(LoggerTest, ParseLogLevel)
+    {
+        ASSERT_EQ(LogLevel::Debug, parseLogLevel("debug"));
+        ASSERT_EQ(LogLevel::Info, parseLogLevel("info"));
+        ASSERT_EQ(LogLevel::Warning, parseLogLevel("warning"));
+        ASSERT_EQ(LogLevel::Error, parseLogLevel("error"));
+        ASSERT_FALSE(parseLogLevel("verbose").has_value());
+
+        for (LogLevel level : { LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error })
+        {
+            ASSERT_EQ(level, parseLogLevel(logLevelToString(level)));
+        }
+    }
+
+    TEST(LoggerTest, Log_ArgumentsAreFormattedInOrder)
+    {
+        std::ostringstream output;
+        Logger logger(output);
+
+        std::string group = "group";
+        logger.log(LogLevel::Warning, "[TCP] - Group [", group, "] peer [", 42, "] queued [", size_t(1024), "] bytes ", -7, ' ', true, " ", 1.5, " ", std::string_view("view"));
+        logger.flush();
+
+        std::vector<std::string> lines = splitLines(output.str());
+        ASSERT_EQ(1, lines.size());
+        ASSERT_NE(std::string::npos, lines[0].find(" WARN  [TCP] - Group [group] peer [42] queued [1024] bytes -7 1 1.5 view"));
+        // Starts with a UTC timestamp, e.g. 2024-01-01T00:00:00.000Z
+        ASSERT_EQ('T', lines[0][10]);
+        ASSERT_EQ('Z', lines[0][23]);
+    }
+
+    TEST(LoggerTest, Log_MessagesBelowTheLevelAreNotWritten)
+    {
+        std::ostringstream output;
+        Logger logger(output);
+        ASSERT_EQ(LogLevel::Info, logger.getLevel());
+        ASSERT_FALSE(logger.isEnabled(LogLevel::Debug));
+
+        logger.log(LogLevel::Debug, "hidden");
+        logger.log(LogLevel::Info, "shown");
+        logger.setLevel(LogLevel::Error);
+        logger.log(LogLevel::Warning, "hidden");
+        logger.log(LogLevel::Error, "error");
+        logger.flush();
+
+        std::vector<std::string> lines = splitLines(output.str());
+        ASSERT_EQ(2, lines.size());
+        ASSERT_NE(std::string::npos, lines[0].find("INFO  shown"));
+        ASSERT_NE(std::string::npos, lines[1].find("ERROR error"));
+    }
+
+    TEST(LoggerTest, Log_LongMessagesAreTruncated)
+    {
+        std::ostringstream output;
+        Logger logger(output);
+
+        std::string message(LOG_RECORD_TEXT_SIZE * 2, 'x');
+        logger.log(LogLevel::Info, message);
+        logger.flush();
+
+        std::vector<std::string> lines = splitLines(output.str());
+        ASSERT_EQ(1, lines.size());
+        ASSERT_NE(std::string::npos, lines[0].find(std::string(LOG_RECORD_TEXT_SIZE, 'x') + "..."));
+        ASSERT_EQ(std::string::npos, lines[0].find(std::string(LOG_RECORD_TEXT_SIZE + 1, 'x')));
+    }
+
+    /**
+     * Every thread has its own ring, so the messages of each thread are written in the order that thread logged them.
+     */
+    TEST(LoggerTest, Log_MessagesFromManyThreadsAreAllWritten)
+    {
+        std::ostringstream output;
+        Logger logger(output);
+
+        const size_t threadCount = 4;
+        const size_t messageCount = 200;
+        std::vector<std::thread> threads;
+        for (size_t thread = 0; thread < threadCount; thread++)
+        {
+            threads.emplace_back([&logger, thread]()
+            {
+                for (size_t message = 0; message < messageCount; message++)
+                {
+                    logger.log(LogLevel::Info, "thread ", thread, " message ", message);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        logger.flush();
+
+        std::vector<std::string> lines = splitLines(output.str());
+        ASSERT_EQ(threadCount * messageCount, lines.size());
+        std::vector<size_t> nextMessage(threadCount, 0);
+        for (const std::string& line : lines)
+        {
+            size_t thread = 0;
+            size_t message = 0;
+            ASSERT_EQ(2, std::sscanf(line.substr(line.find("thread")).c_str(), "thread %zu message %zu", &thread, &message));
+            ASSERT_EQ(nextMessage[thread], message);
+            nextMessage[thread]++;
+        }
+    }
+
+    /**
+     * A thread that logs faster than the writer drains its ring has the overflow dropped rather than waiting, and the drops are reported.
+     */
+    TEST(LoggerTest, Log_FullRingDropsMessagesAndReportsThem)
+    {
+        std::ostringstream output;
+        Logger logger(output);
+
+        const size_t messageCount = LOG_RING_CAPACITY * 20;
+        for (size_t message = 0; message < messageCount; message++)
+        {
+            logger.log(LogLevel::Info, "message ", message);
+        }
+        logger.flush();
+
+        size_t written = 0;
+        size_t dropped = 0;
+        for (const std::string& line : splitLines(output.str()))
+        {
+            size_t position = line.find("[LOG] - Dropped [");
+            if (position != std::string::npos)
+            {
+                dropped += std::stoul(line.substr(position + 17));
+            }
+            else
+            {
+                written++;
+            }
+        }
+        ASSERT_GT(dropped, 0);
+        ASSERT_EQ(messageCount, written + dropped);
+    }
+
+    TEST(LoggerTest, LogRateLimiter_SuppressesRepeatsWithinTheInterval)
+    {
+        std::ostringstream output;
+        Logger logger(output);
+        LogRateLimiter limiter(100ms);
+
+        for (size_t i = 0; i < 6; i++)
+        {
+            logger.log(limiter, LogLevel::Warning, "slow consumer");
+        }
+        std::this_thread::sleep_for(150ms);
+        logger.log(limiter, LogLevel::Warning, "slow consumer");
+        logger.flush();
+
+        std::vector<std::string> lines = splitLines(output.str());
+        ASSERT_EQ(2, lines.size());
+        ASSERT_NE(std::string::npos, lines[0].find("WARN  slow consumer"));
+        ASSERT_EQ(std::string::npos, lines[0].find("suppressed"));
+        ASSERT_NE(std::string::npos, lines[1].find("slow consumer [5] similar message(s) suppressed."));
+    }
+}
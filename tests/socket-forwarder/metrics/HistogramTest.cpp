@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "../../../socket-forwarder/metrics/Histogram.h"
+
+namespace forwarder
+{
+    /**
+     * Every value lands in a bucket whose range contains it and is at most 1/16th of the value wide.
+     */
+    TEST(HistogramTest, BucketIndex_KeepsTheRelativeError)
+    {
+        for (uint64_t value = 0; value < HISTOGRAM_SUB_BUCKETS; value++)
+        {
+            ASSERT_EQ(value, LatencyHistogram::bucketIndex(value));
+            ASSERT_EQ(value, LatencyHistogram::bucketHighestValue(value));
+        }
+
+        size_t previous = 0;
+        for (uint64_t value = HISTOGRAM_SUB_BUCKETS; value < (uint64_t(1) << (HISTOGRAM_HIGHEST_POWER + 1)); value += value / 97 + 1)
+        {
+            const size_t index = LatencyHistogram::bucketIndex(value);
+            ASSERT_GE(index, previous);
+            ASSERT_LT(index, HISTOGRAM_BUCKET_COUNT - 1);
+            const uint64_t highest = LatencyHistogram::bucketHighestValue(index);
+            ASSERT_GE(highest, value);
+            ASSERT_LE(highest - value, value / HISTOGRAM_SUB_BUCKETS);
+            previous = index;
+        }
+
+        ASSERT_EQ(HISTOGRAM_BUCKET_COUNT - 1, LatencyHistogram::bucketIndex(uint64_t(1) << (HISTOGRAM_HIGHEST_POWER + 1)));
+        ASSERT_EQ(HISTOGRAM_BUCKET_COUNT - 1, LatencyHistogram::bucketIndex(UINT64_MAX));
+    }
+
+    TEST(HistogramTest, ValueAtPercentile)
+    {
+        LatencyHistogram histogram;
+        ASSERT_EQ(0, histogram.snapshot().valueAtPercentile(50.0));
+
+        for (uint64_t value = 1; value <= 1000; value++)
+        {
+            histogram.record(value * 1000);
+        }
+        histogram.record(std::chrono::milliseconds(5));
+        // Negative durations are recorded as 0
+        histogram.record(std::chrono::steady_clock::duration(-10));
+
+        HistogramSnapshot snapshot = histogram.snapshot();
+        ASSERT_EQ(1002, snapshot.count);
+        ASSERT_EQ(500500000 + 5000000, snapshot.sum);
+        ASSERT_EQ(5000000, snapshot.max);
+
+        const uint64_t median = snapshot.valueAtPercentile(50.0);
+        ASSERT_GE(median, 500000);
+        ASSERT_LE(median, 500000 + 500000 / HISTOGRAM_SUB_BUCKETS);
+        const uint64_t p99 = snapshot.valueAtPercentile(99.0);
+        ASSERT_GE(p99, 991000);
+        ASSERT_LE(p99, 991000 + 991000 / HISTOGRAM_SUB_BUCKETS);
+        // Percentiles are never reported above the highest recorded value
+        ASSERT_EQ(5000000, snapshot.valueAtPercentile(100.0));
+        ASSERT_EQ(0, snapshot.valueAtPercentile(0.0));
+    }
+
+    TEST(HistogramTest, Snapshot_MergesHistograms)
+    {
+        LatencyHistogram fast;
+        LatencyHistogram slow;
+        for (size_t i = 0; i < 99; i++)
+        {
+            fast.record(uint64_t(100));
+        }
+        slow.record(uint64_t(100000));
+
+        HistogramSnapshot merged = fast.snapshot();
+        merged += slow.snapshot();
+        ASSERT_EQ(100, merged.count);
+        ASSERT_EQ(99 * 100 + 100000, merged.sum);
+        ASSERT_EQ(100000, merged.max);
+        ASSERT_GE(merged.valueAtPercentile(99.0), 100);
+        ASSERT_LE(merged.valueAtPercentile(99.0), 100 + 100 / HISTOGRAM_SUB_BUCKETS);
+        ASSERT_EQ(100000, merged.valueAtPercentile(99.9));
+    }
+
+    /**
+     * Each writer records into its own histogram while another thread keeps reading them, no recorded value is lost once the writers finish.
+     */
+    TEST(HistogramTest, Snapshot_WhileRecording)
+    {
+        const size_t threadCount = 4;
+        const uint64_t valueCount = 100000;
+        std::vector<LatencyHistogram> histograms(threadCount);
+        std::atomic<bool> recording{ true };
+
+        std::thread reader([&histograms, &recording, valueCount]()
+        {
+            while (recording)
+            {
+                for (const LatencyHistogram& histogram : histograms)
+                {
+                    HistogramSnapshot snapshot = histogram.snapshot();
+                    ASSERT_LE(snapshot.count, valueCount);
+                }
+            }
+        });
+
+        std::vector<std::thread> writers;
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            writers.emplace_back([&histogram = histograms[i]]()
+            {
+                for (uint64_t value = 0; value < valueCount; value++)
+                {
+                    histogram.record(value);
+                }
+            });
+        }
+        for (std::thread& writer : writers)
+        {
+            writer.join();
+        }
+        recording = false;
+        reader.join();
+
+        HistogramSnapshot merged;
+        for (const LatencyHistogram& histogram : histograms)
+        {
+            merged += histogram.snapshot();
+        }
+        ASSERT_EQ(threadCount * valueCount, merged.count);
+        ASSERT_EQ(threadCount * (valueCount * (valueCount - 1) / 2), merged.sum);
+        ASSERT_EQ(valueCount - 1, merged.max);
+    }
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <ostream>
+
+#include "../../../socket-forwarder/metrics/MetricsServer.h"
+
+namespace forwarder
+{
+    class MetricsServerTest : public ::testing::Test
+    {
+    protected:
+        MetricsServer server;
+
+        MetricsServerTest() : server([](std::ostream& stream) { stream << "socketforwarder_test_metric 1\n"; }) {}
+
+        void SetUp() override
+        {
+            ASSERT_TRUE(server.start("127.0.0.1", 0));
+            ASSERT_NE(0, server.getPort());
+        }
+
+        void TearDown() override
+        {
+            server.stop();
+        }
+
+        std::string request(const std::string& requestLine)
+        {
+            kt::TCPSocket client("127.0.0.1", server.getPort());
+            EXPECT_TRUE(client.send(requestLine + "\r\nHost: localhost\r\n\r\n").first);
+
+            std::string response;
+            while (client.ready(1000000))
+            {
+                std::string received = client.receiveAmount(4096);
+                if (received.empty())
+                {
+                    break;
+                }
+                response += received;
+            }
+            client.close();
+            return response;
+        }
+    };
+
+    TEST_F(MetricsServerTest, GetMetrics_ReturnsTheWrittenMetrics)
+    {
+        std::string response = request("GET /metrics HTTP/1.1");
+        ASSERT_EQ(0, response.rfind("HTTP/1.1 200 OK\r\n", 0));
+        ASSERT_NE(std::string::npos, response.find("Content-Type: text/plain; version=0.0.4"));
+        ASSERT_NE(std::string::npos, response.find("Content-Length: 30\r\n"));
+        ASSERT_NE(std::string::npos, response.find("\r\n\r\nsocketforwarder_test_metric 1\n"));
+
+        // The server keeps serving after each request
+        response = request("GET /metrics HTTP/1.0");
+        ASSERT_EQ(0, response.rfind("HTTP/1.1 200 OK\r\n", 0));
+    }
+
+    TEST_F(MetricsServerTest, OtherRequests_AreRejected)
+    {
+        ASSERT_EQ(0, request("GET /other HTTP/1.1").rfind("HTTP/1.1 404 Not Found\r\n", 0));
+        ASSERT_EQ(0, request("POST /metrics HTTP/1.1").rfind("HTTP/1.1 405 Method Not Allowed\r\n", 0));
+    }
+}
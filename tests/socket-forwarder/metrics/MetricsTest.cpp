@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <chrono>
+
+#include "../../../socket-forwarder/metrics/Metrics.h"
+
+namespace forwarder
+{
+    TEST(MetricsTest, ForwardingCounters_AreCacheLinePadded)
+    {
+        ASSERT_EQ(64, alignof(ForwardingCounters));
+        ASSERT_EQ(0, sizeof(ForwardingCounters) % 64);
+    }
+
+    /**
+     * Each thread writes its own counters for the same series, they are added together when read.
+     */
+    TEST(MetricsTest, Totals_AddsTheCountersOfEveryThread)
+    {
+        Metrics metrics;
+        const MetricsSeries series{ METRICS_PROTOCOL_TCP, "group" };
+        const size_t threadCount = 4;
+        const size_t messageCount = 10000;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back([&metrics, &series]()
+            {
+                std::shared_ptr<ForwardingCounters> counters = metrics.createCounters(series);
+                for (size_t message = 0; message < messageCount; message++)
+                {
+                    counters->recordReceived(10);
+                    counters->recordSent(10);
+                    counters->recordSent(10);
+                }
+                counters->recordSendFailure();
+                counters->recordRemoval();
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        std::shared_ptr<ForwardingCounters> udpCounters = metrics.createCounters({ METRICS_PROTOCOL_UDP, "" });
+        udpCounters->recordReceived(5);
+        udpCounters->recordDropped(2, 7);
+
+        std::map<MetricsSeries, ForwardingTotals> totals = metrics.totals();
+        ASSERT_EQ(2, totals.size());
+        const ForwardingTotals& group = totals[series];
+        ASSERT_EQ(threadCount * messageCount, group.messagesIn);
+        ASSERT_EQ(threadCount * messageCount * 10, group.bytesIn);
+        ASSERT_EQ(threadCount * messageCount * 2, group.messagesOut);
+        ASSERT_EQ(threadCount * messageCount * 20, group.bytesOut);
+        ASSERT_EQ(threadCount, group.sendFailures);
+        ASSERT_EQ(threadCount, group.removals);
+
+        const ForwardingTotals& udp = totals[{ METRICS_PROTOCOL_UDP, "" }];
+        ASSERT_EQ(1, udp.messagesIn);
+        ASSERT_EQ(5, udp.bytesIn);
+        ASSERT_EQ(2, udp.droppedMessages);
+        ASSERT_EQ(7, udp.droppedBytes);
+    }
+
+    TEST(MetricsTest, Write_UsesThePrometheusTextFormat)
+    {
+        Metrics metrics;
+        std::shared_ptr<ForwardingCounters> tcp = metrics.createCounters({ METRICS_PROTOCOL_TCP, "group-a" });
+        tcp->recordReceived(100);
+        tcp->recordSent(100);
+        tcp->recordSent(100);
+        metrics.createCounters({ METRICS_PROTOCOL_UDP, "" })->recordSendFailure();
+        metrics.createCounters({ METRICS_PROTOCOL_UDP, "" })->recordDropped(1, 64);
+
+        std::ostringstream stream;
+        metrics.write(stream, { { { METRICS_PROTOCOL_TCP, "group-a" }, 3 }, { { METRICS_PROTOCOL_TCP, "group-b" }, 1 }, { { METRICS_PROTOCOL_UDP, "" }, 2 } });
+        const std::string output = stream.str();
+
+        ASSERT_NE(std::string::npos, output.find("# TYPE socketforwarder_messages_in_total counter\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_messages_in_total{protocol=\"tcp\",group=\"group-a\"} 1\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_bytes_out_total{protocol=\"tcp\",group=\"group-a\"} 200\n"));
+        // Groups that have not forwarded anything are still written
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_messages_in_total{protocol=\"tcp\",group=\"group-b\"} 0\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_send_failures_total{protocol=\"udp\"} 1\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_dropped_bytes_total{protocol=\"udp\"} 64\n"));
+        ASSERT_NE(std::string::npos, output.find("# TYPE socketforwarder_groups gauge\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_groups{protocol=\"tcp\"} 2\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_groups{protocol=\"udp\"} 1\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_group_members{protocol=\"tcp\",group=\"group-a\"} 3\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_group_members{protocol=\"udp\"} 2\n"));
+    }
+
+    TEST(MetricsTest, Write_IncludesRecordedLatencies)
+    {
+        Metrics metrics;
+        std::shared_ptr<ForwardingCounters> first = metrics.createCounters({ METRICS_PROTOCOL_TCP, "group" });
+        std::shared_ptr<ForwardingCounters> second = metrics.createCounters({ METRICS_PROTOCOL_TCP, "group" });
+        for (size_t i = 0; i < 999; i++)
+        {
+            first->peerSend.record(std::chrono::microseconds(10));
+        }
+        second->peerSend.record(std::chrono::milliseconds(2));
+
+        std::ostringstream stream;
+        metrics.write(stream, {});
+        const std::string output = stream.str();
+
+        ASSERT_NE(std::string::npos, output.find("# TYPE socketforwarder_latency_microseconds summary\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_latency_microseconds{protocol=\"tcp\",group=\"group\",interval=\"peer_send\",quantile=\"0.5\"} 10.239\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_latency_microseconds{protocol=\"tcp\",group=\"group\",interval=\"peer_send\",quantile=\"0.999\"} 10.239\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_latency_microseconds_count{protocol=\"tcp\",group=\"group\",interval=\"peer_send\"} 1000\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_latency_microseconds_sum{protocol=\"tcp\",group=\"group\",interval=\"peer_send\"} 11990\n"));
+        ASSERT_NE(std::string::npos, output.find("socketforwarder_latency_max_microseconds{protocol=\"tcp\",group=\"group\",interval=\"peer_send\"} 2000\n"));
+        // Intervals that were never recorded are not written
+        ASSERT_EQ(std::string::npos, output.find("interval=\"queue_residency\""));
+    }
+
+    TEST(MetricsTest, EscapeMetricsLabel)
+    {
+        ASSERT_EQ("group", escapeMetricsLabel("group"));
+        ASSERT_EQ("a\\\"b\\\\c\\nd", escapeMetricsLabel("a\"b\\c\nd"));
+    }
+}
@@ -77,13 +77,28 @@ namespace forwarder
     TEST(SocketsTest, getPreconfiguredUDPAddresses)
     {
         std::string input = "localhost:33333,localhost:12345";
-        std::vector<kt::SocketAddress> addresses = getPreconfiguredUDPAddresses(input);
+        std::unordered_map<std::string, std::vector<kt::SocketAddress>> addresses = getPreconfiguredUDPAddresses(input);
 
-        ASSERT_EQ(2, addresses.size());
-        for (const kt::SocketAddress addr : addresses)
+        // Addresses without a group ID are added to the default group
+        ASSERT_EQ(1, addresses.size());
+        ASSERT_EQ(2, addresses[""].size());
+        for (const kt::SocketAddress addr : addresses[""])
         {
             unsigned short port = kt::getPortNumber(addr);
             ASSERT_TRUE(port == 33333 || port == 12345);
         }
     }
+
+    TEST(SocketsTest, getPreconfiguredUDPAddresses_WithGroups)
+    {
+        std::string input = "group1:localhost:33333,group1:localhost:12345,group2:localhost:2255,localhost:4444";
+        std::unordered_map<std::string, std::vector<kt::SocketAddress>> addresses = getPreconfiguredUDPAddresses(input);
+
+        ASSERT_EQ(3, addresses.size());
+        ASSERT_EQ(2, addresses["group1"].size());
+        ASSERT_EQ(1, addresses["group2"].size());
+        ASSERT_EQ(2255, kt::getPortNumber(addresses["group2"][0]));
+        ASSERT_EQ(1, addresses[""].size());
+        ASSERT_EQ(4444, kt::getPortNumber(addresses[""][0]));
+    }
 }
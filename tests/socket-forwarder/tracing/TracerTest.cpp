@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <limits>
+
+#include "../../../socket-forwarder/tracing/Tracer.h"
+
+namespace forwarder
+{
+    TEST(TracerTest, Sample_OneInEveryRateMessagesIsSampled)
+    {
+        Tracer tracer(4, 16);
+
+        std::vector<uint64_t> traceIds;
+        for (size_t i = 0; i < 20; i++)
+        {
+            uint64_t traceId = tracer.sample();
+            if (traceId != 0)
+            {
+                traceIds.push_back(traceId);
+            }
+        }
+        ASSERT_EQ(5, traceIds.size());
+        for (size_t i = 1; i < traceIds.size(); i++)
+        {
+            ASSERT_LT(traceIds[i - 1], traceIds[i]);
+        }
+    }
+
+    TEST(TracerTest, Sample_DisabledUnlessForced)
+    {
+        Tracer tracer(0, 16);
+        for (size_t i = 0; i < 100; i++)
+        {
+            ASSERT_EQ(0, tracer.sample());
+        }
+        ASSERT_NE(0, tracer.sample(true));
+
+        tracer.record(0, TraceEventType::Receive, 1, 10);
+        ASSERT_EQ(0, tracer.getRecordedCount());
+        ASSERT_TRUE(tracer.snapshot().empty());
+    }
+
+    TEST(TracerTest, Sample_ThreadsGenerateDistinctTraceIds)
+    {
+        Tracer tracer(1, 16);
+        uint64_t mainTraceId = tracer.sample();
+        uint64_t otherTraceId = 0;
+        std::thread([&]() { otherTraceId = tracer.sample(); }).join();
+
+        ASSERT_NE(0, mainTraceId);
+        ASSERT_NE(0, otherTraceId);
+        // The thread index is held in the top bits of the trace ID
+        ASSERT_NE(mainTraceId >> 48, otherTraceId >> 48);
+    }
+
+    TEST(TracerTest, Capacity_RoundedUpAndClamped)
+    {
+        ASSERT_EQ(16, Tracer(0, 9).getCapacity());
+        ASSERT_EQ(TRACE_BUFFER_SIZE_MAX, Tracer(0, std::numeric_limits<size_t>::max()).getCapacity());
+    }
+
+    TEST(TracerTest, Record_OldestEventsAreOverwritten)
+    {
+        Tracer tracer(1, 5);
+        ASSERT_EQ(8, tracer.getCapacity());
+
+        for (size_t i = 0; i < 20; i++)
+        {
+            tracer.record(i + 1, TraceEventType::Send, static_cast<int>(i), i);
+        }
+        ASSERT_EQ(20, tracer.getRecordedCount());
+
+        std::vector<TraceEvent> events = tracer.snapshot();
+        ASSERT_EQ(8, events.size());
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            ASSERT_EQ(i + 13, events[i].traceId);
+            ASSERT_EQ(TraceEventType::Send, events[i].type);
+            ASSERT_EQ(static_cast<int>(i + 12), events[i].descriptor);
+            ASSERT_EQ(i + 12, events[i].size);
+        }
+    }
+
+    TEST(TracerTest, Dump_WritesEveryEvent)
+    {
+        Tracer tracer(1, 16);
+        uint64_t traceId = tracer.sample();
+        tracer.record(traceId, TraceEventType::Receive, 3, 100);
+        tracer.record(traceId, TraceEventType::Drop, 4, 100);
+
+        std::ostringstream stream;
+        tracer.dump(stream);
+        std::string output = stream.str();
+        ASSERT_NE(std::string::npos, output.find("[2] trace event(s)"));
+        ASSERT_NE(std::string::npos, output.find("[TRACE - " + traceIdToString(traceId) + "]"));
+        ASSERT_NE(std::string::npos, output.find("[receive]"));
+        ASSERT_NE(std::string::npos, output.find("[drop]"));
+    }
+
+    /**
+     * Snapshots taken while several threads record only contain whole events, each recorded event's fields are derived from its trace ID.
+     * Run under ThreadSanitizer to check that recording and taking snapshots do not race.
+     */
+    TEST(TracerTest, Snapshot_ConcurrentWithRecordingSeesWholeEvents)
+    {
+        Tracer tracer(1, 64);
+        std::atomic<bool> recording{ true };
+        std::atomic<size_t> inconsistentEvents{ 0 };
+
+        std::thread reader([&]()
+        {
+            while (recording.load())
+            {
+                for (const TraceEvent& event : tracer.snapshot())
+                {
+                    if (event.size != (event.traceId & 0xFFFF) || event.descriptor != static_cast<int>(event.traceId & 0xFF))
+                    {
+                        inconsistentEvents++;
+                    }
+                }
+            }
+        });
+
+        std::vector<std::thread> writers;
+        for (size_t i = 0; i < 3; i++)
+        {
+            writers.emplace_back([&]()
+            {
+                for (size_t count = 0; count < 20000; count++)
+                {
+                    uint64_t traceId = tracer.sample();
+                    tracer.record(traceId, TraceEventType::Send, static_cast<int>(traceId & 0xFF), traceId & 0xFFFF);
+                }
+            });
+        }
+        for (std::thread& writer : writers)
+        {
+            writer.join();
+        }
+        recording = false;
+        reader.join();
+
+        ASSERT_EQ(0, inconsistentEvents.load());
+        ASSERT_EQ(60000, tracer.getRecordedCount());
+        ASSERT_EQ(64, tracer.snapshot().size());
+    }
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include "../../../socket-forwarder/uring/IoUring.h"
+
+namespace forwarder
+{
+    class IoUringTest : public ::testing::Test
+    {
+    protected:
+        IoUring ring;
+        int sockets[2] = { -1, -1 };
+
+        void SetUp() override
+        {
+            if (!isIoUringSupported())
+            {
+                GTEST_SKIP() << "io_uring is not available on this system.";
+            }
+            ASSERT_TRUE(ring.open(8));
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+        }
+
+        void TearDown() override
+        {
+            ring.close();
+            for (int socket : sockets)
+            {
+                if (socket != -1)
+                {
+                    close(socket);
+                }
+            }
+        }
+
+        io_uring_cqe waitForCompletion()
+        {
+            io_uring_cqe* entry = ring.peekCompletion();
+            while (entry == nullptr)
+            {
+                ring.submit(1, std::chrono::milliseconds(1000));
+                entry = ring.peekCompletion();
+            }
+            io_uring_cqe completion = *entry;
+            ring.advanceCompletion();
+            return completion;
+        }
+    };
+
+    /**
+     * A multishot receive keeps completing into buffers picked from the provided buffer ring, reporting which buffer it used.
+     */
+    TEST_F(IoUringTest, TestMultishotReceiveIntoProvidedBuffers)
+    {
+        std::vector<std::string> buffers(2, std::string(64, '\0'));
+        ASSERT_TRUE(ring.registerBufferRing(0, 2));
+        for (uint16_t id = 0; id < buffers.size(); id++)
+        {
+            ring.provideBuffer(buffers[id].data(), buffers[id].size(), id);
+        }
+        ring.commitBuffers();
+
+        ASSERT_TRUE(ring.prepareReceive(sockets[0], 0, true, 42));
+        ring.submit();
+
+        for (const std::string message : { "first", "second" })
+        {
+            ASSERT_EQ(message.size(), write(sockets[1], message.data(), message.size()));
+            io_uring_cqe completion = waitForCompletion();
+            ASSERT_EQ(42, completion.user_data);
+            ASSERT_EQ(message.size(), completion.res);
+            ASSERT_TRUE(completion.flags & IORING_CQE_F_BUFFER);
+            ASSERT_TRUE(completion.flags & IORING_CQE_F_MORE);
+
+            const uint16_t id = completion.flags >> IORING_CQE_BUFFER_SHIFT;
+            ASSERT_EQ(message, buffers[id].substr(0, completion.res));
+        }
+
+        // Both buffers are in use, the receive stops once the ring runs out of buffers
+        ASSERT_EQ(5, write(sockets[1], "third", 5));
+        io_uring_cqe completion = waitForCompletion();
+        ASSERT_EQ(-ENOBUFS, completion.res);
+        ASSERT_FALSE(completion.flags & IORING_CQE_F_MORE);
+    }
+
+    TEST_F(IoUringTest, TestBatchedSendMessages)
+    {
+        std::string first = "hello ";
+        std::string second = "world";
+        iovec vectors[2] = { { first.data(), first.size() }, { second.data(), second.size() } };
+        msghdr message{};
+        message.msg_iov = vectors;
+        message.msg_iovlen = 2;
+
+        // Both sends are submitted with a single system call
+        ASSERT_TRUE(ring.prepareSendMessage(sockets[0], &message, MSG_NOSIGNAL, 1));
+        ASSERT_TRUE(ring.prepareSendMessage(sockets[0], &message, MSG_NOSIGNAL, 2));
+        ASSERT_EQ(2, ring.submit());
+
+        for (uint64_t expected : { 1, 2 })
+        {
+            io_uring_cqe completion = waitForCompletion();
+            ASSERT_EQ(expected, completion.user_data);
+            ASSERT_EQ(first.size() + second.size(), completion.res);
+        }
+
+        std::string received(64, '\0');
+        ASSERT_EQ(22, read(sockets[1], received.data(), received.size()));
+        ASSERT_EQ("hello worldhello world", received.substr(0, 22));
+    }
+
+    TEST_F(IoUringTest, TestPollAndWaitTimeout)
+    {
+        ASSERT_TRUE(ring.preparePoll(sockets[0], POLLIN, true, 7));
+        ring.submit();
+
+        // Nothing is readable so the wait times out without any completions
+        ring.submit(1, std::chrono::milliseconds(10));
+        ASSERT_EQ(nullptr, ring.peekCompletion());
+
+        ASSERT_EQ(1, write(sockets[1], "x", 1));
+        io_uring_cqe completion = waitForCompletion();
+        ASSERT_EQ(7, completion.user_data);
+        ASSERT_TRUE(completion.res & POLLIN);
+        ASSERT_TRUE(completion.flags & IORING_CQE_F_MORE);
+    }
+}